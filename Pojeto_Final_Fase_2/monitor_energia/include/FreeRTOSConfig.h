@@ -76,15 +76,26 @@
 #define configAPPLICATION_ALLOCATED_HEAP        0
 
 /* Hook function related definitions. */
-#define configCHECK_FOR_STACK_OVERFLOW          0
+/* Ligado até o relatório `rtos stack` ser levantado na placa: vários stacks
+   foram reduzidos sem medição (hook em src/main.c) */
+#define configCHECK_FOR_STACK_OVERFLOW          2
 #define configUSE_MALLOC_FAILED_HOOK            0
 #define configUSE_DAEMON_TASK_STARTUP_HOOK      0
 
 /* Run time and task stats gathering related definitions. */
-#define configGENERATE_RUN_TIME_STATS           0
+#define configGENERATE_RUN_TIME_STATS           1
 #define configUSE_TRACE_FACILITY                1
 #define configUSE_STATS_FORMATTING_FUNCTIONS    0
 
+/* Tempo de execução por task em µs do timer de 1 MHz do RP2040, que já
+   roda desde o boot (nada a configurar); 64 bits, não dá a volta. */
+#ifndef __ASSEMBLER__
+#include "hardware/timer.h"
+#endif
+#define configRUN_TIME_COUNTER_TYPE             uint64_t
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()        time_us_64()
+
 /* Co-routine related definitions. */
 #define configUSE_CO_ROUTINES                   0
 #define configMAX_CO_ROUTINE_PRIORITIES         1
@@ -138,6 +149,8 @@ to exclude the API function. */
 #define INCLUDE_xQueueGetMutexHolder            1
 
 /* A header file that defines trace macro can be included here. */
+/* Gravador de eventos (trocas de contexto, filas): RTOS_TRACE_ENABLE vem do CMake */
+#include "lib/rtos_trace.h"
 
 /* Enable printf via USB */
 #define configUSE_STDIO 1
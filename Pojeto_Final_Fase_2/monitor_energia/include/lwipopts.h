@@ -51,6 +51,15 @@
 #define DHCP_DOES_ARP_CHECK         0
 #define LWIP_DHCP_DOES_ACD_CHECK    0
 
+// MQTT (lib/mqtt_publisher.c): um timeout cíclico extra e janela em voo limitada
+#define MEMP_NUM_SYS_TIMEOUT        (LWIP_NUM_SYS_TIMEOUT_INTERNAL + 1)
+#define MQTT_REQ_MAX_IN_FLIGHT      4
+#define MQTT_OUTPUT_RINGBUF_SIZE    512
+
+// PCBs TCP: HTTP_SERVER_MAX_CONNS (4, prioridade mínima) + MQTT + ThingSpeak + folga para
+// TIME_WAIT/FIN_WAIT. Com o padrão (5) uma conexão de cliente derrubava scrapes (tcp_kill_prio).
+#define MEMP_NUM_TCP_PCB            10
+
 #ifndef NDEBUG
 #define LWIP_DEBUG                  1
 #define LWIP_STATS                  1
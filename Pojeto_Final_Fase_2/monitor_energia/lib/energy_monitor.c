@@ -5,6 +5,7 @@
  *  Executa uma task periódica que amostra dois canais do ADS1115 (tensão e corrente),
  *  acumula amostras, calcula valores RMS e publica o último resultado via
  *  `energy_monitor_get_last()`. Amostragem nominal: 200 Hz por ~1 s (128 amostras).
+ *  Cada par de amostras também segue, já em V/A, para o fluxo UDP (`udp_stream`).
  */
 
 #include "lib/energy_monitor.h"
@@ -13,7 +14,10 @@
 #include "FreeRTOS.h"
 #include "task.h"
 #include "lib/ads1115_adc.h"
+#include "lib/udp_stream.h"
+#include "lib/time_sync.h"
 #include "lib/logger.h"
+#include "lib/rtos_trace.h"
 
 #define TAG "energy_monitor"
 
@@ -33,8 +37,8 @@
 
 static int16_t buffer_ch0[NUM_SAMPLES];
 static int16_t buffer_ch1[NUM_SAMPLES];
-static uint32_t timestamps_ch0[NUM_SAMPLES];
-static uint32_t timestamps_ch1[NUM_SAMPLES];
+static uint64_t timestamps_ch0[NUM_SAMPLES];  /**< µs desde o boot (`time_us_64`). */
+static uint64_t timestamps_ch1[NUM_SAMPLES];
 
 static energy_monitor_data_t g_last = {0};
 static volatile bool g_last_valid = false;
@@ -71,12 +75,16 @@ void energy_monitor_task(void *params)
     const TickType_t sampling_period = pdMS_TO_TICKS(1000 / SAMPLE_RATE_HZ);
 
     TickType_t cycle_wake = xTaskGetTickCount();
+    uint64_t prev_t_us = 0;
+    double e_wh = 0.0;
+    const uint16_t trace_span = rtos_trace_span("amostragem");
 
     while (1)
     {
         vTaskDelayUntil(&cycle_wake, cycle_period);
 
         TickType_t sample_wake = xTaskGetTickCount();
+        RTOS_TRACE_SPAN_BEGIN(trace_span);
 
         for (int i = 0; i < NUM_SAMPLES; i++)
         {
@@ -86,7 +94,7 @@ void energy_monitor_task(void *params)
                 taskYIELD();
             }
             int16_t ch0 = ads1115_read_conversion();
-            uint32_t t_ch0 = to_ms_since_boot(get_absolute_time());
+            uint64_t t_ch0 = time_us_64();
 
             ads1115_write(0x01, (uint16_t)(CONFIG_DEFAULT | CONFIG_MUX_AIN1));
             while (!ads1115_conversion_ready())
@@ -94,16 +102,24 @@ void energy_monitor_task(void *params)
                 taskYIELD();
             }
             int16_t ch1 = ads1115_read_conversion();
-            uint32_t t_ch1 = to_ms_since_boot(get_absolute_time());
+            uint64_t t_ch1 = time_us_64();
 
             buffer_ch0[i] = ch0;
             buffer_ch1[i] = ch1;
             timestamps_ch0[i] = t_ch0;
             timestamps_ch1[i] = t_ch1;
 
+            /* O par V/I é datado no meio das duas conversões. */
+            udp_stream_push(t_ch0 + (t_ch1 - t_ch0) / 2U,
+                            ((float)ch0 * LSB_4_096V - VOLT_DC_OFFSET) * VOLT_CONV_FACTOR,
+                            ((float)ch1 * LSB_4_096V - CURR_DC_OFFSET) * CURR_CONV_FACTOR);
+
             vTaskDelayUntil(&sample_wake, sampling_period);
         }
 
+        RTOS_TRACE_SPAN_END(trace_span);
+        udp_stream_flush();
+
         double sum_sq_ch0 = 0.0;
         double sum_sq_ch1 = 0.0;
 
@@ -124,20 +140,30 @@ void energy_monitor_task(void *params)
 
         const int last = NUM_SAMPLES - 1;
 
-        const uint32_t t_ms = (timestamps_ch0[last] > timestamps_ch1[last])
+        const uint64_t t_us = (timestamps_ch0[last] > timestamps_ch1[last])
                                   ? timestamps_ch0[last]
                                   : timestamps_ch1[last];
 
+        if (prev_t_us != 0)
+        {
+            e_wh += p_instant * (double)(t_us - prev_t_us) / 3600000000.0;
+        }
+        prev_t_us = t_us;
+        const int64_t t_unix_us = time_sync_to_unix_us(t_us);
+
         taskENTER_CRITICAL();
         g_last.vrms = vrms_real;
         g_last.irms = irms_real;
         g_last.v_pu = v_pu;
         g_last.p_instant = p_instant;
-        g_last.t_ms = t_ms;
+        g_last.e_wh = e_wh;
+        g_last.t_boot_us = t_us;
+        g_last.t_unix_us = t_unix_us;
         g_last_valid = true;
         taskEXIT_CRITICAL();
 
-        LOG(TAG, "V=%.2f V (PU=%.3f) | I=%.3f A | Pinst=%.1f W | t=%u ms",
-            vrms_real, v_pu, irms_real, p_instant, t_ms);
+        LOGD(TAG, "V=%.2f V (PU=%.3f) | I=%.3f A | Pinst=%.1f W | t=%lu.%03lu s",
+             vrms_real, v_pu, irms_real, p_instant, (unsigned long)(t_us / 1000000U),
+             (unsigned long)((t_us / 1000U) % 1000U));
     }
 }
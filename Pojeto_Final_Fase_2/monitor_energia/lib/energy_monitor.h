@@ -18,7 +18,9 @@ typedef struct
     double irms;      /**< Corrente RMS [A] */
     double v_pu;      /**< Tensão em PU (base 127 V) */
     double p_instant; /**< Potência instantânea no último sample [W] */
-    uint32_t t_ms;    /**< Timestamp (ms desde boot) do último sample usado em p_instant */
+    double e_wh;      /**< Energia acumulada desde o boot [Wh] */
+    uint64_t t_boot_us; /**< Instante (µs desde o boot, 64 bits) do último sample usado em p_instant */
+    int64_t t_unix_us;  /**< O mesmo instante em tempo Unix (µs), pelo relógio de `time_sync` */
 } energy_monitor_data_t;
 
 void energy_monitor_task(void *params);
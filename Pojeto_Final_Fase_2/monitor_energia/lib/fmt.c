@@ -0,0 +1,383 @@
+/**
+ * @file fmt.c
+ * @brief Formatador numérico de ponto fixo compartilhado por telemetria, CSV e logger.
+ * @details
+ *  Substitui `snprintf("%.Nf")`/`sprintf("%04d...")` nos caminhos quentes. O
+ *  `printf` do newlib com ponto flutuante é emulado por software no Cortex-M0+,
+ *  usa bastante stack e é lento; aqui os dígitos saem de divisões inteiras de
+ *  32 bits (dois dígitos por iteração) e só caímos em 64 bits quando o valor
+ *  não cabe em `uint32_t`. Não depende do Pico SDK (compila também no host).
+ */
+
+#include "lib/fmt.h"
+
+/** @brief Pares "00".."99" para gerar dois dígitos por divisão. */
+static const char k_digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/** @brief Potências de 10 usadas para separar parte inteira e fracionária. */
+static const uint32_t k_pow10[FMT_MAX_DECIMALS + 1] = {
+    1U, 10U, 100U, 1000U, 10000U, 100000U, 1000000U, 10000000U, 100000000U, 1000000000U};
+
+/**
+ * @brief Garante terminação vazia quando o resultado não cabe.
+ * @return Sempre 0.
+ */
+static size_t fmt_overflow(char *buf, size_t size)
+{
+    if (buf && size > 0)
+    {
+        buf[0] = '\0';
+    }
+    return 0;
+}
+
+/**
+ * @brief Gera os dígitos de `v` de trás para frente a partir de `end`.
+ * @param end Ponteiro uma posição após o último dígito.
+ * @param v Valor a converter.
+ * @return Ponteiro para o primeiro dígito gerado.
+ */
+static char *u32_digits_rev(char *end, uint32_t v)
+{
+    char *p = end;
+
+    while (v >= 100U)
+    {
+        const uint32_t idx = (v % 100U) * 2U;
+        v /= 100U;
+        *--p = k_digit_pairs[idx + 1];
+        *--p = k_digit_pairs[idx];
+    }
+
+    if (v >= 10U)
+    {
+        const uint32_t idx = v * 2U;
+        *--p = k_digit_pairs[idx + 1];
+        *--p = k_digit_pairs[idx];
+    }
+    else
+    {
+        *--p = (char)('0' + v);
+    }
+
+    return p;
+}
+
+/**
+ * @brief Gera exatamente `width` dígitos de `v` (com zeros à esquerda).
+ * @param end Ponteiro uma posição após o último dígito.
+ * @param v Valor a converter (deve caber em `width` dígitos).
+ * @param width Quantidade de dígitos.
+ * @return Ponteiro para o primeiro dígito gerado.
+ */
+static char *u32_digits_rev_pad(char *end, uint32_t v, uint8_t width)
+{
+    char *p = end;
+
+    while (width >= 2U)
+    {
+        const uint32_t idx = (v % 100U) * 2U;
+        v /= 100U;
+        *--p = k_digit_pairs[idx + 1];
+        *--p = k_digit_pairs[idx];
+        width -= 2U;
+    }
+
+    if (width)
+    {
+        *--p = (char)('0' + (v % 10U));
+    }
+
+    return p;
+}
+
+/**
+ * @brief Gera os dígitos de um valor de 64 bits de trás para frente.
+ * @note Usa blocos de 9 dígitos para limitar a 2 as divisões de 64 bits.
+ */
+static char *u64_digits_rev(char *end, uint64_t v)
+{
+    char *p = end;
+
+    while (v > UINT32_MAX)
+    {
+        const uint32_t low = (uint32_t)(v % 1000000000ULL);
+        v /= 1000000000ULL;
+        p = u32_digits_rev_pad(p, low, 9U);
+    }
+
+    return u32_digits_rev(p, (uint32_t)v);
+}
+
+/**
+ * @brief Copia `len` bytes de `src` para `buf`, se couberem (com '\0').
+ * @return `len` em sucesso; 0 se não couber.
+ */
+static size_t emit(char *buf, size_t size, const char *src, size_t len)
+{
+    if (!buf || len + 1U > size)
+    {
+        return fmt_overflow(buf, size);
+    }
+
+    for (size_t i = 0; i < len; i++)
+    {
+        buf[i] = src[i];
+    }
+    buf[len] = '\0';
+    return len;
+}
+
+/**
+ * @brief Copia uma string para o buffer.
+ * @param[out] buf Buffer de saída.
+ * @param size Tamanho do buffer.
+ * @param s String de origem (NULL é tratado como vazia).
+ * @return Caracteres escritos; 0 se não couber.
+ */
+size_t fmt_str(char *buf, size_t size, const char *s)
+{
+    size_t len = 0;
+
+    if (s)
+    {
+        while (s[len] != '\0')
+        {
+            len++;
+        }
+    }
+
+    return emit(buf, size, s ? s : "", len);
+}
+
+/**
+ * @brief Escreve um único caractere.
+ * @return 1 em sucesso; 0 se não couber.
+ */
+size_t fmt_char(char *buf, size_t size, char c)
+{
+    return emit(buf, size, &c, 1U);
+}
+
+/**
+ * @brief Formata inteiro sem sinal de 32 bits (equivale a "%u").
+ * @return Caracteres escritos; 0 se não couber.
+ */
+size_t fmt_u32(char *buf, size_t size, uint32_t v)
+{
+    char tmp[10];
+    char *end = tmp + sizeof(tmp);
+    char *p = u32_digits_rev(end, v);
+    return emit(buf, size, p, (size_t)(end - p));
+}
+
+/**
+ * @brief Formata inteiro com sinal de 32 bits (equivale a "%d").
+ * @return Caracteres escritos; 0 se não couber.
+ */
+size_t fmt_i32(char *buf, size_t size, int32_t v)
+{
+    char tmp[11];
+    char *end = tmp + sizeof(tmp);
+    const uint32_t mag = (v < 0) ? (0U - (uint32_t)v) : (uint32_t)v;
+    char *p = u32_digits_rev(end, mag);
+
+    if (v < 0)
+    {
+        *--p = '-';
+    }
+
+    return emit(buf, size, p, (size_t)(end - p));
+}
+
+/**
+ * @brief Formata inteiro sem sinal de 64 bits (equivale a "%llu").
+ * @return Caracteres escritos; 0 se não couber.
+ */
+size_t fmt_u64(char *buf, size_t size, uint64_t v)
+{
+    char tmp[20];
+    char *end = tmp + sizeof(tmp);
+    char *p = u64_digits_rev(end, v);
+    return emit(buf, size, p, (size_t)(end - p));
+}
+
+/**
+ * @brief Formata inteiro com sinal de 64 bits (equivale a "%lld").
+ * @return Caracteres escritos; 0 se não couber.
+ */
+size_t fmt_i64(char *buf, size_t size, int64_t v)
+{
+    char tmp[21];
+    char *end = tmp + sizeof(tmp);
+    const uint64_t mag = (v < 0) ? (0ULL - (uint64_t)v) : (uint64_t)v;
+    char *p = u64_digits_rev(end, mag);
+
+    if (v < 0)
+    {
+        *--p = '-';
+    }
+
+    return emit(buf, size, p, (size_t)(end - p));
+}
+
+/**
+ * @brief Formata inteiro com zeros à esquerda até `width` dígitos (equivale a "%0Nu").
+ * @note Valores com mais dígitos que `width` são escritos por completo.
+ * @return Caracteres escritos; 0 se não couber.
+ */
+size_t fmt_u32_pad(char *buf, size_t size, uint32_t v, uint8_t width)
+{
+    char tmp[10];
+    char *end = tmp + sizeof(tmp);
+    char *p = u32_digits_rev(end, v);
+
+    if (width > sizeof(tmp))
+    {
+        width = sizeof(tmp);
+    }
+
+    while ((size_t)(end - p) < width)
+    {
+        *--p = '0';
+    }
+
+    return emit(buf, size, p, (size_t)(end - p));
+}
+
+/**
+ * @brief Formata um valor escalado como decimal fixo.
+ * @param[out] buf Buffer de saída.
+ * @param size Tamanho do buffer.
+ * @param scaled Valor multiplicado por 10^decimals (ex.: 12345 com 2 casas -> "123.45").
+ * @param decimals Casas decimais [0..FMT_MAX_DECIMALS].
+ * @return Caracteres escritos; 0 se não couber ou `decimals` inválido.
+ */
+size_t fmt_fixed(char *buf, size_t size, int64_t scaled, uint8_t decimals)
+{
+    if (decimals > FMT_MAX_DECIMALS)
+    {
+        return fmt_overflow(buf, size);
+    }
+
+    char tmp[32];
+    char *end = tmp + sizeof(tmp);
+    char *p = end;
+    const bool neg = (scaled < 0);
+    const uint64_t mag = neg ? (0ULL - (uint64_t)scaled) : (uint64_t)scaled;
+
+    uint64_t ipart = mag;
+    uint32_t frac = 0;
+
+    if (decimals)
+    {
+        const uint32_t pw = k_pow10[decimals];
+
+        if (mag <= UINT32_MAX)
+        {
+            ipart = (uint32_t)mag / pw;
+            frac = (uint32_t)mag % pw;
+        }
+        else
+        {
+            ipart = mag / pw;
+            frac = (uint32_t)(mag % pw);
+        }
+
+        p = u32_digits_rev_pad(p, frac, decimals);
+        *--p = '.';
+    }
+
+    p = u64_digits_rev(p, ipart);
+
+    if (neg && (ipart || frac))
+    {
+        *--p = '-';
+    }
+
+    return emit(buf, size, p, (size_t)(end - p));
+}
+
+/**
+ * @brief Formata data/hora com separadores configuráveis.
+ * @param[out] buf Buffer de saída.
+ * @param size Tamanho do buffer.
+ * @param t Campos de data/hora.
+ * @param date_sep Separador da data (ex.: '/' ou '-').
+ * @param time_sep Separador entre data e hora (ex.: ' ' ou 'T').
+ * @param with_msec Acrescenta ".mmm" ao final.
+ * @return Caracteres escritos; 0 se não couber.
+ * @note Saída: "AAAA<ds>MM<ds>DD<ts>hh:mm:ss[.mmm]".
+ */
+size_t fmt_timestamp(char *buf, size_t size, const fmt_time_t *t,
+                     char date_sep, char time_sep, bool with_msec)
+{
+    if (!t)
+    {
+        return fmt_overflow(buf, size);
+    }
+
+    char tmp[23];
+    char *end = tmp + (with_msec ? 23 : 19);
+    char *p = end;
+
+    if (with_msec)
+    {
+        p = u32_digits_rev_pad(p, t->msec, 3U);
+        *--p = '.';
+    }
+
+    p = u32_digits_rev_pad(p, t->sec, 2U);
+    *--p = ':';
+    p = u32_digits_rev_pad(p, t->min, 2U);
+    *--p = ':';
+    p = u32_digits_rev_pad(p, t->hour, 2U);
+    *--p = time_sep;
+    p = u32_digits_rev_pad(p, t->day, 2U);
+    *--p = date_sep;
+    p = u32_digits_rev_pad(p, t->month, 2U);
+    *--p = date_sep;
+    p = u32_digits_rev_pad(p, t->year, 4U);
+
+    return emit(buf, size, p, (size_t)(end - p));
+}
+
+/**
+ * @brief Converte `double` em inteiro escalado por 10^decimals (arredonda meio para longe do zero).
+ * @param v Valor de entrada.
+ * @param decimals Casas decimais [0..FMT_MAX_DECIMALS].
+ * @return Valor escalado; 0 para NaN/Inf; saturado nos limites de `int64_t`.
+ */
+int64_t fmt_scale(double v, uint8_t decimals)
+{
+    /* `v - v` só é diferente de zero para NaN e ±Inf. */
+    if ((v - v) != 0.0 || decimals > FMT_MAX_DECIMALS)
+    {
+        return 0;
+    }
+
+    double x = v * (double)k_pow10[decimals];
+
+    if (x >= 9.2e18)
+    {
+        return INT64_MAX;
+    }
+
+    if (x <= -9.2e18)
+    {
+        return INT64_MIN;
+    }
+
+    x += (x >= 0.0) ? 0.5 : -0.5;
+    return (int64_t)x;
+}
@@ -0,0 +1,143 @@
+/**
+ * @file fmt.h
+ * @brief Formatação rápida de inteiros, decimais fixos e timestamps (sem printf).
+ * @details
+ *  Todas as funções escrevem no buffer do chamador, sempre terminam a string
+ *  com '\0' e retornam a quantidade de caracteres escritos (sem o '\0').
+ *  Se o resultado não couber, nada é escrito além de `buf[0] = '\0'` e o
+ *  retorno é 0, o que permite encadear chamadas com `pos += fmt_xxx(...)`.
+ *  Não usam varargs nem ponto flutuante (exceto `fmt_scale()`, que faz uma
+ *  única multiplicação para converter `double` em inteiro escalado).
+ */
+
+#ifndef FMT_H
+#define FMT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define FMT_MAX_DECIMALS    9U      /**< Máximo de casas decimais em `fmt_fixed`. */
+
+/** @brief Campos de data/hora aceitos por `fmt_timestamp`. */
+typedef struct
+{
+    uint16_t year;  /**< Ano (0..9999). */
+    uint8_t month;  /**< Mês [1..12]. */
+    uint8_t day;    /**< Dia [1..31]. */
+    uint8_t hour;   /**< Hora [0..23]. */
+    uint8_t min;    /**< Minuto [0..59]. */
+    uint8_t sec;    /**< Segundo [0..59]. */
+    uint16_t msec;  /**< Milissegundo [0..999]. */
+} fmt_time_t;
+
+size_t fmt_str(char *buf, size_t size, const char *s);
+size_t fmt_char(char *buf, size_t size, char c);
+size_t fmt_u32(char *buf, size_t size, uint32_t v);
+size_t fmt_i32(char *buf, size_t size, int32_t v);
+size_t fmt_u64(char *buf, size_t size, uint64_t v);
+size_t fmt_i64(char *buf, size_t size, int64_t v);
+size_t fmt_u32_pad(char *buf, size_t size, uint32_t v, uint8_t width);
+size_t fmt_fixed(char *buf, size_t size, int64_t scaled, uint8_t decimals);
+size_t fmt_timestamp(char *buf, size_t size, const fmt_time_t *t,
+                     char date_sep, char time_sep, bool with_msec);
+int64_t fmt_scale(double v, uint8_t decimals);
+
+/**
+ * @brief Formata um `double` com `decimals` casas fixas (equivale a "%.Nf").
+ * @note NaN/Inf viram 0 e valores fora da faixa de `int64_t` são saturados.
+ */
+static inline size_t fmt_double(char *buf, size_t size, double v, uint8_t decimals)
+{
+    return fmt_fixed(buf, size, fmt_scale(v, decimals), decimals);
+}
+
+/**
+ * @brief Acumulador para montar uma linha com várias chamadas `fmt_*`.
+ * @details
+ *  `overflow` fica verdadeiro se algum trecho não coube; a linha então deve
+ *  ser descartada pelo chamador (nunca é enviada truncada no meio de um campo).
+ */
+typedef struct
+{
+    char *buf;      /**< Buffer de destino. */
+    size_t size;    /**< Capacidade total (inclui o '\0'). */
+    size_t len;     /**< Caracteres já escritos. */
+    bool overflow;  /**< Algum trecho não coube. */
+} fmt_buf_t;
+
+/** @brief Inicializa o acumulador sobre `buf`. */
+static inline void fmt_buf_init(fmt_buf_t *b, char *buf, size_t size)
+{
+    b->buf = buf;
+    b->size = size;
+    b->len = 0;
+    b->overflow = (size == 0);
+
+    if (size)
+    {
+        buf[0] = '\0';
+    }
+}
+
+/** @brief Ponteiro para a posição livre do acumulador. */
+static inline char *fmt_buf_tail(const fmt_buf_t *b) { return b->buf + b->len; }
+
+/** @brief Espaço livre (inclui o '\0') do acumulador. */
+static inline size_t fmt_buf_room(const fmt_buf_t *b) { return b->size - b->len; }
+
+/**
+ * @brief Contabiliza `n` caracteres escritos na cauda; `n == 0` indica estouro.
+ * @note Para trechos que podem ser vazios (strings), use `fmt_buf_str`.
+ */
+static inline void fmt_buf_commit(fmt_buf_t *b, size_t n)
+{
+    if (n == 0)
+    {
+        b->overflow = true;
+    }
+    b->len += n;
+}
+
+/** @brief Acrescenta string (vazia é permitida). */
+static inline void fmt_buf_str(fmt_buf_t *b, const char *s)
+{
+    if (s && s[0] != '\0')
+    {
+        fmt_buf_commit(b, fmt_str(fmt_buf_tail(b), fmt_buf_room(b), s));
+    }
+}
+
+/** @brief Acrescenta um caractere. */
+static inline void fmt_buf_char(fmt_buf_t *b, char c)
+{
+    fmt_buf_commit(b, fmt_char(fmt_buf_tail(b), fmt_buf_room(b), c));
+}
+
+/** @brief Acrescenta inteiro sem sinal. */
+static inline void fmt_buf_u32(fmt_buf_t *b, uint32_t v)
+{
+    fmt_buf_commit(b, fmt_u32(fmt_buf_tail(b), fmt_buf_room(b), v));
+}
+
+/** @brief Acrescenta inteiro com sinal. */
+static inline void fmt_buf_i32(fmt_buf_t *b, int32_t v)
+{
+    fmt_buf_commit(b, fmt_i32(fmt_buf_tail(b), fmt_buf_room(b), v));
+}
+
+/** @brief Acrescenta decimal fixo a partir de `double`. */
+static inline void fmt_buf_double(fmt_buf_t *b, double v, uint8_t decimals)
+{
+    fmt_buf_commit(b, fmt_double(fmt_buf_tail(b), fmt_buf_room(b), v, decimals));
+}
+
+/** @brief Acrescenta timestamp (ver `fmt_timestamp`). */
+static inline void fmt_buf_timestamp(fmt_buf_t *b, const fmt_time_t *t,
+                                     char date_sep, char time_sep, bool with_msec)
+{
+    fmt_buf_commit(b, fmt_timestamp(fmt_buf_tail(b), fmt_buf_room(b), t,
+                                    date_sep, time_sep, with_msec));
+}
+
+#endif /* FMT_H */
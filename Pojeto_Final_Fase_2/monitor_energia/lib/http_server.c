@@ -0,0 +1,979 @@
+/**
+ * @file http_server.c
+ * @brief Servidor HTTP mínimo (TCP bruto lwIP) com métricas Prometheus em /metrics e histórico em /query.
+ * @details
+ *  A task renderiza periodicamente o estado em memória (última medição,
+ *  energia, Wi‑Fi, MQTT, heap e tasks) no formato texto do Prometheus, em
+ *  páginas estáticas. Cada conexão "fixa" a página corrente (contador de
+ *  referências) e a envia sem cópia com `tcp_write`; a task só reescreve
+ *  páginas sem referências. Assim vários scrapers são atendidos ao mesmo
+ *  tempo, sem alocação dinâmica e sem montar texto no contexto do lwIP.
+ *
+ *  A renderização roda na menor prioridade e só lê cópias do estado
+ *  (`energy_monitor_get_last`), portanto não interfere na amostragem.
+ *
+ *  `GET /query?from=...&to=...&metrics=vrms,p_w&limit=N` entrega o histórico
+ *  do SD em CSV (`lib/sd_query.h`), uma consulta por vez. O corpo não cabe
+ *  numa página: a task de consulta gera blocos e os entrega ao TCP com
+ *  cópia (o bloco é reusado em seguida), esperando os `sent` quando o
+ *  buffer de envio enche; a resposta termina ao fechar a conexão.
+ *
+ *  Enquanto houver conexão aberta o rádio fica acordado
+ *  (`wifi_manager_tx_hold`): em `CYW43_AGGRESSIVE_PM` cada segmento do
+ *  scrape esperaria o próximo beacon.
+ */
+
+#include "lib/http_server.h"
+#include <string.h>
+#include "pico/cyw43_arch.h"
+#include "lwip/tcp.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "lib/energy_monitor.h"
+#include "lib/wifi_manager.h"
+#include "lib/time_sync.h"
+#include "lib/mqtt_publisher.h"
+#include "lib/telemetry.h"
+#include "lib/udp_stream.h"
+#include "lib/sd_card_log_task.h"
+#include "lib/sd_query.h"
+#include "lib/timestamp.h"
+#include "lib/logger.h"
+#include "lib/rtos_stats.h"
+#include "lib/fmt.h"
+
+#define TAG "http"
+
+/* Um PCB para cada slot, MQTT e ThingSpeak: senão o lwIP aborta scrapes (prioridade mínima) para conectar. */
+#if MEMP_NUM_TCP_PCB < HTTP_SERVER_MAX_CONNS + 2
+#error "MEMP_NUM_TCP_PCB (include/lwipopts.h) menor que HTTP_SERVER_MAX_CONNS + 2"
+#endif
+
+#define HTTP_METRICS_PAGES      3U      /**< Páginas: 1 corrente + 1 em renderização + 1 folga. */
+#define HTTP_REQ_LINE_MAX       160U    /**< Bytes guardados da linha de requisição (parâmetros de /query). */
+#define HTTP_POLL_INTERVAL      4U      /**< Intervalo do `tcp_poll` (x 500 ms). */
+#define HTTP_IDLE_POLLS_MAX     5U      /**< Polls sem progresso antes de abortar (~10 s). */
+
+/** @brief Página de métricas pronta para envio (cabeçalho + corpo). */
+typedef struct
+{
+    char head[128];                         /**< Cabeçalho HTTP com Content-Length. */
+    char body[HTTP_METRICS_PAGE_SIZE];      /**< Corpo no formato Prometheus. */
+    uint16_t head_len;                      /**< Tamanho do cabeçalho. */
+    uint16_t body_len;                      /**< Tamanho do corpo. */
+    volatile uint8_t refs;                  /**< Conexões enviando esta página. */
+} metrics_page_t;
+
+/** @brief Estado de uma conexão HTTP. */
+typedef struct
+{
+    struct tcp_pcb *pcb;            /**< PCB (NULL se slot livre). */
+    char req[HTTP_REQ_LINE_MAX];    /**< Início da requisição recebida. */
+    uint8_t req_len;                /**< Bytes em `req`. */
+    bool responded;                 /**< Resposta já definida. */
+    int8_t page;                    /**< Página fixada (-1 se nenhuma). */
+    const char *seg[2];             /**< Segmentos a enviar (cabeçalho, corpo). */
+    uint16_t seg_len[2];            /**< Tamanho de cada segmento. */
+    uint8_t seg_idx;                /**< Segmento corrente. */
+    uint16_t seg_off;               /**< Offset no segmento corrente. */
+    uint32_t unacked;               /**< Bytes escritos ainda não confirmados. */
+    uint8_t idle_polls;             /**< Polls consecutivos sem progresso. */
+    bool streaming;                 /**< Corpo de /query ainda sendo gerado. */
+} http_conn_t;
+
+static const char k_resp_404[] =
+    "HTTP/1.1 404 Not Found\r\n"
+    "Content-Type: text/plain\r\n"
+    "Content-Length: 10\r\n"
+    "Connection: close\r\n"
+    "\r\n"
+    "not found\n";
+
+static const char k_resp_400[] =
+    "HTTP/1.1 400 Bad Request\r\n"
+    "Content-Type: text/plain\r\n"
+    "Content-Length: 59\r\n"
+    "Connection: close\r\n"
+    "\r\n"
+    "uso: /query?from=AAAA-MM-DDTHH:MM:SS&to=...&metrics=&limit\n";
+
+static const char k_resp_query[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/csv; charset=utf-8\r\n"
+    "Cache-Control: no-store\r\n"
+    "Connection: close\r\n"
+    "\r\n";
+
+static const char k_resp_503[] =
+    "HTTP/1.1 503 Service Unavailable\r\n"
+    "Content-Length: 0\r\n"
+    "Connection: close\r\n"
+    "\r\n";
+
+static metrics_page_t s_pages[HTTP_METRICS_PAGES];
+static volatile int8_t s_current = -1;
+static http_conn_t s_conns[HTTP_SERVER_MAX_CONNS];
+static struct tcp_pcb *s_listen = NULL;
+static rtos_stats_snapshot_t s_rtos;            /**< Cópia do instantâneo de `rtos_stats` (só a task). */
+static http_server_stats_t s_stats;
+static http_conn_t *volatile s_stream = NULL;   /**< Conexão que recebe a consulta em andamento. */
+static TaskHandle_t s_stream_waiter = NULL;     /**< Task de consulta à espera de `sent`. */
+static uint8_t s_open = 0;                      /**< Conexões com slot (contexto do lwIP). */
+static int8_t s_tx_client = -1;                 /**< Cliente de envio no gerenciador Wi‑Fi. */
+
+/* ---------------------------------------------------------------------- */
+/* Conexões (executam no contexto do lwIP)                                */
+/* ---------------------------------------------------------------------- */
+
+/**
+ * @brief Acorda a task de consulta à espera de espaço no envio.
+ * @details Com `pico_cyw43_arch_lwip_threadsafe_background` os callbacks do
+ *          lwIP rodam numa IRQ de baixa prioridade; pelas tasks (`query_done`)
+ *          chegam com o lock do lwIP.
+ */
+static void wake_stream_waiter(void)
+{
+    TaskHandle_t t = s_stream_waiter;
+
+    if (!t)
+    {
+        return;
+    }
+
+    if (portCHECK_IF_IN_ISR())
+    {
+        BaseType_t hp = pdFALSE;
+        vTaskNotifyGiveFromISR(t, &hp);
+        portYIELD_FROM_ISR(hp);
+    }
+    else
+    {
+        xTaskNotifyGive(t);
+    }
+}
+
+/**
+ * @brief Libera a página fixada e o slot da conexão.
+ */
+static void conn_release(http_conn_t *c)
+{
+    if (c == s_stream)
+    {
+        /* A consulta aborta na próxima entrega */
+        s_stream = NULL;
+        wake_stream_waiter();
+    }
+
+    if (c->page >= 0)
+    {
+        s_pages[c->page].refs--;
+        c->page = -1;
+    }
+
+    if (c->pcb && --s_open == 0)
+    {
+        wifi_manager_tx_hold(s_tx_client, false);
+    }
+
+    memset(c, 0, sizeof(*c));
+    c->page = -1;
+}
+
+/**
+ * @brief Fecha a conexão graciosamente (aborta se houver dados pendentes ou `tcp_close` falhar).
+ * @return ERR_OK, ou ERR_ABRT se o PCB foi abortado.
+ */
+static err_t conn_close(http_conn_t *c)
+{
+    struct tcp_pcb *pcb = c->pcb;
+    err_t ret = ERR_OK;
+
+    tcp_arg(pcb, NULL);
+    tcp_recv(pcb, NULL);
+    tcp_sent(pcb, NULL);
+    tcp_err(pcb, NULL);
+    tcp_poll(pcb, NULL, 0);
+
+    /* Segmentos sem cópia ainda não confirmados apontam para a página
+       fixada: abortar descarta-os antes de a página voltar a ser usada. */
+    if (c->unacked > 0 || tcp_close(pcb) != ERR_OK)
+    {
+        tcp_abort(pcb);
+        s_stats.aborted++;
+        ret = ERR_ABRT;
+    }
+
+    conn_release(c);
+    return ret;
+}
+
+/**
+ * @brief Enfileira no TCP o máximo possível dos segmentos pendentes (sem cópia).
+ * @return true se todos os bytes já foram entregues ao TCP.
+ */
+static bool conn_send_more(http_conn_t *c)
+{
+    while (c->seg_idx < 2)
+    {
+        const uint16_t remaining = (uint16_t)(c->seg_len[c->seg_idx] - c->seg_off);
+
+        if (remaining == 0)
+        {
+            c->seg_idx++;
+            c->seg_off = 0;
+            continue;
+        }
+
+        uint16_t n = tcp_sndbuf(c->pcb);
+        if (n == 0)
+        {
+            break;
+        }
+        if (n > remaining)
+        {
+            n = remaining;
+        }
+
+        const bool more = (n < remaining) || (c->seg_idx == 0 && c->seg_len[1] > 0);
+        err_t err = tcp_write(c->pcb, c->seg[c->seg_idx] + c->seg_off, n,
+                              more ? TCP_WRITE_FLAG_MORE : 0);
+        if (err != ERR_OK)
+        {
+            break; /* ERR_MEM: continua no próximo `sent`/`poll`. */
+        }
+
+        c->seg_off = (uint16_t)(c->seg_off + n);
+        c->unacked += n;
+    }
+
+    tcp_output(c->pcb);
+    return c->seg_idx >= 2;
+}
+
+/**
+ * @brief Acha `key` nos parâmetros "k=v&k=v" da requisição.
+ * @param[out] val Início do valor (sem decodificar '%').
+ * @param[out] len Tamanho do valor.
+ */
+static bool query_param(const char *q, size_t qlen, const char *key, const char **val, size_t *len)
+{
+    const size_t klen = strlen(key);
+    const char *end = q + qlen;
+
+    while (q < end)
+    {
+        const char *amp = memchr(q, '&', (size_t)(end - q));
+        const char *stop = amp ? amp : end;
+
+        if ((size_t)(stop - q) > klen && memcmp(q, key, klen) == 0 && q[klen] == '=')
+        {
+            *val = q + klen + 1U;
+            *len = (size_t)(stop - *val);
+            return true;
+        }
+        q = amp ? amp + 1 : end;
+    }
+    return false;
+}
+
+/** @brief Monta o pedido de /query; false se um parâmetro é inválido. */
+static bool query_parse(const char *q, size_t qlen, sd_query_req_t *req)
+{
+    const char *v;
+    size_t n;
+
+    memset(req, 0, sizeof(*req));
+    if (!query_param(q, qlen, "from", &v, &n) || !timestamp_parse(v, n, &req->t_from))
+    {
+        return false;
+    }
+
+    req->t_to = time_sync_now_us();
+    if (query_param(q, qlen, "to", &v, &n) && !timestamp_parse(v, n, &req->t_to))
+    {
+        return false;
+    }
+    if (query_param(q, qlen, "metrics", &v, &n) && !sd_query_parse_metrics(v, n, &req->metrics))
+    {
+        return false;
+    }
+    if (query_param(q, qlen, "limit", &v, &n))
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            if (v[i] < '0' || v[i] > '9' || req->limit > UINT32_MAX / 10U)
+            {
+                return false;
+            }
+            req->limit = req->limit * 10U + (uint32_t)(v[i] - '0');
+        }
+    }
+    return true;
+}
+
+/** @brief Fim da consulta (task de consulta): fecha a conexão quando o TCP confirmar tudo. */
+static void query_done(void *ctx, bool ok)
+{
+    (void)ctx;
+    cyw43_arch_lwip_begin();
+    http_conn_t *c = s_stream;
+    s_stream = NULL;
+    if (c)
+    {
+        c->streaming = false;
+        s_stats.queries += ok ? 1U : 0U;
+        if (conn_send_more(c) && c->unacked == 0)
+        {
+            (void)conn_close(c);
+        }
+    }
+    cyw43_arch_lwip_end();
+}
+
+/**
+ * @brief Entrega um bloco CSV à conexão (task de consulta).
+ * @details Com cópia: o bloco é reusado assim que esta função volta, ao
+ *          contrário das páginas de /metrics, que ficam fixas até o `sent`.
+ *          Sem espaço no envio, espera o `sent`, o `poll` (`tcp_write` sem
+ *          memória com nada em voo não gera `sent`) ou o fim da conexão.
+ * @return false se a conexão caiu ou não andou em `HTTP_QUERY_WAIT_MS`.
+ */
+static bool query_out(void *ctx, const char *data, size_t len)
+{
+    (void)ctx;
+    s_stream_waiter = xTaskGetCurrentTaskHandle();
+
+    while (len > 0U)
+    {
+        uint16_t n = 0;
+
+        cyw43_arch_lwip_begin();
+        http_conn_t *c = s_stream;
+        if (c && conn_send_more(c)) /* Cabeçalho primeiro */
+        {
+            n = tcp_sndbuf(c->pcb);
+            n = (n > len) ? (uint16_t)len : n;
+            if (n && tcp_write(c->pcb, data, n, TCP_WRITE_FLAG_COPY | ((n < len) ? TCP_WRITE_FLAG_MORE : 0)) == ERR_OK)
+            {
+                c->unacked += n;
+                tcp_output(c->pcb);
+            }
+            else
+            {
+                n = 0;
+            }
+        }
+        cyw43_arch_lwip_end();
+
+        if (!c)
+        {
+            return false;
+        }
+        data += n;
+        len -= n;
+        if (n == 0 && ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(HTTP_QUERY_WAIT_MS)) == 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** @brief Inicia /query: 200 e o corpo pela task de consulta, ou 400/503. */
+static void conn_route_query(http_conn_t *c)
+{
+    const char *q = c->req + 10;
+    const char *sp = strchr(q, ' ');
+    sd_query_req_t req;
+
+    q += (*q == '?') ? 1 : 0;
+    if (!sp || !query_parse(q, (size_t)(sp - q), &req))
+    {
+        s_stats.bad_requests++;
+        c->seg[0] = k_resp_400;
+        c->seg_len[0] = sizeof(k_resp_400) - 1U;
+        return;
+    }
+
+    s_stream = c;
+    c->streaming = true;
+    const sd_query_result_t res = sd_query_start(&req, query_out, query_done, NULL);
+    if (res != SD_QUERY_STARTED)
+    {
+        s_stream = NULL;
+        c->streaming = false;
+        c->seg[0] = (res == SD_QUERY_INVALID) ? k_resp_400 : k_resp_503;
+        c->seg_len[0] = (uint16_t)((res == SD_QUERY_INVALID) ? sizeof(k_resp_400) : sizeof(k_resp_503)) - 1U;
+        s_stats.bad_requests += (res == SD_QUERY_INVALID) ? 1U : 0U;
+        return;
+    }
+
+    c->seg[0] = k_resp_query;
+    c->seg_len[0] = sizeof(k_resp_query) - 1U;
+}
+
+/**
+ * @brief Define a resposta a partir da linha de requisição recebida.
+ */
+static void conn_route(http_conn_t *c)
+{
+    c->responded = true;
+    c->seg_idx = 0;
+    c->seg_off = 0;
+    c->seg_len[1] = 0;
+
+    if (strncmp(c->req, "GET /query", 10) == 0 && (c->req[10] == '?' || c->req[10] == ' '))
+    {
+        conn_route_query(c);
+        return;
+    }
+
+    const bool is_metrics = (strncmp(c->req, "GET /metrics", 12) == 0) &&
+                            (c->req[12] == ' ' || c->req[12] == '?' || c->req[12] == '\r');
+
+    if (!is_metrics)
+    {
+        s_stats.not_found++;
+        c->seg[0] = k_resp_404;
+        c->seg_len[0] = sizeof(k_resp_404) - 1U;
+        c->seg_len[1] = 0;
+        return;
+    }
+
+    const int8_t cur = s_current;
+
+    if (cur < 0)
+    {
+        c->seg[0] = k_resp_503;
+        c->seg_len[0] = sizeof(k_resp_503) - 1U;
+        c->seg_len[1] = 0;
+        return;
+    }
+
+    s_pages[cur].refs++;
+    c->page = cur;
+    c->seg[0] = s_pages[cur].head;
+    c->seg_len[0] = s_pages[cur].head_len;
+    c->seg[1] = s_pages[cur].body;
+    c->seg_len[1] = s_pages[cur].body_len;
+}
+
+/**
+ * @brief Callback de dados confirmados: continua o envio ou fecha.
+ */
+static err_t http_sent_cb(void *arg, struct tcp_pcb *pcb, u16_t len)
+{
+    (void)pcb;
+    http_conn_t *c = (http_conn_t *)arg;
+
+    c->unacked = (c->unacked > len) ? (c->unacked - len) : 0U;
+    c->idle_polls = 0;
+
+    if (c->streaming)
+    {
+        wake_stream_waiter();
+        return ERR_OK;
+    }
+
+    if (conn_send_more(c) && c->unacked == 0)
+    {
+        if (c->page >= 0)
+        {
+            s_stats.scrapes++;
+        }
+        return conn_close(c);
+    }
+
+    return ERR_OK;
+}
+
+/**
+ * @brief Callback de recepção: acumula a linha de requisição e responde.
+ */
+static err_t http_recv_cb(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
+{
+    http_conn_t *c = (http_conn_t *)arg;
+
+    if (!p)
+    {
+        return conn_close(c);
+    }
+
+    if (err != ERR_OK)
+    {
+        pbuf_free(p);
+        return err;
+    }
+
+    if (!c->responded)
+    {
+        const u16_t room = (u16_t)(sizeof(c->req) - 1U - c->req_len);
+        const u16_t n = pbuf_copy_partial(p, c->req + c->req_len, room, 0);
+        c->req_len = (uint8_t)(c->req_len + n);
+        c->req[c->req_len] = '\0';
+
+        if (strchr(c->req, '\n') || c->req_len >= sizeof(c->req) - 1U)
+        {
+            conn_route(c);
+            conn_send_more(c);
+        }
+    }
+
+    tcp_recved(pcb, p->tot_len);
+    pbuf_free(p);
+    return ERR_OK;
+}
+
+/**
+ * @brief Callback de erro: o PCB já foi liberado pelo lwIP.
+ */
+static void http_err_cb(void *arg, err_t err)
+{
+    (void)err;
+    http_conn_t *c = (http_conn_t *)arg;
+
+    if (c)
+    {
+        s_stats.aborted++;
+        conn_release(c);
+    }
+}
+
+/**
+ * @brief Callback periódico: retoma envios travados e derruba conexões ociosas.
+ */
+static err_t http_poll_cb(void *arg, struct tcp_pcb *pcb)
+{
+    http_conn_t *c = (http_conn_t *)arg;
+
+    if (!c)
+    {
+        tcp_abort(pcb);
+        return ERR_ABRT;
+    }
+
+    /* Com /query esperando o cartão, nada a enviar não é falta de progresso do cliente */
+    const bool waiting_sd = c->streaming && c->unacked == 0;
+    if (!waiting_sd && ++c->idle_polls > HTTP_IDLE_POLLS_MAX)
+    {
+        s_stats.aborted++;
+        tcp_arg(pcb, NULL);
+        tcp_err(pcb, NULL);
+        tcp_abort(pcb);
+        conn_release(c);
+        return ERR_ABRT;
+    }
+
+    if (c->responded)
+    {
+        conn_send_more(c);
+    }
+
+    if (c->streaming)
+    {
+        /* Sem bytes em voo não chega `sent`: a consulta tenta de novo a cada poll */
+        wake_stream_waiter();
+    }
+
+    return ERR_OK;
+}
+
+/**
+ * @brief Callback de nova conexão: aloca um slot estático.
+ */
+static err_t http_accept_cb(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+    (void)arg;
+
+    if (err != ERR_OK || !pcb)
+    {
+        return ERR_VAL;
+    }
+
+    http_conn_t *c = NULL;
+    for (size_t i = 0; i < HTTP_SERVER_MAX_CONNS; i++)
+    {
+        if (!s_conns[i].pcb)
+        {
+            c = &s_conns[i];
+            break;
+        }
+    }
+
+    if (!c)
+    {
+        s_stats.rejected++;
+        tcp_abort(pcb);
+        return ERR_ABRT;
+    }
+
+    memset(c, 0, sizeof(*c));
+    c->pcb = pcb;
+    c->page = -1;
+
+    if (s_open++ == 0)
+    {
+        wifi_manager_tx_hold(s_tx_client, true);
+    }
+
+    tcp_setprio(pcb, TCP_PRIO_MIN);
+    tcp_arg(pcb, c);
+    tcp_recv(pcb, http_recv_cb);
+    tcp_sent(pcb, http_sent_cb);
+    tcp_err(pcb, http_err_cb);
+    tcp_poll(pcb, http_poll_cb, HTTP_POLL_INTERVAL);
+    return ERR_OK;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Renderização (contexto da task)                                        */
+/* ---------------------------------------------------------------------- */
+
+/** @brief Emite "# HELP" e "# TYPE" de uma métrica. */
+static void put_meta(fmt_buf_t *b, const char *name, const char *type, const char *help)
+{
+    fmt_buf_str(b, "# HELP ");
+    fmt_buf_str(b, name);
+    fmt_buf_char(b, ' ');
+    fmt_buf_str(b, help);
+    fmt_buf_str(b, "\n# TYPE ");
+    fmt_buf_str(b, name);
+    fmt_buf_char(b, ' ');
+    fmt_buf_str(b, type);
+    fmt_buf_char(b, '\n');
+}
+
+/** @brief Emite nome e rótulo opcional `{key="val"}` seguidos de espaço. */
+static void put_name(fmt_buf_t *b, const char *name, const char *key, const char *val)
+{
+    fmt_buf_str(b, name);
+
+    if (key)
+    {
+        fmt_buf_char(b, '{');
+        fmt_buf_str(b, key);
+        fmt_buf_str(b, "=\"");
+        fmt_buf_str(b, val);
+        fmt_buf_str(b, "\"}");
+    }
+
+    fmt_buf_char(b, ' ');
+}
+
+/** @brief Amostra com valor decimal. */
+static void put_double(fmt_buf_t *b, const char *name, double v, uint8_t decimals)
+{
+    put_name(b, name, NULL, NULL);
+    fmt_buf_double(b, v, decimals);
+    fmt_buf_char(b, '\n');
+}
+
+/** @brief Amostra com valor inteiro sem sinal (com rótulo opcional). */
+static void put_u32(fmt_buf_t *b, const char *name, const char *key, const char *val, uint32_t v)
+{
+    put_name(b, name, key, val);
+    fmt_buf_u32(b, v);
+    fmt_buf_char(b, '\n');
+}
+
+/** @brief Métrica completa (meta + uma amostra inteira). */
+static void metric_u32(fmt_buf_t *b, const char *name, const char *type, const char *help, uint32_t v)
+{
+    put_meta(b, name, type, help);
+    put_u32(b, name, NULL, NULL, v);
+}
+
+/** @brief Métrica completa (meta + uma amostra decimal). */
+static void metric_double(fmt_buf_t *b, const char *name, const char *type, const char *help,
+                          double v, uint8_t decimals)
+{
+    put_meta(b, name, type, help);
+    put_double(b, name, v, decimals);
+}
+
+/**
+ * @brief Renderiza o corpo e o cabeçalho de uma página de métricas.
+ * @return true se coube inteira no buffer.
+ */
+static bool render_page(metrics_page_t *pg)
+{
+    fmt_buf_t b;
+    fmt_buf_init(&b, pg->body, sizeof(pg->body));
+
+    energy_monitor_data_t em;
+    if (energy_monitor_get_last(&em))
+    {
+        metric_double(&b, "energia_vrms_volts", "gauge", "Tensao RMS.", em.vrms, 2);
+        metric_double(&b, "energia_irms_amperes", "gauge", "Corrente RMS.", em.irms, 3);
+        metric_double(&b, "energia_voltage_pu", "gauge", "Tensao em PU (base 127 V).", em.v_pu, 4);
+        metric_double(&b, "energia_power_watts", "gauge", "Potencia.", em.p_instant, 1);
+        metric_double(&b, "energia_energy_watthours_total", "counter", "Energia desde o boot.", em.e_wh, 4);
+        metric_double(&b, "energia_sample_timestamp_seconds", "gauge", "Instante da amostra.",
+                      (double)em.t_unix_us / 1e6, 3);
+    }
+
+    const bool up = wifi_manager_is_connected();
+    metric_u32(&b, "wifi_connected", "gauge", "Wi-Fi com IP.", up ? 1U : 0U);
+    metric_u32(&b, "wifi_events_total", "counter", "Eventos de rede.",
+               wifi_manager_event_count());
+
+    wifi_manager_stats_t ws;
+    wifi_manager_get_stats(&ws);
+    metric_u32(&b, "wifi_fast_rejoin_ok_total", "counter", "Reassociacoes rapidas.", ws.fast_ok);
+    metric_u32(&b, "wifi_outage_last_ms", "gauge", "Ultima queda ate o IP.", ws.last_outage_ms);
+    metric_u32(&b, "wifi_connect_failures_total", "counter", "Conexoes falhas.", ws.failures);
+    metric_u32(&b, "wifi_connect_last_ms", "gauge", "Ultima conexao.", ws.last_attempt_ms);
+
+    wifi_pm_stats_t pm;
+    wifi_manager_get_pm_stats(&pm);
+    metric_double(&b, "wifi_radio_active_seconds_total", "counter", "Radio sem economia.",
+                  (double)pm.active_ms / 1000.0, 1);
+    metric_double(&b, "wifi_radio_save_seconds_total", "counter", "Radio em economia.",
+                  (double)pm.save_ms / 1000.0, 1);
+    metric_u32(&b, "wifi_pm_switches_total", "counter", "Trocas de modo do radio.", pm.switches);
+
+    int32_t rssi;
+    if (up && wifi_manager_get_rssi(&rssi))
+    {
+        put_meta(&b, "wifi_rssi_dbm", "gauge", "RSSI.");
+        put_name(&b, "wifi_rssi_dbm", NULL, NULL);
+        fmt_buf_i32(&b, rssi);
+        fmt_buf_char(&b, '\n');
+    }
+
+    time_sync_stats_t ts;
+    time_sync_get_stats(&ts);
+    metric_u32(&b, "time_synced", "gauge", "Relogio por NTP.", ts.synced ? 1U : 0U);
+    metric_u32(&b, "time_sync_samples_total", "counter", "Amostras NTP aceitas.", ts.samples);
+    metric_u32(&b, "time_sync_rejected_total", "counter", "Amostras NTP recusadas.",
+               ts.rejected);
+    metric_double(&b, "time_sync_offset_seconds", "gauge", "Offset NTP.",
+                  (double)ts.last_offset_us / 1e6, 6);
+    metric_double(&b, "time_sync_delay_seconds", "gauge", "Atraso NTP.",
+                  (double)ts.last_delay_us / 1e6, 6);
+    metric_double(&b, "time_sync_freq_ppm", "gauge", "Correcao do cristal.",
+                  (double)ts.freq_ppb / 1000.0, 3);
+
+    mqtt_publisher_stats_t mq;
+    mqtt_publisher_get_stats(&mq);
+    metric_u32(&b, "mqtt_connected", "gauge", "MQTT conectado.", mq.connected ? 1U : 0U);
+    metric_u32(&b, "mqtt_published_total", "counter", "Mensagens confirmadas.", mq.published);
+    metric_u32(&b, "mqtt_inflight", "gauge", "Mensagens em voo.", mq.inflight);
+
+    udp_stream_stats_t us;
+    udp_stream_get_stats(&us);
+    metric_u32(&b, "udp_stream_datagrams_total", "counter", "Datagramas de amostras.", us.datagrams);
+    metric_u32(&b, "udp_stream_samples_dropped_total", "counter", "Amostras nao enviadas.", us.dropped);
+    metric_u32(&b, "udp_stream_record_datagrams_total", "counter", "Datagramas de registros.",
+               us.record_datagrams);
+
+    sd_card_log_stats_t sd;
+    sd_card_log_get_stats(&sd);
+    metric_u32(&b, "sd_records_total", "counter", "Registros gravados.", sd.records);
+    metric_double(&b, "sd_record_max_seconds", "gauge", "Maior gravacao.",
+                  (double)sd.record_max_us / 1e6, 6);
+    metric_double(&b, "sd_record_seconds_total", "counter", "Tempo gravando.",
+                  (double)sd.record_total_us / 1e6, 6);
+    metric_u32(&b, "sd_syncs_total", "counter", "Chamadas de f_sync.", sd.writer.syncs);
+    metric_u32(&b, "sd_disk_writes_total", "counter", "Chamadas de disk_write.", sd.disk.writes);
+    metric_u32(&b, "sd_disk_sectors_written_total", "counter", "Setores gravados.",
+               sd.disk.write_sectors);
+    metric_double(&b, "sd_disk_write_max_seconds", "gauge", "Maior disk_write.",
+                  (double)sd.disk.write_max_us / 1e6, 6);
+    metric_double(&b, "sd_disk_write_seconds_total", "counter", "Tempo em disk_write.",
+                  (double)sd.disk.write_total_us / 1e6, 6);
+    metric_u32(&b, "sd_spi_hz", "gauge", "Relogio do SPI.", sd.disk.spi_hz);
+    metric_u32(&b, "sd_spi_downshifts_total", "counter", "Descidas do SPI.",
+               sd.disk.spi_downshifts);
+
+    logger_stats_t ls;
+    logger_get_stats(&ls);
+    metric_u32(&b, "log_messages_total", "counter", "Mensagens aceitas.", ls.messages);
+    metric_u32(&b, "log_dropped_total", "counter", "Mensagens descartadas.", ls.dropped);
+    metric_u32(&b, "log_truncated_total", "counter", "Mensagens truncadas.", ls.truncated);
+    metric_u32(&b, "log_ring_high_water_bytes", "gauge", "Maior ocupacao do anel.", ls.ring_high_water);
+    metric_double(&b, "log_call_max_seconds", "gauge", "Maior chamada de log.",
+                  (double)ls.call_max_us / 1e6, 6);
+    metric_double(&b, "log_call_seconds_total", "counter", "Tempo em chamadas de log.",
+                  (double)ls.call_total_us / 1e6, 6);
+#if LOGGER_TOKENIZED
+    metric_double(&b, "log_token_saved_cycles_per_call", "gauge",
+                  "Ciclos poupados por chamada.", (double)ls.token_saved_cycles, 0);
+#endif
+
+    static const struct
+    {
+        const char *name;
+        const char *type;
+        const char *help;
+    } k_sink_metrics[] = {
+        {"telemetry_sink_delivered_total", "counter", "Entregues."},
+        {"telemetry_sink_failed_total", "counter", "Falhas de entrega."},
+        {"telemetry_sink_dropped_total", "counter", "Descartados (fila cheia)."},
+        {"telemetry_sink_queued", "gauge", "Na fila."},
+        {"telemetry_sink_queued_max", "gauge", "Maior fila."},
+        {"telemetry_sink_healthy", "gauge", "Destino pronto."},
+    };
+
+    for (size_t m = 0; m < sizeof(k_sink_metrics) / sizeof(k_sink_metrics[0]); m++)
+    {
+        put_meta(&b, k_sink_metrics[m].name, k_sink_metrics[m].type, k_sink_metrics[m].help);
+
+        for (uint8_t i = 0; i < telemetry_sink_count(); i++)
+        {
+            telemetry_sink_stats_t ts;
+            (void)telemetry_get_sink_stats(i, &ts);
+            const uint32_t v[] = {ts.delivered, ts.failed, ts.dropped, ts.queued, ts.queued_max,
+                                  ts.healthy ? 1U : 0U};
+            put_u32(&b, k_sink_metrics[m].name, "sink", telemetry_sink_name(i), v[m]);
+        }
+    }
+
+    metric_u32(&b, "freertos_heap_free_bytes", "gauge", "Heap livre.", (uint32_t)xPortGetFreeHeapSize());
+    metric_u32(&b, "freertos_heap_min_free_bytes", "gauge", "Menor heap livre.",
+               (uint32_t)xPortGetMinimumEverFreeHeapSize());
+
+    metric_u32(&b, "freertos_tasks", "gauge", "Tasks.", (uint32_t)uxTaskGetNumberOfTasks());
+
+    /* Folgas do último instantâneo de `rtos_stats` (até RTOS_STATS_MAX_TASKS tasks) */
+    if (rtos_stats_get(&s_rtos))
+    {
+        put_meta(&b, "freertos_task_stack_free_words", "gauge", "Menor folga de stack (palavras).");
+        for (uint8_t i = 0; i < s_rtos.ntasks; i++)
+        {
+            put_u32(&b, "freertos_task_stack_free_words", "task", s_rtos.tasks[i].name,
+                    s_rtos.tasks[i].stack_free_min);
+        }
+    }
+
+    metric_u32(&b, "http_scrapes_total", "counter", "Respostas /metrics.", s_stats.scrapes);
+    metric_u32(&b, "http_queries_total", "counter", "Respostas /query.", s_stats.queries);
+    metric_u32(&b, "uptime_seconds", "counter", "Tempo desde o boot.",
+               (uint32_t)(time_us_64() / 1000000U));
+
+    if (b.overflow)
+    {
+        return false;
+    }
+
+    pg->body_len = (uint16_t)b.len;
+
+    fmt_buf_init(&b, pg->head, sizeof(pg->head));
+    fmt_buf_str(&b, "HTTP/1.1 200 OK\r\n"
+                    "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                    "Content-Length: ");
+    fmt_buf_u32(&b, pg->body_len);
+    fmt_buf_str(&b, "\r\nConnection: close\r\n\r\n");
+    pg->head_len = (uint16_t)b.len;
+    return !b.overflow;
+}
+
+/**
+ * @brief Renderiza em uma página livre e a publica como corrente.
+ */
+static void render_metrics(void)
+{
+    int8_t idx = -1;
+
+    taskENTER_CRITICAL();
+    for (int8_t i = 0; i < (int8_t)HTTP_METRICS_PAGES; i++)
+    {
+        if (i != s_current && s_pages[i].refs == 0)
+        {
+            idx = i;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if (idx < 0)
+    {
+        s_stats.render_skips++;
+        return;
+    }
+
+    if (!render_page(&s_pages[idx]))
+    {
+        LOGW(TAG, "Métricas excedem HTTP_METRICS_PAGE_SIZE (%u); página mantida.",
+             (unsigned)HTTP_METRICS_PAGE_SIZE);
+        return;
+    }
+
+    taskENTER_CRITICAL();
+    s_current = idx;
+    taskEXIT_CRITICAL();
+    s_stats.renders++;
+}
+
+/**
+ * @brief Abre o socket de escuta.
+ * @return true em sucesso.
+ */
+static bool http_listen(void)
+{
+    cyw43_arch_lwip_begin();
+    struct tcp_pcb *pcb = tcp_new_ip_type(IPADDR_TYPE_ANY);
+    bool ok = false;
+
+    if (pcb && tcp_bind(pcb, IP_ANY_TYPE, HTTP_SERVER_PORT) == ERR_OK)
+    {
+        s_listen = tcp_listen_with_backlog(pcb, HTTP_SERVER_MAX_CONNS);
+        if (s_listen)
+        {
+            tcp_accept(s_listen, http_accept_cb);
+            ok = true;
+        }
+    }
+
+    if (!ok && pcb && !s_listen)
+    {
+        tcp_abort(pcb);
+    }
+    cyw43_arch_lwip_end();
+
+    return ok;
+}
+
+/**
+ * @brief Copia os contadores do servidor.
+ * @param[out] out Destino.
+ */
+void http_server_get_stats(http_server_stats_t *out)
+{
+    if (out)
+    {
+        *out = s_stats;
+    }
+}
+
+/**
+ * @brief Task do servidor HTTP: escuta na porta e renderiza /metrics periodicamente (/query roda em `sd_query_task`).
+ * @param params Não utilizado.
+ */
+void http_server_task(void *params)
+{
+    (void)params;
+
+    for (size_t i = 0; i < HTTP_SERVER_MAX_CONNS; i++)
+    {
+        s_conns[i].page = -1;
+    }
+
+    s_tx_client = wifi_manager_tx_register("http");
+
+    while (!http_listen())
+    {
+        LOGW(TAG, "Falha ao abrir porta %u; nova tentativa em 5 s.", (unsigned)HTTP_SERVER_PORT);
+        vTaskDelay(pdMS_TO_TICKS(5000));
+    }
+
+    LOG(TAG, "Servidor HTTP na porta %u (GET /metrics, GET /query).", (unsigned)HTTP_SERVER_PORT);
+
+    TickType_t last = xTaskGetTickCount();
+
+    for (;;)
+    {
+        render_metrics();
+        vTaskDelayUntil(&last, pdMS_TO_TICKS(HTTP_METRICS_RENDER_MS));
+    }
+}
@@ -0,0 +1,33 @@
+/**
+ * @file http_server.h
+ * @brief Servidor HTTP do dispositivo (TCP bruto lwIP) com endpoint Prometheus e consulta ao histórico do SD.
+ */
+
+#ifndef HTTP_SERVER_H
+#define HTTP_SERVER_H
+
+#include <stdint.h>
+
+#define HTTP_SERVER_PORT            80U     /**< Porta TCP do servidor. */
+#define HTTP_SERVER_MAX_CONNS       4U      /**< Conexões simultâneas atendidas. */
+#define HTTP_METRICS_PAGE_SIZE      10240U  /**< Corpo de /metrics: pior caso ~10,1 kB (6 sinks, 24 tasks, valores na largura máxima). */
+#define HTTP_METRICS_RENDER_MS      1000U   /**< Período de renderização das métricas. */
+#define HTTP_QUERY_WAIT_MS          10000U  /**< Espera máxima por espaço no envio de /query. */
+
+/** @brief Contadores do servidor. */
+typedef struct
+{
+    uint32_t scrapes;       /**< Respostas /metrics concluídas. */
+    uint32_t queries;       /**< Respostas /query concluídas. */
+    uint32_t bad_requests;  /**< Requisições /query com parâmetros inválidos. */
+    uint32_t not_found;     /**< Requisições para caminhos desconhecidos. */
+    uint32_t rejected;      /**< Conexões recusadas por falta de slot. */
+    uint32_t aborted;       /**< Conexões abortadas (erro/timeout). */
+    uint32_t renders;       /**< Páginas de métricas renderizadas. */
+    uint32_t render_skips;  /**< Renderizações adiadas (todas as páginas em uso). */
+} http_server_stats_t;
+
+void http_server_get_stats(http_server_stats_t *out);
+void http_server_task(void *params);
+
+#endif /* HTTP_SERVER_H */
@@ -0,0 +1,144 @@
+/**
+ * @file log_ring.c
+ * @brief Anel de mensagens de log de tamanho variável (vários produtores, um consumidor).
+ * @details
+ *  `head` e `tail` só crescem (aritmética módulo 2^32); a posição no buffer é
+ *  o valor mascarado por `size - 1`. A ocupação é `head - tail`. O consumidor
+ *  é o único que escreve `tail`, e os produtores só o leem (palavra de 32
+ *  bits, leitura atômica no Cortex‑M0+ e no host).
+ */
+
+#include "lib/log_ring.h"
+#include <string.h>
+
+/** @brief Barreira de memória: o texto fica visível antes do estado/índice que o publica. */
+#define LOG_RING_BARRIER()  __sync_synchronize()
+
+static uint32_t align_up(uint32_t n)
+{
+    return (n + LOG_RING_ALIGN - 1U) & ~(LOG_RING_ALIGN - 1U);
+}
+
+static log_ring_entry_t *entry_at(const log_ring_t *r, uint32_t pos)
+{
+    return (log_ring_entry_t *)(void *)&r->buf[pos & (r->size - 1U)];
+}
+
+/**
+ * @brief Prepara o anel sobre `buf`.
+ * @param size Capacidade em bytes (potência de 2, no mínimo 4 cabeçalhos).
+ * @return false se `size` ou o alinhamento de `buf` forem inválidos.
+ */
+bool log_ring_init(log_ring_t *r, void *buf, uint32_t size)
+{
+    if (!r || !buf || (size & (size - 1U)) != 0U || size < 4U * sizeof(log_ring_entry_t) ||
+        ((uintptr_t)buf & (LOG_RING_ALIGN - 1U)) != 0U)
+    {
+        return false;
+    }
+
+    memset(r, 0, sizeof(*r));
+    r->buf = (uint8_t *)buf;
+    r->size = size;
+    return true;
+}
+
+/**
+ * @brief Reserva espaço para uma mensagem de `len` bytes.
+ * @return Entrada em estado `LOG_RING_RESERVED`, ou NULL se o anel estiver cheio.
+ * @note Deve ser serializada entre produtores (seção crítica curta); o
+ *       preenchimento e `log_ring_commit` ficam fora dela.
+ */
+log_ring_entry_t *log_ring_reserve(log_ring_t *r, uint16_t len)
+{
+    const uint32_t need = align_up((uint32_t)sizeof(log_ring_entry_t) + len);
+    const uint32_t head = r->head;
+    const uint32_t used = head - r->tail;
+    const uint32_t contig = r->size - (head & (r->size - 1U));
+    const uint32_t pad = (need > contig) ? contig : 0U;
+
+    if (need > log_ring_max_len(r->size) + sizeof(log_ring_entry_t) || used + pad + need > r->size)
+    {
+        return NULL;
+    }
+
+    if (pad)
+    {
+        /* Sobra no fim do buffer: sempre comporta state/size (múltiplo de 8 bytes). */
+        log_ring_entry_t *p = entry_at(r, head);
+        p->size = (uint16_t)pad;
+        p->state = LOG_RING_PAD;
+    }
+
+    log_ring_entry_t *e = entry_at(r, head + pad);
+    e->state = LOG_RING_RESERVED;
+    e->size = (uint16_t)need;
+    e->len = len;
+    e->flags = 0;
+
+    LOG_RING_BARRIER();
+    r->head = head + pad + need;
+
+    if (used + pad + need > r->high_water)
+    {
+        r->high_water = used + pad + need;
+    }
+
+    return e;
+}
+
+/**
+ * @brief Publica uma entrada preenchida para o consumidor.
+ */
+void log_ring_commit(log_ring_entry_t *e)
+{
+    LOG_RING_BARRIER();
+    e->state = LOG_RING_COMMITTED;
+}
+
+/**
+ * @brief Próxima entrada publicada (somente o consumidor).
+ * @return Entrada, ou NULL se o anel estiver vazio ou a mais antiga ainda estiver reservada.
+ */
+log_ring_entry_t *log_ring_peek(log_ring_t *r)
+{
+    for (;;)
+    {
+        const uint32_t tail = r->tail;
+
+        if (tail == r->head)
+        {
+            return NULL;
+        }
+
+        log_ring_entry_t *e = entry_at(r, tail);
+        const uint8_t state = e->state;
+        LOG_RING_BARRIER();
+
+        if (state == LOG_RING_PAD)
+        {
+            r->tail = tail + e->size;
+            continue;
+        }
+
+        return (state == LOG_RING_COMMITTED) ? e : NULL;
+    }
+}
+
+/**
+ * @brief Devolve ao anel a entrada obtida por `log_ring_peek` (somente o consumidor).
+ */
+void log_ring_release(log_ring_t *r, const log_ring_entry_t *e)
+{
+    const uint32_t size = e->size;
+    LOG_RING_BARRIER();
+    r->tail += size;
+}
+
+/**
+ * @brief Bytes ocupados no momento.
+ */
+uint32_t log_ring_used(const log_ring_t *r)
+{
+    return r->head - r->tail;
+}
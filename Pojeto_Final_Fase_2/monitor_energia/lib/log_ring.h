@@ -0,0 +1,74 @@
+/**
+ * @file log_ring.h
+ * @brief Anel de mensagens de log de tamanho variável (vários produtores, um consumidor).
+ * @details
+ *  Não depende do SDK nem do FreeRTOS (também compila no host). Cada
+ *  mensagem ocupa um trecho contíguo do anel: cabeçalho `log_ring_entry_t`
+ *  seguido do texto, alinhado a 8 bytes. Quando o fim do buffer não comporta
+ *  a mensagem, o resto é marcado como enchimento e ela começa no início.
+ *
+ *  Só `log_ring_reserve` precisa de exclusão mútua entre produtores (avança
+ *  `head`); o chamador a envolve numa seção crítica curta. O texto é copiado
+ *  fora dela e a entrada é publicada por `log_ring_commit`. O consumidor lê
+ *  em ordem e para na primeira entrada ainda não publicada, de modo que um
+ *  produtor lento só atrasa as mensagens posteriores a ele.
+ */
+
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define LOG_RING_ALIGN      8U      /**< Alinhamento das entradas no anel. */
+
+/** @brief Estado de uma entrada. */
+typedef enum
+{
+    LOG_RING_RESERVED = 0,      /**< Reservada; o produtor ainda copia o texto. */
+    LOG_RING_COMMITTED,         /**< Pronta para o consumidor. */
+    LOG_RING_PAD,               /**< Enchimento até o fim do buffer. */
+} log_ring_state_t;
+
+/** @brief Cabeçalho de uma entrada (o texto vem logo depois, sem terminador). */
+typedef struct
+{
+    volatile uint8_t state;     /**< `log_ring_state_t`. */
+    uint8_t flags;              /**< Livre para o usuário do anel. */
+    uint16_t size;              /**< Bytes ocupados no anel (cabeçalho + texto + alinhamento). */
+    uint16_t len;               /**< Bytes de texto. */
+    uint64_t t_us;              /**< Instante da mensagem (relógio monotônico do chamador). */
+    const char *tag;            /**< Tag do módulo (cadeia estática). */
+} log_ring_entry_t;
+
+/** @brief Anel; `size` deve ser potência de 2. */
+typedef struct
+{
+    uint8_t *buf;               /**< Área de dados (alinhada a 8 bytes). */
+    uint32_t size;              /**< Capacidade em bytes. */
+    volatile uint32_t head;     /**< Próximo byte a reservar (cresce sem dar a volta). */
+    volatile uint32_t tail;     /**< Próximo byte a consumir. */
+    uint32_t high_water;        /**< Maior ocupação observada. */
+} log_ring_t;
+
+bool log_ring_init(log_ring_t *r, void *buf, uint32_t size);
+log_ring_entry_t *log_ring_reserve(log_ring_t *r, uint16_t len);
+void log_ring_commit(log_ring_entry_t *e);
+log_ring_entry_t *log_ring_peek(log_ring_t *r);
+void log_ring_release(log_ring_t *r, const log_ring_entry_t *e);
+uint32_t log_ring_used(const log_ring_t *r);
+
+/** @brief Texto de uma entrada. */
+static inline char *log_ring_text(log_ring_entry_t *e)
+{
+    return (char *)(e + 1);
+}
+
+/** @brief Maior texto que cabe numa entrada de um anel de `size` bytes. */
+static inline uint32_t log_ring_max_len(uint32_t size)
+{
+    return size / 2U - (uint32_t)sizeof(log_ring_entry_t);
+}
+
+#endif /* LOG_RING_H */
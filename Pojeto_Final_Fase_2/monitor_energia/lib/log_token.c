@@ -0,0 +1,602 @@
+/**
+ * @file log_token.c
+ * @brief Log tokenizado: empacota argumentos pelo formato e os renderiza no host.
+ * @details
+ *  `log_token_pack` percorre o formato só para saber o tipo de cada
+ *  argumento (sem converter números em texto) e os grava como descrito em
+ *  `log_token.h`. `log_token_render` faz o caminho inverso com `snprintf`,
+ *  uma conversão por vez; é usado pelo decodificador do host.
+ */
+
+#include "lib/log_token.h"
+#include <stdio.h>
+#include <string.h>
+
+/** @brief Modificador de tamanho de uma conversão. */
+typedef enum
+{
+    MOD_NONE = 0,
+    MOD_HH,
+    MOD_H,
+    MOD_L,
+    MOD_LL,
+    MOD_J,
+    MOD_Z,
+    MOD_T,
+    MOD_BIG_L,
+} len_mod_t;
+
+/** @brief Conversão `%...` decomposta. */
+typedef struct
+{
+    const char *start;      /**< O '%'. */
+    const char *end;        /**< Primeiro caractere após a conversão. */
+    const char *flags;      /**< Flags (`-+ #0`). */
+    size_t flags_len;
+    const char *width;      /**< Dígitos da largura (se não for `*`). */
+    size_t width_len;
+    const char *prec;       /**< Dígitos da precisão (se não for `*`). */
+    size_t prec_len;
+    bool has_prec;
+    bool star_width;
+    bool star_prec;
+    len_mod_t mod;
+    char conv;
+} spec_t;
+
+/**
+ * @brief Localiza e decompõe a próxima conversão a partir de `p`.
+ * @return false se não houver mais conversões completas.
+ */
+static bool next_spec(const char *p, spec_t *s)
+{
+    p = strchr(p, '%');
+    if (!p)
+    {
+        return false;
+    }
+
+    memset(s, 0, sizeof(*s));
+    s->start = p++;
+
+    s->flags = p;
+    while (*p && strchr("-+ #0", *p))
+    {
+        p++;
+    }
+    s->flags_len = (size_t)(p - s->flags);
+
+    if (*p == '*')
+    {
+        s->star_width = true;
+        p++;
+    }
+    else
+    {
+        s->width = p;
+        while (*p >= '0' && *p <= '9')
+        {
+            p++;
+        }
+        s->width_len = (size_t)(p - s->width);
+    }
+
+    if (*p == '.')
+    {
+        s->has_prec = true;
+        p++;
+
+        if (*p == '*')
+        {
+            s->star_prec = true;
+            p++;
+        }
+        else
+        {
+            s->prec = p;
+            while (*p >= '0' && *p <= '9')
+            {
+                p++;
+            }
+            s->prec_len = (size_t)(p - s->prec);
+        }
+    }
+
+    switch (*p)
+    {
+    case 'h':
+        s->mod = (p[1] == 'h') ? MOD_HH : MOD_H;
+        p += (p[1] == 'h') ? 2 : 1;
+        break;
+    case 'l':
+        s->mod = (p[1] == 'l') ? MOD_LL : MOD_L;
+        p += (p[1] == 'l') ? 2 : 1;
+        break;
+    case 'j':
+        s->mod = MOD_J;
+        p++;
+        break;
+    case 'z':
+        s->mod = MOD_Z;
+        p++;
+        break;
+    case 't':
+        s->mod = MOD_T;
+        p++;
+        break;
+    case 'L':
+        s->mod = MOD_BIG_L;
+        p++;
+        break;
+    default:
+        break;
+    }
+
+    if (*p == '\0')
+    {
+        return false;
+    }
+
+    s->conv = *p;
+    s->end = p + 1;
+    return true;
+}
+
+static bool is_float_conv(char c)
+{
+    return c && strchr("fFeEgGaA", c) != NULL;
+}
+
+static bool is_int_conv(char c)
+{
+    return c && strchr("diuxXoc", c) != NULL;
+}
+
+static uint64_t zigzag(int64_t v)
+{
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static int64_t unzigzag(uint64_t v)
+{
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1U);
+}
+
+/**
+ * @brief Grava `v` em LEB128.
+ * @return Bytes escritos, ou 0 se não couber.
+ */
+size_t log_token_put_varint(uint8_t *out, size_t size, uint64_t v)
+{
+    size_t n = 0;
+
+    do
+    {
+        if (n >= size)
+        {
+            return 0;
+        }
+        out[n++] = (uint8_t)((v & 0x7FU) | (v >= 0x80U ? 0x80U : 0U));
+        v >>= 7;
+    } while (v);
+
+    return n;
+}
+
+/**
+ * @brief Lê um LEB128.
+ * @return Bytes consumidos, ou 0 se `in` terminar antes do fim do número.
+ */
+size_t log_token_get_varint(const uint8_t *in, size_t len, uint64_t *v)
+{
+    uint64_t r = 0;
+
+    for (size_t n = 0; n < len && n < 10U; n++)
+    {
+        r |= (uint64_t)(in[n] & 0x7FU) << (7U * n);
+
+        if (!(in[n] & 0x80U))
+        {
+            *v = r;
+            return n + 1U;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Empacota os argumentos de `ap` segundo as conversões de `fmt`.
+ * @param[out] truncated Algum argumento não coube (os seguintes são omitidos).
+ * @return Bytes escritos em `out` (só argumentos completos).
+ */
+size_t log_token_pack(uint8_t *out, size_t size, const char *fmt, va_list ap, bool *truncated)
+{
+    size_t len = 0;
+    spec_t s;
+
+    *truncated = false;
+
+    for (const char *p = fmt; next_spec(p, &s); p = s.end)
+    {
+        const size_t mark = len;
+        size_t n = 1;
+
+        if (s.star_width && n)
+        {
+            n = log_token_put_varint(&out[len], size - len, zigzag(va_arg(ap, int)));
+            len += n;
+        }
+
+        if (s.star_prec && n)
+        {
+            n = log_token_put_varint(&out[len], size - len, zigzag(va_arg(ap, int)));
+            len += n;
+        }
+
+        if (!n)
+        {
+            *truncated = true;
+            return mark;
+        }
+
+        if (s.conv == 'd' || s.conv == 'i')
+        {
+            int64_t v;
+            switch (s.mod)
+            {
+            case MOD_LL:
+            case MOD_J:
+                v = (int64_t)va_arg(ap, long long);
+                break;
+            case MOD_L:
+                v = (int64_t)va_arg(ap, long);
+                break;
+            case MOD_Z:
+            case MOD_T:
+                v = (int64_t)va_arg(ap, ptrdiff_t);
+                break;
+            default:
+                v = (int64_t)va_arg(ap, int);
+                break;
+            }
+            n = log_token_put_varint(&out[len], size - len, zigzag(v));
+        }
+        else if (is_int_conv(s.conv))
+        {
+            uint64_t v;
+            switch (s.mod)
+            {
+            case MOD_LL:
+            case MOD_J:
+                v = (uint64_t)va_arg(ap, unsigned long long);
+                break;
+            case MOD_L:
+                v = (uint64_t)va_arg(ap, unsigned long);
+                break;
+            case MOD_Z:
+            case MOD_T:
+                v = (uint64_t)va_arg(ap, size_t);
+                break;
+            default:
+                v = (uint64_t)va_arg(ap, unsigned int);
+                break;
+            }
+            n = log_token_put_varint(&out[len], size - len, v);
+        }
+        else if (s.conv == 'p')
+        {
+            n = log_token_put_varint(&out[len], size - len, (uint64_t)(uintptr_t)va_arg(ap, void *));
+        }
+        else if (is_float_conv(s.conv))
+        {
+            const double v = (s.mod == MOD_BIG_L) ? (double)va_arg(ap, long double) : va_arg(ap, double);
+
+            n = 0;
+            if (size - len >= sizeof(v))
+            {
+                memcpy(&out[len], &v, sizeof(v));
+                n = sizeof(v);
+            }
+        }
+        else if (s.conv == 's')
+        {
+            const char *str = va_arg(ap, const char *);
+            str = str ? str : "(null)";
+            size_t sl = 0;
+
+            while (sl < LOG_TOKEN_STR_MAX && str[sl])
+            {
+                sl++;
+            }
+
+            n = log_token_put_varint(&out[len], size - len, sl);
+            if (n && size - len - n >= sl)
+            {
+                memcpy(&out[len + n], str, sl);
+                n += sl;
+            }
+            else
+            {
+                n = 0;
+            }
+        }
+        else if (s.conv == 'n')
+        {
+            (void)va_arg(ap, void *);
+        }
+        else if (s.conv != '%')
+        {
+            /* Conversão desconhecida: os tipos seguintes não podem ser inferidos. */
+            *truncated = true;
+            return mark;
+        }
+
+        if (!n)
+        {
+            *truncated = true;
+            return mark;
+        }
+
+        len += (s.conv == '%' || s.conv == 'n') ? 0U : n;
+    }
+
+    return len;
+}
+
+/** @brief Acrescenta `n` bytes de `src` ao texto de saída (com truncamento). */
+static void out_append(char *out, size_t size, size_t *pos, const char *src, size_t n)
+{
+    for (size_t i = 0; i < n; i++, (*pos)++)
+    {
+        if (*pos + 1U < size)
+        {
+            out[*pos] = src[i];
+        }
+    }
+}
+
+/**
+ * @brief Remonta a conversão com larguras `*` resolvidas e o modificador indicado.
+ */
+static void build_spec(char *dst, size_t size, const spec_t *s, int64_t w, int64_t p, const char *mod)
+{
+    char wbuf[24] = "";
+    char pbuf[24] = "";
+
+    if (s->star_width)
+    {
+        snprintf(wbuf, sizeof(wbuf), "%lld", (long long)w);
+    }
+    else
+    {
+        snprintf(wbuf, sizeof(wbuf), "%.*s", (int)s->width_len, s->width);
+    }
+
+    if (s->has_prec)
+    {
+        if (s->star_prec)
+        {
+            snprintf(pbuf, sizeof(pbuf), ".%lld", (long long)(p < 0 ? 0 : p));
+        }
+        else
+        {
+            snprintf(pbuf, sizeof(pbuf), ".%.*s", (int)s->prec_len, s->prec);
+        }
+    }
+
+    snprintf(dst, size, "%%%.*s%s%s%s%c", (int)s->flags_len, s->flags, wbuf, pbuf, mod, s->conv);
+}
+
+/**
+ * @brief Monta o texto de `fmt` com os argumentos empacotados por `log_token_pack`.
+ * @return Comprimento do texto (truncado em `size - 1`, sempre terminado em NUL).
+ * @note Argumentos ausentes aparecem como "<?>".
+ */
+size_t log_token_render(char *out, size_t size, const char *fmt, const uint8_t *args, size_t len)
+{
+    size_t pos = 0;
+    size_t rd = 0;
+    bool missing = false;
+    const char *p = fmt;
+    spec_t s;
+
+    while (next_spec(p, &s))
+    {
+        out_append(out, size, &pos, p, (size_t)(s.start - p));
+        p = s.end;
+
+        if (s.conv == '%')
+        {
+            out_append(out, size, &pos, "%", 1);
+            continue;
+        }
+        if (s.conv == 'n')
+        {
+            continue;
+        }
+
+        char spec[48];
+        char tmp[128];
+        int64_t w = 0;
+        int64_t pr = 0;
+        uint64_t u = 0;
+        size_t n;
+        int tl = -1;
+
+        if (!missing && s.star_width)
+        {
+            n = log_token_get_varint(&args[rd], len - rd, &u);
+            missing = (n == 0);
+            rd += n;
+            w = unzigzag(u);
+        }
+        if (!missing && s.star_prec)
+        {
+            n = log_token_get_varint(&args[rd], len - rd, &u);
+            missing = (n == 0);
+            rd += n;
+            pr = unzigzag(u);
+        }
+
+        if (!missing && (s.conv == 'd' || s.conv == 'i'))
+        {
+            n = log_token_get_varint(&args[rd], len - rd, &u);
+            missing = (n == 0);
+            rd += n;
+            build_spec(spec, sizeof(spec), &s, w, pr, "ll");
+            tl = missing ? -1 : snprintf(tmp, sizeof(tmp), spec, (long long)unzigzag(u));
+        }
+        else if (!missing && (is_int_conv(s.conv) || s.conv == 'p'))
+        {
+            n = log_token_get_varint(&args[rd], len - rd, &u);
+            missing = (n == 0);
+            rd += n;
+
+            if (s.conv == 'c')
+            {
+                build_spec(spec, sizeof(spec), &s, w, pr, "");
+                tl = missing ? -1 : snprintf(tmp, sizeof(tmp), spec, (int)u);
+            }
+            else if (s.conv == 'p')
+            {
+                tl = missing ? -1 : snprintf(tmp, sizeof(tmp), "0x%llx", (unsigned long long)u);
+            }
+            else
+            {
+                build_spec(spec, sizeof(spec), &s, w, pr, "ll");
+                tl = missing ? -1 : snprintf(tmp, sizeof(tmp), spec, (unsigned long long)u);
+            }
+        }
+        else if (!missing && is_float_conv(s.conv))
+        {
+            double v = 0.0;
+            missing = (len - rd < sizeof(v));
+
+            if (!missing)
+            {
+                memcpy(&v, &args[rd], sizeof(v));
+                rd += sizeof(v);
+                build_spec(spec, sizeof(spec), &s, w, pr, "");
+                tl = snprintf(tmp, sizeof(tmp), spec, v);
+            }
+        }
+        else if (!missing && s.conv == 's')
+        {
+            n = log_token_get_varint(&args[rd], len - rd, &u);
+            missing = (n == 0 || len - rd - n < u);
+
+            if (!missing)
+            {
+                char str[LOG_TOKEN_STR_MAX + 1U];
+                const size_t sl = (u > LOG_TOKEN_STR_MAX) ? LOG_TOKEN_STR_MAX : (size_t)u;
+                memcpy(str, &args[rd + n], sl);
+                str[sl] = '\0';
+                rd += n + (size_t)u;
+                build_spec(spec, sizeof(spec), &s, w, pr, "");
+                tl = snprintf(tmp, sizeof(tmp), spec, str);
+            }
+        }
+        else
+        {
+            missing = true;
+        }
+
+        if (missing || tl < 0)
+        {
+            out_append(out, size, &pos, "<?>", 3);
+        }
+        else
+        {
+            out_append(out, size, &pos, tmp, ((size_t)tl < sizeof(tmp)) ? (size_t)tl : sizeof(tmp) - 1U);
+        }
+    }
+
+    out_append(out, size, &pos, p, strlen(p));
+
+    if (size)
+    {
+        out[(pos < size) ? pos : size - 1U] = '\0';
+    }
+
+    return (pos < size) ? pos : (size ? size - 1U : 0U);
+}
+
+/**
+ * @brief Codifica `in` em COBS (sem bytes 0x00 na saída).
+ * @return Bytes escritos, ou 0 se não couber.
+ */
+size_t log_token_cobs_encode(const uint8_t *in, size_t len, uint8_t *out, size_t size)
+{
+    if (size < log_token_cobs_max(len))
+    {
+        return 0;
+    }
+
+    size_t code_pos = 0;
+    size_t o = 1;
+    uint8_t code = 1;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        if (in[i] == 0U)
+        {
+            out[code_pos] = code;
+            code_pos = o++;
+            code = 1;
+            continue;
+        }
+
+        out[o++] = in[i];
+
+        if (++code == 0xFFU)
+        {
+            out[code_pos] = code;
+            code_pos = o++;
+            code = 1;
+        }
+    }
+
+    out[code_pos] = code;
+    return o;
+}
+
+/**
+ * @brief Decodifica um quadro COBS (sem os delimitadores).
+ * @return Bytes decodificados, ou 0 se o quadro for inválido ou não couber.
+ */
+size_t log_token_cobs_decode(const uint8_t *in, size_t len, uint8_t *out, size_t size)
+{
+    size_t o = 0;
+    size_t i = 0;
+
+    while (i < len)
+    {
+        const uint8_t code = in[i++];
+
+        if (code == 0U || i + code - 1U > len)
+        {
+            return 0;
+        }
+
+        for (uint8_t k = 1; k < code; k++)
+        {
+            if (o >= size)
+            {
+                return 0;
+            }
+            out[o++] = in[i++];
+        }
+
+        if (code != 0xFFU && i < len)
+        {
+            if (o >= size)
+            {
+                return 0;
+            }
+            out[o++] = 0U;
+        }
+    }
+
+    return o;
+}
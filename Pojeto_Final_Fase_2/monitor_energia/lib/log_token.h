@@ -0,0 +1,56 @@
+/**
+ * @file log_token.h
+ * @brief Log tokenizado: formato por ID e argumentos brutos (firmware e host).
+ * @details
+ *  Com `LOGGER_TOKENIZED`, cada `LOG(TAG, fmt, ...)` guarda a cadeia
+ *  `TAG "\x1f" fmt` na seção `log_fmt` do ELF e envia só o deslocamento dela
+ *  na seção (ID) e os argumentos, sem formatar texto no Pico. O host lê a
+ *  seção do ELF (`tools/log_decode.c`) e monta as linhas.
+ *
+ *  Argumentos, na ordem das conversões do formato:
+ *   - inteiros (`d i` com zigzag; `u x X o c p` sem sinal) e larguras/
+ *     precisões `*`: varint LEB128, independente do tamanho do tipo;
+ *   - `f F e E g G a A`: double IEEE‑754 (8 bytes, little-endian);
+ *   - `s`: varint com o comprimento (até `LOG_TOKEN_STR_MAX`) e os bytes.
+ *
+ *  Quadro (antes do COBS): tipo (u8), t_unix_us (i64 LE) e o corpo. Para
+ *  `LOG_TOKEN_FRAME_MSG` o corpo é o ID (varint) e os argumentos; para
+ *  `LOG_TOKEN_FRAME_DROPPED`, a quantidade descartada (varint). No fio cada
+ *  quadro vai codificado em COBS entre dois bytes 0x00, o que permite
+ *  separá-lo de texto comum (stdio do SDK) no mesmo canal.
+ */
+
+#ifndef LOG_TOKEN_H
+#define LOG_TOKEN_H
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define LOG_TOKEN_SECTION       "log_fmt"   /**< Seção do ELF com as cadeias `TAG "\x1f" fmt`. */
+#define LOG_TOKEN_TAG_SEP       '\x1f'      /**< Separador entre tag e formato. */
+#define LOG_TOKEN_STR_MAX       48U         /**< Bytes copiados de cada argumento `%s`. */
+#define LOG_TOKEN_FRAME_HDR     9U          /**< Tipo + t_unix_us. */
+
+/** @brief Tipos de quadro. */
+typedef enum
+{
+    LOG_TOKEN_FRAME_MSG = 1,        /**< Mensagem tokenizada. */
+    LOG_TOKEN_FRAME_DROPPED = 2,    /**< Mensagens descartadas (anel cheio). */
+} log_token_frame_t;
+
+size_t log_token_put_varint(uint8_t *out, size_t size, uint64_t v);
+size_t log_token_get_varint(const uint8_t *in, size_t len, uint64_t *v);
+size_t log_token_pack(uint8_t *out, size_t size, const char *fmt, va_list ap, bool *truncated);
+size_t log_token_render(char *out, size_t size, const char *fmt, const uint8_t *args, size_t len);
+size_t log_token_cobs_encode(const uint8_t *in, size_t len, uint8_t *out, size_t size);
+size_t log_token_cobs_decode(const uint8_t *in, size_t len, uint8_t *out, size_t size);
+
+/** @brief Pior tamanho COBS de `len` bytes (sem os delimitadores). */
+static inline size_t log_token_cobs_max(size_t len)
+{
+    return len + len / 254U + 1U;
+}
+
+#endif /* LOG_TOKEN_H */
@@ -1,19 +1,86 @@
 /**
  * @file logger.c
- * @brief Logger simples com timestamp e mutex opcional (FreeRTOS).
+ * @brief Logger assíncrono: anel de mensagens e task de escoamento (FreeRTOS).
  * @details
- *  Encapsula `printf` com marcação de tempo (RTC) e proteção por mutex.
+ *  `logger_log` só formata o texto na pilha do chamador, reserva espaço no
+ *  anel (`lib/log_ring`) numa seção crítica de poucas instruções e copia a
+ *  mensagem; nunca espera pelo USB. O instante é capturado na chamada
+ *  (`time_us_64`) e convertido para data/hora (relógio de `time_sync`) só
+ *  na `logger_task`, que monta as linhas e as entrega ao stdio e aos
+ *  destinos registrados com `logger_add_sink`.
+ *
+ *  Com o anel cheio a mensagem nova é descartada e contada (política
+ *  `LOGGER_BLOCK_MS` = 0); a task avisa quantas se perderam assim que
+ *  houver espaço. Antes do scheduler as mensagens vão direto ao stdio.
+ *  Também pode ser chamado de interrupção (callbacks do lwIP/CYW43).
+ *
+ *  Com `LOGGER_TOKENIZED` o `LOG` chama `logger_log_token`: em vez do texto,
+ *  o anel recebe o ID do formato e os argumentos empacotados
+ *  (`lib/log_token`), e a task escreve quadros binários que
+ *  `tools/log_decode` transforma em linhas com a ajuda do ELF. A cada
+ *  `LOGGER_TOKEN_PROBE_EVERY` chamadas o texto também é formatado (e
+ *  descartado) só para medir quantos ciclos o modo poupa.
+ *
+ *  Limiares por tag: `logger_tag_levels` é lido sem trava pelos pontos de
+ *  chamada (um byte por tag); a tabela de nomes só muda sob seção crítica,
+ *  na primeira chamada de cada tag ou pelo comando serial `log`.
  */
 
 #include "lib/logger.h"
 #include <stdio.h>
 #include <stdarg.h>
+#include <string.h>
 #include "pico/stdlib.h"
-#include "hardware/rtc.h"
+#include "hardware/clocks.h"
 #include "FreeRTOS.h"
-#include "semphr.h"
+#include "task.h"
+#include "lib/fmt.h"
+#include "lib/log_ring.h"
+#include "lib/log_token.h"
+#include "lib/serial_cmd.h"
+#include "lib/time_sync.h"
+#include "lib/timestamp.h"
 
-static SemaphoreHandle_t s_mutex = NULL;
+#define LOGGER_HEAD_MAX     64U     /**< Timestamp + tag de uma linha. */
+#define LOGGER_ENTRY_TEXT   0U      /**< Entrada com texto formatado. */
+#define LOGGER_ENTRY_TOKEN  1U      /**< Entrada com ID + argumentos empacotados. */
+#define LOGGER_FRAME_MAX    (2U + LOG_TOKEN_FRAME_HDR + LOGGER_MSG_MAX + LOGGER_MSG_MAX / 254U + 1U)
+
+/** @brief Destino registrado. */
+typedef struct
+{
+    logger_sink_fn fn;
+    void *ctx;
+} logger_sink_t;
+
+static uint8_t s_ring_buf[LOGGER_RING_SIZE] __attribute__((aligned(LOG_RING_ALIGN)));
+static log_ring_t s_ring;
+static bool s_ring_ok = false;
+
+static TaskHandle_t s_task = NULL;
+static logger_sink_t s_sinks[LOGGER_MAX_SINKS];
+static uint8_t s_sink_count = 0;
+static logger_stats_t s_stats;
+
+volatile uint8_t logger_tag_levels[LOGGER_MAX_TAGS + 1U] = {[0 ... LOGGER_MAX_TAGS] = LOGGER_DEFAULT_LEVEL};
+static const char *s_tag_names[LOGGER_MAX_TAGS + 1U] = {"*"};
+static uint8_t s_tag_count = 1;
+
+static const char *const s_level_names[] = {"off", "error", "warn", "info", "debug"};
+
+static void log_cmd(int argc, char **argv);
+
+static const serial_cmd_t s_log_cmd = {
+    .name = "log",
+    .args = "[<tag|*> <off|error|warn|info|debug|0-4>]",
+    .help = "Lista ou altera o nível de log por tag (* = todas e as novas).",
+    .fn = log_cmd,
+};
+
+#if LOGGER_TOKENIZED
+extern const char __start_log_fmt[];    /**< Início da seção `log_fmt` (gerado pelo linker). */
+static uint32_t s_token_calls = 0;
+#endif
 
 /**
  * @brief Indica se o escalonador do FreeRTOS já foi iniciado.
@@ -25,59 +92,576 @@ static inline int scheduler_started(void)
 }
 
 /**
- * @brief Formata timestamp (data/hora + milissegundo) no buffer fornecido.
- * @param[out] buf Buffer de saída.
- * @param buflen Tamanho do buffer.
+ * @brief Monta o início da linha: data/hora com milissegundo, tag e ": ".
+ * @param cache Cache de data do chamador (exclusivo dele).
  */
-static void format_timestamp(char *buf, size_t buflen)
+static size_t format_head(char *out, size_t size, timestamp_cache_t *cache, uint64_t t_us, const char *tag)
 {
-    datetime_t dt;
-    rtc_get_datetime(&dt);
-    uint32_t msec = (uint32_t)((time_us_64() / 1000ULL) % 1000ULL);
-
-    snprintf(buf, buflen, "%04d/%02d/%02d %02d:%02d:%02d.%03u",
-             dt.year, dt.month, dt.day, dt.hour, dt.min, dt.sec, msec);
+    fmt_buf_t b;
+    fmt_buf_init(&b, out, size);
+    fmt_buf_commit(&b, timestamp_format(cache, fmt_buf_tail(&b), fmt_buf_room(&b), time_sync_to_unix_us(t_us)));
+    fmt_buf_char(&b, ' ');
+    fmt_buf_str(&b, tag ? tag : "LOG");
+    fmt_buf_str(&b, ": ");
+    return b.len;
 }
 
 /**
- * @brief Inicializa o logger, criando o mutex de proteção.
+ * @brief Inicializa o anel de mensagens e registra o comando serial `log`.
  */
 void logger_init(void)
 {
-    if (!s_mutex)
+    if (!s_ring_ok)
     {
-        s_mutex = xSemaphoreCreateMutex();
+        s_ring_ok = log_ring_init(&s_ring, s_ring_buf, LOGGER_RING_SIZE);
+        (void)serial_cmd_register(&s_log_cmd);
     }
 }
 
 /**
- * @brief Escreve uma linha de log formatada com timestamp e tag.
- * @param tag Cadeia de identificação do módulo (ou NULL).
- * @param fmt Formato `printf` seguido dos respectivos argumentos variádicos.
+ * @brief Índice da tag na tabela de limiares; cadastra a tag na primeira vez.
+ * @return Índice (0: tag nula ou tabela cheia, usa o limiar padrão).
  */
-void logger_log(const char *tag, const char *fmt, ...)
+int8_t logger_tag_slot(const char *tag)
+{
+    if (!tag)
+    {
+        return 0;
+    }
+
+    const bool locked = scheduler_started();
+    const bool in_isr = locked && portCHECK_IF_IN_ISR();
+    UBaseType_t saved = 0;
+
+    if (in_isr)
+    {
+        saved = taskENTER_CRITICAL_FROM_ISR();
+    }
+    else if (locked)
+    {
+        taskENTER_CRITICAL();
+    }
+
+    uint8_t slot = 0;
+
+    for (uint8_t i = 1; i < s_tag_count; i++)
+    {
+        if (s_tag_names[i] == tag || strcmp(s_tag_names[i], tag) == 0)
+        {
+            slot = i;
+            break;
+        }
+    }
+
+    if (!slot && s_tag_count <= LOGGER_MAX_TAGS)
+    {
+        slot = s_tag_count++;
+        s_tag_names[slot] = tag;
+        logger_tag_levels[slot] = logger_tag_levels[0];
+    }
+
+    if (in_isr)
+    {
+        taskEXIT_CRITICAL_FROM_ISR(saved);
+    }
+    else if (locked)
+    {
+        taskEXIT_CRITICAL();
+    }
+
+    return (int8_t)slot;
+}
+
+/**
+ * @brief Altera o limiar de uma tag, ou de todas com "*".
+ * @param tag Tag (cópia estática; pode ainda não ter registrado nada) ou "*".
+ * @param level `LOG_LEVEL_*`.
+ * @return false se o nível for inválido ou a tabela de tags estiver cheia.
+ */
+bool logger_set_level(const char *tag, uint8_t level)
+{
+    if (!tag || level > LOG_LEVEL_DEBUG)
+    {
+        return false;
+    }
+
+    if (strcmp(tag, "*") == 0)
+    {
+        for (uint8_t i = 0; i <= LOGGER_MAX_TAGS; i++)
+        {
+            logger_tag_levels[i] = level;
+        }
+        return true;
+    }
+
+    const int8_t slot = logger_tag_slot(tag);
+    if (slot == 0)
+    {
+        return false;
+    }
+
+    logger_tag_levels[slot] = level;
+    return true;
+}
+
+/**
+ * @brief Nome de um nível ("off" ... "debug").
+ */
+const char *logger_level_str(uint8_t level)
+{
+    return (level <= LOG_LEVEL_DEBUG) ? s_level_names[level] : "?";
+}
+
+/**
+ * @brief Interpreta um nível por nome ou número.
+ * @return `LOG_LEVEL_*`, ou -1 se inválido.
+ */
+static int parse_level(const char *s)
+{
+    if (s[0] >= '0' && s[0] <= '4' && s[1] == '\0')
+    {
+        return s[0] - '0';
+    }
+
+    for (uint8_t i = 0; i < count_of(s_level_names); i++)
+    {
+        if (strcmp(s, s_level_names[i]) == 0)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Comando serial `log`: sem argumentos lista os limiares; com tag e nível, altera.
+ */
+static void log_cmd(int argc, char **argv)
+{
+    if (argc == 1)
+    {
+        printf("Compilado até %s; padrão %s.\n", logger_level_str(LOG_LEVEL_MIN),
+               logger_level_str(logger_tag_levels[0]));
+
+        for (uint8_t i = 1; i < s_tag_count; i++)
+        {
+            printf("  %-16s %s\n", s_tag_names[i], logger_level_str(logger_tag_levels[i]));
+        }
+        return;
+    }
+
+    const int level = (argc == 3) ? parse_level(argv[2]) : -1;
+    if (level < 0)
+    {
+        printf("uso: log %s\n", s_log_cmd.args);
+        return;
+    }
+
+    /* A tag digitada não é estática: usa o nome já cadastrado ou "*". */
+    const char *tag = NULL;
+    for (uint8_t i = 1; i < s_tag_count; i++)
+    {
+        if (strcmp(s_tag_names[i], argv[1]) == 0)
+        {
+            tag = s_tag_names[i];
+            break;
+        }
+    }
+
+    if (!tag && strcmp(argv[1], "*") != 0)
+    {
+        printf("Tag desconhecida: %s (digite log para listar)\n", argv[1]);
+        return;
+    }
+
+    (void)logger_set_level(tag ? tag : "*", (uint8_t)level);
+    printf("%s -> %s%s\n", argv[1], logger_level_str((uint8_t)level),
+           (level > (int)LOG_LEVEL_MIN) ? " (acima do nível compilado)" : "");
+}
+
+/**
+ * @brief Registra um destino extra para as linhas (antes do scheduler).
+ * @return false se não houver vaga.
+ */
+bool logger_add_sink(logger_sink_fn fn, void *ctx)
+{
+    if (!fn || s_sink_count >= LOGGER_MAX_SINKS)
+    {
+        return false;
+    }
+
+    s_sinks[s_sink_count].ctx = ctx;
+    s_sinks[s_sink_count].fn = fn;
+    s_sink_count++;
+    return true;
+}
+
+/**
+ * @brief Reserva espaço no anel, em seção crítica (task ou interrupção).
+ */
+static log_ring_entry_t *reserve(uint16_t len, bool in_isr)
+{
+    log_ring_entry_t *e;
+
+    if (in_isr)
+    {
+        const UBaseType_t saved = taskENTER_CRITICAL_FROM_ISR();
+        e = log_ring_reserve(&s_ring, len);
+        taskEXIT_CRITICAL_FROM_ISR(saved);
+    }
+    else
+    {
+        taskENTER_CRITICAL();
+        e = log_ring_reserve(&s_ring, len);
+        taskEXIT_CRITICAL();
+    }
+
+    return e;
+}
+
+/**
+ * @brief Contabiliza uma chamada (task ou interrupção).
+ * @param accepted Mensagem entrou no anel (senão foi descartada).
+ * @param dt_us Duração da chamada.
+ */
+static void account(bool in_isr, bool accepted, bool truncated, uint32_t dt_us)
+{
+    const UBaseType_t saved = in_isr ? taskENTER_CRITICAL_FROM_ISR() : 0U;
+    if (!in_isr)
+    {
+        taskENTER_CRITICAL();
+    }
+
+    if (accepted)
+    {
+        s_stats.messages++;
+        s_stats.truncated += truncated ? 1U : 0U;
+        s_stats.call_total_us += dt_us;
+        s_stats.call_max_us = (dt_us > s_stats.call_max_us) ? dt_us : s_stats.call_max_us;
+    }
+    else
+    {
+        s_stats.dropped++;
+    }
+
+    if (in_isr)
+    {
+        taskEXIT_CRITICAL_FROM_ISR(saved);
+    }
+    else
+    {
+        taskEXIT_CRITICAL();
+    }
+}
+
+/**
+ * @brief Escreve a linha direto no stdio (antes do scheduler: um único contexto).
+ */
+static void log_direct(uint64_t t_us, const char *tag, const char *text, size_t len)
 {
-    char ts[32];
-    format_timestamp(ts, sizeof(ts));
+    static timestamp_cache_t s_cache = TIMESTAMP_CACHE_INIT('/', ' ', true);
+    char head[LOGGER_HEAD_MAX];
 
-    int locked = 0;
-    if (s_mutex && scheduler_started())
+    const size_t n = format_head(head, sizeof(head), &s_cache, t_us, tag);
+    fwrite(head, 1, n, stdout);
+    fwrite(text, 1, len, stdout);
+    putchar('\n');
+    s_stats.direct++;
+}
+
+/**
+ * @brief Copia uma mensagem pronta para o anel e avisa a task (não bloqueia).
+ * @param t0 Início da chamada (`time_us_64`), também o instante da mensagem.
+ * @param flags `LOGGER_ENTRY_*`.
+ */
+static void enqueue(uint64_t t0, const char *tag, uint8_t flags, const void *data, size_t n, bool truncated)
+{
+    const bool in_isr = portCHECK_IF_IN_ISR();
+    log_ring_entry_t *e = reserve((uint16_t)n, in_isr);
+
+#if LOGGER_BLOCK_MS > 0
+    if (!e && !in_isr)
     {
-        if (xSemaphoreTake(s_mutex, pdMS_TO_TICKS(50)) == pdTRUE)
+        const TickType_t start = xTaskGetTickCount();
+
+        while (!e && (xTaskGetTickCount() - start) < pdMS_TO_TICKS(LOGGER_BLOCK_MS))
         {
-            locked = 1;
+            vTaskDelay(1);
+            e = reserve((uint16_t)n, false);
         }
     }
+#endif
+
+    if (!e)
+    {
+        account(in_isr, false, truncated, 0);
+        return;
+    }
+
+    e->t_us = t0;
+    e->tag = tag;
+    e->flags = flags;
+    memcpy(log_ring_text(e), data, n);
+    log_ring_commit(e);
+
+    if (s_task && in_isr)
+    {
+        BaseType_t hp = pdFALSE;
+        vTaskNotifyGiveFromISR(s_task, &hp);
+        portYIELD_FROM_ISR(hp);
+    }
+    else if (s_task)
+    {
+        xTaskNotifyGive(s_task);
+    }
+
+    account(in_isr, true, truncated, (uint32_t)(time_us_64() - t0));
+}
+
+/**
+ * @brief Registra uma mensagem formatada com tag; não bloqueia.
+ * @param tag Cadeia de identificação do módulo (estática, ou NULL).
+ * @param fmt Formato `printf` seguido dos respectivos argumentos variádicos.
+ */
+void logger_log(const char *tag, const char *fmt, ...)
+{
+    const uint64_t t0 = time_us_64();
+    char text[LOGGER_MSG_MAX];
+
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(text, sizeof(text), fmt, ap);
+    va_end(ap);
+
+    const bool truncated = n >= (int)sizeof(text);
+    if (n < 0)
+    {
+        n = 0;
+    }
+    else if (truncated)
+    {
+        n = (int)sizeof(text) - 1;
+    }
+
+    /* Antes do scheduler (um único contexto) ou sem anel: direto no stdio, na ordem das chamadas. */
+    if (!scheduler_started() || !s_ring_ok)
+    {
+        log_direct(t0, tag, text, (size_t)n);
+        return;
+    }
+
+    enqueue(t0, tag, LOGGER_ENTRY_TEXT, text, (size_t)n, truncated);
+}
+
+#if LOGGER_TOKENIZED
+/**
+ * @brief Monta um quadro tokenizado: 0x00, COBS(tipo, t_unix_us, corpo), 0x00.
+ * @return Bytes em `out` (0 se não couber).
+ */
+static size_t build_frame(uint8_t *out, size_t size, uint8_t kind, uint64_t t_us, const uint8_t *body,
+                          size_t len)
+{
+    uint8_t raw[LOG_TOKEN_FRAME_HDR + LOGGER_MSG_MAX];
+    const int64_t t_unix = time_sync_to_unix_us(t_us);
+
+    if (len > LOGGER_MSG_MAX || size < 2U)
+    {
+        return 0;
+    }
+
+    raw[0] = kind;
+    for (uint8_t i = 0; i < 8U; i++)
+    {
+        raw[1U + i] = (uint8_t)((uint64_t)t_unix >> (8U * i));
+    }
+    memcpy(&raw[LOG_TOKEN_FRAME_HDR], body, len);
+
+    const size_t n = log_token_cobs_encode(raw, LOG_TOKEN_FRAME_HDR + len, &out[1], size - 2U);
+    if (!n)
+    {
+        return 0;
+    }
+
+    out[0] = 0U;
+    out[n + 1U] = 0U;
+    return n + 2U;
+}
+
+/**
+ * @brief Registra uma mensagem tokenizada (chamada pela macro `LOG`); não bloqueia.
+ * @param tag_fmt Cadeia `TAG "\x1f" fmt` na seção `log_fmt` (o ID é o deslocamento dela).
+ * @param fmt Formato dentro de `tag_fmt`, seguido dos argumentos.
+ */
+void logger_log_token(const char *tag_fmt, const char *fmt, ...)
+{
+    const uint64_t t0 = time_us_64();
+    uint8_t body[LOGGER_MSG_MAX];
+    bool truncated;
 
-    printf("%s %s: ", ts, tag ? tag : "LOG");
+    size_t n = log_token_put_varint(body, sizeof(body), (uint32_t)(tag_fmt - __start_log_fmt));
     va_list ap;
     va_start(ap, fmt);
-    vprintf(fmt, ap);
+    n += log_token_pack(&body[n], sizeof(body) - n, fmt, ap, &truncated);
     va_end(ap);
-    printf("\n");
 
-    if (locked)
+    if (!scheduler_started() || !s_ring_ok)
+    {
+        uint8_t frame[LOGGER_FRAME_MAX];
+        fwrite(frame, 1, build_frame(frame, sizeof(frame), LOG_TOKEN_FRAME_MSG, t0, body, n), stdout);
+        s_stats.direct++;
+        return;
+    }
+
+    /* Amostra de vez em quando o custo do caminho em texto para o mesmo formato. */
+    if (!portCHECK_IF_IN_ISR() && (++s_token_calls % LOGGER_TOKEN_PROBE_EVERY) == 0U)
+    {
+        const uint64_t t1 = time_us_64();
+        char text[LOGGER_MSG_MAX];
+        va_start(ap, fmt);
+        (void)vsnprintf(text, sizeof(text), fmt, ap);
+        va_end(ap);
+        const uint64_t t2 = time_us_64();
+
+        taskENTER_CRITICAL();
+        s_stats.token_probes++;
+        s_stats.token_pack_us += t1 - t0;
+        s_stats.token_text_us += t2 - t1;
+        taskEXIT_CRITICAL();
+    }
+
+    enqueue(t0, NULL, LOGGER_ENTRY_TOKEN, body, n, truncated);
+}
+#endif
+
+/**
+ * @brief Espera o anel esvaziar (ex.: antes de reiniciar).
+ * @return true se esvaziou dentro do prazo.
+ */
+bool logger_flush(uint32_t timeout_ms)
+{
+    if (!scheduler_started() || !s_task || xTaskGetCurrentTaskHandle() == s_task)
+    {
+        return true;
+    }
+
+    const TickType_t start = xTaskGetTickCount();
+
+    while (log_ring_used(&s_ring) != 0U)
+    {
+        if ((xTaskGetTickCount() - start) >= pdMS_TO_TICKS(timeout_ms))
+        {
+            return false;
+        }
+        xTaskNotifyGive(s_task);
+        vTaskDelay(1);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Copia os contadores do logger.
+ * @param[out] out Destino.
+ */
+void logger_get_stats(logger_stats_t *out)
+{
+    if (!out)
+    {
+        return;
+    }
+
+    taskENTER_CRITICAL();
+    *out = s_stats;
+    out->ring_high_water = s_ring.high_water;
+    taskEXIT_CRITICAL();
+
+    if (out->token_probes)
+    {
+        const int64_t saved_us = (int64_t)(out->token_text_us - out->token_pack_us);
+        out->token_saved_cycles =
+            (int32_t)(saved_us * (int64_t)(clock_get_hz(clk_sys) / 1000000U) / (int64_t)out->token_probes);
+    }
+}
+
+/**
+ * @brief Entrega uma linha pronta ao stdio e aos destinos extras.
+ */
+static void emit(const char *line, size_t len)
+{
+    fwrite(line, 1, len, stdout);
+
+    for (uint8_t i = 0; i < s_sink_count; i++)
     {
-        xSemaphoreGive(s_mutex);
+        s_sinks[i].fn(line, len, s_sinks[i].ctx);
+    }
+}
+
+/**
+ * @brief Task de escoamento: esvazia o anel a cada aviso dos produtores.
+ * @param params Não utilizado.
+ * @note Prioridade baixa: USB lento atrasa só os logs, não as tasks que os geram.
+ */
+void logger_task(void *params)
+{
+    (void)params;
+
+    static timestamp_cache_t s_cache = TIMESTAMP_CACHE_INIT('/', ' ', true);
+    static char line[LOGGER_HEAD_MAX + LOGGER_MSG_MAX + 1U]; /* Também comporta LOGGER_FRAME_MAX. */
+    uint32_t dropped_seen = 0;
+
+    s_task = xTaskGetCurrentTaskHandle();
+
+    for (;;)
+    {
+        (void)ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LOGGER_DRAIN_IDLE_MS));
+
+        log_ring_entry_t *e;
+
+        while ((e = log_ring_peek(&s_ring)) != NULL)
+        {
+#if LOGGER_TOKENIZED
+            if (e->flags == LOGGER_ENTRY_TOKEN)
+            {
+                const size_t len = build_frame((uint8_t *)line, sizeof(line), LOG_TOKEN_FRAME_MSG, e->t_us,
+                                               (const uint8_t *)log_ring_text(e), e->len);
+                log_ring_release(&s_ring, e);
+                emit(line, len);
+                continue;
+            }
+#endif
+            size_t n = format_head(line, LOGGER_HEAD_MAX, &s_cache, e->t_us, e->tag);
+            memcpy(&line[n], log_ring_text(e), e->len);
+            n += e->len;
+            line[n++] = '\n';
+            log_ring_release(&s_ring, e);
+            emit(line, n);
+        }
+
+        const uint32_t dropped = s_stats.dropped;
+
+#if LOGGER_TOKENIZED
+        if (dropped != dropped_seen)
+        {
+            uint8_t body[10];
+            const size_t len = log_token_put_varint(body, sizeof(body), dropped - dropped_seen);
+            dropped_seen = dropped;
+            emit(line, build_frame((uint8_t *)line, sizeof(line), LOG_TOKEN_FRAME_DROPPED, time_us_64(), body, len));
+        }
+#else
+        if (dropped != dropped_seen)
+        {
+            char head[LOGGER_HEAD_MAX];
+            const size_t n = format_head(head, sizeof(head), &s_cache, time_us_64(), "logger");
+            memcpy(line, head, n);
+
+            fmt_buf_t b;
+            fmt_buf_init(&b, &line[n], sizeof(line) - n);
+            fmt_buf_u32(&b, dropped - dropped_seen);
+            fmt_buf_str(&b, " mensagens descartadas (anel cheio).\n");
+            dropped_seen = dropped;
+            emit(line, n + b.len);
+        }
+#endif
     }
 }
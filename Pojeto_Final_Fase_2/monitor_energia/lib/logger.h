@@ -1,15 +1,154 @@
 /**
  * @file logger.h
  * @brief Declarações do logger.
+ * @details
+ *  Níveis: `LOGE` (erro), `LOGW` (aviso), `LOG`/`LOGI` (informação) e
+ *  `LOGD` (depuração). Chamadas acima de `LOG_LEVEL_MIN` somem na
+ *  compilação (argumentos inclusive). As demais comparam o nível com o
+ *  limiar da sua tag antes de qualquer formatação: cada ponto de chamada
+ *  guarda o índice da tag na tabela de limiares, resolvido na primeira
+ *  execução, e depois custa uma leitura e um desvio. Os limiares mudam em
+ *  tempo de execução pelo comando serial `log`.
  */
 
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define LOGGER_RING_SIZE        4096U   /**< Bytes do anel de mensagens (potência de 2). */
+#define LOGGER_MSG_MAX          160U    /**< Maior texto por mensagem (o resto é truncado). */
+#define LOGGER_MAX_SINKS        3U      /**< Destinos além do stdio. */
+#define LOGGER_DRAIN_IDLE_MS    250U    /**< Espera máxima da task de escoamento sem aviso. */
+#define LOGGER_MAX_TAGS         16U     /**< Tags com limiar próprio (as demais usam o padrão). */
+
+#define LOG_LEVEL_OFF           0U      /**< Nada é registrado. */
+#define LOG_LEVEL_ERROR         1U      /**< Falhas que impedem uma função. */
+#define LOG_LEVEL_WARN          2U      /**< Falhas recuperáveis. */
+#define LOG_LEVEL_INFO          3U      /**< Eventos de operação normal. */
+#define LOG_LEVEL_DEBUG         4U      /**< Detalhe por evento/janela. */
+
+#ifndef LOG_LEVEL_MIN
+/** @brief Nível mais detalhado compilado (produção: `LOG_LEVEL_INFO` ou menor). */
+#define LOG_LEVEL_MIN           LOG_LEVEL_DEBUG
+#endif
+
+#ifndef LOGGER_DEFAULT_LEVEL
+/** @brief Limiar inicial de todas as tags. */
+#define LOGGER_DEFAULT_LEVEL    LOG_LEVEL_INFO
+#endif
+
+#ifndef LOGGER_TOKENIZED
+/** @brief 1: `LOG` grava o ID do formato e os argumentos brutos (ver `log_token.h`); 0: texto. */
+#define LOGGER_TOKENIZED        0
+#endif
+
+#define LOGGER_TOKEN_PROBE_EVERY 32U    /**< Modo tokenizado: a cada N chamadas mede também o custo do texto. */
+
+#ifndef LOGGER_BLOCK_MS
+/** @brief Anel cheio: 0 descarta a mensagem nova; N>0 espera até N ms (só em task). */
+#define LOGGER_BLOCK_MS         0U
+#endif
+
+/**
+ * @brief Destino de linhas de log, chamado pela task de escoamento.
+ * @param line Linha completa, terminada em '\n' (não terminada em NUL); no modo
+ *             tokenizado, um quadro binário delimitado por 0x00.
+ * @param len Bytes de `line`.
+ */
+typedef void (*logger_sink_fn)(const char *line, size_t len, void *ctx);
+
+/** @brief Contadores do logger. */
+typedef struct
+{
+    uint32_t messages;          /**< Mensagens aceitas no anel. */
+    uint32_t dropped;           /**< Mensagens descartadas com o anel cheio. */
+    uint32_t truncated;         /**< Mensagens cortadas em `LOGGER_MSG_MAX`. */
+    uint32_t direct;            /**< Mensagens escritas direto (antes do scheduler). */
+    uint32_t ring_high_water;   /**< Maior ocupação do anel (bytes). */
+    uint32_t call_max_us;       /**< Maior duração de uma chamada de log. */
+    uint64_t call_total_us;     /**< Soma das durações (média = total / messages). */
+    uint32_t token_probes;      /**< Chamadas tokenizadas em que o texto também foi medido. */
+    uint64_t token_text_us;     /**< Soma do custo de `vsnprintf` nessas chamadas. */
+    uint64_t token_pack_us;     /**< Soma do custo de empacotar os argumentos nessas chamadas. */
+    int32_t token_saved_cycles; /**< Ciclos de CPU poupados por chamada (média das medições). */
+} logger_stats_t;
+
 void logger_init(void);
 void logger_log(const char *tag, const char *fmt, ...);
+bool logger_add_sink(logger_sink_fn fn, void *ctx);
+bool logger_flush(uint32_t timeout_ms);
+void logger_get_stats(logger_stats_t *out);
+void logger_task(void *params);
+int8_t logger_tag_slot(const char *tag);
+bool logger_set_level(const char *tag, uint8_t level);
+const char *logger_level_str(uint8_t level);
+
+/** @brief Limiar por índice de tag (índice 0: padrão e tags além de `LOGGER_MAX_TAGS`). */
+extern volatile uint8_t logger_tag_levels[LOGGER_MAX_TAGS + 1U];
+
+/**
+ * @brief Indica se `level` passa pelo limiar da tag (resolve o índice na primeira chamada).
+ * @param slot Índice da tag guardado no ponto de chamada (-1: ainda não resolvido).
+ */
+static inline bool logger_enabled(int8_t *slot, const char *tag, uint8_t level)
+{
+    if (*slot < 0)
+    {
+        *slot = logger_tag_slot(tag);
+    }
+    return level <= logger_tag_levels[*slot];
+}
+
+#if LOGGER_TOKENIZED
+#include <stdio.h>
+#include "lib/log_token.h"
+
+void logger_log_token(const char *tag_fmt, const char *fmt, ...);
+
+/**
+ * @brief Guarda `TAG "\x1f" fmt` na seção `log_fmt` (lida do ELF pelo host) e
+ *        registra o deslocamento da cadeia na seção mais os argumentos brutos.
+ * @note `TAG` e `fmt` devem ser literais; o `sizeof(printf(...))` mantém a
+ *       checagem de formato do compilador sem gerar código.
+ */
+#define LOGGER_EMIT(TAG, fmt, ...)                                                                \
+    do                                                                                            \
+    {                                                                                             \
+        static const char _log_tok[] __attribute__((section(LOG_TOKEN_SECTION), used)) =         \
+            TAG "\x1f" fmt;                                                                       \
+        (void)sizeof(printf((fmt), ##__VA_ARGS__));                                               \
+        logger_log_token(_log_tok, &_log_tok[sizeof(TAG)], ##__VA_ARGS__);                       \
+    } while (0)
+#else
+#define LOGGER_EMIT(TAG, fmt, ...) logger_log((TAG), (fmt), ##__VA_ARGS__)
+#endif
+
+/**
+ * @brief Log com nível: eliminado na compilação acima de `LOG_LEVEL_MIN` e
+ *        filtrado pelo limiar da tag antes de avaliar argumentos.
+ */
+#define LOG_AT(LVL, TAG, fmt, ...)                                                                \
+    do                                                                                            \
+    {                                                                                             \
+        if ((LVL) <= LOG_LEVEL_MIN)                                                               \
+        {                                                                                         \
+            static int8_t _log_slot = -1;                                                         \
+            if (logger_enabled(&_log_slot, (TAG), (LVL)))                                         \
+            {                                                                                     \
+                LOGGER_EMIT(TAG, fmt, ##__VA_ARGS__);                                             \
+            }                                                                                     \
+        }                                                                                         \
+    } while (0)
+
+#define LOGE(TAG, fmt, ...) LOG_AT(LOG_LEVEL_ERROR, TAG, fmt, ##__VA_ARGS__)
+#define LOGW(TAG, fmt, ...) LOG_AT(LOG_LEVEL_WARN, TAG, fmt, ##__VA_ARGS__)
+#define LOGI(TAG, fmt, ...) LOG_AT(LOG_LEVEL_INFO, TAG, fmt, ##__VA_ARGS__)
+#define LOGD(TAG, fmt, ...) LOG_AT(LOG_LEVEL_DEBUG, TAG, fmt, ##__VA_ARGS__)
 
-/** @brief Macro prática para logs com tag constante. */
-#define LOG(TAG, fmt, ...) logger_log((TAG), (fmt), ##__VA_ARGS__)
+/** @brief Macro prática para logs com tag constante (nível informação). */
+#define LOG(TAG, fmt, ...) LOGI(TAG, fmt, ##__VA_ARGS__)
 
 #endif /* LOGGER_H */
@@ -0,0 +1,533 @@
+/**
+ * @file mqtt_publisher.c
+ * @brief Publicação MQTT 3.1.1 das janelas de medição (cliente `lwip/apps/mqtt`).
+ * @details
+ *  A task mantém uma única conexão TCP com o broker (reconecta com backoff
+ *  quando cai) e publica cada janela recebida do sink `mqtt_publisher_sink` em um
+ *  tópico por grandeza, com QoS 0 ou 1 configurável por tópico.
+ *
+ *  No máximo `MQTT_PUBLISHER_MAX_INFLIGHT` mensagens ficam em voo. Uma
+ *  mensagem QoS 1 só libera o slot ao receber PUBACK; em timeout ou queda de
+ *  conexão ela é republicada após a reconexão. O cliente do lwIP sempre abre
+ *  a sessão com "clean session", então essa retenção é feita aqui.
+ */
+
+#include "lib/mqtt_publisher.h"
+#include <string.h>
+#include "pico/cyw43_arch.h"
+#include "lwip/apps/mqtt.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "utils.h"
+#include "lib/wifi_manager.h"
+#include "lib/logger.h"
+#include "lib/rtos_stats.h"
+#include "lib/fmt.h"
+
+#define TAG "mqtt"
+
+#define MQTT_BACKOFF_MIN_MS     2000U       /**< Backoff mínimo entre conexões. */
+#define MQTT_BACKOFF_MAX_MS     60000U      /**< Backoff máximo entre conexões. */
+#define MQTT_DNS_TIMEOUT_MS     5000U       /**< Timeout de resolução do broker. */
+#define MQTT_IDLE_WAIT_MS       1000U       /**< Espera máxima da task sem eventos. */
+#define MQTT_PAYLOAD_MAX        24U         /**< Tamanho máximo do payload textual. */
+
+#if defined(MQTT_REQ_MAX_IN_FLIGHT) && (MQTT_REQ_MAX_IN_FLIGHT < MQTT_PUBLISHER_MAX_INFLIGHT)
+#error "MQTT_REQ_MAX_IN_FLIGHT (lwipopts.h) deve ser >= MQTT_PUBLISHER_MAX_INFLIGHT"
+#endif
+
+/** @brief Índices dos valores de uma janela. */
+enum
+{
+    FIELD_VRMS = 0,
+    FIELD_IRMS,
+    FIELD_P,
+    FIELD_E_WH,
+    FIELD_UPTIME,
+    FIELD_COUNT
+};
+
+/** @brief Configuração de um tópico publicado por janela. */
+typedef struct
+{
+    const char *topic;  /**< Tópico completo. */
+    uint8_t field;      /**< Índice do valor na janela. */
+    uint8_t decimals;   /**< Casas decimais do payload. */
+    uint8_t qos;        /**< QoS (0 ou 1). */
+} mqtt_topic_cfg_t;
+
+static const mqtt_topic_cfg_t k_topics[] = {
+    {MQTT_TOPIC_PREFIX "vrms", FIELD_VRMS, 2, 1},
+    {MQTT_TOPIC_PREFIX "irms", FIELD_IRMS, 3, 1},
+    {MQTT_TOPIC_PREFIX "p_w", FIELD_P, 1, 1},
+    {MQTT_TOPIC_PREFIX "e_wh", FIELD_E_WH, 4, 1},
+    {MQTT_TOPIC_PREFIX "uptime_s", FIELD_UPTIME, 0, 0},
+};
+
+#define MQTT_TOPIC_COUNT (sizeof(k_topics) / sizeof(k_topics[0]))
+
+/** @brief Janela de medição aguardando publicação. */
+typedef struct
+{
+    double values[FIELD_COUNT];
+} mqtt_window_t;
+
+/** @brief Estados de um slot de mensagem. */
+typedef enum
+{
+    SLOT_FREE = 0,  /**< Livre. */
+    SLOT_RETRY,     /**< Montada, aguardando (re)publicação. */
+    SLOT_INFLIGHT,  /**< Entregue ao lwIP, aguardando confirmação. */
+    SLOT_ACKED,     /**< Confirmada pelo callback (liberar). */
+    SLOT_FAILED     /**< Falhou no lwIP (republicar). */
+} slot_state_t;
+
+/** @brief Mensagem em voo (payload próprio, válido até a confirmação). */
+typedef struct
+{
+    volatile uint8_t state;             /**< `slot_state_t` (escrito também no callback). */
+    uint8_t topic;                      /**< Índice em `k_topics`. */
+    uint8_t len;                        /**< Tamanho do payload. */
+    char payload[MQTT_PAYLOAD_MAX];     /**< Valor em texto. */
+} mqtt_slot_t;
+
+static mqtt_client_t *s_client = NULL;
+static QueueHandle_t s_queue = NULL;
+static TaskHandle_t s_task = NULL;
+static volatile bool s_connected = false;
+static volatile bool s_conn_event = false;
+
+static mqtt_slot_t s_slots[MQTT_PUBLISHER_MAX_INFLIGHT];
+static mqtt_window_t s_cur;             /**< Janela em publicação. */
+static uint8_t s_cur_next = MQTT_TOPIC_COUNT;
+static mqtt_publisher_stats_t s_stats;
+
+static int8_t s_tx_client = -1;         /**< Cliente de envio no gerenciador Wi‑Fi. */
+static volatile bool s_tx_awake = false; /**< Janela entregue e ainda não confirmada. */
+
+/**
+ * @brief Acorda a task do publicador (chamado nos callbacks do lwIP).
+ */
+static void wake_task_from_cb(void)
+{
+    if (!s_task)
+    {
+        return;
+    }
+
+    if (portCHECK_IF_IN_ISR())
+    {
+        BaseType_t hp = pdFALSE;
+        vTaskNotifyGiveFromISR(s_task, &hp);
+        portYIELD_FROM_ISR(hp);
+    }
+    else
+    {
+        xTaskNotifyGive(s_task);
+    }
+}
+
+/**
+ * @brief Transição do Wi‑Fi: acorda a task para conectar/detectar a queda já.
+ */
+static void wifi_link_cb(bool up, void *ctx)
+{
+    (void)up;
+    (void)ctx;
+    wake_task_from_cb();
+}
+
+/**
+ * @brief Callback de estado da conexão MQTT.
+ */
+static void mqtt_conn_cb(mqtt_client_t *client, void *arg, mqtt_connection_status_t status)
+{
+    (void)client;
+    (void)arg;
+    s_connected = (status == MQTT_CONNECT_ACCEPTED);
+    s_conn_event = true;
+    wake_task_from_cb();
+}
+
+/**
+ * @brief Callback de conclusão de publicação (PUBACK em QoS 1; envio em QoS 0).
+ */
+static void mqtt_pub_cb(void *arg, err_t err)
+{
+    mqtt_slot_t *slot = (mqtt_slot_t *)arg;
+    slot->state = (err == ERR_OK) ? SLOT_ACKED : SLOT_FAILED;
+    wake_task_from_cb();
+}
+
+/**
+ * @brief Quantidade de slots ocupados.
+ */
+static uint8_t slots_busy(void)
+{
+    uint8_t n = 0;
+    for (size_t i = 0; i < MQTT_PUBLISHER_MAX_INFLIGHT; i++)
+    {
+        if (s_slots[i].state != SLOT_FREE)
+        {
+            n++;
+        }
+    }
+    return n;
+}
+
+/**
+ * @brief Libera slots confirmados e agenda republicação dos que falharam.
+ */
+static void reclaim_slots(void)
+{
+    for (size_t i = 0; i < MQTT_PUBLISHER_MAX_INFLIGHT; i++)
+    {
+        mqtt_slot_t *slot = &s_slots[i];
+
+        if (slot->state == SLOT_ACKED)
+        {
+            slot->state = SLOT_FREE;
+            s_stats.published++;
+        }
+        else if (slot->state == SLOT_FAILED)
+        {
+            slot->state = SLOT_RETRY;
+            s_stats.retried++;
+        }
+    }
+}
+
+/**
+ * @brief Entrega um slot ao cliente lwIP.
+ * @return true se o lwIP aceitou a mensagem.
+ */
+static bool publish_slot(mqtt_slot_t *slot)
+{
+    const mqtt_topic_cfg_t *cfg = &k_topics[slot->topic];
+
+    slot->state = SLOT_INFLIGHT;
+    cyw43_arch_lwip_begin();
+    err_t err = mqtt_publish(s_client, cfg->topic, slot->payload, slot->len,
+                             cfg->qos, 0, mqtt_pub_cb, slot);
+    cyw43_arch_lwip_end();
+
+    if (err != ERR_OK)
+    {
+        /* Buffer de saída do lwIP cheio: tenta de novo no próximo ciclo. */
+        slot->state = SLOT_RETRY;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Republica slots pendentes e publica os próximos tópicos da janela atual.
+ */
+static void pump_publications(void)
+{
+    for (size_t i = 0; i < MQTT_PUBLISHER_MAX_INFLIGHT; i++)
+    {
+        if (s_slots[i].state == SLOT_RETRY && !publish_slot(&s_slots[i]))
+        {
+            return;
+        }
+    }
+
+    for (;;)
+    {
+        if (s_cur_next >= MQTT_TOPIC_COUNT)
+        {
+            if (xQueueReceive(s_queue, &s_cur, 0) != pdTRUE)
+            {
+                return;
+            }
+            s_cur_next = 0;
+        }
+
+        mqtt_slot_t *slot = NULL;
+        for (size_t i = 0; i < MQTT_PUBLISHER_MAX_INFLIGHT; i++)
+        {
+            if (s_slots[i].state == SLOT_FREE)
+            {
+                slot = &s_slots[i];
+                break;
+            }
+        }
+
+        if (!slot)
+        {
+            return; /* Janela em voo cheia: aguarda PUBACKs. */
+        }
+
+        const mqtt_topic_cfg_t *cfg = &k_topics[s_cur_next];
+        slot->topic = s_cur_next;
+        slot->len = (uint8_t)fmt_double(slot->payload, sizeof(slot->payload),
+                                        s_cur.values[cfg->field], cfg->decimals);
+        s_cur_next++;
+
+        if (!publish_slot(slot))
+        {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Marca todas as mensagens em voo para republicação (conexão caiu).
+ */
+static void requeue_inflight(void)
+{
+    for (size_t i = 0; i < MQTT_PUBLISHER_MAX_INFLIGHT; i++)
+    {
+        if (s_slots[i].state == SLOT_INFLIGHT || s_slots[i].state == SLOT_FAILED)
+        {
+            s_slots[i].state = SLOT_RETRY;
+            s_stats.retried++;
+        }
+        else if (s_slots[i].state == SLOT_ACKED)
+        {
+            s_slots[i].state = SLOT_FREE;
+            s_stats.published++;
+        }
+    }
+}
+
+/**
+ * @brief Resolve o broker e inicia a conexão MQTT (resultado chega em `mqtt_conn_cb`).
+ * @return true se a conexão foi iniciada.
+ */
+static bool start_connect(void)
+{
+    ip_addr_t ip;
+
+    if (!utils_resolve_dns(MQTT_BROKER_HOST, &ip, MQTT_DNS_TIMEOUT_MS))
+    {
+        LOGW(TAG, "DNS falhou para %s", MQTT_BROKER_HOST);
+        return false;
+    }
+
+    static const struct mqtt_connect_client_info_t info = {
+        .client_id = MQTT_CLIENT_ID,
+        .keep_alive = MQTT_PUBLISHER_KEEPALIVE_S,
+        .will_topic = MQTT_TOPIC_PREFIX "status",
+        .will_msg = "offline",
+        .will_qos = 1,
+        .will_retain = 1,
+    };
+
+    s_conn_event = false;
+    cyw43_arch_lwip_begin();
+    err_t err = mqtt_client_connect(s_client, &ip, MQTT_BROKER_PORT, mqtt_conn_cb, NULL, &info);
+    cyw43_arch_lwip_end();
+
+    if (err != ERR_OK)
+    {
+        LOGW(TAG, "mqtt_client_connect err=%d", (int)err);
+        return false;
+    }
+
+    LOG(TAG, "Conectando a %s:%u ...", MQTT_BROKER_HOST, (unsigned)MQTT_BROKER_PORT);
+    return true;
+}
+
+/**
+ * @brief Cria a fila de janelas e o cliente MQTT.
+ */
+void mqtt_publisher_init(void)
+{
+    if (!s_queue)
+    {
+        s_queue = xQueueCreate(MQTT_PUBLISHER_QUEUE_LEN, sizeof(mqtt_window_t));
+        rtos_stats_watch_queue(s_queue, "mqtt_windows");
+    }
+
+    if (!s_client)
+    {
+        cyw43_arch_lwip_begin();
+        s_client = mqtt_client_new();
+        cyw43_arch_lwip_end();
+    }
+
+    if (!s_queue || !s_client)
+    {
+        LOGE(TAG, "Falha ao criar fila/cliente MQTT.");
+    }
+}
+
+/**
+ * @brief Enfileira uma janela para publicação (não bloqueia).
+ * @return true se enfileirada; false se a fila estava cheia (a mais antiga é descartada).
+ */
+bool mqtt_publisher_publish_window(double vrms, double irms, double p_w,
+                                   double e_wh, uint32_t uptime_s)
+{
+    if (!s_queue)
+    {
+        return false;
+    }
+
+    mqtt_window_t w;
+    w.values[FIELD_VRMS] = vrms;
+    w.values[FIELD_IRMS] = irms;
+    w.values[FIELD_P] = p_w;
+    w.values[FIELD_E_WH] = e_wh;
+    w.values[FIELD_UPTIME] = (double)uptime_s;
+
+    bool ok = true;
+
+    if (xQueueSend(s_queue, &w, 0) != pdTRUE)
+    {
+        mqtt_window_t oldest;
+        (void)xQueueReceive(s_queue, &oldest, 0);
+        (void)xQueueSend(s_queue, &w, 0);
+        s_stats.dropped++;
+        ok = false;
+    }
+
+    if (s_task)
+    {
+        xTaskNotifyGive(s_task);
+    }
+
+    return ok;
+}
+
+/**
+ * @brief Informa se a conexão com o broker está ativa.
+ */
+bool mqtt_publisher_is_connected(void)
+{
+    return s_connected;
+}
+
+/**
+ * @brief Copia as estatísticas do publicador.
+ * @param[out] out Destino.
+ */
+void mqtt_publisher_get_stats(mqtt_publisher_stats_t *out)
+{
+    if (!out)
+    {
+        return;
+    }
+
+    *out = s_stats;
+    out->inflight = slots_busy();
+    out->connected = s_connected;
+}
+
+/**
+ * @brief Task do publicador MQTT: conexão persistente, backoff e janela em voo.
+ * @param params Não utilizado.
+ */
+void mqtt_publisher_task(void *params)
+{
+    (void)params;
+
+    s_task = xTaskGetCurrentTaskHandle();
+    mqtt_publisher_init();
+    (void)wifi_manager_subscribe(wifi_link_cb, NULL);
+    s_tx_client = wifi_manager_tx_register("mqtt");
+    wifi_manager_tx_schedule(s_tx_client, telemetry_next_window_ms());
+
+    uint32_t backoff_ms = MQTT_BACKOFF_MIN_MS;
+    TickType_t next_try = xTaskGetTickCount();
+    bool connecting = false;
+    bool was_connected = false;
+
+    for (;;)
+    {
+        (void)ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(MQTT_IDLE_WAIT_MS));
+
+        if (!s_client || !s_queue)
+        {
+            continue;
+        }
+
+        if (s_conn_event)
+        {
+            s_conn_event = false;
+            connecting = false;
+
+            if (s_connected)
+            {
+                LOG(TAG, "Conectado ao broker (%u mensagens em voo para republicar).",
+                    (unsigned)slots_busy());
+                s_stats.reconnects++;
+                backoff_ms = MQTT_BACKOFF_MIN_MS;
+            }
+        }
+
+        if (was_connected && !s_connected)
+        {
+            LOGW(TAG, "Conexão com o broker perdida.");
+            requeue_inflight();
+            next_try = xTaskGetTickCount() + pdMS_TO_TICKS(backoff_ms);
+        }
+        was_connected = s_connected;
+
+        if (s_connected)
+        {
+            reclaim_slots();
+            pump_publications();
+
+            /* Janela toda confirmada: o rádio pode dormir até a próxima. */
+            if (s_tx_awake && s_cur_next >= MQTT_TOPIC_COUNT && slots_busy() == 0 &&
+                uxQueueMessagesWaiting(s_queue) == 0)
+            {
+                s_tx_awake = false;
+                wifi_manager_tx_schedule(s_tx_client, telemetry_next_window_ms());
+            }
+            continue;
+        }
+
+        if (connecting || !wifi_manager_is_connected())
+        {
+            continue;
+        }
+
+        if ((int32_t)(xTaskGetTickCount() - next_try) >= 0)
+        {
+            connecting = start_connect();
+            next_try = xTaskGetTickCount() + pdMS_TO_TICKS(backoff_ms);
+            backoff_ms = (backoff_ms < MQTT_BACKOFF_MAX_MS / 2U) ? (backoff_ms * 2U) : MQTT_BACKOFF_MAX_MS;
+        }
+    }
+}
+
+/** @brief Energia total já entregue ao publicador (base do delta da janela). */
+static double s_sink_e_wh = 0.0;
+
+/**
+ * @brief Entrega uma janela da telemetria à fila do publicador.
+ * @details A fila do publicador já retém janelas enquanto o broker está fora.
+ *          O rádio fica acordado até a janela ser confirmada pelo broker.
+ */
+static bool mqtt_sink_publish(void *ctx, const telemetry_record_t *rec)
+{
+    (void)ctx;
+
+    const double e_wh = rec->e_total_wh - s_sink_e_wh;
+    s_sink_e_wh = rec->e_total_wh;
+
+    s_tx_awake = true;
+    wifi_manager_tx_schedule(s_tx_client, WIFI_TX_NOW);
+
+    return mqtt_publisher_publish_window(rec->vrms, rec->irms, rec->p_w, e_wh, rec->uptime_s);
+}
+
+const telemetry_sink_t mqtt_publisher_sink = {
+    .name = "MqttSink",
+    .begin = NULL,
+    .publish = mqtt_sink_publish,
+    .flush = NULL,
+    .healthy = NULL,
+    .ctx = NULL,
+    .accept = TELEMETRY_ACCEPT_WINDOW,
+    .queue_len = 2,
+    .stack_words = 512,
+    .priority = tskIDLE_PRIORITY + 1,
+    .idle_flush_ms = 0,
+};
@@ -0,0 +1,51 @@
+/**
+ * @file mqtt_publisher.h
+ * @brief Publicador MQTT 3.1.1 (cliente MQTT do lwIP) para as janelas de medição.
+ */
+
+#ifndef MQTT_PUBLISHER_H
+#define MQTT_PUBLISHER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "credentials.h"
+#include "lib/telemetry.h"
+
+#ifndef MQTT_BROKER_HOST
+#define MQTT_BROKER_HOST        "test.mosquitto.org"    /**< Broker (sobrescreva em credentials.h). */
+#endif
+#ifndef MQTT_BROKER_PORT
+#define MQTT_BROKER_PORT        1883U                   /**< Porta TCP do broker. */
+#endif
+#ifndef MQTT_CLIENT_ID
+#define MQTT_CLIENT_ID          "monitor-energia"       /**< Client ID (sessão identificada por ele). */
+#endif
+#ifndef MQTT_TOPIC_PREFIX
+#define MQTT_TOPIC_PREFIX       "monitor_energia/"      /**< Prefixo comum dos tópicos. */
+#endif
+
+#define MQTT_PUBLISHER_MAX_INFLIGHT 4U      /**< Publicações aguardando PUBACK/envio. */
+#define MQTT_PUBLISHER_QUEUE_LEN    4U      /**< Janelas pendentes aguardando publicação. */
+#define MQTT_PUBLISHER_KEEPALIVE_S  60U     /**< Keep-alive da conexão (s). */
+
+/** @brief Estatísticas do publicador. */
+typedef struct
+{
+    uint32_t published;     /**< Mensagens confirmadas (PUBACK ou enviadas em QoS 0). */
+    uint32_t retried;       /**< Mensagens republicadas após timeout/queda. */
+    uint32_t dropped;       /**< Janelas descartadas por fila cheia. */
+    uint32_t reconnects;    /**< Conexões estabelecidas com o broker. */
+    uint8_t inflight;       /**< Mensagens em voo no momento. */
+    bool connected;         /**< Conexão MQTT ativa. */
+} mqtt_publisher_stats_t;
+
+void mqtt_publisher_init(void);
+bool mqtt_publisher_publish_window(double vrms, double irms, double p_w,
+                                   double e_wh, uint32_t uptime_s);
+bool mqtt_publisher_is_connected(void);
+void mqtt_publisher_get_stats(mqtt_publisher_stats_t *out);
+void mqtt_publisher_task(void *params);
+
+extern const telemetry_sink_t mqtt_publisher_sink;  /**< Sink de janelas para o publicador. */
+
+#endif /* MQTT_PUBLISHER_H */
@@ -0,0 +1,433 @@
+/**
+ * @file rtos_stats.c
+ * @brief Instantâneos de CPU, stack, heap e filas do FreeRTOS; resumo no log e comando serial `rtos`.
+ */
+
+#include "lib/rtos_stats.h"
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "lib/logger.h"
+#include "lib/serial_cmd.h"
+#include "lib/rtos_trace.h"
+
+#define TAG "rtos_stats"
+
+#define RTOS_STATS_REPORT_S     86400U  /**< Uptime em que a recomendação de stack vai uma vez ao log. */
+
+/** @brief Stack alocado de uma task criada por `rtos_stats_create_task`. */
+typedef struct
+{
+    TaskHandle_t handle;    /**< Task. */
+    uint32_t words;         /**< Stack alocado [palavras]. */
+} stack_reg_t;
+
+/** @brief Fila observada. */
+typedef struct
+{
+    QueueHandle_t queue;    /**< Fila. */
+    const char *name;       /**< Nome no relatório. */
+    uint16_t max;           /**< Maior ocupação vista. */
+} queue_reg_t;
+
+/** @brief Contador de execução de uma task no instantâneo anterior. */
+typedef struct
+{
+    UBaseType_t number;     /**< `xTaskNumber` (único por task). */
+    uint32_t run_us;        /**< Contador truncado (a diferença vale até 71 min). */
+    bool warned;            /**< Folga baixa já avisada no log. */
+} run_prev_t;
+
+static stack_reg_t s_stacks[RTOS_STATS_MAX_TASKS];
+static uint8_t s_nstacks = 0;
+static queue_reg_t s_queues[RTOS_STATS_MAX_QUEUES];
+static uint8_t s_nqueues = 0;
+
+/* Estado da task de coleta */
+static TaskStatus_t s_status[RTOS_STATS_MAX_TASKS];
+static run_prev_t s_prev[RTOS_STATS_MAX_TASKS];
+static run_prev_t s_cur[RTOS_STATS_MAX_TASKS];
+static uint8_t s_nprev = 0;
+static uint64_t s_prev_t_us = 0;
+static bool s_reported = false;
+static bool s_warned_max = false;     /**< Excesso de tasks já avisado. */
+static rtos_stats_snapshot_t s_work;    /**< Instantâneo em montagem. */
+static rtos_stats_snapshot_t s_snap;    /**< Último instantâneo publicado. */
+
+static void rtos_cmd(int argc, char **argv);
+
+static const serial_cmd_t s_rtos_cmd = {
+    .name = "rtos",
+    .args = "[stack]",
+    .help = "CPU, stack, heap e filas do FreeRTOS; 'stack' recomenda tamanhos de stack.",
+    .fn = rtos_cmd,
+};
+
+/**
+ * @brief `xTaskCreate` que registra o tamanho do stack para a recomendação.
+ * @note Chamar antes do scheduler (o registro não é protegido).
+ * @return Resultado de `xTaskCreate`.
+ */
+BaseType_t rtos_stats_create_task(TaskFunction_t fn, const char *name, uint32_t stack_words, void *params,
+                                  UBaseType_t priority, TaskHandle_t *handle)
+{
+    TaskHandle_t h = NULL;
+    const BaseType_t rc = xTaskCreate(fn, name, (configSTACK_DEPTH_TYPE)stack_words, params, priority, &h);
+
+    if (rc == pdPASS && s_nstacks < RTOS_STATS_MAX_TASKS)
+    {
+        s_stacks[s_nstacks].handle = h;
+        s_stacks[s_nstacks].words = stack_words;
+        s_nstacks++;
+    }
+    if (handle)
+    {
+        *handle = h;
+    }
+    return rc;
+}
+
+/**
+ * @brief Inclui uma fila nos instantâneos, no registro de filas do kernel (depurador) e no trace.
+ * @note Chamar antes do scheduler ou da primeira coleta.
+ */
+void rtos_stats_watch_queue(QueueHandle_t q, const char *name)
+{
+    if (!q || s_nqueues >= RTOS_STATS_MAX_QUEUES)
+    {
+        return;
+    }
+
+    vQueueAddToRegistry(q, name);
+    (void)rtos_trace_name_queue(q, name);
+    s_queues[s_nqueues].queue = q;
+    s_queues[s_nqueues].name = name;
+    s_queues[s_nqueues].max = 0;
+    s_nqueues++;
+}
+
+/**
+ * @brief Stack recomendado: pico de uso + `RTOS_STATS_STACK_MARGIN_PCT`, múltiplo de `RTOS_STATS_STACK_ROUND`.
+ * @param stack_words Stack alocado [palavras].
+ * @param free_min Menor folga medida [palavras].
+ * @return Recomendação [palavras], nunca abaixo de `configMINIMAL_STACK_SIZE`.
+ */
+uint32_t rtos_stats_recommend_stack(uint32_t stack_words, uint32_t free_min)
+{
+    const uint32_t used = (stack_words > free_min) ? stack_words - free_min : 0U;
+    uint32_t rec = used + (used * RTOS_STATS_STACK_MARGIN_PCT + 99U) / 100U;
+
+    rec = (rec + RTOS_STATS_STACK_ROUND - 1U) / RTOS_STATS_STACK_ROUND * RTOS_STATS_STACK_ROUND;
+    return (rec < configMINIMAL_STACK_SIZE) ? (uint32_t)configMINIMAL_STACK_SIZE : rec;
+}
+
+/**
+ * @brief Copia o último instantâneo.
+ * @return false se nenhum foi tirado ainda.
+ */
+bool rtos_stats_get(rtos_stats_snapshot_t *out)
+{
+    vTaskSuspendAll();
+    *out = s_snap;
+    (void)xTaskResumeAll();
+    return out->t_us != 0U;
+}
+
+/** @brief Task IDLE (uma por núcleo no SMP: "IDLE0", "IDLE1"). */
+static bool is_idle(const char *name)
+{
+    return strncmp(name, "IDLE", 4) == 0;
+}
+
+/** @brief Stack alocado de uma task: registrado na criação ou, nas do kernel, do `FreeRTOSConfig.h`. */
+static uint32_t stack_words_of(const TaskStatus_t *ts)
+{
+    for (uint8_t i = 0; i < s_nstacks; i++)
+    {
+        if (s_stacks[i].handle == ts->xHandle)
+        {
+            return s_stacks[i].words;
+        }
+    }
+    if (is_idle(ts->pcTaskName))
+    {
+        return configMINIMAL_STACK_SIZE;
+    }
+    if (strcmp(ts->pcTaskName, "Tmr Svc") == 0)
+    {
+        return configTIMER_TASK_STACK_DEPTH;
+    }
+    return 0U;
+}
+
+/** @brief Contador do instantâneo anterior da task `number` (NULL se ela é nova). */
+static const run_prev_t *find_prev(UBaseType_t number)
+{
+    for (uint8_t i = 0; i < s_nprev; i++)
+    {
+        if (s_prev[i].number == number)
+        {
+            return &s_prev[i];
+        }
+    }
+    return NULL;
+}
+
+/** @brief Parte em ‰ de `part` sobre `whole`, limitada a 1000. */
+static uint16_t permille(uint32_t part, uint32_t whole)
+{
+    if (whole == 0U)
+    {
+        return 0U;
+    }
+    const uint64_t p = (uint64_t)part * 1000U / whole;
+    return (uint16_t)((p > 1000U) ? 1000U : p);
+}
+
+/**
+ * @brief Monta um instantâneo em `s_work` e o publica.
+ */
+static void take_snapshot(void)
+{
+    rtos_stats_snapshot_t *w = &s_work;
+    const UBaseType_t n = uxTaskGetSystemState(s_status, RTOS_STATS_MAX_TASKS, NULL);
+    const uint64_t now = time_us_64();
+    const uint32_t period = (uint32_t)(now - s_prev_t_us);
+    uint32_t idle_us = 0;
+
+    w->t_us = now;
+    w->period_us = period;
+    w->seq++;
+    w->ntasks = (uint8_t)n;
+
+    /* Com o vetor pequeno o kernel não devolve nenhuma task */
+    if (n == 0U && !s_warned_max)
+    {
+        LOGW(TAG, "%lu tasks excedem RTOS_STATS_MAX_TASKS (%u); instantâneo sem tasks.",
+             (unsigned long)uxTaskGetNumberOfTasks(), (unsigned)RTOS_STATS_MAX_TASKS);
+        s_warned_max = true;
+    }
+
+    for (UBaseType_t i = 0; i < n; i++)
+    {
+        const TaskStatus_t *ts = &s_status[i];
+        rtos_task_stat_t *t = &w->tasks[i];
+        const run_prev_t *prev = find_prev(ts->xTaskNumber);
+        const uint32_t run = (uint32_t)ts->ulRunTimeCounter;
+        const uint32_t delta = run - (prev ? prev->run_us : 0U);
+
+        strncpy(t->name, ts->pcTaskName, sizeof(t->name) - 1U);
+        t->name[sizeof(t->name) - 1U] = '\0';
+        t->stack_words = stack_words_of(ts);
+        t->stack_free_min = (uint32_t)ts->usStackHighWaterMark;
+        t->cpu_permille = permille(delta, period);
+        t->priority = (uint8_t)ts->uxCurrentPriority;
+        t->state = (uint8_t)ts->eCurrentState;
+
+        if (is_idle(t->name))
+        {
+            idle_us += delta;
+        }
+
+        s_cur[i].number = ts->xTaskNumber;
+        s_cur[i].run_us = run;
+        s_cur[i].warned = prev ? prev->warned : false;
+        if (t->stack_free_min < RTOS_STATS_STACK_LOW_WORDS && !s_cur[i].warned)
+        {
+            LOGW(TAG, "Task %s com folga de stack de %lu palavras (de %lu).", t->name,
+                 (unsigned long)t->stack_free_min, (unsigned long)t->stack_words);
+            s_cur[i].warned = true;
+        }
+    }
+    memcpy(s_prev, s_cur, sizeof(s_prev[0]) * n);
+    s_nprev = (uint8_t)n;
+    s_prev_t_us = now;
+    w->cpu_busy_permille = (uint16_t)(1000U - permille(idle_us, period));
+
+    HeapStats_t hs;
+    vPortGetHeapStats(&hs);
+    w->heap_free = (uint32_t)hs.xAvailableHeapSpaceInBytes;
+    w->heap_min_free = (uint32_t)hs.xMinimumEverFreeBytesRemaining;
+    w->heap_largest = (uint32_t)hs.xSizeOfLargestFreeBlockInBytes;
+    w->heap_allocs = (uint32_t)hs.xNumberOfSuccessfulAllocations;
+    w->heap_frees = (uint32_t)hs.xNumberOfSuccessfulFrees;
+
+    w->nqueues = s_nqueues;
+    for (uint8_t i = 0; i < s_nqueues; i++)
+    {
+        queue_reg_t *r = &s_queues[i];
+        rtos_queue_stat_t *q = &w->queues[i];
+        const UBaseType_t waiting = uxQueueMessagesWaiting(r->queue);
+
+        if (waiting > r->max)
+        {
+            r->max = (uint16_t)waiting;
+        }
+        q->name = r->name;
+        q->waiting = (uint16_t)waiting;
+        q->waiting_max = r->max;
+        q->capacity = (uint16_t)(waiting + uxQueueSpacesAvailable(r->queue));
+    }
+
+    vTaskSuspendAll();
+    s_snap = *w;
+    (void)xTaskResumeAll();
+}
+
+/**
+ * @brief Resumo no log: uma linha de CPU/heap/menor folga; por task e por fila em depuração.
+ */
+static void log_snapshot(const rtos_stats_snapshot_t *s)
+{
+    const rtos_task_stat_t *worst = NULL;
+
+    for (uint8_t i = 0; i < s->ntasks; i++)
+    {
+        const rtos_task_stat_t *t = &s->tasks[i];
+        if (!worst || t->stack_free_min < worst->stack_free_min)
+        {
+            worst = t;
+        }
+        LOGD(TAG, "%s: CPU %u.%u%%, stack %lu livres de %lu", t->name, t->cpu_permille / 10U,
+             t->cpu_permille % 10U, (unsigned long)t->stack_free_min, (unsigned long)t->stack_words);
+    }
+    for (uint8_t i = 0; i < s->nqueues; i++)
+    {
+        const rtos_queue_stat_t *q = &s->queues[i];
+        LOGD(TAG, "Fila %s: %u/%u (max %u)", q->name, q->waiting, q->capacity, q->waiting_max);
+    }
+
+    LOG(TAG, "CPU %u.%u%% | heap %lu livres, min %lu, bloco %lu | menor folga: %s %lu palavras",
+        s->cpu_busy_permille / 10U, s->cpu_busy_permille % 10U, (unsigned long)s->heap_free,
+        (unsigned long)s->heap_min_free, (unsigned long)s->heap_largest, worst ? worst->name : "-",
+        worst ? (unsigned long)worst->stack_free_min : 0UL);
+}
+
+/**
+ * @brief Recomendação de stack no log, uma vez, após `RTOS_STATS_REPORT_S` de operação.
+ */
+static void log_stack_report(const rtos_stats_snapshot_t *s)
+{
+    LOG(TAG, "Recomendacao de stack apos %lu h (pico + %u%%):", (unsigned long)(s->t_us / 3600000000ULL),
+        (unsigned)RTOS_STATS_STACK_MARGIN_PCT);
+
+    for (uint8_t i = 0; i < s->ntasks; i++)
+    {
+        const rtos_task_stat_t *t = &s->tasks[i];
+        if (t->stack_words != 0U)
+        {
+            LOG(TAG, "  %s: %lu -> %lu palavras", t->name, (unsigned long)t->stack_words,
+                (unsigned long)rtos_stats_recommend_stack(t->stack_words, t->stack_free_min));
+        }
+    }
+}
+
+/** @brief Relatório de `rtos stack`: pico, recomendação e RAM recuperável por task. */
+static void print_stack_report(const rtos_stats_snapshot_t *s)
+{
+    int32_t total = 0;
+
+    printf("Stack apos %lu min de operacao (recomendado = pico + %u%%, multiplo de %u palavras):\n",
+           (unsigned long)(s->t_us / 60000000ULL), (unsigned)RTOS_STATS_STACK_MARGIN_PCT,
+           (unsigned)RTOS_STATS_STACK_ROUND);
+    printf("%-16s %8s %6s %11s %8s\n", "task", "alocado", "pico", "recomendado", "ganho");
+
+    for (uint8_t i = 0; i < s->ntasks; i++)
+    {
+        const rtos_task_stat_t *t = &s->tasks[i];
+        if (t->stack_words == 0U)
+        {
+            printf("%-16s %8s %6s %11s %8s\n", t->name, "?", "?", "-", "-");
+            continue;
+        }
+
+        const uint32_t rec = rtos_stats_recommend_stack(t->stack_words, t->stack_free_min);
+        const int32_t gain = (int32_t)t->stack_words - (int32_t)rec;
+        total += (gain > 0) ? gain : 0;
+        printf("%-16s %8lu %6lu %11lu %+8ld%s\n", t->name, (unsigned long)t->stack_words,
+               (unsigned long)(t->stack_words - t->stack_free_min), (unsigned long)rec, (long)gain,
+               (is_idle(t->name) || strcmp(t->name, "Tmr Svc") == 0) ? "  (FreeRTOSConfig.h)" : "");
+    }
+
+    printf("Recuperavel: %ld palavras (%ld bytes). O pico so cobre os caminhos ja executados.\n", (long)total,
+           (long)total * (long)sizeof(StackType_t));
+}
+
+/** @brief Nome curto de `eTaskState`. */
+static const char *state_name(uint8_t st)
+{
+    static const char *const k_states[] = {"exec", "pronta", "bloq", "susp", "apagada"};
+    return (st < sizeof(k_states) / sizeof(k_states[0])) ? k_states[st] : "?";
+}
+
+/**
+ * @brief Comando serial "rtos": último instantâneo; "rtos stack": recomendação de stack.
+ */
+static void rtos_cmd(int argc, char **argv)
+{
+    static rtos_stats_snapshot_t s; /* Fora do stack da task do console */
+
+    if (!rtos_stats_get(&s))
+    {
+        printf("Nenhum instantaneo ainda (a cada %u s).\n", (unsigned)(RTOS_STATS_PERIOD_MS / 1000U));
+        return;
+    }
+    if (argc > 1 && strcmp(argv[1], "stack") == 0)
+    {
+        print_stack_report(&s);
+        return;
+    }
+
+    printf("Instantaneo %lu, ha %lu s (periodo %lu ms): CPU ocupada %u.%u%%\n", (unsigned long)s.seq,
+           (unsigned long)((time_us_64() - s.t_us) / 1000000U), (unsigned long)(s.period_us / 1000U),
+           s.cpu_busy_permille / 10U, s.cpu_busy_permille % 10U);
+    printf("Heap: %lu livres de %lu | min %lu | maior bloco %lu | %lu alocacoes, %lu liberacoes\n",
+           (unsigned long)s.heap_free, (unsigned long)configTOTAL_HEAP_SIZE, (unsigned long)s.heap_min_free,
+           (unsigned long)s.heap_largest, (unsigned long)s.heap_allocs, (unsigned long)s.heap_frees);
+    printf("%-16s %6s %4s %7s %7s %6s\n", "task", "CPU%", "prio", "estado", "stack", "folga");
+    for (uint8_t i = 0; i < s.ntasks; i++)
+    {
+        const rtos_task_stat_t *t = &s.tasks[i];
+        printf("%-16s %4u.%u %4u %7s %7lu %6lu\n", t->name, t->cpu_permille / 10U, t->cpu_permille % 10U,
+               t->priority, state_name(t->state), (unsigned long)t->stack_words, (unsigned long)t->stack_free_min);
+    }
+    for (uint8_t i = 0; i < s.nqueues; i++)
+    {
+        const rtos_queue_stat_t *q = &s.queues[i];
+        printf("Fila %-16s %3u/%-3u (max %u)\n", q->name, q->waiting, q->capacity, q->waiting_max);
+    }
+}
+
+/**
+ * @brief Registra o comando serial `rtos`.
+ */
+void rtos_stats_init(void)
+{
+    (void)serial_cmd_register(&s_rtos_cmd);
+}
+
+/**
+ * @brief Task de coleta: um instantâneo a cada `RTOS_STATS_PERIOD_MS`.
+ * @param params Não utilizado.
+ */
+void rtos_stats_task(void *params)
+{
+    (void)params;
+    TickType_t last = xTaskGetTickCount();
+
+    for (;;)
+    {
+        vTaskDelayUntil(&last, pdMS_TO_TICKS(RTOS_STATS_PERIOD_MS));
+        take_snapshot();
+
+        if (s_work.seq % RTOS_STATS_LOG_EVERY == 0U)
+        {
+            log_snapshot(&s_work);
+        }
+        if (!s_reported && s_work.t_us >= (uint64_t)RTOS_STATS_REPORT_S * 1000000U)
+        {
+            log_stack_report(&s_work);
+            s_reported = true;
+        }
+    }
+}
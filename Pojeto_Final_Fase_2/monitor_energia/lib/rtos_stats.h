@@ -0,0 +1,86 @@
+/**
+ * @file rtos_stats.h
+ * @brief Estatísticas de execução do FreeRTOS: CPU e stack por task, heap e filas, em instantâneos periódicos.
+ * @details
+ *  A `rtos_stats_task` tira um instantâneo a cada `RTOS_STATS_PERIOD_MS`:
+ *  uso de CPU de cada task no período (contador de tempo de execução do
+ *  kernel, em µs de `time_us_64`, ver `FreeRTOSConfig.h`), menor folga de
+ *  stack desde o boot, heap-4 (livre, menor livre já visto, maior bloco) e
+ *  ocupação das filas observadas. O resumo vai ao logger a cada
+ *  `RTOS_STATS_LOG_EVERY` instantâneos (o detalhe por task em depuração) e
+ *  o instantâneo inteiro ao comando serial `rtos`.
+ *
+ *  Para recomendar tamanhos de stack, o tamanho alocado de cada task precisa
+ *  ser conhecido: as tasks da aplicação são criadas por
+ *  `rtos_stats_create_task` (que o registra); as do kernel (IDLE, timers)
+ *  vêm do `FreeRTOSConfig.h`. `rtos stack` mostra, para cada uma, o pico
+ *  de uso, a recomendação (pico + `RTOS_STATS_STACK_MARGIN_PCT`, arredondada
+ *  a `RTOS_STATS_STACK_ROUND` palavras) e a RAM recuperável. O pico só cobre
+ *  os caminhos já executados: o relatório vale após horas de operação com
+ *  Wi‑Fi caindo e voltando, SD, consultas e comandos exercitados.
+ */
+
+#ifndef RTOS_STATS_H
+#define RTOS_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+#define RTOS_STATS_PERIOD_MS        10000U  /**< Intervalo entre instantâneos. */
+#define RTOS_STATS_LOG_EVERY        6U      /**< Instantâneos entre resumos no log (1 min). */
+#define RTOS_STATS_MAX_TASKS        24U     /**< Tasks no instantâneo (acima disso sai sem tasks). */
+#define RTOS_STATS_MAX_QUEUES       10U     /**< Filas observadas. */
+#define RTOS_STATS_STACK_MARGIN_PCT 25U     /**< Folga sobre o pico medido na recomendação [%]. */
+#define RTOS_STATS_STACK_ROUND      64U     /**< Arredondamento da recomendação [palavras]. */
+#define RTOS_STATS_STACK_LOW_WORDS  64U     /**< Folga abaixo da qual a task é avisada no log [palavras]. */
+
+/** @brief Uma task no instantâneo. */
+typedef struct
+{
+    char name[configMAX_TASK_NAME_LEN]; /**< Nome (truncado pelo kernel). */
+    uint32_t stack_words;       /**< Stack alocado [palavras] (0: desconhecido). */
+    uint32_t stack_free_min;    /**< Menor folga desde o boot [palavras]. */
+    uint16_t cpu_permille;      /**< CPU no último período [‰]. */
+    uint8_t priority;           /**< Prioridade corrente. */
+    uint8_t state;              /**< `eTaskState`. */
+} rtos_task_stat_t;
+
+/** @brief Uma fila observada no instantâneo. */
+typedef struct
+{
+    const char *name;           /**< Nome dado em `rtos_stats_watch_queue`. */
+    uint16_t waiting;           /**< Itens na fila. */
+    uint16_t waiting_max;       /**< Maior ocupação vista nos instantâneos. */
+    uint16_t capacity;          /**< Tamanho da fila. */
+} rtos_queue_stat_t;
+
+/** @brief Instantâneo completo. */
+typedef struct
+{
+    uint64_t t_us;              /**< Instante (`time_us_64`, 0: nenhum ainda). */
+    uint32_t period_us;         /**< Duração do período da CPU. */
+    uint32_t seq;               /**< Número do instantâneo. */
+    uint32_t heap_free;         /**< Heap livre [bytes]. */
+    uint32_t heap_min_free;     /**< Menor heap livre desde o boot [bytes]. */
+    uint32_t heap_largest;      /**< Maior bloco livre (fragmentação) [bytes]. */
+    uint32_t heap_allocs;       /**< Alocações desde o boot. */
+    uint32_t heap_frees;        /**< Liberações desde o boot. */
+    uint16_t cpu_busy_permille; /**< CPU fora das tasks IDLE [‰]. */
+    uint8_t ntasks;             /**< Entradas em `tasks`. */
+    uint8_t nqueues;            /**< Entradas em `queues`. */
+    rtos_task_stat_t tasks[RTOS_STATS_MAX_TASKS];       /**< Tasks, na ordem do kernel. */
+    rtos_queue_stat_t queues[RTOS_STATS_MAX_QUEUES];    /**< Filas, na ordem de registro. */
+} rtos_stats_snapshot_t;
+
+BaseType_t rtos_stats_create_task(TaskFunction_t fn, const char *name, uint32_t stack_words, void *params,
+                                  UBaseType_t priority, TaskHandle_t *handle);
+void rtos_stats_watch_queue(QueueHandle_t q, const char *name);
+bool rtos_stats_get(rtos_stats_snapshot_t *out);
+uint32_t rtos_stats_recommend_stack(uint32_t stack_words, uint32_t free_min);
+void rtos_stats_init(void);
+void rtos_stats_task(void *params);
+
+#endif /* RTOS_STATS_H */
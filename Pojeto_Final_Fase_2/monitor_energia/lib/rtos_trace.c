@@ -0,0 +1,367 @@
+/**
+ * @file rtos_trace.c
+ * @brief Anel de eventos do FreeRTOS, imagem de despejo e console por teclas (USB).
+ */
+
+#include "lib/rtos_trace.h"
+
+#if RTOS_TRACE_ENABLE
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+#if (RTOS_TRACE_EVENTS & (RTOS_TRACE_EVENTS - 1U)) != 0U
+#error "RTOS_TRACE_EVENTS deve ser potência de 2"
+#endif
+
+#define RTOS_TRACE_HEX_BYTES    32U     /**< Bytes por linha do despejo em hexadecimal. */
+#define RTOS_TRACE_NO_TASK      0xFFFFU /**< Nenhuma troca gravada ainda. */
+
+_Static_assert(sizeof(rtos_trace_event_t) == 8U, "evento da imagem tem 8 bytes");
+
+/** @brief Fila, ISR ou trecho com nome. */
+typedef struct
+{
+    uint8_t kind;           /**< `rtos_trace_name_kind_t`. */
+    uint16_t id;            /**< Id nos eventos. */
+    const char *name;       /**< Nome (literal ou estático). */
+} trace_name_t;
+
+/** @brief Linha em montagem do despejo em hexadecimal. */
+typedef struct
+{
+    char line[RTOS_TRACE_HEX_BYTES * 2U + 1U];
+    uint8_t n;              /**< Bytes na linha. */
+    uint32_t total;         /**< Bytes despejados. */
+} hex_out_t;
+
+volatile bool g_rtos_trace_on = false;
+
+static rtos_trace_event_t s_ring[RTOS_TRACE_EVENTS];
+static uint32_t s_head = 0;             /**< Próxima posição (contínua; índice = s_head % tamanho). */
+static uint32_t s_count = 0;            /**< Eventos válidos no anel. */
+static uint32_t s_overwritten = 0;
+static bool s_oneshot = false;
+static uint16_t s_last_task = RTOS_TRACE_NO_TASK;
+
+static trace_name_t s_names[RTOS_TRACE_MAX_NAMES];
+static uint8_t s_nnames = 0;
+static uint16_t s_next_id[RTOS_TRACE_NAME_SPAN + 1] = {0U, 1U, 1U, 1U};
+static TaskStatus_t s_tasks[RTOS_TRACE_MAX_TASKS];
+
+/**
+ * @brief Grava um evento (ganchos do kernel, ISRs e tasks).
+ * @note Na RAM (`__time_critical_func`): roda dentro da troca de contexto.
+ */
+void __time_critical_func(rtos_trace_event)(uint8_t type, uint16_t id, uint32_t aux)
+{
+    const uint32_t irq = save_and_disable_interrupts();
+
+    if (!g_rtos_trace_on || (type == RTOS_TRACE_EV_SWITCH_IN && id == s_last_task))
+    {
+        restore_interrupts(irq);
+        return;
+    }
+
+    if (s_count == RTOS_TRACE_EVENTS)
+    {
+        if (s_oneshot)
+        {
+            g_rtos_trace_on = false;
+            restore_interrupts(irq);
+            return;
+        }
+        s_overwritten++;
+    }
+    else
+    {
+        s_count++;
+    }
+
+    if (type == RTOS_TRACE_EV_SWITCH_IN)
+    {
+        s_last_task = id;
+    }
+
+    rtos_trace_event_t *e = &s_ring[s_head & (RTOS_TRACE_EVENTS - 1U)];
+    s_head++;
+    e->t_us = time_us_32();
+    e->type = type;
+    e->aux = (uint8_t)((aux > 0xFFU) ? 0xFFU : aux);
+    e->id = id;
+
+    restore_interrupts(irq);
+}
+
+/**
+ * @brief Esvazia o anel e começa a gravar.
+ * @param oneshot true: para com o anel cheio; false: sobrescreve os mais antigos.
+ */
+void rtos_trace_start(bool oneshot)
+{
+    const uint32_t irq = save_and_disable_interrupts();
+    s_head = 0;
+    s_count = 0;
+    s_overwritten = 0;
+    s_oneshot = oneshot;
+    s_last_task = RTOS_TRACE_NO_TASK;
+    g_rtos_trace_on = true;
+    restore_interrupts(irq);
+
+    /* A task que chamou é a primeira fatia (`xTaskNumber` é o `uxTCBNumber` do gancho) */
+    if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+    {
+        TaskStatus_t ts;
+        vTaskGetInfo(NULL, &ts, pdFALSE, eInvalid);
+        rtos_trace_event(RTOS_TRACE_EV_SWITCH_IN, (uint16_t)ts.xTaskNumber, 0U);
+    }
+}
+
+/** @brief Para a gravação (o anel fica para o despejo). */
+void rtos_trace_stop(void)
+{
+    g_rtos_trace_on = false;
+}
+
+/** @brief Copia o estado do gravador. */
+void rtos_trace_get_status(rtos_trace_status_t *out)
+{
+    const uint32_t irq = save_and_disable_interrupts();
+    out->on = g_rtos_trace_on;
+    out->oneshot = s_oneshot;
+    out->count = s_count;
+    out->overwritten = s_overwritten;
+    out->span_us = (s_count > 1U) ? s_ring[(s_head - 1U) & (RTOS_TRACE_EVENTS - 1U)].t_us -
+                                        s_ring[(s_head - s_count) & (RTOS_TRACE_EVENTS - 1U)].t_us
+                                  : 0U;
+    restore_interrupts(irq);
+}
+
+/**
+ * @brief Dá um id a um nome da espécie `kind`.
+ * @return Id (a partir de 1), ou 0 com a tabela cheia.
+ */
+static uint16_t add_name(uint8_t kind, const char *name)
+{
+    uint16_t id = 0;
+
+    taskENTER_CRITICAL();
+    if (s_nnames < RTOS_TRACE_MAX_NAMES)
+    {
+        id = s_next_id[kind]++;
+        s_names[s_nnames].kind = kind;
+        s_names[s_nnames].id = id;
+        s_names[s_nnames].name = name;
+        s_nnames++;
+    }
+    taskEXIT_CRITICAL();
+    return id;
+}
+
+/**
+ * @brief Dá nome e id a uma fila (ou semáforo/mutex): só as nomeadas geram eventos.
+ * @return Id da fila nos eventos (0: tabela cheia, fila não gravada).
+ */
+uint16_t rtos_trace_name_queue(void *queue, const char *name)
+{
+    if (!queue)
+    {
+        return 0U;
+    }
+
+    const uint16_t id = add_name(RTOS_TRACE_NAME_QUEUE, name);
+    vQueueSetQueueNumber((QueueHandle_t)queue, id);
+    return id;
+}
+
+/** @brief Id de uma ISR da aplicação para `RTOS_TRACE_ISR_ENTER/EXIT`. */
+uint16_t rtos_trace_isr(const char *name)
+{
+    return add_name(RTOS_TRACE_NAME_ISR, name);
+}
+
+/** @brief Id de um trecho da aplicação para `RTOS_TRACE_SPAN_BEGIN/END`. */
+uint16_t rtos_trace_span(const char *name)
+{
+    return add_name(RTOS_TRACE_NAME_SPAN, name);
+}
+
+/** @brief Grava `v` em little-endian. */
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+/** @brief Grava `v` em little-endian. */
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    put_u16(p, (uint16_t)v);
+    put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+/** @brief Entrega uma entrada da tabela de nomes. */
+static bool write_name(rtos_trace_write_fn fn, void *ctx, uint8_t kind, uint16_t id, const char *name)
+{
+    uint8_t e[RTOS_TRACE_NAME_SIZE] = {0};
+
+    e[0] = kind;
+    put_u16(&e[2], id);
+    strncpy((char *)&e[4], name, RTOS_TRACE_NAME_LEN - 1U);
+    return fn(ctx, e, sizeof(e));
+}
+
+/**
+ * @brief Para a gravação e entrega a imagem: cabeçalho, nomes e eventos do mais antigo ao mais novo.
+ * @details
+ *  Cabeçalho (`RTOS_TRACE_HDR_SIZE` bytes, little-endian): magic u32,
+ *  versão u16, tamanho do evento u16, eventos u32, sobrescritos u32, nomes
+ *  u16, flags u16 (bit 0: modo único), `time_us_32` do despejo u32. Nomes:
+ *  espécie u8, reservado u8, id u16, nome[`RTOS_TRACE_NAME_LEN`]. Os nomes
+ *  das tasks são os das existentes no despejo.
+ * @return false se o destino recusou algum trecho.
+ */
+bool rtos_trace_dump(rtos_trace_write_fn fn, void *ctx)
+{
+    rtos_trace_stop();
+
+    const UBaseType_t ntasks = uxTaskGetSystemState(s_tasks, RTOS_TRACE_MAX_TASKS, NULL);
+    uint8_t hdr[RTOS_TRACE_HDR_SIZE];
+
+    put_u32(&hdr[0], RTOS_TRACE_MAGIC);
+    put_u16(&hdr[4], RTOS_TRACE_VERSION);
+    put_u16(&hdr[6], (uint16_t)sizeof(rtos_trace_event_t));
+    put_u32(&hdr[8], s_count);
+    put_u32(&hdr[12], s_overwritten);
+    put_u16(&hdr[16], (uint16_t)(ntasks + s_nnames));
+    put_u16(&hdr[18], s_oneshot ? 1U : 0U);
+    put_u32(&hdr[20], time_us_32());
+    if (!fn(ctx, hdr, sizeof(hdr)))
+    {
+        return false;
+    }
+
+    for (UBaseType_t i = 0; i < ntasks; i++)
+    {
+        if (!write_name(fn, ctx, RTOS_TRACE_NAME_TASK, (uint16_t)s_tasks[i].xTaskNumber, s_tasks[i].pcTaskName))
+        {
+            return false;
+        }
+    }
+    for (uint8_t i = 0; i < s_nnames; i++)
+    {
+        if (!write_name(fn, ctx, s_names[i].kind, s_names[i].id, s_names[i].name))
+        {
+            return false;
+        }
+    }
+
+    /* Eventos em até dois trechos contíguos do anel (RP2040 é little-endian) */
+    const uint32_t first = (s_head - s_count) & (RTOS_TRACE_EVENTS - 1U);
+    const uint32_t n1 = (first + s_count <= RTOS_TRACE_EVENTS) ? s_count : RTOS_TRACE_EVENTS - first;
+    const uint32_t n2 = s_count - n1;
+
+    if (n1 && !fn(ctx, &s_ring[first], n1 * sizeof(rtos_trace_event_t)))
+    {
+        return false;
+    }
+    return !n2 || fn(ctx, &s_ring[0], n2 * sizeof(rtos_trace_event_t));
+}
+
+/** @brief Destino hexadecimal do despejo: linhas de `RTOS_TRACE_HEX_BYTES` bytes. */
+static bool hex_write(void *ctx, const void *data, size_t len)
+{
+    static const char k_hex[] = "0123456789abcdef";
+    hex_out_t *h = (hex_out_t *)ctx;
+    const uint8_t *p = (const uint8_t *)data;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        h->line[h->n * 2U] = k_hex[p[i] >> 4];
+        h->line[h->n * 2U + 1U] = k_hex[p[i] & 0x0FU];
+        h->total++;
+        if (++h->n == RTOS_TRACE_HEX_BYTES)
+        {
+            h->line[h->n * 2U] = '\0';
+            printf("%s\n", h->line);
+            h->n = 0;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Despeja a imagem no stdio em hexadecimal, entre marcadores (para `tools/rtos_trace_json.c`).
+ * @return false se o despejo falhou.
+ */
+bool rtos_trace_dump_usb(void)
+{
+    static hex_out_t h;
+
+    memset(&h, 0, sizeof(h));
+    printf("=== RTOS TRACE BEGIN ===\n");
+    const bool ok = rtos_trace_dump(hex_write, &h);
+    if (h.n)
+    {
+        h.line[h.n * 2U] = '\0';
+        printf("%s\n", h.line);
+    }
+    printf("=== RTOS TRACE END %lu ===\n", (unsigned long)h.total);
+    return ok;
+}
+
+/** @brief Uma linha com o estado do gravador. */
+static void print_status(void)
+{
+    rtos_trace_status_t st;
+    rtos_trace_get_status(&st);
+    printf("trace %s (%s): %lu/%u eventos, %lu sobrescritos, %lu ms cobertos\n", st.on ? "gravando" : "parado",
+           st.oneshot ? "unico" : "continuo", (unsigned long)st.count, (unsigned)RTOS_TRACE_EVENTS,
+           (unsigned long)st.overwritten, (unsigned long)(st.span_us / 1000U));
+}
+
+/**
+ * @brief Console por teclas no stdio USB, para projetos sem console de comandos.
+ * @details 't' grava contínuo, 'o' grava único, 's' para, 'd' despeja, '?' estado.
+ * @param params Não utilizado.
+ */
+void rtos_trace_console_task(void *params)
+{
+    (void)params;
+
+    for (;;)
+    {
+        const int c = getchar_timeout_us(0);
+
+        switch (c)
+        {
+        case 't':
+        case 'o':
+            rtos_trace_start(c == 'o');
+            print_status();
+            break;
+        case 's':
+            rtos_trace_stop();
+            print_status();
+            break;
+        case 'd':
+            (void)rtos_trace_dump_usb();
+            break;
+        case '?':
+            print_status();
+            printf("teclas: t continuo, o unico, s parar, d despejar\n");
+            break;
+        default:
+            vTaskDelay(pdMS_TO_TICKS(100));
+            break;
+        }
+    }
+}
+
+#endif /* RTOS_TRACE_ENABLE */
@@ -0,0 +1,208 @@
+/**
+ * @file rtos_trace.h
+ * @brief Gravador de eventos do FreeRTOS (trocas de contexto, filas, ISRs, trechos) num anel em RAM.
+ * @details
+ *  Incluído no fim do `FreeRTOSConfig.h`, define as macros de trace do
+ *  kernel: `traceTASK_SWITCHED_IN`, envio/recebimento/bloqueio/falha em
+ *  filas (também semáforos e mutexes, que são filas) e as variantes
+ *  `FromISR`. Cada evento ocupa 8 bytes (µs de `time_us_32`, tipo, auxiliar
+ *  e id) num anel de `RTOS_TRACE_EVENTS` entradas. Parado, cada gancho custa
+ *  a leitura de uma flag; gravando, um trecho curto com interrupções
+ *  desligadas. Trocas para a mesma task (ex.: `taskYIELD` sem outra pronta)
+ *  não são gravadas, e só as filas com nome (`rtos_trace_name_queue`) geram
+ *  eventos.
+ *
+ *  O kernel não tem ganchos de entrada/saída de ISR: as ISRs da aplicação
+ *  se marcam com `RTOS_TRACE_ISR_ENTER/EXIT` (id de `rtos_trace_isr`), e o
+ *  que as demais fazem com filas aparece nos eventos `FromISR`. Trechos da
+ *  aplicação (amostragem, envio) se marcam com `RTOS_TRACE_SPAN_BEGIN/END`.
+ *
+ *  Modos: contínuo (o anel sobrescreve os mais antigos; parar logo após o
+ *  fenômeno) ou único (para sozinho com o anel cheio). O despejo
+ *  (`rtos_trace_dump`) para a gravação e produz a imagem binária: cabeçalho,
+ *  nomes (tasks, filas, ISRs, trechos) e eventos do mais antigo ao mais
+ *  novo; `rtos_trace_dump_usb` a imprime em hexadecimal entre marcadores.
+ *  `tools/rtos_trace_json.c` converte a imagem (arquivo do SD ou captura da
+ *  serial) para o formato JSON do Chrome/Perfetto.
+ *
+ *  Só depende do SDK e do FreeRTOS, para servir também aos exercícios de
+ *  `atividades/semana_12` (console por teclas em `rtos_trace_console_task`).
+ *  Núcleo único: com o port SMP, os eventos dos dois núcleos se misturariam.
+ *  Sem `RTOS_TRACE_ENABLE` (padrão dos CMakeLists: 0) tudo some da
+ *  compilação; é uma ferramenta de depuração, ligada com
+ *  `-DRTOS_TRACE_ENABLE=1` para a sessão de medição.
+ */
+
+#ifndef RTOS_TRACE_H
+#define RTOS_TRACE_H
+
+#ifndef RTOS_TRACE_ENABLE
+/** @brief 1: ganchos do kernel e gravador compilados (definido pelo CMake). */
+#define RTOS_TRACE_ENABLE       0
+#endif
+
+#ifndef RTOS_TRACE_EVENTS
+/** @brief Entradas do anel (potência de 2; 8 bytes cada). */
+#define RTOS_TRACE_EVENTS       2048U
+#endif
+
+#ifndef RTOS_TRACE_TICKS
+/** @brief 1: grava também cada tick do SysTick (1 kHz; enche o anel 10x mais rápido). */
+#define RTOS_TRACE_TICKS        0
+#endif
+
+#define RTOS_TRACE_MAGIC        0x52545452UL    /**< "RTTR" em little-endian. */
+#define RTOS_TRACE_VERSION      1U              /**< Versão da imagem de despejo. */
+#define RTOS_TRACE_MAX_NAMES    24U             /**< Filas, ISRs e trechos com nome. */
+#define RTOS_TRACE_MAX_TASKS    24U             /**< Tasks com nome no despejo. */
+#define RTOS_TRACE_NAME_LEN     16U             /**< Bytes de um nome na imagem (com '\0'). */
+#define RTOS_TRACE_HDR_SIZE     24U             /**< Cabeçalho da imagem. */
+#define RTOS_TRACE_NAME_SIZE    (4U + RTOS_TRACE_NAME_LEN) /**< Entrada da tabela de nomes. */
+
+#ifndef __ASSEMBLER__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Tipos de evento (`rtos_trace_event_t::type`). */
+typedef enum
+{
+    RTOS_TRACE_EV_SWITCH_IN = 1,    /**< Task `id` passa a executar. */
+    RTOS_TRACE_EV_QUEUE_SEND,       /**< Envio à fila `id`; aux: itens antes. */
+    RTOS_TRACE_EV_QUEUE_RECV,       /**< Recebimento da fila `id`; aux: itens antes. */
+    RTOS_TRACE_EV_QUEUE_SEND_ISR,   /**< Envio em ISR. */
+    RTOS_TRACE_EV_QUEUE_RECV_ISR,   /**< Recebimento em ISR. */
+    RTOS_TRACE_EV_QUEUE_BLOCK_SEND, /**< Task bloqueia com a fila cheia. */
+    RTOS_TRACE_EV_QUEUE_BLOCK_RECV, /**< Task bloqueia com a fila vazia. */
+    RTOS_TRACE_EV_QUEUE_FAIL,       /**< Tempo esgotado; aux: 0 envio, 1 recebimento. */
+    RTOS_TRACE_EV_ISR_ENTER,        /**< Entrada na ISR `id`. */
+    RTOS_TRACE_EV_ISR_EXIT,         /**< Saída da ISR `id`. */
+    RTOS_TRACE_EV_SPAN_BEGIN,       /**< Início do trecho `id`. */
+    RTOS_TRACE_EV_SPAN_END,         /**< Fim do trecho `id`. */
+    RTOS_TRACE_EV_TICK,             /**< Tick do kernel (`RTOS_TRACE_TICKS`). */
+} rtos_trace_type_t;
+
+/** @brief Espécies de nome na imagem. */
+typedef enum
+{
+    RTOS_TRACE_NAME_TASK = 0,       /**< Task (`xTaskNumber`). */
+    RTOS_TRACE_NAME_QUEUE,          /**< Fila (`uxQueueNumber`). */
+    RTOS_TRACE_NAME_ISR,            /**< ISR da aplicação. */
+    RTOS_TRACE_NAME_SPAN,           /**< Trecho da aplicação. */
+} rtos_trace_name_kind_t;
+
+/** @brief Evento no anel e na imagem (little-endian). */
+typedef struct
+{
+    uint32_t t_us;                  /**< `time_us_32` (volta a cada ~71 min). */
+    uint8_t type;                   /**< `rtos_trace_type_t`. */
+    uint8_t aux;                    /**< Auxiliar do tipo (limitado a 255). */
+    uint16_t id;                    /**< Task, fila, ISR ou trecho. */
+} rtos_trace_event_t;
+
+/** @brief Estado do gravador. */
+typedef struct
+{
+    bool on;                        /**< Gravando. */
+    bool oneshot;                   /**< Modo único. */
+    uint32_t count;                 /**< Eventos no anel. */
+    uint32_t overwritten;           /**< Eventos sobrescritos (modo contínuo). */
+    uint32_t span_us;               /**< Intervalo coberto pelo anel. */
+} rtos_trace_status_t;
+
+/**
+ * @brief Destino da imagem de despejo.
+ * @return false para abortar.
+ */
+typedef bool (*rtos_trace_write_fn)(void *ctx, const void *data, size_t len);
+
+#if RTOS_TRACE_ENABLE
+
+#if defined(configUSE_TRACE_FACILITY) && !configUSE_TRACE_FACILITY
+#error "rtos_trace requer configUSE_TRACE_FACILITY 1 (números de task e de fila)"
+#endif
+
+extern volatile bool g_rtos_trace_on;
+
+void rtos_trace_event(uint8_t type, uint16_t id, uint32_t aux);
+void rtos_trace_start(bool oneshot);
+void rtos_trace_stop(void);
+void rtos_trace_get_status(rtos_trace_status_t *out);
+uint16_t rtos_trace_name_queue(void *queue, const char *name);
+uint16_t rtos_trace_isr(const char *name);
+uint16_t rtos_trace_span(const char *name);
+bool rtos_trace_dump(rtos_trace_write_fn fn, void *ctx);
+bool rtos_trace_dump_usb(void);
+void rtos_trace_console_task(void *params);
+
+/** @brief Grava um evento se o gravador está ligado (uma leitura e um desvio quando parado). */
+#define RTOS_TRACE_EVENT(type, id, aux)                               \
+    do                                                                \
+    {                                                                 \
+        if (g_rtos_trace_on)                                          \
+        {                                                             \
+            rtos_trace_event((uint8_t)(type), (uint16_t)(id), (uint32_t)(aux)); \
+        }                                                             \
+    } while (0)
+
+#define RTOS_TRACE_ISR_ENTER(id)    RTOS_TRACE_EVENT(RTOS_TRACE_EV_ISR_ENTER, (id), 0U)
+#define RTOS_TRACE_ISR_EXIT(id)     RTOS_TRACE_EVENT(RTOS_TRACE_EV_ISR_EXIT, (id), 0U)
+#define RTOS_TRACE_SPAN_BEGIN(id)   RTOS_TRACE_EVENT(RTOS_TRACE_EV_SPAN_BEGIN, (id), 0U)
+#define RTOS_TRACE_SPAN_END(id)     RTOS_TRACE_EVENT(RTOS_TRACE_EV_SPAN_END, (id), 0U)
+
+/* Evento de fila com nome; expandido dentro de queue.c (Queue_t visível) */
+#define RTOS_TRACE_QUEUE(type, q, aux)                                \
+    do                                                                \
+    {                                                                 \
+        if (g_rtos_trace_on && (q)->uxQueueNumber != 0U)              \
+        {                                                             \
+            rtos_trace_event((uint8_t)(type), (uint16_t)(q)->uxQueueNumber, (uint32_t)(aux)); \
+        }                                                             \
+    } while (0)
+
+/* Ganchos do kernel (FreeRTOS.h só define os que faltam) */
+#define traceTASK_SWITCHED_IN()             RTOS_TRACE_EVENT(RTOS_TRACE_EV_SWITCH_IN, pxCurrentTCB->uxTCBNumber, 0U)
+#define traceQUEUE_SEND(q)                  RTOS_TRACE_QUEUE(RTOS_TRACE_EV_QUEUE_SEND, q, (q)->uxMessagesWaiting)
+#define traceQUEUE_RECEIVE(q)               RTOS_TRACE_QUEUE(RTOS_TRACE_EV_QUEUE_RECV, q, (q)->uxMessagesWaiting)
+#define traceQUEUE_SEND_FROM_ISR(q)         RTOS_TRACE_QUEUE(RTOS_TRACE_EV_QUEUE_SEND_ISR, q, (q)->uxMessagesWaiting)
+#define traceQUEUE_RECEIVE_FROM_ISR(q)      RTOS_TRACE_QUEUE(RTOS_TRACE_EV_QUEUE_RECV_ISR, q, (q)->uxMessagesWaiting)
+#define traceBLOCKING_ON_QUEUE_SEND(q)      RTOS_TRACE_QUEUE(RTOS_TRACE_EV_QUEUE_BLOCK_SEND, q, (q)->uxMessagesWaiting)
+#define traceBLOCKING_ON_QUEUE_RECEIVE(q)   RTOS_TRACE_QUEUE(RTOS_TRACE_EV_QUEUE_BLOCK_RECV, q, (q)->uxMessagesWaiting)
+#define traceQUEUE_SEND_FAILED(q)           RTOS_TRACE_QUEUE(RTOS_TRACE_EV_QUEUE_FAIL, q, 0U)
+#define traceQUEUE_RECEIVE_FAILED(q)        RTOS_TRACE_QUEUE(RTOS_TRACE_EV_QUEUE_FAIL, q, 1U)
+#if RTOS_TRACE_TICKS
+#define traceTASK_INCREMENT_TICK(xTickCount) RTOS_TRACE_EVENT(RTOS_TRACE_EV_TICK, 0U, 0U)
+#endif
+
+#else /* !RTOS_TRACE_ENABLE */
+
+static inline uint16_t rtos_trace_name_queue(void *queue, const char *name)
+{
+    (void)queue;
+    (void)name;
+    return 0U;
+}
+
+static inline uint16_t rtos_trace_isr(const char *name)
+{
+    (void)name;
+    return 0U;
+}
+
+static inline uint16_t rtos_trace_span(const char *name)
+{
+    (void)name;
+    return 0U;
+}
+
+#define RTOS_TRACE_ISR_ENTER(id)    ((void)(id))
+#define RTOS_TRACE_ISR_EXIT(id)     ((void)(id))
+#define RTOS_TRACE_SPAN_BEGIN(id)   ((void)(id))
+#define RTOS_TRACE_SPAN_END(id)     ((void)(id))
+
+#endif /* RTOS_TRACE_ENABLE */
+
+#endif /* __ASSEMBLER__ */
+
+#endif /* RTOS_TRACE_H */
@@ -0,0 +1,121 @@
+/**
+ * @file rtos_trace_cmd.c
+ * @brief Comando serial `trace` e despejo do gravador de eventos no cartão SD.
+ */
+
+#include "lib/rtos_trace_cmd.h"
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "ff.h"
+#include "lib/rtos_trace.h"
+#include "lib/sd_card_log_task.h"
+#include "lib/serial_cmd.h"
+
+#if RTOS_TRACE_ENABLE
+
+static void trace_cmd(int argc, char **argv);
+
+static const serial_cmd_t s_trace_cmd = {
+    .name = "trace",
+    .args = "[start|once|stop|usb|sd]",
+    .help = "Eventos do FreeRTOS em RAM; 'usb'/'sd' despejam para tools/rtos_trace_json.",
+    .fn = trace_cmd,
+};
+
+/** @brief Destino FatFs do despejo. */
+static bool fs_write(void *ctx, const void *data, size_t len)
+{
+    UINT bw = 0;
+    return f_write((FIL *)ctx, data, (UINT)len, &bw) == FR_OK && bw == (UINT)len;
+}
+
+/**
+ * @brief Grava a imagem em `trace/<uptime>.bin`.
+ */
+static void dump_sd(void)
+{
+    static FIL f;
+    char path[24];
+
+    if (!sd_card_log_lock(RTOS_TRACE_SD_LOCK_MS))
+    {
+        printf("FatFs ocupado.\n");
+        return;
+    }
+
+    (void)f_mkdir(RTOS_TRACE_SD_DIR);
+    snprintf(path, sizeof(path), RTOS_TRACE_SD_DIR "/%08lu.bin", (unsigned long)(time_us_64() / 1000000U));
+
+    FRESULT fr = f_open(&f, path, FA_WRITE | FA_CREATE_ALWAYS);
+    bool ok = false;
+    if (fr == FR_OK)
+    {
+        ok = rtos_trace_dump(fs_write, &f);
+        fr = f_close(&f);
+    }
+    sd_card_log_unlock();
+
+    if (ok && fr == FR_OK)
+    {
+        printf("Trace gravado em %s.\n", path);
+    }
+    else
+    {
+        printf("Falha ao gravar %s (FatFs %d).\n", path, (int)fr);
+    }
+}
+
+/**
+ * @brief Comando serial "trace": estado; start/once/stop; despejo usb/sd.
+ */
+static void trace_cmd(int argc, char **argv)
+{
+    const char *op = (argc > 1) ? argv[1] : "";
+
+    if (strcmp(op, "start") == 0 || strcmp(op, "once") == 0)
+    {
+        rtos_trace_start(op[0] == 'o');
+    }
+    else if (strcmp(op, "stop") == 0)
+    {
+        rtos_trace_stop();
+    }
+    else if (strcmp(op, "usb") == 0)
+    {
+        (void)rtos_trace_dump_usb();
+        return;
+    }
+    else if (strcmp(op, "sd") == 0)
+    {
+        dump_sd();
+        return;
+    }
+    else if (argc > 1)
+    {
+        printf("Uso: trace [start|once|stop|usb|sd]\n");
+        return;
+    }
+
+    rtos_trace_status_t st;
+    rtos_trace_get_status(&st);
+    printf("Trace %s (%s): %lu/%u eventos, %lu sobrescritos, %lu ms cobertos\n", st.on ? "gravando" : "parado",
+           st.oneshot ? "unico" : "continuo", (unsigned long)st.count, (unsigned)RTOS_TRACE_EVENTS,
+           (unsigned long)st.overwritten, (unsigned long)(st.span_us / 1000U));
+}
+
+/**
+ * @brief Registra o comando serial `trace` (antes do scheduler).
+ */
+void rtos_trace_cmd_init(void)
+{
+    (void)serial_cmd_register(&s_trace_cmd);
+}
+
+#else /* !RTOS_TRACE_ENABLE */
+
+void rtos_trace_cmd_init(void)
+{
+}
+
+#endif /* RTOS_TRACE_ENABLE */
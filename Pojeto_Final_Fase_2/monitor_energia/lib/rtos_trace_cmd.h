@@ -0,0 +1,20 @@
+/**
+ * @file rtos_trace_cmd.h
+ * @brief Comando serial `trace`: controla o gravador de eventos (`lib/rtos_trace.h`) e o despeja na serial ou no SD.
+ * @details
+ *  `trace start` grava em modo contínuo, `trace once` em modo único,
+ *  `trace stop` para; `trace usb` despeja em hexadecimal no console e
+ *  `trace sd` grava a imagem binária em `trace/<uptime em s>.bin`, com o
+ *  FatFs travado pelo sink do SD (`sd_card_log_lock`). Sem argumentos,
+ *  mostra o estado. As duas saídas são lidas por `tools/rtos_trace_json.c`.
+ */
+
+#ifndef RTOS_TRACE_CMD_H
+#define RTOS_TRACE_CMD_H
+
+#define RTOS_TRACE_SD_DIR       "trace" /**< Diretório das imagens no cartão. */
+#define RTOS_TRACE_SD_LOCK_MS   2000U   /**< Espera máxima pelo FatFs. */
+
+void rtos_trace_cmd_init(void);
+
+#endif /* RTOS_TRACE_CMD_H */
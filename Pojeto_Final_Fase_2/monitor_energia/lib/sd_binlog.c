@@ -0,0 +1,408 @@
+/**
+ * @file sd_binlog.c
+ * @brief Codificação das unidades do log binário do SD e busca por instante.
+ * @details
+ *  Sem dependência do SDK nem alocação: o firmware codifica cada registro
+ *  num buffer de 32 bytes na pilha e o entrega ao escritor do SD; o host
+ *  (`tools/binlog_export.c`) usa as mesmas funções para ler.
+ */
+
+#include "lib/sd_binlog.h"
+#include <string.h>
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static void put_u64(uint8_t *p, uint64_t v)
+{
+    put_u32(p, (uint32_t)v);
+    put_u32(p + 4, (uint32_t)(v >> 32));
+}
+
+static void put_f32(uint8_t *p, float v)
+{
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    put_u32(p, bits);
+}
+
+static uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | ((uint16_t)p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t get_u64(const uint8_t *p)
+{
+    return (uint64_t)get_u32(p) | ((uint64_t)get_u32(p + 4) << 32);
+}
+
+static float get_f32(const uint8_t *p)
+{
+    const uint32_t bits = get_u32(p);
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+/**
+ * @brief CRC‑16/CCITT (polinômio 0x1021), bit a bit, continuando de `crc` (0xFFFF no início).
+ * @note 32 bytes por segundo: a tabela de 512 bytes não compensa.
+ */
+uint16_t sd_binlog_crc16(uint16_t crc, const uint8_t *p, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= (uint16_t)((uint16_t)p[i] << 8);
+        for (uint8_t b = 0; b < 8U; b++)
+        {
+            crc = (crc & 0x8000U) ? (uint16_t)((crc << 1) ^ 0x1021U) : (uint16_t)(crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+/**
+ * @brief CRC da unidade com os bytes 2-3 zerados; com `h` v2, precedido do salt.
+ */
+static uint16_t unit_crc(const uint8_t *u, const sd_binlog_hdr_t *h)
+{
+    uint16_t crc = 0xFFFFU;
+
+    if (h && h->version >= 2U)
+    {
+        uint8_t salt[4];
+        put_u32(salt, h->salt);
+        crc = sd_binlog_crc16(crc, salt, sizeof(salt));
+    }
+
+    static const uint8_t zero[2] = {0U, 0U};
+    crc = sd_binlog_crc16(crc, u, 2U);
+    crc = sd_binlog_crc16(crc, zero, 2U);
+    return sd_binlog_crc16(crc, &u[4], SD_BINLOG_UNIT - 4U);
+}
+
+/**
+ * @brief Codifica o cabeçalho do arquivo (sempre na versão corrente) em `u`.
+ */
+void sd_binlog_put_header(uint8_t *u, const sd_binlog_hdr_t *h)
+{
+    memset(u, 0, SD_BINLOG_UNIT);
+    u[0] = SD_BINLOG_TYPE_HEADER;
+    u[1] = SD_BINLOG_VERSION;
+    memcpy(&u[4], SD_BINLOG_MAGIC, 4U);
+    put_u16(&u[8], SD_BINLOG_UNIT);
+    put_u16(&u[10], SD_BINLOG_SEG_UNITS);
+    put_u32(&u[12], h->salt);
+    put_u64(&u[16], (uint64_t)h->created_unix_us);
+    put_u16(&u[2], unit_crc(u, NULL));
+}
+
+/**
+ * @brief Codifica um registro em `u` (`SD_BINLOG_UNIT` bytes).
+ */
+void sd_binlog_put_record(uint8_t *u, const sd_binlog_hdr_t *h, const sd_binlog_rec_t *r)
+{
+    u[0] = SD_BINLOG_TYPE_RECORD;
+    u[1] = r->flags;
+    put_u32(&u[4], r->seq);
+    put_u64(&u[8], (uint64_t)r->t_unix_us);
+    put_f32(&u[16], r->vrms);
+    put_f32(&u[20], r->irms);
+    put_f32(&u[24], r->v_pu);
+    put_f32(&u[28], r->p_w);
+    put_u16(&u[2], unit_crc(u, h));
+}
+
+/**
+ * @brief Codifica o índice de um segmento em `u` (`SD_BINLOG_UNIT` bytes).
+ */
+void sd_binlog_put_index(uint8_t *u, const sd_binlog_hdr_t *h, const sd_binlog_index_t *ix)
+{
+    u[0] = SD_BINLOG_TYPE_INDEX;
+    u[1] = SD_BINLOG_VERSION;
+    put_u32(&u[4], ix->seq_first);
+    put_u64(&u[8], (uint64_t)ix->t_first);
+    put_u64(&u[16], (uint64_t)ix->t_last);
+    put_u16(&u[24], ix->count);
+    put_u16(&u[26], 0U);
+    put_u32(&u[28], ix->first_off);
+    put_u16(&u[2], unit_crc(u, h));
+}
+
+/**
+ * @brief Codifica um início de sessão em `u` (`SD_BINLOG_UNIT` bytes).
+ */
+void sd_binlog_put_session(uint8_t *u, const sd_binlog_hdr_t *h, const sd_binlog_session_t *s)
+{
+    memset(u, 0, SD_BINLOG_UNIT);
+    u[0] = SD_BINLOG_TYPE_SESSION;
+    u[1] = s->reason;
+    put_u32(&u[4], s->next_seq);
+    put_u64(&u[8], (uint64_t)s->t_start);
+    put_u64(&u[16], (uint64_t)s->t_prev);
+    put_u32(&u[24], s->prev_seq);
+    put_u16(&u[2], unit_crc(u, h));
+}
+
+/**
+ * @brief Codifica uma unidade de enchimento em `u` (`SD_BINLOG_UNIT` bytes).
+ */
+void sd_binlog_put_pad(uint8_t *u, const sd_binlog_hdr_t *h)
+{
+    memset(u, 0, SD_BINLOG_UNIT);
+    u[0] = SD_BINLOG_TYPE_PAD;
+    put_u16(&u[2], unit_crc(u, h));
+}
+
+/**
+ * @brief Confere o CRC de uma unidade.
+ * @param h Cabeçalho do arquivo (NULL para conferir o próprio cabeçalho).
+ * @return Tipo (`SD_BINLOG_TYPE_*`) se íntegra e conhecida; 0 caso contrário
+ *         (enchimento, gravação interrompida, resto de outro arquivo ou dado corrompido).
+ */
+int sd_binlog_check(const uint8_t *u, const sd_binlog_hdr_t *h)
+{
+    if (u[0] != SD_BINLOG_TYPE_HEADER && u[0] != SD_BINLOG_TYPE_RECORD && u[0] != SD_BINLOG_TYPE_INDEX &&
+        u[0] != SD_BINLOG_TYPE_SESSION && u[0] != SD_BINLOG_TYPE_PAD)
+    {
+        return 0;
+    }
+
+    return (unit_crc(u, (u[0] == SD_BINLOG_TYPE_HEADER) ? NULL : h) == get_u16(&u[2])) ? u[0] : 0;
+}
+
+/**
+ * @brief Valida o cabeçalho (tipo, CRC, magic, versão 1 ou 2 e geometria).
+ * @param[out] h Cabeçalho decodificado (usado depois em `sd_binlog_check`).
+ */
+bool sd_binlog_get_header(const uint8_t *u, sd_binlog_hdr_t *h)
+{
+    if (sd_binlog_check(u, NULL) != SD_BINLOG_TYPE_HEADER || u[1] < 1U || u[1] > SD_BINLOG_VERSION ||
+        memcmp(&u[4], SD_BINLOG_MAGIC, 4U) != 0 || get_u16(&u[8]) != SD_BINLOG_UNIT ||
+        get_u16(&u[10]) != SD_BINLOG_SEG_UNITS)
+    {
+        return false;
+    }
+
+    h->version = u[1];
+    h->salt = (u[1] >= 2U) ? get_u32(&u[12]) : 0U;
+    h->created_unix_us = (int64_t)get_u64(&u[16]);
+    return true;
+}
+
+/**
+ * @brief Decodifica um registro (validar antes com `sd_binlog_check`).
+ */
+void sd_binlog_get_record(const uint8_t *u, sd_binlog_rec_t *r)
+{
+    r->flags = u[1];
+    r->seq = get_u32(&u[4]);
+    r->t_unix_us = (int64_t)get_u64(&u[8]);
+    r->vrms = get_f32(&u[16]);
+    r->irms = get_f32(&u[20]);
+    r->v_pu = get_f32(&u[24]);
+    r->p_w = get_f32(&u[28]);
+}
+
+/**
+ * @brief Decodifica um índice (validar antes com `sd_binlog_check`).
+ */
+void sd_binlog_get_index(const uint8_t *u, sd_binlog_index_t *ix)
+{
+    ix->seq_first = get_u32(&u[4]);
+    ix->t_first = (int64_t)get_u64(&u[8]);
+    ix->t_last = (int64_t)get_u64(&u[16]);
+    ix->count = get_u16(&u[24]);
+    ix->first_off = get_u32(&u[28]);
+}
+
+/**
+ * @brief Decodifica um início de sessão (validar antes com `sd_binlog_check`).
+ */
+void sd_binlog_get_session(const uint8_t *u, sd_binlog_session_t *s)
+{
+    s->reason = u[1];
+    s->next_seq = get_u32(&u[4]);
+    s->t_start = (int64_t)get_u64(&u[8]);
+    s->t_prev = (int64_t)get_u64(&u[16]);
+    s->prev_seq = get_u32(&u[24]);
+}
+
+/**
+ * @brief Acumula um registro gravado em `off` no índice do segmento corrente.
+ */
+void sd_binlog_index_add(sd_binlog_index_t *ix, uint32_t off, const sd_binlog_rec_t *r)
+{
+    if (ix->count == 0U)
+    {
+        ix->seq_first = r->seq;
+        ix->t_first = r->t_unix_us;
+        ix->first_off = off;
+    }
+
+    ix->count++;
+    ix->t_last = (r->t_unix_us > ix->t_last) ? r->t_unix_us : ix->t_last;
+}
+
+/**
+ * @brief Começa o próximo segmento (mantém `t_last`, que é cumulativo).
+ */
+void sd_binlog_index_next(sd_binlog_index_t *ix)
+{
+    ix->count = 0U;
+    ix->seq_first = 0U;
+    ix->t_first = 0;
+    ix->first_off = 0U;
+}
+
+/**
+ * @brief Deslocamento do primeiro segmento que pode conter instantes >= `t_from`.
+ * @details Busca binária sobre os índices dos segmentos completos (um
+ *          `read` de 32 bytes por passo). Índice ilegível conta como
+ *          "pode conter", o que só faz a leitura começar mais cedo.
+ * @param[out] reads Leituras feitas (pode ser NULL).
+ * @return Deslocamento de início da leitura sequencial (múltiplo de 8 kB).
+ */
+uint32_t sd_binlog_seek(const sd_binlog_src_t *src, int64_t t_from, uint32_t *reads)
+{
+    const uint32_t segs = (src->size / SD_BINLOG_UNIT) / SD_BINLOG_SEG_UNITS;
+    uint32_t lo = 0;
+    uint32_t hi = segs;
+    uint32_t n = 0;
+
+    while (lo < hi)
+    {
+        const uint32_t mid = lo + (hi - lo) / 2U;
+        const uint32_t off = (mid * SD_BINLOG_SEG_UNITS + SD_BINLOG_SEG_UNITS - 1U) * SD_BINLOG_UNIT;
+        uint8_t u[SD_BINLOG_UNIT];
+        sd_binlog_index_t ix;
+
+        n++;
+        if (src->read(src->ctx, off, u, SD_BINLOG_UNIT) && sd_binlog_check(u, &src->hdr) == SD_BINLOG_TYPE_INDEX)
+        {
+            sd_binlog_get_index(u, &ix);
+            if (ix.t_last < t_from)
+            {
+                lo = mid + 1U;
+                continue;
+            }
+        }
+        hi = mid;
+    }
+
+    if (reads)
+    {
+        *reads = n;
+    }
+    return lo * SD_BINLOG_SEG_UNITS * SD_BINLOG_UNIT;
+}
+
+/**
+ * @brief Acha o fim lógico do arquivo (primeira unidade após a última gravada).
+ * @details Índices são gravados em ordem, então os válidos formam um
+ *          prefixo: busca binária pelo último deles e, depois, leitura
+ *          unidade a unidade do segmento seguinte até a primeira inválida
+ *          (no máximo `SD_BINLOG_SEG_UNITS` leituras). Não depende do
+ *          tamanho do arquivo, que inclui a pré-alocação. Registros,
+ *          sessões e enchimento continuam o prefixo válido.
+ * @param[out] ix Índice do segmento em aberto, reconstruído (pode ser NULL):
+ *                `t_last` do último índice e os registros lidos depois dele.
+ * @param[out] tail Último registro do arquivo (pode ser NULL); num segmento
+ *                  em aberto ainda sem registros, vem do último índice.
+ * @return Deslocamento do fim lógico (múltiplo de `SD_BINLOG_UNIT`).
+ */
+uint32_t sd_binlog_find_end(const sd_binlog_src_t *src, sd_binlog_index_t *ix, sd_binlog_tail_t *tail)
+{
+    const uint32_t units = src->size / SD_BINLOG_UNIT;
+    uint32_t lo = 0;
+    uint32_t hi = units / SD_BINLOG_SEG_UNITS;
+    uint8_t u[SD_BINLOG_UNIT];
+    sd_binlog_index_t acc;
+    sd_binlog_tail_t last_rec = {SD_BINLOG_SEQ_NONE, 0};
+
+    memset(&acc, 0, sizeof(acc));
+
+    while (lo < hi)
+    {
+        const uint32_t mid = lo + (hi - lo) / 2U;
+        const uint32_t off = (mid * SD_BINLOG_SEG_UNITS + SD_BINLOG_SEG_UNITS - 1U) * SD_BINLOG_UNIT;
+
+        if (src->read(src->ctx, off, u, SD_BINLOG_UNIT) && sd_binlog_check(u, &src->hdr) == SD_BINLOG_TYPE_INDEX)
+        {
+            lo = mid + 1U;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    /* lo = índices válidos; o segmento lo é o que está em aberto. */
+    if (lo > 0U)
+    {
+        const uint32_t off = (lo * SD_BINLOG_SEG_UNITS - 1U) * SD_BINLOG_UNIT;
+        sd_binlog_index_t last;
+
+        if (src->read(src->ctx, off, u, SD_BINLOG_UNIT))
+        {
+            sd_binlog_get_index(u, &last);
+            acc.t_last = last.t_last;
+            if (last.count)
+            {
+                last_rec.seq = last.seq_first + last.count - 1U;
+                last_rec.t_unix_us = last.t_last;
+            }
+        }
+    }
+
+    uint32_t k = (lo == 0U) ? 1U : lo * SD_BINLOG_SEG_UNITS;
+
+    for (; k < units && !sd_binlog_is_index_unit(k); k++)
+    {
+        if (!src->read(src->ctx, k * SD_BINLOG_UNIT, u, SD_BINLOG_UNIT))
+        {
+            break;
+        }
+
+        const int type = sd_binlog_check(u, &src->hdr);
+        if (type == SD_BINLOG_TYPE_RECORD)
+        {
+            sd_binlog_rec_t r;
+            sd_binlog_get_record(u, &r);
+            sd_binlog_index_add(&acc, k * SD_BINLOG_UNIT, &r);
+            last_rec.seq = r.seq;
+            last_rec.t_unix_us = r.t_unix_us;
+        }
+        else if (type != SD_BINLOG_TYPE_SESSION && type != SD_BINLOG_TYPE_PAD)
+        {
+            break;
+        }
+    }
+
+    if (ix)
+    {
+        *ix = acc;
+    }
+    if (tail)
+    {
+        *tail = last_rec;
+    }
+    return k * SD_BINLOG_UNIT;
+}
@@ -0,0 +1,156 @@
+/**
+ * @file sd_binlog.h
+ * @brief Log binário de medições no SD: unidades de 32 bytes com CRC e índice esparso (firmware e host).
+ * @details
+ *  O arquivo é uma sequência de unidades de `SD_BINLOG_UNIT` bytes, todas
+ *  little-endian e com o mesmo início: tipo (u8), versão/flags (u8) e
+ *  CRC‑16/CCITT (u16) da unidade com esse campo zerado. Como 512 é múltiplo
+ *  de 32, nenhuma unidade cruza um setor.
+ *
+ *  Na versão 2 o CRC das unidades (exceto o cabeçalho) começa pelos 4 bytes
+ *  do `salt` do cabeçalho, sorteado na criação do arquivo. Arquivos
+ *  pré-alocados (`f_expand`) herdam clusters de arquivos apagados; com o
+ *  salt, unidades antigas nesses clusters não passam no CRC, e o fim lógico
+ *  do arquivo é achado por busca (`sd_binlog_find_end`), não pelo tamanho.
+ *
+ *  Na versão 3 o arquivo é um diário: `seq` dos registros é a sequência do
+ *  diário, contínua entre boots e arquivos; cada boot (ou reabertura após
+ *  erro) começa com uma unidade de sessão ('S') que registra o último
+ *  registro recuperado, e cada confirmação (commit) completa o setor com
+ *  enchimento ('P'), de modo que nenhum setor com registros confirmados é
+ *  regravado. As unidades válidas formam um prefixo do arquivo.
+ *
+ *  | unidade                  | conteúdo                                   |
+ *  |--------------------------|--------------------------------------------|
+ *  | 0                        | cabeçalho ('H')                            |
+ *  | k·256 + 255 (k = 0, 1..) | índice ('I') do segmento k                 |
+ *  | demais                   | registros ('R'), sessões ('S'), enchimento ('P' ou zeros na v1) |
+ *
+ *  Cabeçalho: 4 magic "EMLB", 8 tamanho da unidade (u16), 10 unidades por
+ *  segmento (u16), 12 salt (u32, v2), 16 criação em Unix µs (i64).
+ *
+ *  Registro: 4 seq (u32), 8 t_unix_us (i64), 16 vrms, 20 irms, 24 v_pu,
+ *  28 p_w (f32). O byte 1 leva as flags do registro de telemetria.
+ *
+ *  Sessão (v3): 1 motivo (u8), 4 seq do próximo registro (u32), 8 início
+ *  da sessão em Unix µs (i64), 16 instante e 24 seq do último registro já
+ *  no arquivo quando a sessão começou (i64, u32; 0 e `SD_BINLOG_SEQ_NONE`
+ *  se nenhum). O intervalo entre os dois instantes é a janela sem dados.
+ *
+ *  Índice do segmento k (cobre as unidades k·256 .. k·256+254): 4 seq do
+ *  primeiro registro (u32), 8 t_first e 16 t_last (i64), 24 registros
+ *  (u16), 28 deslocamento do primeiro registro no arquivo (u32). `t_last`
+ *  é o maior instante visto até o fim do segmento (inclusive segmentos
+ *  anteriores), logo os índices formam uma sequência não decrescente e a
+ *  busca por instante é binária sobre posições calculadas, sem varrer o
+ *  arquivo. O último segmento, incompleto, não tem índice e é lido inteiro.
+ */
+
+#ifndef SD_BINLOG_H
+#define SD_BINLOG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SD_BINLOG_MAGIC         "EMLB"  /**< Magic do cabeçalho. */
+#define SD_BINLOG_VERSION       3U      /**< Versão do formato (1: sem salt; 2: sem sessões; ambas lidas). */
+#define SD_BINLOG_UNIT          32U     /**< Bytes por unidade. */
+#define SD_BINLOG_SEG_UNITS     256U    /**< Unidades por segmento (8 kB; a última é o índice). */
+
+#define SD_BINLOG_TYPE_HEADER   'H'     /**< Cabeçalho do arquivo. */
+#define SD_BINLOG_TYPE_RECORD   'R'     /**< Registro de medição. */
+#define SD_BINLOG_TYPE_INDEX    'I'     /**< Índice de um segmento. */
+#define SD_BINLOG_TYPE_SESSION  'S'     /**< Início de sessão do diário (v3). */
+#define SD_BINLOG_TYPE_PAD      'P'     /**< Enchimento até o fim do setor (v3). */
+
+#define SD_BINLOG_SEQ_NONE      UINT32_MAX /**< Nenhum registro anterior. */
+
+#define SD_BINLOG_SESSION_BOOT   1U     /**< Sessão aberta após o boot. */
+#define SD_BINLOG_SESSION_REOPEN 2U     /**< Sessão reaberta após erro de gravação. */
+
+/** @brief Cabeçalho decodificado (necessário para conferir as demais unidades). */
+typedef struct
+{
+    uint8_t version;        /**< Versão do arquivo. */
+    uint32_t salt;          /**< Semente do CRC (v2). */
+    int64_t created_unix_us; /**< Criação do arquivo. */
+} sd_binlog_hdr_t;
+
+/** @brief Registro de medição decodificado. */
+typedef struct
+{
+    uint32_t seq;           /**< Sequência do registro de telemetria. */
+    uint8_t flags;          /**< Flags do registro de telemetria. */
+    int64_t t_unix_us;      /**< Instante Unix (µs; 0 = relógio sem NTP). */
+    float vrms;             /**< Tensão RMS [V]. */
+    float irms;             /**< Corrente RMS [A]. */
+    float v_pu;             /**< Tensão em PU. */
+    float p_w;              /**< Potência [W]. */
+} sd_binlog_rec_t;
+
+/** @brief Início de sessão decodificado. */
+typedef struct
+{
+    uint8_t reason;         /**< `SD_BINLOG_SESSION_*`. */
+    uint32_t next_seq;      /**< Seq do primeiro registro da sessão. */
+    int64_t t_start;        /**< Início da sessão (instante do primeiro registro). */
+    uint32_t prev_seq;      /**< Último registro já gravado (`SD_BINLOG_SEQ_NONE`: nenhum). */
+    int64_t t_prev;         /**< Instante desse registro (0: nenhum). */
+} sd_binlog_session_t;
+
+/** @brief Último registro de um arquivo, achado por `sd_binlog_find_end`. */
+typedef struct
+{
+    uint32_t seq;           /**< Seq (`SD_BINLOG_SEQ_NONE`: nenhum registro). */
+    int64_t t_unix_us;      /**< Instante (0: nenhum registro). */
+} sd_binlog_tail_t;
+
+/** @brief Índice de um segmento (também o acumulador do escritor). */
+typedef struct
+{
+    uint32_t seq_first;     /**< Sequência do primeiro registro. */
+    int64_t t_first;        /**< Instante do primeiro registro. */
+    int64_t t_last;         /**< Maior instante até o fim do segmento. */
+    uint16_t count;         /**< Registros no segmento. */
+    uint32_t first_off;     /**< Deslocamento do primeiro registro no arquivo. */
+} sd_binlog_index_t;
+
+/**
+ * @brief Leitura de `len` bytes a partir de `off` (FatFs no firmware, stdio no host).
+ * @return true se todos os bytes foram lidos.
+ */
+typedef bool (*sd_binlog_read_fn)(void *ctx, uint32_t off, uint8_t *buf, uint32_t len);
+
+/** @brief Arquivo de log aberto para leitura. */
+typedef struct
+{
+    sd_binlog_read_fn read;     /**< Função de leitura. */
+    void *ctx;                  /**< Contexto de `read`. */
+    uint32_t size;              /**< Tamanho do arquivo (pré-alocação inclusa). */
+    sd_binlog_hdr_t hdr;        /**< Cabeçalho já lido. */
+} sd_binlog_src_t;
+
+/** @brief Indica se a unidade `u` é a posição de um índice. */
+static inline bool sd_binlog_is_index_unit(uint32_t u)
+{
+    return (u % SD_BINLOG_SEG_UNITS) == SD_BINLOG_SEG_UNITS - 1U;
+}
+
+uint16_t sd_binlog_crc16(uint16_t crc, const uint8_t *p, size_t len);
+void sd_binlog_put_header(uint8_t *u, const sd_binlog_hdr_t *h);
+void sd_binlog_put_record(uint8_t *u, const sd_binlog_hdr_t *h, const sd_binlog_rec_t *r);
+void sd_binlog_put_index(uint8_t *u, const sd_binlog_hdr_t *h, const sd_binlog_index_t *ix);
+void sd_binlog_put_session(uint8_t *u, const sd_binlog_hdr_t *h, const sd_binlog_session_t *s);
+void sd_binlog_put_pad(uint8_t *u, const sd_binlog_hdr_t *h);
+int sd_binlog_check(const uint8_t *u, const sd_binlog_hdr_t *h);
+bool sd_binlog_get_header(const uint8_t *u, sd_binlog_hdr_t *h);
+void sd_binlog_get_record(const uint8_t *u, sd_binlog_rec_t *r);
+void sd_binlog_get_index(const uint8_t *u, sd_binlog_index_t *ix);
+void sd_binlog_get_session(const uint8_t *u, sd_binlog_session_t *s);
+void sd_binlog_index_add(sd_binlog_index_t *ix, uint32_t off, const sd_binlog_rec_t *r);
+void sd_binlog_index_next(sd_binlog_index_t *ix);
+uint32_t sd_binlog_seek(const sd_binlog_src_t *src, int64_t t_from, uint32_t *reads);
+uint32_t sd_binlog_find_end(const sd_binlog_src_t *src, sd_binlog_index_t *ix, sd_binlog_tail_t *tail);
+
+#endif /* SD_BINLOG_H */
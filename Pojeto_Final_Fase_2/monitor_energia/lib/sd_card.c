@@ -4,17 +4,181 @@
 #include "sd_card.h"
 #include "hw_config.h"
 #include "ff.h"
-#include "hardware/rtc.h"
-#include "pico/util/datetime.h"
+#include "diskio.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "hardware/spi.h"
+#include "lib/fmt.h"
+#include "lib/time_sync.h"
+#include "lib/timestamp.h"
 
 // Variável estática para manter o estado do cartão SD.
 // O "static" a torna visível apenas neste arquivo.
 static sd_card_t *sd_card_instance;
 
-// Inicializa o cartão SD.
+// Contadores de acesso ao cartão, atualizados pelos wrappers abaixo.
+static sd_disk_stats_t s_disk;
+
+// Degraus de frequência do SPI: os de SD_CARD_SPI_TRY_HZ e, por último, a segura.
+static const uint32_t k_spi_try_hz[] = SD_CARD_SPI_TRY_HZ;
+#define SPI_LEVELS (sizeof(k_spi_try_hz) / sizeof(k_spi_try_hz[0]) + 1U)
+static size_t s_spi_level = SPI_LEVELS - 1U;
+static size_t s_spi_best = 0;           // Degrau da última negociação (0 até haver uma)
+static uint32_t s_spi_errors = 0;       // Erros seguidos de transferência no degrau atual
+static uint64_t s_spi_down_us = 0;      // Instante da última descida (base da renegociação)
+
+// Aplica um degrau de frequência. O driver guarda a frequência em spi->baud_rate
+// e a reaplica sozinho quando reinicializa o cartão após um erro.
+static void spi_set_level(size_t level) {
+    const uint32_t hz = (level < SPI_LEVELS - 1U) ? k_spi_try_hz[level] : SD_CARD_SPI_SAFE_HZ;
+    s_spi_level = level;
+    s_spi_errors = 0;
+    sd_card_instance->spi->baud_rate = hz;
+    const uint32_t real_hz = spi_set_baudrate(sd_card_instance->spi->hw_inst, hz);
+    taskENTER_CRITICAL();
+    s_disk.spi_hz = real_hz;
+    taskEXIT_CRITICAL();
+}
+
+// Desce um degrau; false se já está na frequência segura.
+static bool spi_downshift(void) {
+    if (!sd_card_instance || s_spi_level >= SPI_LEVELS - 1U) {
+        return false;
+    }
+    spi_set_level(s_spi_level + 1U);
+    s_spi_down_us = time_us_64();
+    taskENTER_CRITICAL();
+    s_disk.spi_downshifts++;
+    taskEXIT_CRITICAL();
+    return true;
+}
+
+// Conta um erro de transferência; true se a operação deve ser repetida. Os
+// primeiros repetem no mesmo degrau (um erro isolado não custa frequência);
+// só SD_CARD_SPI_ERRORS_DOWN seguidos descem um degrau.
+static bool spi_on_error(void) {
+    if (!sd_card_instance) {
+        return false;
+    }
+    if (++s_spi_errors < SD_CARD_SPI_ERRORS_DOWN) {
+        return true;
+    }
+    return spi_downshift();
+}
+
+// disk_read/disk_write do driver FatFs SPI, interceptados com --wrap no link
+// (CMakeLists.txt) para medir latência e setores gravados sem alterar a lib.
+DRESULT __real_disk_read(BYTE pdrv, BYTE *buff, LBA_t sector, UINT count);
+DRESULT __real_disk_write(BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count);
+
+DRESULT __wrap_disk_read(BYTE pdrv, BYTE *buff, LBA_t sector, UINT count) {
+    DRESULT r = __real_disk_read(pdrv, buff, sector, count);
+    while (r == RES_ERROR && spi_on_error()) {
+        r = __real_disk_read(pdrv, buff, sector, count);
+    }
+    if (r == RES_OK) {
+        s_spi_errors = 0;
+    }
+    taskENTER_CRITICAL();
+    s_disk.reads++;
+    s_disk.read_sectors += count;
+    s_disk.errors += (r != RES_OK) ? 1U : 0U;
+    taskEXIT_CRITICAL();
+    return r;
+}
+
+DRESULT __wrap_disk_write(BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count) {
+    const uint64_t t0 = time_us_64();
+    DRESULT r = __real_disk_write(pdrv, buff, sector, count);
+    while (r == RES_ERROR && spi_on_error()) {
+        r = __real_disk_write(pdrv, buff, sector, count);
+    }
+    if (r == RES_OK) {
+        s_spi_errors = 0;
+    }
+    const uint32_t dt = (uint32_t)(time_us_64() - t0);
+    taskENTER_CRITICAL();
+    s_disk.writes++;
+    s_disk.write_sectors += count;
+    s_disk.write_total_us += dt;
+    s_disk.write_max_us = (dt > s_disk.write_max_us) ? dt : s_disk.write_max_us;
+    s_disk.errors += (r != RES_OK) ? 1U : 0U;
+    taskEXIT_CRITICAL();
+    return r;
+}
+
+// Copia os contadores de acesso ao cartão.
+void sd_card_get_disk_stats(sd_disk_stats_t *out) {
+    taskENTER_CRITICAL();
+    *out = s_disk;
+    taskEXIT_CRITICAL();
+}
+
+// Soma de verificação (FNV-1a) dos primeiros setores da FAT, lidos em
+// blocos de 4 setores (leitura múltipla, como as do FatFs). Lê direto do
+// driver: a negociação não entra nos contadores nem nos degraus do wrapper.
+static bool spi_test_sum(uint32_t *sum) {
+    static uint8_t buf[4U * SD_SECTOR_SIZE];
+    const LBA_t base = sd_card_instance->fatfs.fatbase;
+    uint32_t h = 2166136261U;
+
+    for (LBA_t s = 0; s < SD_CARD_SPI_TEST_SECTORS; s += 4U) {
+        if (__real_disk_read(0, buf, base + s, 4U) != RES_OK) { // Drive "0:"
+            return false;
+        }
+        for (size_t i = 0; i < sizeof(buf); i++) {
+            h = (h ^ buf[i]) * 16777619U;
+        }
+    }
+    *sum = h;
+    return true;
+}
+
+// Escolhe a maior frequência cujas duas releituras batem com a da frequência
+// segura (fios e soquete limitam antes do cartão, que aceita 25 MHz).
+static void spi_negotiate(void) {
+    uint32_t ref;
+    uint32_t sum;
+
+    spi_set_level(SPI_LEVELS - 1U);
+    s_spi_down_us = time_us_64();
+    if (!spi_test_sum(&ref)) {
+        return; // Sem referência: s_spi_best fica, e sd_card_spi_recheck tenta de novo
+    }
+    for (size_t level = 0; level < SPI_LEVELS - 1U; level++) {
+        spi_set_level(level);
+        if (spi_test_sum(&sum) && sum == ref && spi_test_sum(&sum) && sum == ref) {
+            s_spi_best = level;
+            return;
+        }
+        taskENTER_CRITICAL();
+        s_disk.spi_downshifts++;
+        taskEXIT_CRITICAL();
+    }
+    spi_set_level(SPI_LEVELS - 1U);
+    s_spi_best = SPI_LEVELS - 1U;
+}
+
+// Renegocia o relógio se ele desceu por erros abaixo do que a última negociação
+// achou, passados SD_CARD_SPI_RECHECK_MS da descida (cartão removido e
+// recolocado, ruído passageiro). Chamar com o FatFs travado.
+void sd_card_spi_recheck(void) {
+    if (!sd_card_instance || s_spi_level <= s_spi_best ||
+        time_us_64() - s_spi_down_us < (uint64_t)SD_CARD_SPI_RECHECK_MS * 1000U) {
+        return;
+    }
+    spi_negotiate();
+}
+
+// Monta o cartão na frequência segura e negocia o relógio do SPI.
 FRESULT sd_card_init() {
     sd_card_instance = sd_get_by_num(0);
-    return f_mount(&sd_card_instance->fatfs, sd_card_instance->pcName, 1);
+    sd_card_instance->spi->baud_rate = SD_CARD_SPI_SAFE_HZ;
+    const FRESULT fr = f_mount(&sd_card_instance->fatfs, sd_card_instance->pcName, 1);
+    if (fr == FR_OK) {
+        spi_negotiate();
+    }
+    return fr;
 }
 
 
@@ -51,10 +215,9 @@ FRESULT sd_card_append_to_csv(const char* filename, const char* data) {
     return fr;
 }
 
-// Obtém e formata a data e hora do RTC.
+// Obtém e formata a data e hora do relógio de software (time_sync).
+// O texto de data/hora fica em cache; só a task de log do SD chama esta função.
 void sd_card_get_formatted_timestamp(char* buffer, size_t size) {
-    datetime_t now;
-    rtc_get_datetime(&now);
-    sprintf(buffer, "%04d-%02d-%02dT%02d:%02d:%02d",
-            now.year, now.month, now.day, now.hour, now.min, now.sec);
-}
\ No newline at end of file
+    static timestamp_cache_t cache = TIMESTAMP_CACHE_INIT('-', 'T', false);
+    timestamp_format(&cache, buffer, size, time_sync_now_us());
+}
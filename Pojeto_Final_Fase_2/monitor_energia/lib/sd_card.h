@@ -1,12 +1,45 @@
 #ifndef SD_CARD_H
 #define SD_CARD_H
 
+#include <stdbool.h>
 #include "ff.h"
 #include "pico/types.h"
+#include "lib/sd_writer.h"
 
-// Inicializa a comunicação com o cartão SD.
+// Relógio do SPI do cartão. A montagem (e toda reinicialização do cartão pelo
+// driver) usa SD_CARD_SPI_SAFE_HZ; depois, sd_card_init testa as frequências
+// de SD_CARD_SPI_TRY_HZ, da maior para a menor, relendo os mesmos setores e
+// comparando com a leitura na frequência segura, e fica com a maior que
+// passar. Um erro de transferência repete a operação (setores inteiros:
+// repetir é seguro); só SD_CARD_SPI_ERRORS_DOWN erros seguidos no mesmo
+// degrau o descem. sd_card_spi_recheck sobe de volta: renegocia quando o
+// relógio está abaixo do negociado há SD_CARD_SPI_RECHECK_MS.
+#define SD_CARD_SPI_SAFE_HZ     (12500U * 1000U)    // Valor de hw_config.c (fios longos, protoboard)
+#define SD_CARD_SPI_TRY_HZ      {25000U * 1000U, 16000U * 1000U} // Pedidas; clk_peri 125 MHz dá 20,8 e 15,6 MHz
+#define SD_CARD_SPI_TEST_SECTORS 64U                // Setores relidos por frequência (32 kB)
+#define SD_CARD_SPI_ERRORS_DOWN 3U                  // Erros seguidos num degrau para descer
+#define SD_CARD_SPI_RECHECK_MS  (10U * 60U * 1000U) // Espera após uma descida para renegociar
+
+// Contadores do acesso ao cartão (disk_read/disk_write do driver FatFs SPI).
+typedef struct {
+    uint32_t reads;             // Chamadas de disk_read
+    uint32_t read_sectors;      // Setores lidos
+    uint32_t writes;            // Chamadas de disk_write
+    uint32_t write_sectors;     // Setores gravados (desgaste: cada um é um ciclo de programação)
+    uint32_t write_max_us;      // Maior duração de um disk_write
+    uint64_t write_total_us;    // Soma das durações de disk_write
+    uint32_t errors;            // Retornos diferentes de RES_OK
+    uint32_t spi_hz;            // Relógio atual do SPI (real, após o divisor)
+    uint32_t spi_downshifts;    // Descidas de frequência por erro (negociação e operação)
+} sd_disk_stats_t;
+
+// Monta o cartão na frequência segura e negocia a maior frequência estável do SPI.
 FRESULT sd_card_init();
 
+// Renegocia o relógio do SPI se erros o desceram e já passou SD_CARD_SPI_RECHECK_MS.
+// Chamar com o FatFs travado (lê o cartão direto do driver).
+void sd_card_spi_recheck(void);
+
 // Grava uma string em um arquivo CSV, adicionando uma nova linha.
 // A função verifica se o arquivo existe e cria o cabeçalho se necessário.
 FRESULT sd_card_append_to_csv(const char* filename, const char* data);
@@ -14,4 +47,7 @@ FRESULT sd_card_append_to_csv(const char* filename, const char* data);
 // Obtém e formata a hora atual do RTC em uma string.
 void sd_card_get_formatted_timestamp(char* buffer, size_t size);
 
-#endif
\ No newline at end of file
+// Copia os contadores de acesso ao cartão.
+void sd_card_get_disk_stats(sd_disk_stats_t *out);
+
+#endif
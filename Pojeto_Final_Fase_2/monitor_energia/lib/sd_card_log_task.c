@@ -1,47 +1,304 @@
 #include "sd_card_log_task.h"
 #include <stdio.h>
+#include <string.h>
 #include "pico/stdlib.h"
-#include "lib/energy_monitor.h"
 #include "lib/sd_card.h"
+#include "lib/fmt.h"
+#include "lib/serial_cmd.h"
+#include "lib/sd_daylog.h"
+#include "lib/time_sync.h"
+#include "lib/rtos_trace.h"
 
-#define SD_CARD_LOG_PERIOD_MS 1000 // A cada 1 segundos
+#define SD_CARD_LOG_QUEUE_LEN 8         // Registros retidos enquanto o cartão está ocupado
+#define SD_CARD_LOG_IDLE_MS 2000U       // Sem registros por este tempo: aplica os prazos do escritor
 
-void sd_card_log_task(void *params) {
-    (void)params;
-    TickType_t xLastWakeTime;
-    xLastWakeTime = xTaskGetTickCount();
+#if SD_CARD_LOG_BINARY
+#if !SD_CARD_LOG_KEEP_OPEN
+#error "SD_CARD_LOG_BINARY requer SD_CARD_LOG_KEEP_OPEN"
+#endif
+#define SD_CARD_LOG_FILE SD_DAYLOG_DIR "/AAAAMMDD.bin"
+static sd_daylog_t s_daylog;            // Task do sink; consultas com o FatFs travado
+#else
+#define SD_CARD_LOG_FILE "dados.csv"
+#define SD_CARD_LOG_HEADER "timestamp,vrms,irms,v_pu,p_instant\n"
+#endif
 
-    // Inicializa o cartão SD
-    if (sd_card_init() != FR_OK) {
+#if SD_CARD_LOG_KEEP_OPEN && !SD_CARD_LOG_BINARY
+static sd_writer_t s_writer;            // Só a task do sink usa
+#endif
+static sd_card_log_stats_t s_stats;
+static volatile bool s_sync_req = false; // Pedido de f_sync do comando serial
+static volatile bool s_mounted = false;  // Cartão montado pelo sink
+static SemaphoreHandle_t s_fs_mutex;     // FatFs: o sink e as consultas (lib/sd_query)
+
+static void sd_cmd(int argc, char **argv);
+static void sd_sink_service_locked(void);
+
+static const serial_cmd_t s_sd_cmd = {
+    .name = "sd",
+    .args = "[sync]",
+    .help = "Contadores de gravacao no SD; sync descarrega e sincroniza o arquivo.",
+    .fn = sd_cmd,
+};
+
+// Aplica os prazos do escritor e atende pedidos de f_sync.
+static void sd_sink_service(void) {
+    xSemaphoreTake(s_fs_mutex, portMAX_DELAY);
+    sd_sink_service_locked();
+    xSemaphoreGive(s_fs_mutex);
+}
+
+static void sd_sink_service_locked(void) {
+    sd_card_spi_recheck();
+#if SD_CARD_LOG_BINARY
+    const FRESULT fr = sd_daylog_poll(&s_daylog, s_sync_req);
+    s_sync_req = false;
+    if (fr != FR_OK) {
+        printf("Erro ao descarregar no SD: %d\n", fr);
+    }
+    taskENTER_CRITICAL();
+    s_stats.writer = s_daylog.writer.stats;
+    s_stats.daylog = s_daylog.stats;
+    taskEXIT_CRITICAL();
+#elif SD_CARD_LOG_KEEP_OPEN
+    const FRESULT fr = s_sync_req ? sd_writer_flush(&s_writer, true) : sd_writer_poll(&s_writer);
+    s_sync_req = false;
+    if (fr != FR_OK) {
+        printf("Erro ao descarregar no SD: %d\n", fr);
+    }
+    taskENTER_CRITICAL();
+    s_stats.writer = s_writer.stats;
+    taskEXIT_CRITICAL();
+#else
+    s_sync_req = false;
+#endif
+}
+
+// Monta o cartão; o despachante repete até conseguir
+static bool sd_sink_begin(void *ctx) {
+    (void)ctx;
+    xSemaphoreTake(s_fs_mutex, portMAX_DELAY);
+    const FRESULT fr = sd_card_init();
+    if (fr != FR_OK) {
+        xSemaphoreGive(s_fs_mutex);
         printf("Erro ao inicializar o cartao SD!\n");
-    } else {
-        printf("Cartao SD inicializado com sucesso!\n");
-    }
-
-    while (true) {
-        vTaskDelayUntil(&xLastWakeTime, pdMS_TO_TICKS(SD_CARD_LOG_PERIOD_MS));
-
-        energy_monitor_data_t data;
-        if (energy_monitor_get_last(&data)) {
-            char log_line[256];
-            char timestamp_buffer[32];
-            sd_card_get_formatted_timestamp(timestamp_buffer, sizeof(timestamp_buffer));
-
-            // Formata os dados em uma linha de texto CSV
-            sprintf(log_line, "%s,%.2f,%.2f,%.2f,%.1f\n",
-                timestamp_buffer,
-                data.vrms,
-                data.irms,
-                data.v_pu,
-                data.p_instant);
-
-            // Grava os dados no arquivo
-            FRESULT fr = sd_card_append_to_csv("dados.csv", log_line);
-            if (fr != FR_OK) {
-                printf("Erro ao gravar no SD: %d\n", fr);
-            } else {
-                printf("Dados gravados no SD: %s", log_line);
-            }
+        return false;
+    }
+    sd_disk_stats_t ds;
+    sd_card_get_disk_stats(&ds);
+    printf("Cartao SD inicializado com sucesso! SPI a %lu kHz\n", (unsigned long)(ds.spi_hz / 1000U));
+#if SD_CARD_LOG_BINARY
+    sd_daylog_init(&s_daylog, SD_DAYLOG_COMMIT_MS);
+#elif SD_CARD_LOG_KEEP_OPEN
+    sd_writer_init(&s_writer, SD_CARD_LOG_FILE, SD_CARD_LOG_HEADER, strlen(SD_CARD_LOG_HEADER), SD_WRITER_FLUSH_MS,
+                   SD_WRITER_SYNC_MS);
+#endif
+    s_mounted = true;
+    xSemaphoreGive(s_fs_mutex);
+    return true;
+}
+
+#if SD_CARD_LOG_BINARY
+// Grava um registro binário (32 bytes, sem formatação de texto nem alocação)
+// no arquivo do dia; a rotação, a pré-alocação e o seq do diário (contínuo
+// entre boots, no lugar do seq do registro) ficam em lib/sd_daylog.
+static FRESULT sd_bin_write(const telemetry_record_t *rec) {
+    const sd_binlog_rec_t r = {
+        .flags = rec->flags,
+        .t_unix_us = rec->t_unix_us,
+        .vrms = rec->vrms,
+        .irms = rec->irms,
+        .v_pu = rec->v_pu,
+        .p_w = rec->p_w,
+    };
+    return sd_daylog_append(&s_daylog, &r, time_sync_is_synced());
+}
+#else
+// Formata e grava um registro como linha CSV.
+static FRESULT sd_csv_write(const telemetry_record_t *rec) {
+    char log_line[96];
+    char timestamp_buffer[32];
+    sd_card_get_formatted_timestamp(timestamp_buffer, sizeof(timestamp_buffer));
+
+    // Formata os dados em uma linha de texto CSV (sem printf de ponto flutuante)
+    fmt_buf_t b;
+    fmt_buf_init(&b, log_line, sizeof(log_line));
+    fmt_buf_str(&b, timestamp_buffer);
+    fmt_buf_char(&b, ',');
+    fmt_buf_double(&b, rec->vrms, 2);
+    fmt_buf_char(&b, ',');
+    fmt_buf_double(&b, rec->irms, 2);
+    fmt_buf_char(&b, ',');
+    fmt_buf_double(&b, rec->v_pu, 2);
+    fmt_buf_char(&b, ',');
+    fmt_buf_double(&b, rec->p_w, 1);
+    fmt_buf_char(&b, '\n');
+
+    if (b.overflow) {
+        printf("Linha CSV excedeu o buffer; descartada.\n");
+        return FR_INVALID_PARAMETER;
+    }
+
+    // Grava os dados no arquivo (no buffer do escritor, que descarrega em setores inteiros)
+#if SD_CARD_LOG_KEEP_OPEN
+    return sd_writer_append(&s_writer, log_line, b.len);
+#else
+    return sd_card_append_to_csv(SD_CARD_LOG_FILE, log_line);
+#endif
+}
+#endif
+
+// Grava um registro no arquivo do SD
+static bool sd_sink_publish(void *ctx, const telemetry_record_t *rec) {
+    (void)ctx;
+    if (!rec->valid) {
+        sd_sink_service();
+        return true; // Ainda sem medição: nada a gravar
+    }
+
+    // A espera pelo FatFs (consulta em andamento) fica fora da duração da gravação
+    xSemaphoreTake(s_fs_mutex, portMAX_DELAY);
+    const uint64_t t0 = time_us_64();
+#if SD_CARD_LOG_BINARY
+    const FRESULT fr = sd_bin_write(rec);
+#else
+    const FRESULT fr = sd_csv_write(rec);
+#endif
+    const uint32_t dt = (uint32_t)(time_us_64() - t0);
+    xSemaphoreGive(s_fs_mutex);
+
+    taskENTER_CRITICAL();
+    s_stats.records += (fr == FR_OK) ? 1U : 0U;
+    s_stats.record_total_us += dt;
+    s_stats.record_max_us = (dt > s_stats.record_max_us) ? dt : s_stats.record_max_us;
+    taskEXIT_CRITICAL();
+
+    sd_sink_service();
+
+    if (fr != FR_OK) {
+        printf("Erro ao gravar no SD: %d\n", fr);
+        return false;
+    }
+    return true;
+}
+
+// Ociosidade (sem registros): aplica os prazos de descarga e f_sync.
+static bool sd_sink_flush(void *ctx) {
+    (void)ctx;
+    sd_sink_service();
+    return true;
+}
+
+// Copia os contadores do sink do SD.
+void sd_card_log_get_stats(sd_card_log_stats_t *out) {
+    taskENTER_CRITICAL();
+    *out = s_stats;
+    taskEXIT_CRITICAL();
+    sd_card_get_disk_stats(&out->disk);
+}
+
+// Registra o comando serial "sd" e cria a trava do FatFs (antes do scheduler).
+void sd_card_log_init(void) {
+    s_fs_mutex = xSemaphoreCreateMutex();
+    (void)rtos_trace_name_queue(s_fs_mutex, "fs_mutex");
+    (void)serial_cmd_register(&s_sd_cmd);
+}
+
+// Trava o FatFs para outra task; o mutex herda prioridade, então o sink
+// espera no máximo o trecho em curso da consulta.
+bool sd_card_log_lock(uint32_t timeout_ms) {
+    return xSemaphoreTake(s_fs_mutex, pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+}
+
+void sd_card_log_unlock(void) {
+    xSemaphoreGive(s_fs_mutex);
+}
+
+// Log diário do sink; só com o FatFs travado.
+sd_daylog_t *sd_card_log_daylog(void) {
+#if SD_CARD_LOG_BINARY
+    return s_mounted ? &s_daylog : NULL;
+#else
+    return NULL;
+#endif
+}
+
+// Indica se o log diário está disponível para consultas.
+bool sd_card_log_ready(void) {
+    return SD_CARD_LOG_BINARY && s_mounted;
+}
+
+// Comando serial "sd": contadores; "sd sync" pede descarga + f_sync ao sink.
+static void sd_cmd(int argc, char **argv) {
+    if (argc == 2 && strcmp(argv[1], "sync") == 0) {
+        s_sync_req = true;
+        printf("f_sync pedido (atendido no proximo registro).\n");
+        return;
+    }
+
+    sd_card_log_stats_t st;
+    sd_card_log_get_stats(&st);
+    const uint32_t avg_us = st.records ? (uint32_t)(st.record_total_us / st.records) : 0U;
+
+    printf("Modo: %s (%s)\n", SD_CARD_LOG_KEEP_OPEN ? "arquivo aberto com buffer" : "abre/grava/fecha por linha",
+           SD_CARD_LOG_FILE);
+    printf("Registros: %lu | gravacao media %lu us, max %lu us\n", (unsigned long)st.records,
+           (unsigned long)avg_us, (unsigned long)st.record_max_us);
+    printf("Escritor: %lu descargas (max %lu us), %lu f_sync (max %lu us), %lu aberturas, %lu erros\n",
+           (unsigned long)st.writer.flushes, (unsigned long)st.writer.flush_max_us,
+           (unsigned long)st.writer.syncs, (unsigned long)st.writer.sync_max_us,
+           (unsigned long)st.writer.opens, (unsigned long)st.writer.errors);
+    printf("Cartao: %lu leituras (%lu setores), %lu gravacoes (%lu setores, max %lu us), %lu erros\n",
+           (unsigned long)st.disk.reads, (unsigned long)st.disk.read_sectors, (unsigned long)st.disk.writes,
+           (unsigned long)st.disk.write_sectors, (unsigned long)st.disk.write_max_us,
+           (unsigned long)st.disk.errors);
+    const uint32_t per_write_x100 = st.disk.writes ? st.disk.write_sectors * 100U / st.disk.writes : 0U;
+    const uint32_t kbps = st.disk.write_total_us
+                              ? (uint32_t)((uint64_t)st.disk.write_sectors * SD_SECTOR_SIZE * 1000U /
+                                           st.disk.write_total_us)
+                              : 0U;
+    printf("SPI: %lu kHz (%lu descidas por erro) | %lu.%02lu setores por gravacao, %lu kB/s durante a gravacao\n",
+           (unsigned long)(st.disk.spi_hz / 1000U), (unsigned long)st.disk.spi_downshifts,
+           (unsigned long)(per_write_x100 / 100U), (unsigned long)(per_write_x100 % 100U), (unsigned long)kbps);
+    for (uint8_t i = 0; i < telemetry_sink_count(); i++) {
+        telemetry_sink_stats_t ts;
+        if (telemetry_sink_name(i) == sd_card_log_sink.name && telemetry_get_sink_stats(i, &ts)) {
+            printf("Fila: %u de %u agora, maximo %u, %lu descartados\n", ts.queued, SD_CARD_LOG_QUEUE_LEN,
+                   ts.queued_max, (unsigned long)ts.dropped);
         }
     }
-}
\ No newline at end of file
+#if SD_CARD_LOG_BINARY
+    printf("Arquivos diarios: %s | %lu trocas (max %lu us), %lu criados (max %lu us), %lu sem pre-alocacao, "
+           "%lu apagados\n",
+           s_daylog.path[0] ? s_daylog.path : "-", (unsigned long)st.daylog.rotations,
+           (unsigned long)st.daylog.rotate_max_us, (unsigned long)st.daylog.created,
+           (unsigned long)st.daylog.create_max_us, (unsigned long)st.daylog.prealloc_failed,
+           (unsigned long)st.daylog.pruned);
+    if (st.daylog.committed_seq == SD_BINLOG_SEQ_NONE) {
+        printf("Diario: proximo seq %lu, nada confirmado | ", (unsigned long)s_daylog.next_seq);
+    } else {
+        printf("Diario: proximo seq %lu, confirmado ate %lu | ", (unsigned long)s_daylog.next_seq,
+               (unsigned long)st.daylog.committed_seq);
+    }
+    printf("%lu commits, %lu unidades de enchimento, %lu sessoes\n", (unsigned long)st.daylog.commits,
+           (unsigned long)st.daylog.pad_units, (unsigned long)st.daylog.sessions);
+#endif
+    if (st.records) {
+        printf("Setores gravados por registro: %lu.%02lu\n", (unsigned long)(st.disk.write_sectors / st.records),
+               (unsigned long)((st.disk.write_sectors % st.records) * 100U / st.records));
+    }
+}
+
+const telemetry_sink_t sd_card_log_sink = {
+    .name = "SDCardLogSink",
+    .begin = sd_sink_begin,
+    .publish = sd_sink_publish,
+    .flush = sd_sink_flush,
+    .healthy = NULL,
+    .ctx = NULL,
+    .accept = TELEMETRY_ACCEPT_ALL,
+    .queue_len = SD_CARD_LOG_QUEUE_LEN,
+    .stack_words = 2048, // Sem printf de ponto flutuante (lib/fmt), 2048 palavras bastam
+    .priority = tskIDLE_PRIORITY + 1,
+    .idle_flush_ms = SD_CARD_LOG_IDLE_MS,
+};
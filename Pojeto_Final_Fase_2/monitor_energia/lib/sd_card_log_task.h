@@ -3,7 +3,50 @@
 
 #include "FreeRTOS.h"
 #include "task.h"
+#include "semphr.h"
+#include "lib/telemetry.h"
+#include "lib/sd_card.h"
+#include "lib/sd_daylog.h"
 
-void sd_card_log_task(void *params);
+#ifndef SD_CARD_LOG_KEEP_OPEN
+// 1: arquivo aberto com buffer (sd_writer_t); 0: abre/grava/fecha a cada linha (comparação).
+#define SD_CARD_LOG_KEEP_OPEN 1
+#endif
 
-#endif
\ No newline at end of file
+#ifndef SD_CARD_LOG_BINARY
+// 1: registros binários de 32 bytes com CRC e índice (lib/sd_binlog.h), um arquivo por dia
+// (lib/sd_daylog.h, "log/AAAAMMDD.bin"); 0: CSV ("dados.csv", arquivo único).
+#define SD_CARD_LOG_BINARY 1
+#endif
+
+// Contadores do sink do SD.
+typedef struct {
+    uint32_t records;           // Registros aceitos
+    uint32_t record_max_us;     // Maior duração de uma gravação de registro
+    uint64_t record_total_us;   // Soma das durações
+    sd_writer_stats_t writer;   // Escritor (zerado com SD_CARD_LOG_KEEP_OPEN = 0)
+    sd_daylog_stats_t daylog;   // Rotação diária (zerado em CSV)
+    sd_disk_stats_t disk;       // Acesso ao cartão
+} sd_card_log_stats_t;
+
+// Sink que grava cada registro (1 Hz) como linha CSV no cartão SD.
+extern const telemetry_sink_t sd_card_log_sink;
+
+// Registra o comando serial "sd" (antes do scheduler).
+void sd_card_log_init(void);
+
+// Copia os contadores do sink do SD.
+void sd_card_log_get_stats(sd_card_log_stats_t *out);
+
+// Trava o FatFs para outra task (consultas, lib/sd_query); false se não conseguiu em timeout_ms.
+// O sink trava a cada registro, então quem trava deve soltar a cada trecho curto.
+bool sd_card_log_lock(uint32_t timeout_ms);
+void sd_card_log_unlock(void);
+
+// Log diário do sink; só com o FatFs travado. NULL se o cartão não está montado ou em CSV.
+sd_daylog_t *sd_card_log_daylog(void);
+
+// Indica se o log diário está disponível para consultas (sem travar).
+bool sd_card_log_ready(void);
+
+#endif
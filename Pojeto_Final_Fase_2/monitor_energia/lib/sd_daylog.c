@@ -0,0 +1,640 @@
+/**
+ * @file sd_daylog.c
+ * @brief Rotação diária do log binário do SD: criação antecipada, pré-alocação, poda e diário.
+ */
+
+#include "lib/sd_daylog.h"
+#include <stdio.h>
+#include <string.h>
+#include "pico/time.h"
+#include "lib/timestamp.h"
+#include "lib/fmt.h"
+
+#if !FF_USE_EXPAND
+#error "sd_daylog requer FF_USE_EXPAND = 1 no ffconf.h (f_expand)"
+#endif
+
+#define DAY_S   86400
+
+/**
+ * @brief Dia local (dias desde 1970-01-01 no fuso `TIMESTAMP_TZ_OFFSET_S`) de um instante Unix.
+ */
+int64_t sd_daylog_local_day(int64_t unix_us)
+{
+    int64_t s = unix_us / 1000000;
+    s -= (unix_us % 1000000 < 0) ? 1 : 0;
+    s += TIMESTAMP_TZ_OFFSET_S;
+    return (s >= 0) ? s / DAY_S : -((-s + DAY_S - 1) / DAY_S);
+}
+
+/**
+ * @brief Segundos desde a meia-noite local.
+ */
+static int64_t local_second_of_day(int64_t unix_us)
+{
+    const int64_t s = unix_us / 1000000 + TIMESTAMP_TZ_OFFSET_S;
+    return s - sd_daylog_local_day(unix_us) * DAY_S;
+}
+
+/**
+ * @brief Caminho do arquivo de um dia: "log/AAAAMMDD.bin".
+ */
+void sd_daylog_path(char *buf, size_t size, int64_t day)
+{
+    int32_t y;
+    uint32_t m;
+    uint32_t d;
+
+    timestamp_civil_from_days(day, &y, &m, &d);
+
+    /* Ano fora de 0..9999 não cabe em 8 dígitos (e não ocorre com o relógio válido) */
+    const uint32_t year = (y < 0) ? 0U : (y > 9999) ? 9999U : (uint32_t)y;
+
+    fmt_buf_t b;
+    fmt_buf_init(&b, buf, size);
+    fmt_buf_str(&b, SD_DAYLOG_DIR "/");
+    fmt_buf_commit(&b, fmt_u32_pad(fmt_buf_tail(&b), fmt_buf_room(&b), year, 4U));
+    fmt_buf_commit(&b, fmt_u32_pad(fmt_buf_tail(&b), fmt_buf_room(&b), m, 2U));
+    fmt_buf_commit(&b, fmt_u32_pad(fmt_buf_tail(&b), fmt_buf_room(&b), d, 2U));
+    fmt_buf_str(&b, ".bin");
+}
+
+/**
+ * @brief Reconhece um nome "AAAAMMDD.bin" (maiúsculas ou não) e devolve o dia.
+ */
+bool sd_daylog_parse_name(const char *name, int64_t *day)
+{
+    uint32_t v = 0;
+
+    for (size_t i = 0; i < 8U; i++)
+    {
+        if (name[i] < '0' || name[i] > '9')
+        {
+            return false;
+        }
+        v = v * 10U + (uint32_t)(name[i] - '0');
+    }
+
+    if ((strcmp(&name[8], ".bin") != 0 && strcmp(&name[8], ".BIN") != 0) || (v / 100U) % 100U == 0U ||
+        (v / 100U) % 100U > 12U || v % 100U == 0U || v % 100U > 31U)
+    {
+        return false;
+    }
+
+    *day = timestamp_days_from_civil((int32_t)(v / 10000U), (v / 100U) % 100U, v % 100U);
+    return true;
+}
+
+/**
+ * @brief Salt do CRC de um arquivo novo: mistura (fmix64) do relógio e de um contador.
+ * @note Não precisa ser imprevisível, só diferir entre arquivos que reutilizam os mesmos clusters.
+ */
+static uint32_t daylog_salt(int64_t now_unix_us)
+{
+    static uint32_t count = 0;
+    uint64_t x = time_us_64() ^ (uint64_t)now_unix_us ^ ((uint64_t)++count << 40);
+
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDULL;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ULL;
+    x ^= x >> 33;
+    return (uint32_t)x;
+}
+
+/**
+ * @brief Percorre os arquivos diários.
+ * @param[out] total Soma dos tamanhos (pré-alocação inclusa).
+ * @param[out] oldest Dia mais antigo fora de `keep_a`/`keep_b` (INT64_MAX: nenhum).
+ * @param[out] newest Dia mais recente antes de `before` (`SD_DAYLOG_NO_DAY`: nenhum).
+ */
+static bool daylog_scan(int64_t keep_a, int64_t keep_b, int64_t before, uint64_t *total, int64_t *oldest,
+                        int64_t *newest)
+{
+    DIR dir;
+    FILINFO fno;
+
+    *total = 0;
+    *oldest = INT64_MAX;
+    *newest = SD_DAYLOG_NO_DAY;
+
+    if (f_opendir(&dir, SD_DAYLOG_DIR) != FR_OK)
+    {
+        return false;
+    }
+
+    while (f_readdir(&dir, &fno) == FR_OK && fno.fname[0])
+    {
+        int64_t day;
+
+        if ((fno.fattrib & AM_DIR) || !sd_daylog_parse_name(fno.fname, &day))
+        {
+            continue;
+        }
+
+        *total += fno.fsize;
+        *newest = (day > *newest && day < before) ? day : *newest;
+        if (day != keep_a && day != keep_b && day < *oldest)
+        {
+            *oldest = day;
+        }
+    }
+
+    (void)f_closedir(&dir);
+    return true;
+}
+
+/**
+ * @brief Apaga os arquivos mais antigos até `reserve` bytes novos caberem no orçamento.
+ * @note Nunca apaga o arquivo aberto nem o de `keep_day`.
+ */
+static void daylog_prune(sd_daylog_t *d, int64_t keep_day, uint64_t reserve)
+{
+    uint64_t total;
+    int64_t oldest;
+    int64_t newest;
+    char path[SD_DAYLOG_PATH_LEN];
+
+    while (daylog_scan(d->day, keep_day, INT64_MAX, &total, &oldest, &newest) &&
+           total + reserve > SD_DAYLOG_BUDGET_BYTES &&
+           oldest != INT64_MAX)
+    {
+        sd_daylog_path(path, sizeof(path), oldest);
+        if (f_unlink(path) != FR_OK)
+        {
+            return;
+        }
+        d->stats.pruned++;
+    }
+}
+
+/**
+ * @brief Cria o arquivo de `day`, se ainda não existe: poda, `f_expand` e cabeçalho v2.
+ * @details Clusters contíguos reservados de uma vez: os anexos do dia só
+ *          gravam dados. Sem espaço contíguo o arquivo fica só com o
+ *          cabeçalho e cresce normalmente.
+ */
+static FRESULT daylog_create(sd_daylog_t *d, int64_t day, int64_t now_unix_us)
+{
+    char path[SD_DAYLOG_PATH_LEN];
+    FILINFO fno;
+    FIL f;
+    UINT bw;
+
+    sd_daylog_path(path, sizeof(path), day);
+    if (f_stat(path, &fno) == FR_OK)
+    {
+        return FR_OK;
+    }
+
+    const uint64_t t0 = time_us_64();
+    daylog_prune(d, day, SD_DAYLOG_PREALLOC);
+
+    FRESULT fr = f_open(&f, path, FA_WRITE | FA_CREATE_NEW);
+    if (fr != FR_OK)
+    {
+        return fr;
+    }
+
+    if (f_expand(&f, SD_DAYLOG_PREALLOC, 1) != FR_OK)
+    {
+        d->stats.prealloc_failed++;
+    }
+
+    const sd_binlog_hdr_t h = {
+        .version = SD_BINLOG_VERSION,
+        .salt = daylog_salt(now_unix_us),
+        .created_unix_us = now_unix_us,
+    };
+    uint8_t u[SD_BINLOG_UNIT];
+    sd_binlog_put_header(u, &h);
+
+    fr = f_write(&f, u, sizeof(u), &bw);
+    const FRESULT fc = f_close(&f);
+    fr = (fr == FR_OK) ? fc : fr;
+
+    const uint32_t dt = (uint32_t)(time_us_64() - t0);
+    d->stats.created++;
+    d->stats.create_max_us = (dt > d->stats.create_max_us) ? dt : d->stats.create_max_us;
+    return fr;
+}
+
+/** @brief `sd_binlog_read_fn` sobre o escritor aberto. */
+static bool daylog_read(void *ctx, uint32_t off, uint8_t *buf, uint32_t len)
+{
+    return sd_writer_read((sd_writer_t *)ctx, off, buf, len) == FR_OK;
+}
+
+/** @brief `sd_binlog_read_fn` sobre um FIL aberto só para leitura. */
+static bool fil_read(void *ctx, uint32_t off, uint8_t *buf, uint32_t len)
+{
+    UINT br = 0;
+    return f_lseek((FIL *)ctx, off) == FR_OK && f_read((FIL *)ctx, buf, len, &br) == FR_OK && br == len;
+}
+
+/**
+ * @brief `sd_writer_end_fn`: lê o cabeçalho, acha o fim lógico, o último registro e o índice do segmento.
+ * @details É a recuperação do boot: ~log2(segmentos) leituras de índice e
+ *          no máximo um segmento lido unidade a unidade.
+ * @return Fim lógico; 0 se o cabeçalho é ilegível (o arquivo é reescrito do início).
+ */
+static FSIZE_t daylog_find_end(sd_writer_t *w, void *ctx)
+{
+    sd_daylog_t *d = (sd_daylog_t *)ctx;
+    uint8_t u[SD_BINLOG_UNIT];
+    sd_binlog_src_t src = {.read = daylog_read, .ctx = w, .size = (uint32_t)f_size(&w->file)};
+
+    memset(&d->index, 0, sizeof(d->index));
+    d->alloc_end = f_size(&w->file);
+
+    if (sd_writer_read(w, 0, u, sizeof(u)) != FR_OK || !sd_binlog_get_header(u, &src.hdr) ||
+        src.hdr.version < 2U)
+    {
+        return 0;
+    }
+
+    d->hdr = src.hdr;
+    return sd_binlog_find_end(&src, &d->index, &d->tail);
+}
+
+/**
+ * @brief Último registro do arquivo diário mais recente antes de `day` (boot num dia ainda sem registros).
+ */
+static void daylog_prev_tail(sd_daylog_t *d, int64_t day)
+{
+    uint64_t total;
+    int64_t oldest;
+    int64_t prev;
+    char path[SD_DAYLOG_PATH_LEN];
+    uint8_t u[SD_BINLOG_UNIT];
+    FIL f;
+
+    if (!daylog_scan(SD_DAYLOG_NO_DAY, SD_DAYLOG_NO_DAY, day, &total, &oldest, &prev) || prev == SD_DAYLOG_NO_DAY)
+    {
+        return;
+    }
+
+    sd_daylog_path(path, sizeof(path), prev);
+    if (f_open(&f, path, FA_READ) != FR_OK)
+    {
+        return;
+    }
+
+    sd_binlog_src_t src = {.read = fil_read, .ctx = &f, .size = (uint32_t)f_size(&f)};
+    if (fil_read(&f, 0, u, sizeof(u)) && sd_binlog_get_header(u, &src.hdr))
+    {
+        (void)sd_binlog_find_end(&src, NULL, &d->tail);
+    }
+    (void)f_close(&f);
+}
+
+/**
+ * @brief Atualiza o último registro confirmado (já fora do buffer do escritor, no cartão).
+ * @details Além da pré-alocação, os clusters novos só valem após o `f_sync`.
+ */
+static void daylog_note_commit(sd_daylog_t *d)
+{
+    const FSIZE_t pos = d->writer.buf_pos;
+    const FSIZE_t done = (d->writer.unsynced && pos > d->alloc_end) ? d->alloc_end : pos;
+
+    if (d->last_seq != SD_BINLOG_SEQ_NONE && d->last_off + SD_BINLOG_UNIT <= done)
+    {
+        d->stats.committed_seq = d->last_seq;
+    }
+    else if (d->prev_seq != SD_BINLOG_SEQ_NONE && d->prev_off + SD_BINLOG_UNIT <= done)
+    {
+        d->stats.committed_seq = d->prev_seq;
+    }
+}
+
+/**
+ * @brief Acrescenta uma unidade, precedida do índice do segmento quando a próxima posição é a dele.
+ */
+static FRESULT daylog_put(sd_daylog_t *d, const uint8_t *u)
+{
+    FRESULT fr;
+
+    if (sd_binlog_is_index_unit((uint32_t)(sd_writer_size(&d->writer) / SD_BINLOG_UNIT)))
+    {
+        uint8_t ix[SD_BINLOG_UNIT];
+        sd_binlog_put_index(ix, &d->hdr, &d->index);
+        fr = sd_writer_append(&d->writer, ix, sizeof(ix));
+        if (fr != FR_OK)
+        {
+            return fr;
+        }
+        sd_binlog_index_next(&d->index);
+    }
+
+    fr = sd_writer_append(&d->writer, u, SD_BINLOG_UNIT);
+    daylog_note_commit(d);
+    return fr;
+}
+
+/**
+ * @brief Confirma o buffer: completa o setor com enchimento e grava setores inteiros.
+ * @details Cada setor com registros vai ao cartão uma única vez: um corte
+ *          de energia só pode rasgar o setor em gravação, nunca um já
+ *          confirmado. Dentro da área pré-alocada os dados no cartão bastam
+ *          (tamanho e FAT já cobrem os clusters), então não há `f_sync`
+ *          nem escrita de metadados; fora dela, ou com `sync`, o commit
+ *          inclui o `f_sync`.
+ */
+static FRESULT daylog_commit(sd_daylog_t *d, bool sync)
+{
+    sd_writer_t *w = &d->writer;
+    FRESULT fr = FR_OK;
+
+    if (!w->open || (!w->len && !sync))
+    {
+        return FR_OK;
+    }
+
+    if (w->len)
+    {
+        uint8_t u[SD_BINLOG_UNIT];
+        sd_binlog_put_pad(u, &d->hdr);
+
+        while (fr == FR_OK && sd_writer_size(w) % SD_SECTOR_SIZE)
+        {
+            fr = daylog_put(d, u);
+            d->stats.pad_units++;
+        }
+    }
+
+    const bool grown = sd_writer_size(w) > d->alloc_end;
+    if (fr == FR_OK)
+    {
+        fr = sd_writer_flush(w, sync || grown);
+    }
+    if (fr == FR_OK)
+    {
+        d->alloc_end = grown ? f_size(&w->file) : d->alloc_end; // Tamanho e FAT já no cartão
+        d->stats.commits++;
+        daylog_note_commit(d);
+    }
+    return fr;
+}
+
+/**
+ * @brief Fecha o arquivo aberto e passa para o de `day` (criado agora se a preparação não o fez).
+ */
+static FRESULT daylog_rotate(sd_daylog_t *d, int64_t day, int64_t now_unix_us)
+{
+    const uint64_t t0 = time_us_64();
+    FILINFO fno;
+
+    (void)daylog_commit(d, false);
+    (void)sd_writer_close(&d->writer);
+    d->last_seq = SD_BINLOG_SEQ_NONE;
+    d->prev_seq = SD_BINLOG_SEQ_NONE;
+
+    if (d->day == SD_DAYLOG_NO_DAY)
+    {
+        (void)f_mkdir(SD_DAYLOG_DIR); // FR_EXIST após o primeiro boot
+    }
+
+    sd_daylog_path(d->path, sizeof(d->path), day);
+    if (f_stat(d->path, &fno) != FR_OK)
+    {
+        (void)daylog_create(d, day, now_unix_us);
+    }
+
+    const sd_writer_stats_t keep = d->writer.stats;
+    sd_writer_init(&d->writer, d->path, NULL, 0, 0, 0); // Commits e f_sync ficam com o diário
+    sd_writer_set_end(&d->writer, daylog_find_end, d);
+    d->writer.stats = keep;
+    d->day = day;
+    d->tail.seq = SD_BINLOG_SEQ_NONE;
+    d->tail.t_unix_us = 0;
+    d->alloc_end = 0;
+    d->stats.rotations++;
+
+    const FRESULT fr = sd_writer_open(&d->writer);
+    const uint32_t dt = (uint32_t)(time_us_64() - t0);
+    d->stats.rotate_max_us = (dt > d->stats.rotate_max_us) ? dt : d->stats.rotate_max_us;
+    return fr;
+}
+
+/**
+ * @brief Prepara o estado (nada é aberto até o primeiro registro, que abre a sessão de boot).
+ * @param commit_ms Maior espera de um registro no buffer antes do commit (`SD_DAYLOG_COMMIT_MS`).
+ */
+void sd_daylog_init(sd_daylog_t *d, uint32_t commit_ms)
+{
+    memset(d, 0, sizeof(*d));
+    d->day = SD_DAYLOG_NO_DAY;
+    d->prepared_day = SD_DAYLOG_NO_DAY;
+    d->commit_ms = commit_ms;
+    d->session = SD_BINLOG_SESSION_BOOT;
+    d->last_seq = SD_BINLOG_SEQ_NONE;
+    d->prev_seq = SD_BINLOG_SEQ_NONE;
+    d->tail.seq = SD_BINLOG_SEQ_NONE;
+    d->stats.committed_seq = SD_BINLOG_SEQ_NONE;
+}
+
+/**
+ * @brief Grava um registro no arquivo do seu dia, trocando ou preparando arquivos quando for a hora.
+ * @details O registro vai inteiro para o buffer do escritor (32 bytes,
+ *          precedido do cabeçalho num arquivo vazio, da unidade de sessão
+ *          após boot ou erro e do índice quando a próxima unidade é a de
+ *          índice); a troca de arquivo acontece antes dele, então nenhum
+ *          registro fica entre dois arquivos. O `seq` de `r` é ignorado: o
+ *          registro recebe o próximo seq do diário.
+ * @param clock_ok Relógio sincronizado (`time_sync_is_synced()`): só então o dia do registro decide o arquivo.
+ */
+FRESULT sd_daylog_append(sd_daylog_t *d, const sd_binlog_rec_t *r, bool clock_ok)
+{
+    int64_t day = d->day;
+    FRESULT fr;
+
+    if (clock_ok)
+    {
+        day = sd_daylog_local_day(r->t_unix_us);
+    }
+    else if (day == SD_DAYLOG_NO_DAY)
+    {
+        uint64_t total;
+        int64_t oldest;
+        int64_t newest = SD_DAYLOG_NO_DAY;
+        (void)daylog_scan(SD_DAYLOG_NO_DAY, SD_DAYLOG_NO_DAY, INT64_MAX, &total, &oldest, &newest);
+        day = (newest != SD_DAYLOG_NO_DAY) ? newest : sd_daylog_local_day(r->t_unix_us);
+    }
+
+    if (day != d->day)
+    {
+        fr = daylog_rotate(d, day, r->t_unix_us);
+        if (fr != FR_OK)
+        {
+            return fr;
+        }
+    }
+
+    if (clock_ok && d->prepared_day != day + 1 && local_second_of_day(r->t_unix_us) >= DAY_S - SD_DAYLOG_PREPARE_S)
+    {
+        d->prepared_day = day + 1; // Uma tentativa; se falhar, a virada cria o arquivo
+        (void)daylog_create(d, day + 1, r->t_unix_us);
+    }
+
+    if (!d->writer.open)
+    {
+        // Reabertura após erro: o buffer perdido aparece como salto de seq
+        d->session = d->session ? d->session : SD_BINLOG_SESSION_REOPEN;
+        d->last_seq = SD_BINLOG_SEQ_NONE;
+        d->prev_seq = SD_BINLOG_SEQ_NONE;
+        fr = sd_writer_open(&d->writer);
+        if (fr != FR_OK)
+        {
+            return fr;
+        }
+    }
+
+    uint8_t u[SD_BINLOG_UNIT];
+
+    if (sd_writer_size(&d->writer) == 0U)
+    {
+        // Arquivo criado sem cabeçalho (falha no meio da criação) ou cabeçalho ilegível
+        d->hdr.version = SD_BINLOG_VERSION;
+        d->hdr.salt = daylog_salt(r->t_unix_us);
+        d->hdr.created_unix_us = r->t_unix_us;
+        sd_binlog_put_header(u, &d->hdr);
+        fr = sd_writer_append(&d->writer, u, sizeof(u));
+        if (fr != FR_OK)
+        {
+            return fr;
+        }
+        memset(&d->index, 0, sizeof(d->index));
+    }
+
+    if (d->session)
+    {
+        if (d->session == SD_BINLOG_SESSION_BOOT && d->tail.seq == SD_BINLOG_SEQ_NONE)
+        {
+            daylog_prev_tail(d, d->day);
+        }
+        if (d->session == SD_BINLOG_SESSION_BOOT)
+        {
+            d->next_seq = (d->tail.seq != SD_BINLOG_SEQ_NONE) ? d->tail.seq + 1U : 0U;
+        }
+
+        const sd_binlog_session_t ss = {
+            .reason = d->session,
+            .next_seq = d->next_seq,
+            .t_start = r->t_unix_us,
+            .prev_seq = d->tail.seq,
+            .t_prev = d->tail.t_unix_us,
+        };
+        sd_binlog_put_session(u, &d->hdr, &ss);
+        fr = daylog_put(d, u);
+        if (fr != FR_OK)
+        {
+            return fr;
+        }
+        d->session = 0;
+        d->stats.sessions++;
+    }
+
+    sd_binlog_rec_t jr = *r;
+    jr.seq = d->next_seq;
+    sd_binlog_put_record(u, &d->hdr, &jr);
+    fr = daylog_put(d, u);
+    if (fr != FR_OK)
+    {
+        return fr;
+    }
+
+    const uint32_t off = (uint32_t)sd_writer_size(&d->writer) - SD_BINLOG_UNIT;
+    sd_binlog_index_add(&d->index, off, &jr);
+    d->prev_seq = d->last_seq;
+    d->prev_off = d->last_off;
+    d->last_seq = jr.seq;
+    d->last_off = off;
+    d->next_seq++;
+    daylog_note_commit(d);
+    return FR_OK;
+}
+
+/**
+ * @brief Faz o commit quando o registro mais antigo do buffer passa de `commit_ms`; com `sync`, já e com `f_sync`.
+ */
+FRESULT sd_daylog_poll(sd_daylog_t *d, bool sync)
+{
+    const sd_writer_t *w = &d->writer;
+
+    if (sync || (w->len && (time_us_64() - w->first_us) >= (uint64_t)d->commit_ms * 1000U))
+    {
+        return daylog_commit(d, sync);
+    }
+    return FR_OK;
+}
+
+/**
+ * @brief Faz o commit e fecha o arquivo do dia; o próximo registro o reabre.
+ */
+FRESULT sd_daylog_close(sd_daylog_t *d)
+{
+    FRESULT fr = daylog_commit(d, false);
+    const FRESULT fc = sd_writer_close(&d->writer);
+    fr = (fr == FR_OK) ? fc : fr;
+    d->day = SD_DAYLOG_NO_DAY;
+    return fr;
+}
+
+/**
+ * @brief Abre o arquivo de `day` para leitura, sem atrapalhar a gravação.
+ * @details O arquivo em gravação é lido pelo escritor, até o que já foi
+ *          descarregado (o buffer em RAM fica de fora; o fim lógico é a
+ *          posição de descarga). Os outros são abertos só para leitura; o
+ *          fim lógico é procurado com `find_end` (arquivos v2+), o que custa
+ *          ~log2(segmentos) leituras, então quem reabre o mesmo dia guarda
+ *          `end` e passa `find_end` falso.
+ * @return FR_NO_FILE se não há arquivo do dia ou o cabeçalho é inválido.
+ */
+FRESULT sd_daylog_reader_open(sd_daylog_t *d, sd_daylog_reader_t *rd, int64_t day, bool find_end)
+{
+    uint8_t u[SD_BINLOG_UNIT];
+    char path[SD_DAYLOG_PATH_LEN];
+
+    rd->live = (day == d->day && d->writer.open);
+    if (rd->live)
+    {
+        rd->src.read = daylog_read;
+        rd->src.ctx = &d->writer;
+        rd->src.size = (uint32_t)d->writer.buf_pos;
+        rd->src.hdr = d->hdr;
+        rd->end = rd->src.size;
+        return FR_OK;
+    }
+
+    sd_daylog_path(path, sizeof(path), day);
+    FRESULT fr = f_open(&rd->file, path, FA_READ);
+    if (fr != FR_OK)
+    {
+        return fr;
+    }
+
+    rd->src.read = fil_read;
+    rd->src.ctx = &rd->file;
+    rd->src.size = (uint32_t)f_size(&rd->file);
+    if (!fil_read(&rd->file, 0, u, sizeof(u)) || !sd_binlog_get_header(u, &rd->src.hdr))
+    {
+        (void)f_close(&rd->file);
+        return FR_NO_FILE;
+    }
+
+    rd->end = 0U;
+    if (find_end)
+    {
+        rd->end = (rd->src.hdr.version >= 2U) ? sd_binlog_find_end(&rd->src, NULL, NULL) : rd->src.size;
+    }
+    return FR_OK;
+}
+
+/** @brief Fecha o leitor (o escritor do arquivo em gravação continua aberto). */
+void sd_daylog_reader_close(sd_daylog_reader_t *rd)
+{
+    if (!rd->live)
+    {
+        (void)f_close(&rd->file);
+    }
+}
@@ -0,0 +1,112 @@
+/**
+ * @file sd_daylog.h
+ * @brief Log binário do SD em um arquivo por dia, pré-alocado, com limite de espaço (firmware e host).
+ * @details
+ *  Os registros (`lib/sd_binlog.h`) vão para `log/AAAAMMDD.bin`, pelo dia
+ *  local do instante do registro. Cada arquivo nasce com `f_expand`
+ *  (clusters contíguos já reservados), então os anexos não alocam clusters
+ *  nem percorrem a cadeia da FAT, e o fim lógico é achado pelo CRC
+ *  (`sd_binlog_find_end`). O arquivo do dia seguinte é criado na última hora do dia
+ *  (`SD_DAYLOG_PREPARE_S`), fora da virada, que fica reduzida a fechar um
+ *  arquivo e abrir outro. Antes de criar um arquivo, os mais antigos são
+ *  apagados até caber no orçamento (`SD_DAYLOG_BUDGET_BYTES`).
+ *
+ *  Sem relógio sincronizado o dia do registro não é confiável: os registros
+ *  continuam no arquivo aberto ou, após um boot, no arquivo mais recente.
+ *
+ *  Diário (formato v3): cada registro recebe o próximo `seq`, contínuo
+ *  entre boots e arquivos. No boot, a recuperação acha o fim lógico e o
+ *  último registro com a busca binária sobre os índices (sem varrer o
+ *  arquivo) e grava uma unidade de sessão com ele, então a janela perdida
+ *  numa queda fica registrada. Os registros vão ao cartão em commits de
+ *  setores inteiros, a cada `SD_DAYLOG_COMMIT_MS` ou ao encher o buffer do
+ *  escritor, cada setor gravado uma só vez; dentro da pré-alocação nenhum
+ *  commit escreve FAT ou diretório (sem `f_sync`), o que fica para a
+ *  criação, a poda e o fechamento do arquivo, uma vez por dia.
+ *
+ *  Leitura durante a gravação (`sd_daylog_reader_open`): o arquivo do dia
+ *  em gravação é lido pelo próprio escritor, até o que já está no cartão;
+ *  os demais, por um FIL só de leitura. O leitor não guarda nada entre
+ *  chamadas além do tamanho, então pode ser fechado e reaberto a cada
+ *  trecho, entre gravações.
+ *
+ *  Sem FreeRTOS: só FatFs e `time_us_64`, como `lib/sd_writer.h`; a mesma
+ *  rotação roda no host sobre uma imagem FAT (`tools/sd_soak.c`). Não é
+ *  reentrante: um único chamador por vez (a task do sink do SD, ou outra
+ *  task com o FatFs travado pelo sink).
+ */
+
+#ifndef SD_DAYLOG_H
+#define SD_DAYLOG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "ff.h"
+#include "lib/sd_binlog.h"
+#include "lib/sd_writer.h"
+
+#define SD_DAYLOG_DIR           "log"                   /**< Diretório dos arquivos diários. */
+#define SD_DAYLOG_PATH_LEN      20U                     /**< "log/AAAAMMDD.bin" + '\0'. */
+#define SD_DAYLOG_PREALLOC      (376UL * SD_BINLOG_SEG_UNITS * SD_BINLOG_UNIT) /**< ~3 MB: 86400 registros e enchimento dos commits (~362 segmentos) e folga. */
+#define SD_DAYLOG_BUDGET_BYTES  (64ULL * 1024U * 1024U) /**< Espaço máximo dos arquivos diários (~23 dias). */
+#define SD_DAYLOG_PREPARE_S     3600U                   /**< Antecedência da criação do arquivo do dia seguinte [s]. */
+#define SD_DAYLOG_COMMIT_MS     60000U                  /**< Maior espera de um registro antes do commit (perda máxima numa queda). */
+#define SD_DAYLOG_NO_DAY        INT64_MIN               /**< Nenhum arquivo aberto ainda. */
+
+/** @brief Contadores da rotação. */
+typedef struct
+{
+    uint32_t rotations;         /**< Trocas de arquivo (inclui a primeira abertura). */
+    uint32_t created;           /**< Arquivos criados. */
+    uint32_t prealloc_failed;   /**< `f_expand` sem espaço contíguo (o arquivo cresce por anexos). */
+    uint32_t pruned;            /**< Arquivos antigos apagados pelo orçamento. */
+    uint32_t rotate_max_us;     /**< Maior troca de arquivo (commit, fechar, abrir, achar o fim). */
+    uint32_t create_max_us;     /**< Maior criação (poda, `f_expand`, cabeçalho). */
+    uint32_t commits;           /**< Commits (setores completados e gravados). */
+    uint32_t pad_units;         /**< Unidades de enchimento gravadas. */
+    uint32_t sessions;          /**< Sessões abertas (boot e reaberturas após erro). */
+    uint32_t committed_seq;     /**< Último registro já no cartão (`SD_BINLOG_SEQ_NONE`: nenhum). */
+} sd_daylog_stats_t;
+
+/** @brief Estado do log diário (uma instância, estática). */
+typedef struct
+{
+    sd_writer_t writer;         /**< Escritor do arquivo do dia. */
+    sd_binlog_hdr_t hdr;        /**< Cabeçalho do arquivo aberto (salt do CRC). */
+    sd_binlog_index_t index;    /**< Segmento corrente. */
+    int64_t day;                /**< Dia local do arquivo aberto (dias desde 1970). */
+    int64_t prepared_day;       /**< Último dia seguinte já preparado. */
+    uint32_t commit_ms;         /**< Prazo de commit. */
+    uint32_t next_seq;          /**< Seq do próximo registro. */
+    uint8_t session;            /**< Sessão a abrir no próximo registro (0: nenhuma). */
+    sd_binlog_tail_t tail;      /**< Último registro no arquivo quando foi aberto. */
+    FSIZE_t alloc_end;          /**< Tamanho do arquivo na abertura (área já alocada). */
+    uint32_t last_seq;          /**< Último registro anexado... */
+    FSIZE_t last_off;           /**< ...e sua posição. */
+    uint32_t prev_seq;          /**< Penúltimo registro anexado... */
+    FSIZE_t prev_off;           /**< ...e sua posição. */
+    char path[SD_DAYLOG_PATH_LEN]; /**< Caminho do arquivo aberto. */
+    sd_daylog_stats_t stats;    /**< Contadores. */
+} sd_daylog_t;
+
+/** @brief Leitor de um arquivo diário (consultas). */
+typedef struct
+{
+    FIL file;                   /**< Arquivo de um dia passado. */
+    bool live;                  /**< Arquivo em gravação, lido pelo escritor. */
+    sd_binlog_src_t src;        /**< Fonte para `sd_binlog_seek` e leituras. */
+    uint32_t end;               /**< Fim lógico (0 se ainda não procurado). */
+} sd_daylog_reader_t;
+
+int64_t sd_daylog_local_day(int64_t unix_us);
+void sd_daylog_path(char *buf, size_t size, int64_t day);
+bool sd_daylog_parse_name(const char *name, int64_t *day);
+void sd_daylog_init(sd_daylog_t *d, uint32_t commit_ms);
+FRESULT sd_daylog_append(sd_daylog_t *d, const sd_binlog_rec_t *r, bool clock_ok);
+FRESULT sd_daylog_poll(sd_daylog_t *d, bool sync);
+FRESULT sd_daylog_close(sd_daylog_t *d);
+FRESULT sd_daylog_reader_open(sd_daylog_t *d, sd_daylog_reader_t *rd, int64_t day, bool find_end);
+void sd_daylog_reader_close(sd_daylog_reader_t *rd);
+
+#endif /* SD_DAYLOG_H */
@@ -0,0 +1,472 @@
+/**
+ * @file sd_query.c
+ * @brief Consulta ao histórico do SD por intervalo de tempo: busca por índice e saída CSV por trechos.
+ */
+
+#include "lib/sd_query.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "lib/sd_card_log_task.h"
+#include "lib/sd_daylog.h"
+#include "lib/sd_binlog.h"
+#include "lib/serial_cmd.h"
+#include "lib/timestamp.h"
+#include "lib/fmt.h"
+
+#define SD_QUERY_ROW_MAX        96U     /**< Maior linha CSV (todas as métricas). */
+
+/** @brief Métrica selecionável: nome na consulta e no cabeçalho CSV. */
+typedef struct
+{
+    const char *name;       /**< Nome da coluna. */
+    uint8_t decimals;       /**< Casas decimais. */
+} query_metric_t;
+
+static const query_metric_t k_metrics[] = {
+    {"vrms", 2},
+    {"irms", 2},
+    {"v_pu", 2},
+    {"p_w", 1},
+};
+
+/** @brief Consulta em andamento (uma por vez). */
+typedef struct
+{
+    sd_query_req_t req;     /**< Pedido. */
+    sd_query_out_fn out;    /**< Destino das linhas. */
+    sd_query_done_fn done;  /**< Aviso de fim. */
+    void *ctx;              /**< Contexto de `out` e `done`. */
+    fmt_buf_t buf;          /**< Bloco de saída em montagem. */
+    uint32_t rows;          /**< Linhas entregues nesta consulta. */
+    bool failed;            /**< Saída recusou um bloco ou FatFs indisponível. */
+} query_t;
+
+static query_t s_q;
+static volatile bool s_active = false;  /**< Consulta aceita e ainda não encerrada. */
+static volatile bool s_stop = false;    /**< Pedido de interrupção (`sd_query_stop`). */
+static SemaphoreHandle_t s_go;          /**< Aviso de nova consulta à task. */
+static sd_daylog_reader_t s_reader;     /**< Leitor (FIL) do trecho em curso. */
+static uint8_t s_chunk[SD_QUERY_CHUNK]; /**< Trecho lido do cartão. */
+static char s_out[SD_QUERY_OUT_SIZE];   /**< Bloco de saída. */
+static sd_query_stats_t s_stats;
+
+static void query_cmd(int argc, char **argv);
+
+static const serial_cmd_t s_query_cmd = {
+    .name = "query",
+    .args = "[<de> <ate> [metricas] [limite] | stop]",
+    .help = "Historico do SD em CSV (AAAA-MM-DDTHH:MM:SS ou s Unix; metricas vrms,irms,v_pu,p_w).",
+    .fn = query_cmd,
+};
+
+/**
+ * @brief Converte uma lista "vrms,p_w" em máscara `SD_QUERY_*`.
+ * @return false se algum nome é desconhecido.
+ */
+bool sd_query_parse_metrics(const char *s, size_t len, uint8_t *mask)
+{
+    const char *end = s + len;
+    uint8_t m = 0;
+
+    while (s < end)
+    {
+        const char *comma = memchr(s, ',', (size_t)(end - s));
+        const size_t n = (size_t)((comma ? comma : end) - s);
+        bool found = false;
+
+        for (uint8_t i = 0; i < sizeof(k_metrics) / sizeof(k_metrics[0]); i++)
+        {
+            if (strlen(k_metrics[i].name) == n && memcmp(k_metrics[i].name, s, n) == 0)
+            {
+                m |= (uint8_t)(1U << i);
+                found = true;
+            }
+        }
+        if (!found)
+        {
+            return false;
+        }
+        s += n + (comma ? 1U : 0U);
+    }
+
+    *mask = m ? m : SD_QUERY_ALL;
+    return true;
+}
+
+/**
+ * @brief Aceita uma consulta se nenhuma estiver em andamento (não bloqueia; serve ao lwIP).
+ * @details Chamada do comando serial (task) ou de `http_recv_cb`, que com
+ *          `pico_cyw43_arch_lwip_threadsafe_background` roda numa IRQ: a
+ *          seção crítica e o aviso à task usam a variante do contexto.
+ * @param req Pedido (copiado).
+ * @param out Destino das linhas, chamado pela task de consulta.
+ * @param done Aviso de fim, chamado uma vez se a consulta foi aceita (pode ser NULL).
+ */
+sd_query_result_t sd_query_start(const sd_query_req_t *req, sd_query_out_fn out, sd_query_done_fn done, void *ctx)
+{
+    if (req->t_to < req->t_from ||
+        sd_daylog_local_day(req->t_to) - sd_daylog_local_day(req->t_from) >= (int64_t)SD_QUERY_MAX_DAYS)
+    {
+        return SD_QUERY_INVALID;
+    }
+    if (!sd_card_log_ready())
+    {
+        return SD_QUERY_NO_CARD;
+    }
+
+    const bool in_isr = portCHECK_IF_IN_ISR();
+    bool busy;
+
+    if (in_isr)
+    {
+        const UBaseType_t saved = taskENTER_CRITICAL_FROM_ISR();
+        busy = s_active;
+        s_active = true;
+        taskEXIT_CRITICAL_FROM_ISR(saved);
+    }
+    else
+    {
+        taskENTER_CRITICAL();
+        busy = s_active;
+        s_active = true;
+        taskEXIT_CRITICAL();
+    }
+
+    if (busy)
+    {
+        s_stats.busy++;
+        return SD_QUERY_BUSY;
+    }
+
+    s_q.req = *req;
+    s_q.req.metrics = req->metrics ? (req->metrics & SD_QUERY_ALL) : SD_QUERY_ALL;
+    s_q.out = out;
+    s_q.done = done;
+    s_q.ctx = ctx;
+    s_stop = false;
+
+    if (in_isr)
+    {
+        BaseType_t hp = pdFALSE;
+        xSemaphoreGiveFromISR(s_go, &hp);
+        portYIELD_FROM_ISR(hp);
+    }
+    else
+    {
+        xSemaphoreGive(s_go);
+    }
+    return SD_QUERY_STARTED;
+}
+
+/** @brief Interrompe a consulta em andamento no próximo trecho. */
+void sd_query_stop(void)
+{
+    s_stop = s_active;
+}
+
+/** @brief Entrega o bloco de saída montado. */
+static bool query_flush(query_t *q)
+{
+    if (q->buf.len == 0U || q->failed)
+    {
+        return !q->failed;
+    }
+
+    q->failed = !q->out(q->ctx, q->buf.buf, q->buf.len);
+    s_stats.bytes += q->buf.len;
+    fmt_buf_init(&q->buf, s_out, sizeof(s_out));
+    return !q->failed;
+}
+
+/** @brief Garante espaço para uma linha no bloco de saída. */
+static bool query_room(query_t *q)
+{
+    return fmt_buf_room(&q->buf) > SD_QUERY_ROW_MAX || query_flush(q);
+}
+
+/** @brief Cabeçalho CSV com as métricas pedidas. */
+static void query_header(query_t *q)
+{
+    fmt_buf_str(&q->buf, "timestamp");
+    for (uint8_t i = 0; i < sizeof(k_metrics) / sizeof(k_metrics[0]); i++)
+    {
+        if (q->req.metrics & (1U << i))
+        {
+            fmt_buf_char(&q->buf, ',');
+            fmt_buf_str(&q->buf, k_metrics[i].name);
+        }
+    }
+    fmt_buf_str(&q->buf, ",seq\n");
+}
+
+/** @brief Acrescenta a linha CSV de um registro. */
+static void query_row(query_t *q, timestamp_cache_t *tc, const sd_binlog_rec_t *r)
+{
+    const float v[] = {r->vrms, r->irms, r->v_pu, r->p_w};
+    char ts[TIMESTAMP_MAX_LEN];
+
+    timestamp_format(tc, ts, sizeof(ts), r->t_unix_us);
+    fmt_buf_str(&q->buf, ts);
+    for (uint8_t i = 0; i < sizeof(k_metrics) / sizeof(k_metrics[0]); i++)
+    {
+        if (q->req.metrics & (1U << i))
+        {
+            fmt_buf_char(&q->buf, ',');
+            fmt_buf_double(&q->buf, v[i], k_metrics[i].decimals);
+        }
+    }
+    fmt_buf_char(&q->buf, ',');
+    fmt_buf_u32(&q->buf, r->seq);
+    fmt_buf_char(&q->buf, '\n');
+    q->rows++;
+}
+
+/**
+ * @brief Lê o próximo trecho de um dia com o FatFs travado.
+ * @param[in,out] off Posição de leitura (na primeira chamada, a busca pelo índice a define).
+ * @param[in,out] end Fim lógico conhecido (0: ainda não procurado).
+ * @param[in,out] live O arquivo estava em gravação na chamada anterior.
+ * @param[out] n Bytes lidos em `s_chunk` (0: fim do dia).
+ * @return false se o FatFs não ficou disponível a tempo.
+ */
+static bool query_read_chunk(const query_t *q, int64_t day, bool first, uint32_t *off, uint32_t *end, bool *live,
+                             uint32_t *n)
+{
+    *n = 0U;
+    if (!sd_card_log_lock(SD_QUERY_LOCK_MS))
+    {
+        return false;
+    }
+
+    const uint64_t t0 = time_us_64();
+    sd_daylog_t *d = sd_card_log_daylog();
+    if (!d)
+    {
+        sd_card_log_unlock();
+        return false;
+    }
+
+    /* O fim lógico de um dia passado é procurado uma vez; o do dia em
+       gravação é o que já está no cartão e cresce entre trechos. Se o dia
+       virou entre trechos, o fechamento gravou o resto: procura de novo. */
+    if (sd_daylog_reader_open(d, &s_reader, day, first || *live) == FR_OK)
+    {
+        if (s_reader.live || first || *live)
+        {
+            *end = s_reader.end;
+        }
+        *live = s_reader.live;
+
+        if (first)
+        {
+            uint32_t reads = 0;
+            s_reader.src.size = *end;
+            *off = sd_binlog_seek(&s_reader.src, q->req.t_from, &reads);
+            s_stats.seeks += reads;
+        }
+
+        const uint32_t left = (*end > *off) ? *end - *off : 0U;
+        *n = (left < SD_QUERY_CHUNK) ? left : SD_QUERY_CHUNK;
+        *n -= *n % SD_BINLOG_UNIT;
+        if (*n && !s_reader.src.read(s_reader.src.ctx, *off, s_chunk, *n))
+        {
+            *n = 0U;
+        }
+        sd_daylog_reader_close(&s_reader);
+    }
+
+    const uint32_t dt = (uint32_t)(time_us_64() - t0);
+    sd_card_log_unlock();
+    s_stats.chunks++;
+    s_stats.lock_max_us = (dt > s_stats.lock_max_us) ? dt : s_stats.lock_max_us;
+    return true;
+}
+
+/**
+ * @brief Percorre um dia a partir do primeiro segmento do intervalo.
+ * @return false se a consulta terminou (passou de `t_to`, limite, erro ou interrupção).
+ */
+static bool query_day(query_t *q, timestamp_cache_t *tc, int64_t day)
+{
+    uint32_t off = 0U;
+    uint32_t end = 0U;
+    bool live = false;
+
+    for (bool first = true;; first = false)
+    {
+        uint32_t n = 0U;
+
+        if (s_stop)
+        {
+            q->failed = true;
+            return false;
+        }
+        if (!query_read_chunk(q, day, first, &off, &end, &live, &n))
+        {
+            q->failed = true;
+            return false;
+        }
+        if (n == 0U)
+        {
+            return true; /* Fim do dia (ou arquivo ausente): segue no próximo */
+        }
+
+        for (uint32_t i = 0; i < n; i += SD_BINLOG_UNIT)
+        {
+            sd_binlog_rec_t r;
+
+            if (sd_binlog_check(&s_chunk[i], &s_reader.src.hdr) != SD_BINLOG_TYPE_RECORD)
+            {
+                continue;
+            }
+            sd_binlog_get_record(&s_chunk[i], &r);
+            if (r.t_unix_us < q->req.t_from)
+            {
+                continue;
+            }
+            if (r.t_unix_us > q->req.t_to || (q->req.limit && q->rows >= q->req.limit))
+            {
+                return false;
+            }
+            if (!query_room(q))
+            {
+                return false;
+            }
+            query_row(q, tc, &r);
+        }
+        off += n;
+    }
+}
+
+/** @brief Executa a consulta aceita, do dia de `t_from` ao de `t_to`. */
+static void query_run(query_t *q)
+{
+    timestamp_cache_t tc = TIMESTAMP_CACHE_INIT('-', 'T', false);
+    const int64_t last = sd_daylog_local_day(q->req.t_to);
+    const uint64_t t0 = time_us_64();
+
+    fmt_buf_init(&q->buf, s_out, sizeof(s_out));
+    q->rows = 0U;
+    q->failed = false;
+    query_header(q);
+
+    for (int64_t day = sd_daylog_local_day(q->req.t_from); day <= last; day++)
+    {
+        if (!query_day(q, &tc, day))
+        {
+            break;
+        }
+    }
+    (void)query_flush(q);
+
+    s_stats.rows += q->rows;
+    s_stats.queries += q->failed ? 0U : 1U;
+    s_stats.aborted += q->failed ? 1U : 0U;
+    s_stats.last_ms = (uint32_t)((time_us_64() - t0) / 1000U);
+
+    if (q->done)
+    {
+        q->done(q->ctx, !q->failed);
+    }
+}
+
+/**
+ * @brief Copia os contadores das consultas.
+ * @param[out] out Destino.
+ */
+void sd_query_get_stats(sd_query_stats_t *out)
+{
+    *out = s_stats;
+}
+
+/**
+ * @brief Registra o comando serial "query" (antes do scheduler).
+ */
+void sd_query_init(void)
+{
+    s_go = xSemaphoreCreateBinary();
+    (void)serial_cmd_register(&s_query_cmd);
+}
+
+/**
+ * @brief Task de consulta: espera um pedido e o executa (prioridade mínima).
+ * @param params Não utilizado.
+ */
+void sd_query_task(void *params)
+{
+    (void)params;
+
+    for (;;)
+    {
+        xSemaphoreTake(s_go, portMAX_DELAY);
+        query_run(&s_q);
+        s_active = false;
+    }
+}
+
+/* ---------------------------------------------------------------------- */
+/* Comando serial                                                         */
+/* ---------------------------------------------------------------------- */
+
+/** @brief Saída da consulta serial: direto no stdio. */
+static bool query_serial_out(void *ctx, const char *data, size_t len)
+{
+    (void)ctx;
+    return fwrite(data, 1, len, stdout) == len;
+}
+
+/** @brief Fim da consulta serial. */
+static void query_serial_done(void *ctx, bool ok)
+{
+    (void)ctx;
+    printf("# %s: %lu linhas em %lu ms\n", ok ? "fim" : "interrompida", (unsigned long)s_q.rows,
+           (unsigned long)s_stats.last_ms);
+}
+
+/**
+ * @brief Comando serial "query": sem argumentos mostra os contadores;
+ *        "query <de> <ate> [metricas] [limite]" consulta; "query stop" interrompe.
+ */
+static void query_cmd(int argc, char **argv)
+{
+    if (argc == 1)
+    {
+        sd_query_stats_t st;
+        sd_query_get_stats(&st);
+        printf("Consultas: %lu concluidas, %lu interrompidas, %lu recusadas | %lu linhas, %llu bytes\n",
+               (unsigned long)st.queries, (unsigned long)st.aborted, (unsigned long)st.busy,
+               (unsigned long)st.rows, (unsigned long long)st.bytes);
+        printf("Cartao: %lu trechos (max %lu us com o FatFs travado), %lu leituras de indice | ultima %lu ms\n",
+               (unsigned long)st.chunks, (unsigned long)st.lock_max_us, (unsigned long)st.seeks,
+               (unsigned long)st.last_ms);
+        return;
+    }
+    if (argc == 2 && strcmp(argv[1], "stop") == 0)
+    {
+        sd_query_stop();
+        return;
+    }
+
+    sd_query_req_t req = {.metrics = SD_QUERY_ALL};
+    char *end = NULL;
+    if (argc < 3 || !timestamp_parse(argv[1], strlen(argv[1]), &req.t_from) ||
+        !timestamp_parse(argv[2], strlen(argv[2]), &req.t_to) ||
+        (argc > 3 && !sd_query_parse_metrics(argv[3], strlen(argv[3]), &req.metrics)) ||
+        (argc > 4 && ((req.limit = (uint32_t)strtoul(argv[4], &end, 10)), *end != '\0')))
+    {
+        printf("Uso: query <de> <ate> [vrms,irms,v_pu,p_w] [limite]\n");
+        return;
+    }
+
+    static const char *const k_result[] = {"", "consulta em andamento", "intervalo invalido", "SD indisponivel"};
+    const sd_query_result_t res = sd_query_start(&req, query_serial_out, query_serial_done, NULL);
+    if (res != SD_QUERY_STARTED)
+    {
+        printf("Consulta recusada: %s\n", k_result[res]);
+    }
+}
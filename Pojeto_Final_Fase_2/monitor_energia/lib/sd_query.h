@@ -0,0 +1,89 @@
+/**
+ * @file sd_query.h
+ * @brief Consulta ao histórico do SD (log diário binário) por intervalo de tempo, em CSV por trechos.
+ * @details
+ *  Uma consulta (intervalo, métricas, limite de linhas) percorre os arquivos
+ *  diários (`lib/sd_daylog.h`) do dia de `t_from` ao de `t_to`: em cada um,
+ *  a busca binária sobre os índices (`sd_binlog_seek`) acha o primeiro
+ *  segmento do intervalo, e daí a leitura segue em trechos de
+ *  `SD_QUERY_CHUNK` bytes. Cada trecho é lido com o FatFs travado
+ *  (`sd_card_log_lock`) e solto em seguida, então o sink do SD continua
+ *  gravando entre trechos; o arquivo do dia em gravação é lido até o que
+ *  já está no cartão.
+ *
+ *  As linhas CSV vão para a função de saída do chamador (HTTP ou serial)
+ *  em blocos de até `SD_QUERY_OUT_SIZE` bytes; a memória é fixa (um
+ *  trecho, um bloco de saída e um FIL), qualquer que seja o intervalo.
+ *  Uma consulta por vez, numa task de prioridade mínima (`sd_query_task`).
+ */
+
+#ifndef SD_QUERY_H
+#define SD_QUERY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SD_QUERY_CHUNK          4096U   /**< Bytes lidos do cartão por travamento do FatFs. */
+#define SD_QUERY_OUT_SIZE       1024U   /**< Bloco de saída (linhas CSV). */
+#define SD_QUERY_MAX_DAYS       31U     /**< Maior intervalo aceito [dias]. */
+#define SD_QUERY_LOCK_MS        5000U   /**< Espera máxima pelo FatFs antes de abortar. */
+
+#define SD_QUERY_VRMS           (1U << 0) /**< Métrica: tensão RMS. */
+#define SD_QUERY_IRMS           (1U << 1) /**< Métrica: corrente RMS. */
+#define SD_QUERY_V_PU           (1U << 2) /**< Métrica: tensão em PU. */
+#define SD_QUERY_P_W            (1U << 3) /**< Métrica: potência. */
+#define SD_QUERY_ALL            0x0FU     /**< Todas as métricas. */
+
+/** @brief Resultado de `sd_query_start`. */
+typedef enum
+{
+    SD_QUERY_STARTED = 0,   /**< Consulta aceita; a saída segue na task de consulta. */
+    SD_QUERY_BUSY,          /**< Outra consulta em andamento. */
+    SD_QUERY_INVALID,       /**< Intervalo vazio ou maior que `SD_QUERY_MAX_DAYS`. */
+    SD_QUERY_NO_CARD,       /**< Cartão não montado ou log em CSV. */
+} sd_query_result_t;
+
+/**
+ * @brief Entrega um bloco de texto ao destino (no contexto da task de consulta).
+ * @return false para abortar a consulta (cliente desconectado).
+ */
+typedef bool (*sd_query_out_fn)(void *ctx, const char *data, size_t len);
+
+/**
+ * @brief Fim da consulta (no contexto da task de consulta), sempre chamado uma vez.
+ * @param ok false se abortada (saída, FatFs ou `sd_query_stop`).
+ */
+typedef void (*sd_query_done_fn)(void *ctx, bool ok);
+
+/** @brief Pedido de consulta. */
+typedef struct
+{
+    int64_t t_from;         /**< Início do intervalo (Unix µs, inclusive). */
+    int64_t t_to;           /**< Fim do intervalo (Unix µs, inclusive). */
+    uint8_t metrics;        /**< `SD_QUERY_*` (0: todas). */
+    uint32_t limit;         /**< Máximo de linhas (0: sem limite). */
+} sd_query_req_t;
+
+/** @brief Contadores das consultas. */
+typedef struct
+{
+    uint32_t queries;       /**< Consultas concluídas. */
+    uint32_t aborted;       /**< Consultas abortadas. */
+    uint32_t busy;          /**< Pedidos recusados (consulta em andamento). */
+    uint32_t rows;          /**< Linhas entregues. */
+    uint64_t bytes;         /**< Bytes entregues. */
+    uint32_t chunks;        /**< Trechos lidos do cartão. */
+    uint32_t seeks;         /**< Leituras de índice na busca. */
+    uint32_t lock_max_us;   /**< Maior tempo com o FatFs travado por um trecho. */
+    uint32_t last_ms;       /**< Duração da última consulta. */
+} sd_query_stats_t;
+
+bool sd_query_parse_metrics(const char *s, size_t len, uint8_t *mask);
+sd_query_result_t sd_query_start(const sd_query_req_t *req, sd_query_out_fn out, sd_query_done_fn done, void *ctx);
+void sd_query_stop(void);
+void sd_query_get_stats(sd_query_stats_t *out);
+void sd_query_init(void);
+void sd_query_task(void *params);
+
+#endif /* SD_QUERY_H */
@@ -0,0 +1,246 @@
+#include "lib/sd_writer.h"
+#include <string.h>
+#include "pico/time.h"
+
+// Capacidade do buffer nesta rodada: até o limite de setor que fecha o buffer.
+// Assim cada descarga cheia termina alinhada e as seguintes gravam setores
+// inteiros direto no cartão, sem ler-modificar-gravar.
+static size_t writer_cap(const sd_writer_t *w) {
+    return SD_WRITER_BUF_SIZE - (size_t)(w->buf_pos % SD_SECTOR_SIZE);
+}
+
+// Fecha o arquivo após um erro; a próxima gravação tenta reabri-lo.
+static void writer_fail(sd_writer_t *w) {
+    w->stats.errors++;
+    (void)f_close(&w->file);
+    w->open = false;
+}
+
+// Abre o arquivo, se ainda fechado (após init ou após um erro), escrevendo o
+// cabeçalho se for novo e posicionando a escrita no fim lógico. A escrita
+// recomeça no início do setor do fim: o trecho já gravado desse setor volta
+// ao buffer, e toda descarga cheia grava setores inteiros e alinhados, direto
+// no cartão (sem o buffer de setor do FatFs, que só vai ao disco no f_sync).
+FRESULT sd_writer_open(sd_writer_t *w) {
+    if (w->open) {
+        return FR_OK;
+    }
+
+    FRESULT fr = f_open(&w->file, w->path, FA_READ | FA_WRITE | FA_OPEN_ALWAYS);
+    if (fr != FR_OK) {
+        w->stats.errors++;
+        return fr;
+    }
+
+    w->open = true;
+    w->stats.opens++;
+    w->last_sync_us = time_us_64();
+
+    FSIZE_t end = f_size(&w->file);
+    w->buf_pos = end; // sd_writer_read alcança o arquivo inteiro durante find_end
+
+    if (end == 0 && w->header) {
+        UINT bw;
+        fr = f_write(&w->file, w->header, (UINT)w->header_len, &bw);
+        if (fr != FR_OK) {
+            writer_fail(w);
+            return fr;
+        }
+        w->unsynced = true;
+        end = w->header_len;
+    } else if (end && w->find_end) {
+        end = w->find_end(w, w->end_ctx);
+    }
+
+    const size_t head = (size_t)(end % SD_SECTOR_SIZE);
+    UINT br = 0;
+    fr = f_lseek(&w->file, end - head);
+    if (fr == FR_OK && head) {
+        fr = f_read(&w->file, w->buf, (UINT)head, &br);
+        fr = (fr == FR_OK && br != (UINT)head) ? FR_INT_ERR : fr;
+        fr = (fr == FR_OK) ? f_lseek(&w->file, end - head) : fr;
+    }
+    if (fr != FR_OK) {
+        writer_fail(w);
+        return fr;
+    }
+    w->buf_pos = end - head;
+    w->len = head;
+    w->first_us = w->last_sync_us;
+    return FR_OK;
+}
+
+// Descarrega o buffer no arquivo (f_write, sem f_sync).
+static FRESULT writer_drain(sd_writer_t *w) {
+    if (w->len == 0) {
+        return FR_OK;
+    }
+
+    const uint64_t t0 = time_us_64();
+    UINT bw;
+    FRESULT fr = f_write(&w->file, w->buf, (UINT)w->len, &bw);
+    if (fr == FR_OK && bw != (UINT)w->len) {
+        fr = FR_DENIED; // Volume cheio
+    }
+    if (fr != FR_OK) {
+        writer_fail(w);
+        return fr;
+    }
+
+    const uint32_t dt = (uint32_t)(time_us_64() - t0);
+    w->buf_pos += w->len;
+    w->len = 0;
+    w->unsynced = true;
+    w->stats.flushes++;
+    w->stats.flush_max_us = (dt > w->stats.flush_max_us) ? dt : w->stats.flush_max_us;
+    return FR_OK;
+}
+
+// Prepara o escritor (o arquivo é aberto no primeiro sd_writer_append).
+void sd_writer_init(sd_writer_t *w, const char *path, const void *header, size_t header_len, uint32_t flush_ms,
+                    uint32_t sync_ms) {
+    memset(w, 0, sizeof(*w));
+    w->path = path;
+    w->header = header;
+    w->header_len = header ? header_len : 0U;
+    w->flush_ms = flush_ms;
+    w->sync_ms = sync_ms;
+}
+
+// Define a busca do fim lógico para arquivos existentes (antes da abertura).
+void sd_writer_set_end(sd_writer_t *w, sd_writer_end_fn find_end, void *ctx) {
+    w->find_end = find_end;
+    w->end_ctx = ctx;
+}
+
+// Acrescenta bytes ao buffer; descarrega ao completar setores e aplica os prazos.
+// Com erro de gravação o arquivo é fechado e o buffer pendente é descartado na
+// reabertura (parte dele pode ter chegado ao cartão; o formato acha o fim válido).
+FRESULT sd_writer_append(sd_writer_t *w, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+
+    const FRESULT fo = sd_writer_open(w);
+    if (fo != FR_OK) {
+        return fo;
+    }
+
+    w->stats.appends++;
+    w->stats.bytes += (uint32_t)len;
+
+    while (len) {
+        const size_t cap = writer_cap(w);
+
+        if (w->len >= cap) {
+            const FRESULT fr = writer_drain(w);
+            if (fr != FR_OK) {
+                return fr;
+            }
+            continue;
+        }
+
+        if (w->len == 0) {
+            w->first_us = time_us_64();
+        }
+
+        const size_t n = (len < cap - w->len) ? len : cap - w->len;
+        memcpy(&w->buf[w->len], p, n);
+        w->len += n;
+        p += n;
+        len -= n;
+    }
+
+    return sd_writer_poll(w);
+}
+
+// Aplica os prazos de descarga e f_sync sem novos dados.
+FRESULT sd_writer_poll(sd_writer_t *w) {
+    if (!w->open) {
+        return FR_OK;
+    }
+
+    const uint64_t now = time_us_64();
+
+    if (w->flush_ms && w->len && (now - w->first_us) >= (uint64_t)w->flush_ms * 1000U) {
+        const FRESULT fr = writer_drain(w);
+        if (fr != FR_OK) {
+            return fr;
+        }
+    }
+
+    if (w->sync_ms && (w->unsynced || w->len) && (now - w->last_sync_us) >= (uint64_t)w->sync_ms * 1000U) {
+        return sd_writer_flush(w, true);
+    }
+
+    return FR_OK;
+}
+
+// Descarrega o buffer e, se sync, faz f_sync.
+FRESULT sd_writer_flush(sd_writer_t *w, bool sync) {
+    FRESULT fr;
+
+    if (!w->open) {
+        if (w->len == 0) {
+            return FR_OK;
+        }
+        fr = sd_writer_open(w);
+        if (fr != FR_OK) {
+            return fr;
+        }
+    }
+
+    fr = writer_drain(w);
+    if (fr != FR_OK || !sync || !w->unsynced) {
+        return fr;
+    }
+
+    const uint64_t t0 = time_us_64();
+    fr = f_sync(&w->file);
+    if (fr != FR_OK) {
+        writer_fail(w);
+        return fr;
+    }
+
+    const uint32_t dt = (uint32_t)(time_us_64() - t0);
+    w->unsynced = false;
+    w->last_sync_us = time_us_64();
+    w->stats.syncs++;
+    w->stats.sync_total_us += dt;
+    w->stats.sync_max_us = (dt > w->stats.sync_max_us) ? dt : w->stats.sync_max_us;
+    return FR_OK;
+}
+
+// Lê um trecho já descarregado no arquivo (off + len <= buf_pos), sem fechar o escritor.
+// A posição de escrita volta ao fim do arquivo antes de retornar.
+FRESULT sd_writer_read(sd_writer_t *w, FSIZE_t off, void *buf, size_t len) {
+    if (!w->open || off + len > w->buf_pos) {
+        return FR_INVALID_PARAMETER;
+    }
+
+    UINT br = 0;
+    FRESULT fr = f_lseek(&w->file, off);
+    if (fr == FR_OK) {
+        fr = f_read(&w->file, buf, (UINT)len, &br);
+    }
+    const FRESULT fe = f_lseek(&w->file, w->buf_pos);
+    if (fe != FR_OK) {
+        writer_fail(w);
+        return fe;
+    }
+    return (fr == FR_OK && br != (UINT)len) ? FR_INT_ERR : fr;
+}
+
+// Descarrega, sincroniza e fecha o arquivo. Um arquivo pré-alocado mantém o
+// tamanho (sem f_truncate: nenhuma alteração da FAT ao fechar).
+FRESULT sd_writer_close(sd_writer_t *w) {
+    if (!w->open) {
+        return FR_OK;
+    }
+
+    FRESULT fr = sd_writer_flush(w, true);
+    if (w->open) {
+        const FRESULT fc = f_close(&w->file);
+        fr = (fr == FR_OK) ? fc : fr;
+        w->open = false;
+    }
+    return fr;
+}
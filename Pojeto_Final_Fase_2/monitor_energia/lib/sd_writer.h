@@ -0,0 +1,93 @@
+#ifndef SD_WRITER_H
+#define SD_WRITER_H
+
+// Escritor de arquivo no FatFs com buffer alinhado a setor. Só depende do
+// FatFs e de time_us_64, para rodar também no host (tools/sd_soak.c).
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "ff.h"
+
+#define SD_SECTOR_SIZE      512U    // Setor do cartão (FF_MIN_SS)
+#define SD_WRITER_BUF_SIZE  4096U   // Buffer do escritor em RAM (múltiplo do setor; 8 setores por CMD25)
+#define SD_WRITER_FLUSH_MS  10000U  // Maior espera de um registro no buffer em RAM
+#define SD_WRITER_SYNC_MS   60000U  // Intervalo de f_sync (dados em risco numa queda de energia)
+
+typedef struct sd_writer sd_writer_t;
+
+// Contadores de um escritor.
+typedef struct {
+    uint32_t appends;           // Trechos recebidos
+    uint32_t bytes;             // Bytes recebidos
+    uint32_t flushes;           // Descargas do buffer para o arquivo (f_write)
+    uint32_t syncs;             // Chamadas de f_sync
+    uint32_t opens;             // Aberturas do arquivo (1 + reaberturas após erro)
+    uint32_t errors;            // Falhas de f_open/f_write/f_sync
+    uint32_t flush_max_us;      // Maior duração de uma descarga
+    uint32_t sync_max_us;       // Maior duração de um f_sync
+    uint64_t sync_total_us;     // Soma das durações de f_sync
+} sd_writer_stats_t;
+
+// Fim lógico de um arquivo existente, chamado na abertura (o arquivo já pode
+// ser lido com sd_writer_read até f_size). Com ele o arquivo pode ter sido
+// pré-alocado (f_expand): a escrita continua do fim lógico, dentro dos
+// clusters já reservados.
+typedef FSIZE_t (*sd_writer_end_fn)(sd_writer_t *w, void *ctx);
+
+// Arquivo mantido aberto com buffer em RAM alinhado a setor.
+// O buffer acumula registros até completar o próximo limite de setor do
+// arquivo (descarga em setores inteiros, gravados direto pelo FatFs) ou até
+// flush_ms; f_sync (entrada de diretório e FAT) roda a cada sync_ms. Prazo 0
+// desliga a descarga/f_sync automáticos (o dono chama sd_writer_flush).
+struct sd_writer {
+    FIL file;
+    bool open;
+    bool unsynced;              // Dados descarregados desde o último f_sync
+    const char *path;
+    const void *header;         // Início de arquivo novo (ou NULL)
+    size_t header_len;
+    sd_writer_end_fn find_end;  // Fim lógico de arquivo existente (ou NULL: f_size)
+    void *end_ctx;
+    uint32_t flush_ms;
+    uint32_t sync_ms;
+    FSIZE_t buf_pos;            // Posição no arquivo de buf[0]
+    size_t len;                 // Bytes em buf
+    uint64_t first_us;          // Chegada do byte mais antigo em buf
+    uint64_t last_sync_us;
+    sd_writer_stats_t stats;
+    uint8_t buf[SD_WRITER_BUF_SIZE] __attribute__((aligned(4)));
+};
+
+// Prepara o escritor (o arquivo é aberto no primeiro sd_writer_append).
+// header: bytes gravados quando o arquivo é criado (lidos na abertura; pode ser NULL).
+void sd_writer_init(sd_writer_t *w, const char *path, const void *header, size_t header_len, uint32_t flush_ms,
+                    uint32_t sync_ms);
+
+// Define a busca do fim lógico para arquivos existentes (antes da abertura).
+void sd_writer_set_end(sd_writer_t *w, sd_writer_end_fn find_end, void *ctx);
+
+// Abre o arquivo, se ainda fechado (após init ou após um erro).
+FRESULT sd_writer_open(sd_writer_t *w);
+
+// Tamanho lógico do arquivo: gravado + pendente no buffer.
+static inline FSIZE_t sd_writer_size(const sd_writer_t *w) {
+    return w->buf_pos + w->len;
+}
+
+// Lê um trecho já descarregado no arquivo (off + len <= buf_pos), sem fechar o escritor.
+FRESULT sd_writer_read(sd_writer_t *w, FSIZE_t off, void *buf, size_t len);
+
+// Acrescenta bytes ao buffer; descarrega ao completar setores e aplica os prazos.
+FRESULT sd_writer_append(sd_writer_t *w, const void *data, size_t len);
+
+// Aplica os prazos de descarga e f_sync sem novos dados.
+FRESULT sd_writer_poll(sd_writer_t *w);
+
+// Descarrega o buffer e, se sync, faz f_sync.
+FRESULT sd_writer_flush(sd_writer_t *w, bool sync);
+
+// Descarrega, sincroniza e fecha o arquivo.
+FRESULT sd_writer_close(sd_writer_t *w);
+
+#endif
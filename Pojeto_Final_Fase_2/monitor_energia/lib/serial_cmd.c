@@ -0,0 +1,166 @@
+/**
+ * @file serial_cmd.c
+ * @brief Console de comandos pela serial USB.
+ * @details
+ *  A task dorme até o stdio avisar que chegaram caracteres
+ *  (`stdio_set_chars_available_callback`, em interrupção) e então os lê sem
+ *  bloquear. Linhas terminam em '\r' ou '\n'; backspace apaga o último
+ *  caractere. Nada é ecoado: o terminal do host costuma ter eco local.
+ */
+
+#include "lib/serial_cmd.h"
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define SERIAL_CMD_IDLE_MS  1000U   /**< Releitura sem aviso (o aviso não é garantido em todo stdio). */
+
+static const serial_cmd_t *s_cmds[SERIAL_CMD_MAX];
+static uint8_t s_cmd_count = 0;
+static TaskHandle_t s_task = NULL;
+
+/**
+ * @brief Registra um comando (antes do scheduler; `cmd` deve ser estático).
+ * @return false se não houver vaga ou o nome já existir.
+ */
+bool serial_cmd_register(const serial_cmd_t *cmd)
+{
+    if (!cmd || !cmd->name || !cmd->fn || s_cmd_count >= SERIAL_CMD_MAX)
+    {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < s_cmd_count; i++)
+    {
+        if (strcmp(s_cmds[i]->name, cmd->name) == 0)
+        {
+            return false;
+        }
+    }
+
+    s_cmds[s_cmd_count++] = cmd;
+    return true;
+}
+
+/**
+ * @brief Aviso do stdio (interrupção): acorda a task.
+ */
+static void chars_available(void *param)
+{
+    (void)param;
+
+    if (s_task)
+    {
+        BaseType_t hp = pdFALSE;
+        vTaskNotifyGiveFromISR(s_task, &hp);
+        portYIELD_FROM_ISR(hp);
+    }
+}
+
+/**
+ * @brief Lista os comandos registrados.
+ */
+static void print_help(void)
+{
+    printf("Comandos:\n  help\n");
+
+    for (uint8_t i = 0; i < s_cmd_count; i++)
+    {
+        printf("  %s %s\n      %s\n", s_cmds[i]->name, s_cmds[i]->args ? s_cmds[i]->args : "",
+               s_cmds[i]->help ? s_cmds[i]->help : "");
+    }
+}
+
+/**
+ * @brief Separa a linha em palavras e executa o comando.
+ * @param line Linha terminada em NUL (alterada no lugar).
+ */
+static void execute(char *line)
+{
+    char *argv[SERIAL_CMD_ARGS_MAX];
+    int argc = 0;
+    char *save = NULL;
+
+    for (char *w = strtok_r(line, " \t", &save); w && argc < (int)SERIAL_CMD_ARGS_MAX;
+         w = strtok_r(NULL, " \t", &save))
+    {
+        argv[argc++] = w;
+    }
+
+    if (argc == 0)
+    {
+        return;
+    }
+
+    if (strcmp(argv[0], "help") == 0)
+    {
+        print_help();
+        return;
+    }
+
+    for (uint8_t i = 0; i < s_cmd_count; i++)
+    {
+        if (strcmp(s_cmds[i]->name, argv[0]) == 0)
+        {
+            s_cmds[i]->fn(argc, argv);
+            return;
+        }
+    }
+
+    printf("Comando desconhecido: %s (digite help)\n", argv[0]);
+}
+
+/**
+ * @brief Task do console: monta linhas a partir do stdio e as executa.
+ * @param params Não utilizado.
+ */
+void serial_cmd_task(void *params)
+{
+    (void)params;
+
+    static char line[SERIAL_CMD_LINE_MAX];
+    size_t len = 0;
+    bool overflow = false;
+
+    s_task = xTaskGetCurrentTaskHandle();
+    stdio_set_chars_available_callback(chars_available, NULL);
+
+    for (;;)
+    {
+        (void)ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SERIAL_CMD_IDLE_MS));
+
+        int c;
+
+        while ((c = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT)
+        {
+            if (c == '\r' || c == '\n')
+            {
+                if (overflow)
+                {
+                    printf("Linha longa demais (máx. %u caracteres).\n", SERIAL_CMD_LINE_MAX - 1U);
+                }
+                else if (len)
+                {
+                    line[len] = '\0';
+                    execute(line);
+                }
+                len = 0;
+                overflow = false;
+            }
+            else if (c == '\b' || c == 0x7F)
+            {
+                len = len ? len - 1U : 0U;
+            }
+            else if (len < sizeof(line) - 1U)
+            {
+                line[len++] = (char)c;
+            }
+            else
+            {
+                overflow = true;
+            }
+        }
+    }
+}
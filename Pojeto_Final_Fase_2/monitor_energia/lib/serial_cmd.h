@@ -0,0 +1,31 @@
+/**
+ * @file serial_cmd.h
+ * @brief Console de comandos pela serial USB (stdio).
+ * @details
+ *  Cada módulo registra seus comandos com `serial_cmd_register` (antes do
+ *  scheduler); a `serial_cmd_task` lê linhas do stdio, separa as palavras e
+ *  chama o comando correspondente. `help` lista os registrados.
+ */
+
+#ifndef SERIAL_CMD_H
+#define SERIAL_CMD_H
+
+#include <stdbool.h>
+
+#define SERIAL_CMD_MAX          16U     /**< Comandos registrados. */
+#define SERIAL_CMD_LINE_MAX     96U     /**< Maior linha aceita (o excesso é descartado). */
+#define SERIAL_CMD_ARGS_MAX     8U      /**< Palavras por linha, incluindo o nome. */
+
+/** @brief Comando do console. */
+typedef struct
+{
+    const char *name;                           /**< Primeira palavra da linha. */
+    const char *args;                           /**< Sinopse dos argumentos (para `help`), ou NULL. */
+    const char *help;                           /**< Descrição de uma linha. */
+    void (*fn)(int argc, char **argv);          /**< argv[0] é o nome; responde com printf. */
+} serial_cmd_t;
+
+bool serial_cmd_register(const serial_cmd_t *cmd);
+void serial_cmd_task(void *params);
+
+#endif /* SERIAL_CMD_H */
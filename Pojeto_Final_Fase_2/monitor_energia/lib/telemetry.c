@@ -0,0 +1,290 @@
+/**
+ * @file telemetry.c
+ * @brief Produção de registros de medição e fan-out para os sinks registrados.
+ * @details
+ *  `telemetry_task` lê a última medição a cada `TELEMETRY_TICK_MS`, marca o
+ *  fechamento de janelas (a cada `TELEMETRY_WINDOW_S` ou quando o Wi‑Fi sobe)
+ *  e chama `telemetry_dispatch()`. O despachante copia o registro para a fila
+ *  de cada sink interessado sem bloquear; cada sink é consumido pela sua
+ *  própria task (`sink_worker`), que chama `publish`/`flush`/`healthy`.
+ */
+
+#include "lib/telemetry.h"
+#include <string.h>
+#include "pico/stdlib.h"
+#include "task.h"
+#include "queue.h"
+#include "lib/energy_monitor.h"
+#include "lib/wifi_manager.h"
+#include "lib/logger.h"
+#include "lib/rtos_stats.h"
+
+#define TAG "telemetry"
+
+#define TELEMETRY_BEGIN_RETRY_MS    5000U   /**< Espera entre tentativas de `begin`. */
+#define TELEMETRY_UNHEALTHY_WAIT_MS 1000U   /**< Espera enquanto o sink não está saudável. */
+
+/** @brief Sink registrado e seu estado de execução. */
+typedef struct
+{
+    const telemetry_sink_t *sink;   /**< Descritor (memória do chamador). */
+    QueueHandle_t queue;            /**< Fila própria do sink. */
+    telemetry_sink_stats_t stats;   /**< Contadores. */
+} sink_slot_t;
+
+static sink_slot_t s_sinks[TELEMETRY_MAX_SINKS];
+static uint8_t s_count = 0;
+static bool s_started = false;
+static volatile uint32_t s_next_window_at = 0;  /**< Próximo fechamento de janela (ms desde o boot). */
+
+/**
+ * @brief Registra um sink (antes de `telemetry_start`).
+ * @param sink Descritor com duração estática.
+ * @return true se registrado.
+ */
+bool telemetry_register_sink(const telemetry_sink_t *sink)
+{
+    if (!sink || s_started || s_count >= TELEMETRY_MAX_SINKS || sink->queue_len == 0)
+    {
+        LOGW(TAG, "Registro de sink recusado (%s).", (sink && sink->name) ? sink->name : "?");
+        return false;
+    }
+
+    s_sinks[s_count].sink = sink;
+    s_count++;
+    return true;
+}
+
+/**
+ * @brief Task de um sink: `begin`, depois consome a fila enquanto saudável.
+ * @param params Ponteiro para o `sink_slot_t`.
+ */
+static void sink_worker(void *params)
+{
+    sink_slot_t *slot = (sink_slot_t *)params;
+    const telemetry_sink_t *k = slot->sink;
+
+    while (k->begin && !k->begin(k->ctx))
+    {
+        LOGW(TAG, "[%s] begin falhou; nova tentativa em %u ms.", k->name,
+             (unsigned)TELEMETRY_BEGIN_RETRY_MS);
+        vTaskDelay(pdMS_TO_TICKS(TELEMETRY_BEGIN_RETRY_MS));
+    }
+
+    const TickType_t idle = k->idle_flush_ms ? pdMS_TO_TICKS(k->idle_flush_ms) : portMAX_DELAY;
+
+    for (;;)
+    {
+        const bool ok = k->healthy ? k->healthy(k->ctx) : true;
+        slot->stats.healthy = ok;
+
+        if (!ok)
+        {
+            /* Não consome: a fila segura os mais recentes e descarta os antigos. */
+            vTaskDelay(pdMS_TO_TICKS(TELEMETRY_UNHEALTHY_WAIT_MS));
+            continue;
+        }
+
+        telemetry_record_t rec;
+
+        if (xQueueReceive(slot->queue, &rec, idle) == pdTRUE)
+        {
+            if (!k->publish || k->publish(k->ctx, &rec))
+            {
+                slot->stats.delivered++;
+            }
+            else
+            {
+                slot->stats.failed++;
+            }
+        }
+        else if (k->flush)
+        {
+            (void)k->flush(k->ctx);
+        }
+    }
+}
+
+/**
+ * @brief Cria as filas e as tasks dos sinks registrados.
+ * @return true se todos os sinks foram iniciados.
+ */
+bool telemetry_start(void)
+{
+    bool ok = true;
+
+    for (uint8_t i = 0; i < s_count; i++)
+    {
+        sink_slot_t *slot = &s_sinks[i];
+        const telemetry_sink_t *k = slot->sink;
+
+        slot->queue = xQueueCreate(k->queue_len, sizeof(telemetry_record_t));
+
+        if (!slot->queue)
+        {
+            LOGE(TAG, "Falha ao criar fila do sink %s.", k->name);
+            ok = false;
+            continue;
+        }
+
+        rtos_stats_watch_queue(slot->queue, k->name);
+
+        if (rtos_stats_create_task(sink_worker, k->name, k->stack_words, slot, k->priority, NULL) != pdPASS)
+        {
+            LOGE(TAG, "Falha ao criar task do sink %s.", k->name);
+            vQueueDelete(slot->queue);
+            slot->queue = NULL;
+            ok = false;
+        }
+    }
+
+    s_started = true;
+    LOG(TAG, "%u sink(s) iniciados.", (unsigned)s_count);
+    return ok;
+}
+
+/**
+ * @brief Entrega um registro a todos os sinks interessados (não bloqueia).
+ * @param rec Registro a copiar.
+ * @note Com a fila de um sink cheia, o registro mais antigo dele é descartado.
+ */
+void telemetry_dispatch(const telemetry_record_t *rec)
+{
+    if (!rec)
+    {
+        return;
+    }
+
+    for (uint8_t i = 0; i < s_count; i++)
+    {
+        sink_slot_t *slot = &s_sinks[i];
+
+        if (!slot->queue)
+        {
+            continue;
+        }
+
+        if (slot->sink->accept && !(rec->flags & slot->sink->accept))
+        {
+            continue;
+        }
+
+        if (xQueueSend(slot->queue, rec, 0) != pdTRUE)
+        {
+            telemetry_record_t oldest;
+            (void)xQueueReceive(slot->queue, &oldest, 0);
+            (void)xQueueSend(slot->queue, rec, 0);
+            slot->stats.dropped++;
+        }
+
+        const uint8_t queued = (uint8_t)uxQueueMessagesWaiting(slot->queue);
+        slot->stats.queued_max = (queued > slot->stats.queued_max) ? queued : slot->stats.queued_max;
+    }
+}
+
+/**
+ * @brief Quantidade de sinks registrados.
+ */
+uint8_t telemetry_sink_count(void)
+{
+    return s_count;
+}
+
+/**
+ * @brief Nome do sink de índice `idx` (ou NULL).
+ */
+const char *telemetry_sink_name(uint8_t idx)
+{
+    return (idx < s_count) ? s_sinks[idx].sink->name : NULL;
+}
+
+/**
+ * @brief Copia os contadores do sink de índice `idx`.
+ * @return false se o índice for inválido.
+ */
+bool telemetry_get_sink_stats(uint8_t idx, telemetry_sink_stats_t *out)
+{
+    if (idx >= s_count || !out)
+    {
+        return false;
+    }
+
+    *out = s_sinks[idx].stats;
+    out->queued = s_sinks[idx].queue ? (uint8_t)uxQueueMessagesWaiting(s_sinks[idx].queue) : 0U;
+    return true;
+}
+
+/**
+ * @brief Tempo até o próximo fechamento de janela (para quem agenda envios).
+ * @return Milissegundos (0 se já vencido).
+ */
+uint32_t telemetry_next_window_ms(void)
+{
+    const int32_t left = (int32_t)(s_next_window_at - to_ms_since_boot(get_absolute_time()));
+    return (left > 0) ? (uint32_t)left : 0U;
+}
+
+/**
+ * @brief Task produtora: um registro por tick, com marcação de janelas.
+ * @param params Não utilizado.
+ * @details
+ *  A janela fecha a cada `TELEMETRY_WINDOW_S` e também no primeiro tick
+ *  após o Wi‑Fi subir (envio imediato, como no comportamento original).
+ */
+void telemetry_task(void *params)
+{
+    (void)params;
+
+    const TickType_t tick = pdMS_TO_TICKS(TELEMETRY_TICK_MS);
+    TickType_t last_wake = xTaskGetTickCount();
+
+    uint32_t seq = 0;
+    uint32_t acc_ms = 0;
+    bool was_up = false;
+
+    LOG(TAG, "Task iniciada: registro a cada %u ms, janela de %u s.",
+        (unsigned)TELEMETRY_TICK_MS, (unsigned)TELEMETRY_WINDOW_S);
+
+    for (;;)
+    {
+        vTaskDelayUntil(&last_wake, tick);
+
+        telemetry_record_t rec;
+        memset(&rec, 0, sizeof(rec));
+
+        energy_monitor_data_t em;
+        rec.valid = energy_monitor_get_last(&em);
+
+        if (rec.valid)
+        {
+            rec.vrms = (float)em.vrms;
+            rec.irms = (float)em.irms;
+            rec.v_pu = (float)em.v_pu;
+            rec.p_w = (float)em.p_instant;
+            rec.e_total_wh = em.e_wh;
+            rec.t_ms = (uint32_t)(em.t_boot_us / 1000U);
+            rec.t_unix_us = em.t_unix_us;
+        }
+
+        rec.seq = seq++;
+        rec.uptime_s = (uint32_t)(time_us_64() / 1000000U);
+
+        const bool up = wifi_manager_is_connected();
+        acc_ms += TELEMETRY_TICK_MS;
+
+        if (up && !was_up)
+        {
+            rec.flags |= TELEMETRY_FLAG_LINK_UP | TELEMETRY_FLAG_WINDOW;
+            acc_ms = 0;
+        }
+        else if (acc_ms >= TELEMETRY_WINDOW_S * 1000U)
+        {
+            rec.flags |= TELEMETRY_FLAG_WINDOW;
+            acc_ms = 0;
+        }
+
+        was_up = up;
+        s_next_window_at = to_ms_since_boot(get_absolute_time()) + TELEMETRY_WINDOW_S * 1000U - acc_ms;
+        telemetry_dispatch(&rec);
+    }
+}
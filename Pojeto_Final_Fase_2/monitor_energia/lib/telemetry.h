@@ -0,0 +1,77 @@
+/**
+ * @file telemetry.h
+ * @brief Registro de medição, interface de sinks e despachante de telemetria.
+ * @details
+ *  `telemetry_task` produz um registro por segundo e o despachante o entrega
+ *  a cada sink registrado (ThingSpeak, MQTT, SD, ...). Cada sink tem fila
+ *  própria e task própria, de modo que um destino lento só atrasa a si mesmo:
+ *  com a fila cheia, o registro mais antigo daquele sink é descartado.
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "lib/telemetry_codec.h"
+
+#define TELEMETRY_TICK_MS           1000U   /**< Período de produção de registros (ms). */
+#define TELEMETRY_WINDOW_S          60U     /**< Duração da janela de envio (s). */
+#define TELEMETRY_MAX_SINKS         6U      /**< Máximo de sinks registrados. */
+
+/** @name Flags de `telemetry_record_t::flags` */
+//@{
+#define TELEMETRY_FLAG_WINDOW       (1U << 0)   /**< Fecha uma janela de envio. */
+#define TELEMETRY_FLAG_LINK_UP      (1U << 1)   /**< Primeiro registro após o Wi‑Fi subir. */
+//@}
+
+/** @name Seleção de registros por sink (`telemetry_sink_t::accept`) */
+//@{
+#define TELEMETRY_ACCEPT_ALL        0U                      /**< Todos os registros (1 Hz). */
+#define TELEMETRY_ACCEPT_WINDOW     TELEMETRY_FLAG_WINDOW   /**< Só fechamentos de janela. */
+//@}
+
+/**
+ * @brief Operações de um destino de telemetria.
+ * @details
+ *  Todas as operações rodam na task do próprio sink. Qualquer ponteiro pode
+ *  ser NULL (operação opcional). `healthy` falso suspende o consumo da fila
+ *  (os registros aguardam, limitados ao tamanho da fila).
+ */
+typedef struct
+{
+    const char *name;                                           /**< Nome (também da task). */
+    bool (*begin)(void *ctx);                                   /**< Inicialização (repetida até sucesso). */
+    bool (*publish)(void *ctx, const telemetry_record_t *rec);  /**< Entrega um registro. */
+    bool (*flush)(void *ctx);                                   /**< Chamado em ociosidade. */
+    bool (*healthy)(void *ctx);                                 /**< Destino pronto para receber. */
+    void *ctx;                                                  /**< Contexto repassado às operações. */
+    uint8_t accept;                                             /**< `TELEMETRY_ACCEPT_*`. */
+    uint8_t queue_len;                                          /**< Profundidade da fila própria. */
+    uint16_t stack_words;                                       /**< Stack da task do sink. */
+    UBaseType_t priority;                                       /**< Prioridade da task do sink. */
+    uint32_t idle_flush_ms;                                     /**< Ociosidade até chamar `flush`. */
+} telemetry_sink_t;
+
+/** @brief Contadores por sink. */
+typedef struct
+{
+    uint32_t delivered;     /**< `publish` com sucesso. */
+    uint32_t failed;        /**< `publish` com falha. */
+    uint32_t dropped;       /**< Descartados por fila cheia. */
+    uint8_t queued;         /**< Registros na fila agora. */
+    uint8_t queued_max;     /**< Maior ocupação da fila (após cada envio). */
+    bool healthy;           /**< Último resultado de `healthy`. */
+} telemetry_sink_stats_t;
+
+bool telemetry_register_sink(const telemetry_sink_t *sink);
+bool telemetry_start(void);
+void telemetry_dispatch(const telemetry_record_t *rec);
+uint8_t telemetry_sink_count(void);
+const char *telemetry_sink_name(uint8_t idx);
+bool telemetry_get_sink_stats(uint8_t idx, telemetry_sink_stats_t *out);
+uint32_t telemetry_next_window_ms(void);
+void telemetry_task(void *params);
+
+#endif /* TELEMETRY_H */
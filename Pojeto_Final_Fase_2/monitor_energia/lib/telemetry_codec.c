@@ -0,0 +1,180 @@
+/**
+ * @file telemetry_codec.c
+ * @brief Codificação/decodificação binária dos registros de medição.
+ * @details
+ *  Cada campo é escrito byte a byte em little-endian; `float`/`double` são
+ *  copiados como padrão de bits IEEE‑754 (sem conversão para texto nem para
+ *  inteiro), o que no Cortex‑M0+ custa só alguns loads/stores por campo.
+ */
+
+#include "lib/telemetry_codec.h"
+#include <string.h>
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static void put_f32(uint8_t *p, float v)
+{
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    put_u32(p, bits);
+}
+
+static void put_u64(uint8_t *p, uint64_t v)
+{
+    put_u32(p, (uint32_t)v);
+    put_u32(p + 4, (uint32_t)(v >> 32));
+}
+
+static void put_f64(uint8_t *p, double v)
+{
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    put_u64(p, bits);
+}
+
+static uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | ((uint16_t)p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static float get_f32(const uint8_t *p)
+{
+    const uint32_t bits = get_u32(p);
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+static uint64_t get_u64(const uint8_t *p)
+{
+    return (uint64_t)get_u32(p) | ((uint64_t)get_u32(p + 4) << 32);
+}
+
+static double get_f64(const uint8_t *p)
+{
+    const uint64_t bits = get_u64(p);
+    double v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+/**
+ * @brief Inicia um payload em `buf`.
+ * @return false se `buf` não comporta nem o cabeçalho.
+ */
+bool telemetry_codec_begin(telemetry_codec_writer_t *w, uint8_t *buf, size_t size)
+{
+    if (!w || !buf || size < TELEMETRY_CODEC_HDR_SIZE)
+    {
+        return false;
+    }
+
+    w->buf = buf;
+    w->size = size;
+    w->len = TELEMETRY_CODEC_HDR_SIZE;
+    w->count = 0;
+    return true;
+}
+
+/**
+ * @brief Acrescenta um registro ao payload.
+ * @return false se não houver espaço (o payload continua válido sem ele).
+ */
+bool telemetry_codec_add(telemetry_codec_writer_t *w, const telemetry_record_t *rec)
+{
+    if (w->len + TELEMETRY_CODEC_REC_SIZE > w->size || w->count == UINT16_MAX)
+    {
+        return false;
+    }
+
+    uint8_t *p = &w->buf[w->len];
+    put_u32(&p[0], rec->seq);
+    put_u32(&p[4], rec->uptime_s);
+    put_u32(&p[8], rec->t_ms);
+    put_f32(&p[12], rec->vrms);
+    put_f32(&p[16], rec->irms);
+    put_f32(&p[20], rec->v_pu);
+    put_f32(&p[24], rec->p_w);
+    put_f64(&p[28], rec->e_total_wh);
+    p[36] = (uint8_t)((rec->flags & (uint8_t)~TELEMETRY_CODEC_VALID_BIT) |
+                      (rec->valid ? TELEMETRY_CODEC_VALID_BIT : 0U));
+    put_u64(&p[37], (uint64_t)rec->t_unix_us);
+
+    w->len += TELEMETRY_CODEC_REC_SIZE;
+    w->count++;
+    return true;
+}
+
+/**
+ * @brief Escreve o cabeçalho e devolve o tamanho final do payload.
+ */
+size_t telemetry_codec_finish(telemetry_codec_writer_t *w)
+{
+    w->buf[0] = (uint8_t)TELEMETRY_CODEC_MAGIC0;
+    w->buf[1] = (uint8_t)TELEMETRY_CODEC_MAGIC1;
+    w->buf[2] = TELEMETRY_CODEC_VERSION;
+    w->buf[3] = 0;
+    put_u16(&w->buf[4], w->count);
+    put_u16(&w->buf[6], TELEMETRY_CODEC_REC_SIZE);
+    return w->len;
+}
+
+/**
+ * @brief Valida um payload recebido.
+ * @return false se magic, tamanho de registro ou comprimento não conferem.
+ * @note Aceita a v1 (sem `t_unix_us`) e versões mais novas com ao menos os campos da v1.
+ */
+bool telemetry_codec_open(telemetry_codec_reader_t *r, const uint8_t *buf, size_t len)
+{
+    if (!r || !buf || len < TELEMETRY_CODEC_HDR_SIZE ||
+        buf[0] != (uint8_t)TELEMETRY_CODEC_MAGIC0 || buf[1] != (uint8_t)TELEMETRY_CODEC_MAGIC1 ||
+        buf[2] < 1U)
+    {
+        return false;
+    }
+
+    r->buf = buf;
+    r->version = buf[2];
+    r->count = get_u16(&buf[4]);
+    r->rec_size = get_u16(&buf[6]);
+
+    return r->rec_size >= TELEMETRY_CODEC_REC_SIZE_V1 &&
+           len >= TELEMETRY_CODEC_HDR_SIZE + (size_t)r->count * r->rec_size;
+}
+
+/**
+ * @brief Lê o registro `idx` (`idx < r->count`) de um payload validado.
+ */
+void telemetry_codec_get(const telemetry_codec_reader_t *r, uint16_t idx, telemetry_record_t *out)
+{
+    const uint8_t *p = &r->buf[TELEMETRY_CODEC_HDR_SIZE + (size_t)idx * r->rec_size];
+
+    out->seq = get_u32(&p[0]);
+    out->uptime_s = get_u32(&p[4]);
+    out->t_ms = get_u32(&p[8]);
+    out->vrms = get_f32(&p[12]);
+    out->irms = get_f32(&p[16]);
+    out->v_pu = get_f32(&p[20]);
+    out->p_w = get_f32(&p[24]);
+    out->e_total_wh = get_f64(&p[28]);
+    out->flags = (uint8_t)(p[36] & (uint8_t)~TELEMETRY_CODEC_VALID_BIT);
+    out->valid = (p[36] & TELEMETRY_CODEC_VALID_BIT) != 0U;
+    out->t_unix_us = (r->rec_size >= TELEMETRY_CODEC_REC_SIZE_V2) ? (int64_t)get_u64(&p[37]) : 0;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file telemetry_codec.h
+ * @brief Registro de medição e sua codificação binária (little-endian, versionada).
+ * @details
+ *  Usado pelo firmware (sink UDP de registros) e pelas ferramentas de host;
+ *  não depende do SDK. Um payload agrupa vários registros:
+ *
+ *  | off | tam | campo                                          |
+ *  |-----|-----|------------------------------------------------|
+ *  |  0  |  2  | magic "ER"                                     |
+ *  |  2  |  1  | versão (`TELEMETRY_CODEC_VERSION`)             |
+ *  |  3  |  1  | reservado (0)                                  |
+ *  |  4  |  2  | count: registros no payload                    |
+ *  |  6  |  2  | tamanho de cada registro (bytes)               |
+ *
+ *  Registro (`TELEMETRY_CODEC_REC_SIZE` bytes): seq, uptime_s, t_ms (u32);
+ *  vrms, irms, v_pu, p_w (IEEE‑754 f32); e_total_wh (f64); flags (u8, bit 7
+ *  = `valid`). A v2 acrescenta t_unix_us (i64, µs desde 1970, 0 = desconhecido).
+ *  Versões futuras só acrescentam campos ao fim do registro: o decodificador
+ *  usa o tamanho do cabeçalho para saltar o que não conhece.
+ */
+
+#ifndef TELEMETRY_CODEC_H
+#define TELEMETRY_CODEC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TELEMETRY_CODEC_MAGIC0      'E'     /**< Primeiro byte do magic. */
+#define TELEMETRY_CODEC_MAGIC1      'R'     /**< Segundo byte do magic. */
+#define TELEMETRY_CODEC_VERSION     2U      /**< Versão do formato. */
+#define TELEMETRY_CODEC_HDR_SIZE    8U      /**< Bytes do cabeçalho do payload. */
+#define TELEMETRY_CODEC_REC_SIZE_V1 37U     /**< Bytes por registro da versão 1 (mínimo aceito). */
+#define TELEMETRY_CODEC_REC_SIZE_V2 45U     /**< Bytes por registro da versão 2 (com t_unix_us). */
+#define TELEMETRY_CODEC_REC_SIZE    TELEMETRY_CODEC_REC_SIZE_V2 /**< Bytes por registro (versão atual). */
+#define TELEMETRY_CODEC_VALID_BIT   0x80U   /**< Bit de `valid` no byte de flags. */
+
+/** @brief Registro de medição entregue aos sinks. */
+typedef struct
+{
+    uint32_t seq;           /**< Número de sequência (incrementa a cada registro). */
+    uint32_t uptime_s;      /**< Segundos desde o boot. */
+    uint32_t t_ms;          /**< Instante da última amostra (ms desde o boot; volta a zero em ~49 dias). */
+    float vrms;             /**< Tensão RMS [V]. */
+    float irms;             /**< Corrente RMS [A]. */
+    float v_pu;             /**< Tensão em PU. */
+    float p_w;              /**< Potência [W]. */
+    double e_total_wh;      /**< Energia desde o boot [Wh] (sinks calculam o delta desde o último envio). */
+    uint8_t flags;          /**< `TELEMETRY_FLAG_*`. */
+    bool valid;             /**< Há medição (energy_monitor já publicou). */
+    int64_t t_unix_us;      /**< Instante da última amostra em tempo Unix (µs; v2). */
+} telemetry_record_t;
+
+/** @brief Montagem de um payload com vários registros. */
+typedef struct
+{
+    uint8_t *buf;       /**< Destino. */
+    size_t size;        /**< Capacidade de `buf`. */
+    size_t len;         /**< Bytes escritos (cabeçalho incluso). */
+    uint16_t count;     /**< Registros no payload. */
+} telemetry_codec_writer_t;
+
+/** @brief Payload validado, pronto para leitura por índice. */
+typedef struct
+{
+    const uint8_t *buf; /**< Payload. */
+    uint8_t version;    /**< Versão declarada. */
+    uint16_t count;     /**< Registros no payload. */
+    uint16_t rec_size;  /**< Tamanho declarado de cada registro. */
+} telemetry_codec_reader_t;
+
+/** @brief Bytes de um payload com `n` registros. */
+static inline size_t telemetry_codec_payload_size(uint16_t n)
+{
+    return TELEMETRY_CODEC_HDR_SIZE + (size_t)n * TELEMETRY_CODEC_REC_SIZE;
+}
+
+bool telemetry_codec_begin(telemetry_codec_writer_t *w, uint8_t *buf, size_t size);
+bool telemetry_codec_add(telemetry_codec_writer_t *w, const telemetry_record_t *rec);
+size_t telemetry_codec_finish(telemetry_codec_writer_t *w);
+bool telemetry_codec_open(telemetry_codec_reader_t *r, const uint8_t *buf, size_t len);
+void telemetry_codec_get(const telemetry_codec_reader_t *r, uint16_t idx, telemetry_record_t *out);
+
+#endif /* TELEMETRY_CODEC_H */
@@ -2,26 +2,26 @@
  * @file thingspeak.c
  * @brief Envio de leituras ao ThingSpeak usando TCP bruto (lwIP).
  * @details
- *  Oferece `thingspeak_send()` para montar uma requisição HTTP GET e
- *  `thingspeak_task()` que acumula energia e envia periodicamente.
+ *  Oferece `thingspeak_send()` para montar uma requisição HTTP GET e o sink
+ *  `thingspeak_sink`, que recebe do despachante de telemetria os registros
+ *  de fechamento de janela e os envia ao canal.
  */
 
 #include "lib/thingspeak.h"
 #include <stdarg.h>
 #include <string.h>
-#include <math.h>
 #include "pico/time.h"
 #include "lwip/ip_addr.h"
 #include "lwip/tcp.h"
 #include "FreeRTOS.h"
 #include "semphr.h"
 #include "utils.h"
-#include "lib/energy_monitor.h"
 #include "lib/wifi_manager.h"
 #include "credentials.h"
 #include "lib/logger.h"
+#include "lib/fmt.h"
+#include "lib/rtos_trace.h"
 
-#define THINGSPEAK_HOST             "api.thingspeak.com"    /**< Host do ThingSpeak. */
 #define THINGSPEAK_PORT             80                      /**< Porta HTTP. */
 #define THINGSPEAK_TCP_TIMEOUT_MS   7000U                   /**< Timeout de resposta TCP (ms). */
 
@@ -35,26 +35,6 @@ typedef struct
     int finished;
 } ts_http_ctx_t;
 
-/**
- * @brief Retorna o uptime do sistema em segundos.
- * @return Segundos desde o boot.
- */
-static inline uint32_t uptime_s(void)
-{
-    return (uint32_t)(to_ms_since_boot(get_absolute_time()) / 1000u);
-}
-
-/**
- * @brief Zera acumuladores de energia/tempo de 10 min.
- * @param e10_wh Ponteiro para energia acumulada (Wh).
- * @param acc_s Ponteiro para acumulador de tempo (s).
- */
-static inline void reset_e10_wh_acc_s(double *e10_wh, uint32_t *acc_s)
-{
-    *e10_wh = 0.0;
-    *acc_s = 0u;
-}
-
 /**
  * @brief Callback de recepção TCP (HTTP/1.1 Connection: close).
  */
@@ -131,58 +111,58 @@ static err_t thingspeak_tcp_connected(void *arg, struct tcp_pcb *tpcb, err_t err
  * @param api_key Chave de escrita do canal.
  * @param num_fields Quantidade de campos (1..8).
  * @param ... Lista de valores `double` (field1..fieldN).
- * @note NaN/Inf são convertidos para 0.0.
+ * @return true se a requisição foi enviada e a conexão encerrada pelo servidor.
+ * @note NaN/Inf são convertidos para 0.0; a formatação usa `fmt_double` (sem printf).
  */
-void thingspeak_send(const char *api_key, uint8_t num_fields, ...)
+bool thingspeak_send(const char *api_key, uint8_t num_fields, ...)
 {
     if (!api_key || num_fields <= 0 || num_fields > 8)
     {
-        LOG("ThingSpeak", "Parâmetros inválidos (api_key/num_fields)");
-        return;
+        LOGW("ThingSpeak", "Parâmetros inválidos (api_key/num_fields)");
+        return false;
     }
 
-    char qs[256];
-    size_t pos = 0;
-    pos += (size_t)snprintf(qs + pos, sizeof(qs) - pos, "api_key=%s", api_key);
+    char req[512];
+    fmt_buf_t b;
+    fmt_buf_init(&b, req, sizeof(req));
+    fmt_buf_str(&b, "GET /update?api_key=");
+    fmt_buf_str(&b, api_key);
 
     va_list ap;
     va_start(ap, num_fields);
 
-    for (int i = 1; i <= num_fields && pos < sizeof(qs); i++)
+    for (int i = 1; i <= num_fields; i++)
     {
         double val = va_arg(ap, double);
 
-        if (isnan(val) || isinf(val))
-        {
-            val = 0.0;
-        }
-
-        pos += (size_t)snprintf(qs + pos, sizeof(qs) - pos, "&field%d=%.6f", i, val);
+        fmt_buf_str(&b, "&field");
+        fmt_buf_u32(&b, (uint32_t)i);
+        fmt_buf_char(&b, '=');
+        fmt_buf_double(&b, val, 6);
     }
 
     va_end(ap);
 
-    char req[512];
-    int nreq = snprintf(req, sizeof(req),
-                        "GET /update?%s HTTP/1.1\r\n"
-                        "Host: %s\r\n"
-                        "User-Agent: pico-w/rawtcp\r\n"
-                        "Connection: close\r\n"
-                        "\r\n",
-                        qs, THINGSPEAK_HOST);
-
-    if (nreq <= 0 || nreq >= (int)sizeof(req))
+    fmt_buf_str(&b, " HTTP/1.1\r\n"
+                    "Host: " THINGSPEAK_HOST "\r\n"
+                    "User-Agent: pico-w/rawtcp\r\n"
+                    "Connection: close\r\n"
+                    "\r\n");
+
+    if (b.overflow)
     {
-        LOG("ThingSpeak", "Requisição muito grande");
-        return;
+        LOGW("ThingSpeak", "Requisição muito grande");
+        return false;
     }
 
+    const size_t nreq = b.len;
+
     ip_addr_t ip;
 
     if (!utils_resolve_dns(THINGSPEAK_HOST, &ip, 5000))
     {
-        LOG("ThingSpeak", "DNS falhou para %s", THINGSPEAK_HOST);
-        return;
+        LOGW("ThingSpeak", "DNS falhou para %s", THINGSPEAK_HOST);
+        return false;
     }
 
     ts_http_ctx_t ctx = {0};
@@ -190,17 +170,17 @@ void thingspeak_send(const char *api_key, uint8_t num_fields, ...)
 
     if (!ctx.pcb)
     {
-        LOG("ThingSpeak", "tcp_new falhou");
-        return;
+        LOGW("ThingSpeak", "tcp_new falhou");
+        return false;
     }
 
     ctx.sem_done = xSemaphoreCreateBinary();
 
     if (!ctx.sem_done)
     {
-        LOG("ThingSpeak", "semáforo falhou");
+        LOGW("ThingSpeak", "semáforo falhou");
         tcp_abort(ctx.pcb);
-        return;
+        return false;
     }
 
     tcp_arg(ctx.pcb, &ctx);
@@ -212,10 +192,10 @@ void thingspeak_send(const char *api_key, uint8_t num_fields, ...)
 
     if (err != ERR_OK)
     {
-        LOG("ThingSpeak", "tcp_connect err=%d", (int)err);
+        LOGW("ThingSpeak", "tcp_connect err=%d", (int)err);
         vSemaphoreDelete(ctx.sem_done);
         tcp_abort(ctx.pcb);
-        return;
+        return false;
     }
 
     vTaskDelay(pdMS_TO_TICKS(30));
@@ -231,16 +211,16 @@ void thingspeak_send(const char *api_key, uint8_t num_fields, ...)
         }
         else
         {
-            LOG("ThingSpeak", "tcp_write err=%d", (int)err);
+            LOGW("ThingSpeak", "tcp_write err=%d", (int)err);
             tcp_abort(ctx.pcb);
             vSemaphoreDelete(ctx.sem_done);
-            return;
+            return false;
         }
     }
 
     if (xSemaphoreTake(ctx.sem_done, pdMS_TO_TICKS(THINGSPEAK_TCP_TIMEOUT_MS)) != pdTRUE)
     {
-        LOG("ThingSpeak", "timeout aguardando resposta");
+        LOGW("ThingSpeak", "timeout aguardando resposta");
 
         if (ctx.pcb)
         {
@@ -248,7 +228,7 @@ void thingspeak_send(const char *api_key, uint8_t num_fields, ...)
         }
 
         vSemaphoreDelete(ctx.sem_done);
-        return;
+        return false;
     }
 
     if (ctx.pcb)
@@ -262,85 +242,99 @@ void thingspeak_send(const char *api_key, uint8_t num_fields, ...)
 
     vSemaphoreDelete(ctx.sem_done);
 
-    LOG("ThingSpeak", "Enviado para %s (%d bytes)", THINGSPEAK_HOST, nreq);
+    LOGD("ThingSpeak", "Enviado para %s (%u bytes)", THINGSPEAK_HOST, (unsigned)nreq);
+    return true;
 }
 
-/**
- * @brief Task que acumula energia e envia leituras ao ThingSpeak.
- * @param params Não utilizado.
- * @details
- *  Envia imediatamente após o Wi-Fi ficar UP, depois a cada
- *  `THINGSPEAK_SEND_PERIOD_S` enquanto conectado.
- */
-void thingspeak_task(void *params)
+/** @brief Estado do sink ThingSpeak. */
+typedef struct
 {
-    (void)params;
-
-    const TickType_t tick_period = pdMS_TO_TICKS(THINGSPEAK_TICK_S * 1000u);
-    TickType_t last_wake = xTaskGetTickCount();
+    TickType_t last_send;   /**< Tick do último envio (intervalo mínimo). */
+    double e_sent_wh;       /**< `e_total_wh` no último envio bem-sucedido. */
+    bool sent_once;         /**< Houve ao menos um envio. */
+    int8_t tx_client;       /**< Cliente de envio no gerenciador Wi‑Fi. */
+    uint16_t trace_span;    /**< Trecho "thingspeak" no trace. */
+} ts_sink_ctx_t;
 
-    uint64_t last_ms = to_ms_since_boot(get_absolute_time());
-    double e10_wh = 0.0;
-    uint32_t acc_s = 0u;
-    bool was_up = false;
-    bool first_send_done = false;
+static ts_sink_ctx_t s_ts_sink;
 
-    energy_monitor_data_t em = {0};
-    bool have_em = false;
+/**
+ * @brief O sink só consome registros com o Wi‑Fi conectado.
+ */
+static bool ts_sink_healthy(void *ctx)
+{
+    (void)ctx;
+    return wifi_manager_is_connected();
+}
 
-    LOG("ThingSpeak", "Task iniciada: envia no UP e depois a cada %u s.",
-        (unsigned)THINGSPEAK_SEND_PERIOD_S);
+/**
+ * @brief Envia uma janela ao ThingSpeak.
+ * @details
+ *  A energia enviada é o delta de `e_total_wh` desde o último envio bem
+ *  sucedido, de modo que janelas perdidas (rede fora) não perdem energia.
+ *  Respeita o intervalo mínimo de atualização do canal. O rádio é mantido
+ *  acordado durante o envio e o próximo fechamento de janela é declarado.
+ */
+static bool ts_sink_publish(void *ctx, const telemetry_record_t *rec)
+{
+    ts_sink_ctx_t *s = (ts_sink_ctx_t *)ctx;
 
-    for (;;)
+    if (s->sent_once)
     {
-        vTaskDelayUntil(&last_wake, tick_period);
-
-        uint64_t now_ms = to_ms_since_boot(get_absolute_time());
-        uint32_t dt_ms = (uint32_t)(now_ms - last_ms);
-        last_ms = now_ms;
-
-        have_em = energy_monitor_get_last(&em);
+        const TickType_t min_gap = pdMS_TO_TICKS(THINGSPEAK_MIN_INTERVAL_S * 1000U);
+        const TickType_t elapsed = xTaskGetTickCount() - s->last_send;
 
-        if (have_em)
+        if (elapsed < min_gap)
         {
-            double dt_s = (double)dt_ms / 1000.0;
-            e10_wh += (em.p_instant * dt_s) / 3600.0;
+            vTaskDelay(min_gap - elapsed);
         }
+    }
 
-        acc_s += (dt_ms / 1000u);
-
-        bool up = wifi_manager_is_connected();
-        bool just_up = (up && !was_up);
-
-        if (just_up)
-        {
-            (void)utils_resolve_dns(THINGSPEAK_HOST, NULL, 5000);
-
-            float v = have_em ? (float)em.vrms : 0.0f;
-            float i = have_em ? (float)em.irms : 0.0f;
-            float p = have_em ? (float)em.p_instant : 0.0f;
-            float e = (float)e10_wh;
-            float upsecs = (float)uptime_s();
-
-            thingspeak_send(API_KEY, 5, v, i, p, e, upsecs);
-
-            reset_e10_wh_acc_s(&e10_wh, &acc_s);
-            first_send_done = true;
-        }
+    const double e_wh = rec->e_total_wh - s->e_sent_wh;
+    s->last_send = xTaskGetTickCount();
+    s->sent_once = true;
 
-        was_up = up;
+    wifi_manager_tx_schedule(s->tx_client, WIFI_TX_NOW);
+    RTOS_TRACE_SPAN_BEGIN(s->trace_span);
+    const bool ok = thingspeak_send(API_KEY, 5, (double)rec->vrms, (double)rec->irms, (double)rec->p_w,
+                                    e_wh, (double)rec->uptime_s);
+    RTOS_TRACE_SPAN_END(s->trace_span);
+    wifi_manager_tx_schedule(s->tx_client, telemetry_next_window_ms());
 
-        if (up && first_send_done && acc_s >= THINGSPEAK_SEND_PERIOD_S)
-        {
-            float v = have_em ? (float)em.vrms : 0.0f;
-            float i = have_em ? (float)em.irms : 0.0f;
-            float p = have_em ? (float)em.p_instant : 0.0f;
-            float e = (float)e10_wh;
-            float upsecs = (float)uptime_s();
+    if (!ok)
+    {
+        return false;
+    }
 
-            thingspeak_send(API_KEY, 5, v, i, p, e, upsecs);
+    s->e_sent_wh = rec->e_total_wh;
+    return true;
+}
 
-            reset_e10_wh_acc_s(&e10_wh, &acc_s);
-        }
+/**
+ * @brief Registra o sink como cliente de envio do Wi‑Fi (economia de rádio).
+ */
+static bool ts_sink_begin(void *ctx)
+{
+    ts_sink_ctx_t *s = (ts_sink_ctx_t *)ctx;
+    s->tx_client = wifi_manager_tx_register("thingspeak");
+    if (s->trace_span == 0U)
+    {
+        s->trace_span = rtos_trace_span("thingspeak");
     }
+    wifi_manager_tx_schedule(s->tx_client, telemetry_next_window_ms());
+    return true;
 }
+
+const telemetry_sink_t thingspeak_sink = {
+    .name = "ThingSpeakSink",
+    .begin = ts_sink_begin,
+    .publish = ts_sink_publish,
+    .flush = NULL,
+    .healthy = ts_sink_healthy,
+    .ctx = &s_ts_sink,
+    .accept = TELEMETRY_ACCEPT_WINDOW,
+    .queue_len = THINGSPEAK_SINK_QUEUE_LEN,
+    .stack_words = 3072,
+    .priority = tskIDLE_PRIORITY + 1,
+    .idle_flush_ms = 0,
+};
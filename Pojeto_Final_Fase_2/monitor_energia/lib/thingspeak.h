@@ -1,18 +1,21 @@
 /**
  * @file thingspeak.h
- * @brief API para envio de dados ao ThingSpeak e task de telemetria.
+ * @brief API para envio de dados ao ThingSpeak e sink de telemetria.
  */
 
 #ifndef THINGSPEAK_H
 #define THINGSPEAK_H
 
+#include <stdbool.h>
 #include <stdint.h>
+#include "lib/telemetry.h"
 
-#define THINGSPEAK_SEND_PERIOD_S    60U                     /**< Período de envio recorrente (s). */
-#define THINGSPEAK_TICK_S           1U                      /**< Tick da task para acumular energia (s). */
+#define THINGSPEAK_MIN_INTERVAL_S   15U                     /**< Intervalo mínimo entre atualizações do canal (s). */
+#define THINGSPEAK_SINK_QUEUE_LEN   2U                      /**< Janelas retidas enquanto offline. */
 #define THINGSPEAK_HOST             "api.thingspeak.com"    /**< Host do serviço. */
 
-void thingspeak_send(const char *api_key, uint8_t num_fields, ...);
-void thingspeak_task(void *params);
+bool thingspeak_send(const char *api_key, uint8_t num_fields, ...);
+
+extern const telemetry_sink_t thingspeak_sink;   /**< Sink de janelas para o ThingSpeak. */
 
 #endif /* THINGSPEAK_H */
@@ -0,0 +1,628 @@
+/**
+ * @file time_sync.c
+ * @brief Relógio de software disciplinado por NTP (vários servidores, deriva e slew).
+ * @details
+ *  O tempo Unix em µs é `base + (time_us_64() - base_mono)`, com uma correção
+ *  de frequência (deriva do cristal, em ppb) e um slew limitado a
+ *  `TIME_SYNC_SLEW_PPM`: um offset medido é absorvido aos poucos, sem salto
+ *  nem retrocesso na série. Só a primeira sincronização e offsets acima de
+ *  `TIME_SYNC_STEP_MS` saltam o relógio.
+ *
+ *  A cada rodada `time_sync_task` envia uma consulta a todos os servidores de
+ *  `TIME_SYNC_SERVERS` de uma vez e, entre as respostas, usa a de menor
+ *  atraso de ida e volta. Cada resposta dá os quatro instantes do SNTP
+ *  (RFC 4330): T1/T4 são `time_us_64()` no envio e na recepção, T2/T3 vêm
+ *  do servidor com a fração de 2^-32 s, e
+ *
+ *      offset = ((T2 - T1) + (T3 - T4)) / 2
+ *      atraso = (T4 - T1) - (T3 - T2)
+ *
+ *  de modo que o tempo de processamento no servidor não entra no atraso e a
+ *  assimetria só afeta o offset em até metade do atraso. Respostas que não
+ *  são do modo servidor, com stratum fora de 1..15 (kiss-o'-death), alarme
+ *  de "não sincronizado" ou atraso acima de `TIME_SYNC_MAX_DELAY_MS` são
+ *  descartadas. A deriva é estimada pelo offset que sobra entre
+ *  amostras consecutivas. O intervalo entre rodadas dobra a cada amostra
+ *  aceita, de `TIME_SYNC_POLL_MIN_S` até `TIME_SYNC_POLL_MAX_S`.
+ *
+ *  Leitores (`time_sync_now_us`) não bloqueiam: copiam a base com um contador
+ *  de sequência e repetem a leitura se a task a trocou no meio.
+ */
+
+#include "lib/time_sync.h"
+#include <string.h>
+#include <stdlib.h>
+#include "pico/stdlib.h"
+#include "pico/cyw43_arch.h"
+#include "lwip/udp.h"
+#include "lwip/pbuf.h"
+#include "lwip/ip_addr.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "utils.h"
+#include "lib/wifi_manager.h"
+#include "lib/logger.h"
+
+#define TAG "time_sync"
+
+#define NTP_PORT                    123U            /**< Porta UDP do NTP. */
+#define NTP_PKT_LEN                 48U             /**< Tamanho do pacote NTP. */
+#define NTP_UNIX_DELTA_S            2208988800LL    /**< Segundos de 1900-01-01 a 1970-01-01. */
+#define TIME_SYNC_REPLY_TIMEOUT_MS  2000U           /**< Espera pelas respostas de uma rodada. */
+#define TIME_SYNC_RETRY_S           16U             /**< Nova rodada após falha enquanto não sincronizado. */
+#define TIME_SYNC_DNS_TIMEOUT_MS    5000U           /**< Timeout da resolução de cada servidor. */
+#define TIME_SYNC_MAX_MISSES        3U              /**< Rodadas sem resposta antes de resolver o nome de novo. */
+#define TIME_SYNC_FREQ_SPAN_S       60U             /**< Intervalo mínimo entre amostras para estimar a deriva. */
+#define TIME_SYNC_FREQ_GAIN         2               /**< Divisor do erro de frequência aplicado por amostra. */
+#define TIME_SYNC_MAX_DELAY_MS      500U            /**< Respostas com atraso maior são descartadas. */
+#define NTP_MODE_SERVER             4U              /**< Modo das respostas de servidor. */
+#define NTP_LI_ALARM                3U              /**< Leap indicator: servidor não sincronizado. */
+#define NTP_STRATUM_MAX             15U             /**< Maior stratum válido (0 é kiss-o'-death). */
+
+/** @brief Servidor NTP e a consulta da rodada corrente. */
+typedef struct
+{
+    const char *host;           /**< Nome do servidor. */
+    ip_addr_t ip;               /**< Endereço resolvido. */
+    bool resolved;              /**< `ip` válido. */
+    uint8_t misses;             /**< Rodadas seguidas sem resposta. */
+    uint64_t t1_us;             /**< Envio (`time_us_64`), também usado como cookie. */
+    uint64_t t4_us;             /**< Recepção (`time_us_64`). */
+    int64_t t2_unix_us;         /**< Receive timestamp do servidor (Unix µs). */
+    int64_t t3_unix_us;         /**< Transmit timestamp do servidor (Unix µs). */
+    uint8_t stratum;            /**< Stratum informado na resposta. */
+    bool valid;                 /**< A resposta passou na validação (T2/T3 utilizáveis). */
+    volatile bool replied;      /**< Resposta válida nesta rodada. */
+} ntp_server_t;
+
+/** @brief Base do relógio de software. */
+typedef struct
+{
+    uint64_t mono_us;           /**< `time_us_64()` na base. */
+    int64_t unix_us;            /**< Tempo Unix na base. */
+    int32_t freq_ppb;           /**< Correção de frequência. */
+    int32_t slew_us;            /**< Correção ainda a aplicar a partir da base. */
+} clock_base_t;
+
+static const char *const k_hosts[] = {TIME_SYNC_SERVERS};
+
+static ntp_server_t s_servers[TIME_SYNC_MAX_SERVERS];
+static uint8_t s_server_count = 0;
+
+static clock_base_t s_clk;                  /**< Começa em 1970-01-01 + uptime. */
+static volatile uint32_t s_clk_seq = 0;     /**< Incrementado a cada troca de `s_clk`. */
+
+static struct udp_pcb *s_pcb = NULL;
+static SemaphoreHandle_t s_done = NULL;     /**< Todas as respostas da rodada chegaram. */
+static volatile bool s_round_open = false;
+static volatile uint8_t s_sent = 0;
+static volatile uint8_t s_got = 0;
+static volatile uint32_t s_rejected = 0;   /**< Respostas descartadas no callback (somadas pela task). */
+
+static TaskHandle_t s_task = NULL;
+static int8_t s_tx_client = -1;
+static uint64_t s_last_sample_mono = 0;
+static time_sync_stats_t s_stats;
+
+static uint32_t rd_be_u32(const uint8_t *b)
+{
+    return ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | ((uint32_t)b[3]);
+}
+
+static void wr_be_u32(uint8_t *b, uint32_t v)
+{
+    b[0] = (uint8_t)(v >> 24);
+    b[1] = (uint8_t)(v >> 16);
+    b[2] = (uint8_t)(v >> 8);
+    b[3] = (uint8_t)v;
+}
+
+/**
+ * @brief Satura um valor de 64 bits em int32 (estatísticas e logs).
+ */
+static int32_t clamp_i32(int64_t v)
+{
+    return (v > INT32_MAX) ? INT32_MAX : (v < INT32_MIN) ? INT32_MIN : (int32_t)v;
+}
+
+/**
+ * @brief Converte um timestamp NTP (segundos + fração 2^-32) para Unix µs.
+ * @note Segundos abaixo de 2^31 são tratados como a era seguinte (após 2036).
+ */
+static int64_t ntp_to_unix_us(uint32_t sec, uint32_t frac)
+{
+    int64_t s = (int64_t)sec;
+
+    if (sec < 0x80000000UL)
+    {
+        s += 0x100000000LL;
+    }
+
+    return (s - NTP_UNIX_DELTA_S) * 1000000LL + (int64_t)(((uint64_t)frac * 1000000ULL) >> 32);
+}
+
+/**
+ * @brief Avalia o relógio de software em `mono`.
+ * @param c Base.
+ * @param mono Instante `time_us_64()`.
+ * @param[out] applied Parte do slew já aplicada (pode ser NULL).
+ * @return Tempo Unix em µs.
+ */
+static int64_t clock_eval(const clock_base_t *c, uint64_t mono, int32_t *applied)
+{
+    const int64_t el = (int64_t)(mono - c->mono_us);
+    int64_t corr = el * (int64_t)TIME_SYNC_SLEW_PPM / 1000000LL;
+
+    if (c->slew_us >= 0)
+    {
+        corr = (corr < c->slew_us) ? corr : c->slew_us;
+    }
+    else
+    {
+        corr = (-corr > c->slew_us) ? -corr : c->slew_us;
+    }
+
+    if (applied)
+    {
+        *applied = (int32_t)corr;
+    }
+
+    return c->unix_us + el + el * c->freq_ppb / 1000000000LL + corr;
+}
+
+/**
+ * @brief Copia a base sem travar (repete se a task a trocou durante a cópia).
+ */
+static void clock_snapshot(clock_base_t *out)
+{
+    uint32_t seq;
+
+    do
+    {
+        seq = s_clk_seq;
+        __compiler_memory_barrier();
+        *out = s_clk;
+        __compiler_memory_barrier();
+    } while (seq != s_clk_seq);
+}
+
+/**
+ * @brief Publica uma nova base (somente `time_sync_task`).
+ */
+static void clock_publish(const clock_base_t *c)
+{
+    taskENTER_CRITICAL();
+    s_clk = *c;
+    s_clk_seq++;
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Tempo Unix corrente em microssegundos (relógio de software).
+ * @note Antes da primeira sincronização conta a partir de 1970-01-01 no boot.
+ */
+int64_t time_sync_now_us(void)
+{
+    clock_base_t c;
+    clock_snapshot(&c);
+    return clock_eval(&c, time_us_64(), NULL);
+}
+
+/**
+ * @brief Converte um instante `time_us_64()` já capturado para tempo Unix em µs.
+ * @param mono_us Instante monotônico (ex.: momento de uma amostra).
+ * @note Usa a base corrente; vale para instantes recentes (o slew é de no máximo `TIME_SYNC_SLEW_PPM`).
+ */
+int64_t time_sync_to_unix_us(uint64_t mono_us)
+{
+    clock_base_t c;
+    clock_snapshot(&c);
+
+    if (mono_us < c.mono_us)
+    {
+        /* Antes da base: extrapola para trás só com a taxa nominal. */
+        return c.unix_us - (int64_t)(c.mono_us - mono_us);
+    }
+
+    return clock_eval(&c, mono_us, NULL);
+}
+
+/**
+ * @brief Informa se o relógio já foi acertado por NTP.
+ */
+bool time_sync_is_synced(void)
+{
+    return s_stats.synced;
+}
+
+/**
+ * @brief Copia o estado da disciplina.
+ * @param[out] out Destino.
+ */
+void time_sync_get_stats(time_sync_stats_t *out)
+{
+    if (!out)
+    {
+        return;
+    }
+
+    taskENTER_CRITICAL();
+    *out = s_stats;
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Nome do servidor de índice `idx` (ou NULL).
+ */
+const char *time_sync_server_name(uint8_t idx)
+{
+    return (idx < s_server_count) ? s_servers[idx].host : NULL;
+}
+
+/**
+ * @brief Aplica uma amostra de offset ao relógio.
+ * @param offset_us Tempo do servidor menos o relógio de software.
+ * @param mono Instante da amostra (`time_us_64`).
+ * @details
+ *  A base é trazida até `mono`. Na primeira amostra ou com offset grande o
+ *  relógio salta; caso contrário o offset vira slew e o que sobrou desde a
+ *  amostra anterior (descontado o slew ainda pendente) corrige a frequência.
+ */
+static void clock_discipline(int64_t offset_us, uint64_t mono)
+{
+    clock_base_t c = s_clk;
+    int32_t applied;
+
+    c.unix_us = clock_eval(&c, mono, &applied);
+    c.slew_us -= applied;
+    c.mono_us = mono;
+
+    const bool step = !s_stats.synced || llabs(offset_us) > (int64_t)TIME_SYNC_STEP_MS * 1000LL;
+
+    if (step)
+    {
+        c.unix_us += offset_us;
+        c.slew_us = 0;
+    }
+    else
+    {
+        const uint64_t span = mono - s_last_sample_mono;
+
+        if (s_last_sample_mono && span >= (uint64_t)TIME_SYNC_FREQ_SPAN_S * 1000000ULL)
+        {
+            const int64_t residual = offset_us - c.slew_us;
+            int64_t f = c.freq_ppb + residual * 1000000000LL / (int64_t)span / TIME_SYNC_FREQ_GAIN;
+
+            if (f > TIME_SYNC_MAX_FREQ_PPB)
+            {
+                f = TIME_SYNC_MAX_FREQ_PPB;
+            }
+            else if (f < -TIME_SYNC_MAX_FREQ_PPB)
+            {
+                f = -TIME_SYNC_MAX_FREQ_PPB;
+            }
+            c.freq_ppb = (int32_t)f;
+        }
+
+        c.slew_us = (int32_t)offset_us;
+    }
+
+    s_last_sample_mono = mono;
+    clock_publish(&c);
+
+    taskENTER_CRITICAL();
+    s_stats.synced = true;
+    s_stats.samples++;
+    s_stats.steps += step ? 1U : 0U;
+    s_stats.last_offset_us = clamp_i32(offset_us);
+    s_stats.freq_ppb = c.freq_ppb;
+    s_stats.slew_pending_us = c.slew_us;
+    taskEXIT_CRITICAL();
+
+    if (step)
+    {
+        LOG(TAG, "Relógio ajustado por salto (%+ld s).", (long)clamp_i32(offset_us / 1000000LL));
+    }
+}
+
+/**
+ * @brief Recepção UDP (contexto do lwIP): casa a resposta com a consulta pelo cookie.
+ */
+static void ntp_recv_cb(void *arg, struct udp_pcb *upcb, struct pbuf *p,
+                        const ip_addr_t *addr, u16_t port)
+{
+    (void)arg;
+    (void)upcb;
+    (void)addr;
+    (void)port;
+    const uint64_t t4 = time_us_64();
+
+    if (!p)
+    {
+        return;
+    }
+
+    uint8_t pkt[NTP_PKT_LEN];
+
+    if (s_round_open && p->tot_len >= NTP_PKT_LEN && pbuf_copy_partial(p, pkt, NTP_PKT_LEN, 0) == NTP_PKT_LEN)
+    {
+        /* Originate timestamp ecoa o transmit que enviamos (t1). */
+        const uint64_t cookie = ((uint64_t)rd_be_u32(&pkt[24]) << 32) | rd_be_u32(&pkt[28]);
+
+        for (uint8_t i = 0; i < s_server_count; i++)
+        {
+            ntp_server_t *s = &s_servers[i];
+
+            if (s->resolved && !s->replied && s->t1_us == cookie)
+            {
+                const uint8_t li = pkt[0] >> 6;
+                const uint8_t mode = pkt[0] & 0x07U;
+                const uint8_t stratum = pkt[1];
+
+                /* Conta como resposta (fecha a rodada), mas sem amostra. */
+                if (mode != NTP_MODE_SERVER || li == NTP_LI_ALARM || stratum == 0U ||
+                    stratum > NTP_STRATUM_MAX || (rd_be_u32(&pkt[40]) == 0U && rd_be_u32(&pkt[44]) == 0U))
+                {
+                    s_rejected++;
+                    s->stratum = stratum;
+                    s->valid = false;
+                }
+                else
+                {
+                    s->t4_us = t4;
+                    s->t2_unix_us = ntp_to_unix_us(rd_be_u32(&pkt[32]), rd_be_u32(&pkt[36]));
+                    s->t3_unix_us = ntp_to_unix_us(rd_be_u32(&pkt[40]), rd_be_u32(&pkt[44]));
+                    s->stratum = stratum;
+                    s->valid = true;
+                }
+                s->replied = true;
+
+                if (++s_got == s_sent)
+                {
+                    if (portCHECK_IF_IN_ISR())
+                    {
+                        BaseType_t hp = pdFALSE;
+                        xSemaphoreGiveFromISR(s_done, &hp);
+                        portYIELD_FROM_ISR(hp);
+                    }
+                    else
+                    {
+                        xSemaphoreGive(s_done);
+                    }
+                }
+                break;
+            }
+        }
+    }
+
+    pbuf_free(p);
+}
+
+/**
+ * @brief Envia a consulta a um servidor, com o instante de envio como cookie.
+ */
+static bool send_query(ntp_server_t *s)
+{
+    uint8_t ntp[NTP_PKT_LEN] = {0};
+    ntp[0] = 0x23; /* LI 0, versão 4, modo cliente */
+
+    bool ok = false;
+    cyw43_arch_lwip_begin();
+    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, NTP_PKT_LEN, PBUF_RAM);
+
+    if (p)
+    {
+        s->replied = false;
+        s->t1_us = time_us_64();
+        wr_be_u32(&ntp[40], (uint32_t)(s->t1_us >> 32));
+        wr_be_u32(&ntp[44], (uint32_t)s->t1_us);
+        (void)pbuf_take(p, ntp, NTP_PKT_LEN);
+        ok = (udp_sendto(s_pcb, p, &s->ip, NTP_PORT) == ERR_OK);
+        pbuf_free(p);
+    }
+    cyw43_arch_lwip_end();
+
+    return ok;
+}
+
+/**
+ * @brief Uma rodada: consulta todos os servidores e aplica a melhor resposta.
+ * @return true se alguma resposta foi aceita.
+ */
+static bool poll_round(void)
+{
+    for (uint8_t i = 0; i < s_server_count; i++)
+    {
+        ntp_server_t *s = &s_servers[i];
+
+        if (!s->resolved && wifi_manager_is_connected())
+        {
+            s->resolved = utils_resolve_dns(s->host, &s->ip, TIME_SYNC_DNS_TIMEOUT_MS);
+            s->misses = 0;
+        }
+    }
+
+    (void)xSemaphoreTake(s_done, 0);
+    s_got = 0;
+    s_sent = 0;
+    s_round_open = true;
+
+    for (uint8_t i = 0; i < s_server_count; i++)
+    {
+        if (s_servers[i].resolved && send_query(&s_servers[i]))
+        {
+            s_sent++;
+        }
+    }
+
+    if (s_sent)
+    {
+        (void)xSemaphoreTake(s_done, pdMS_TO_TICKS(TIME_SYNC_REPLY_TIMEOUT_MS));
+    }
+
+    cyw43_arch_lwip_begin();
+    s_round_open = false;
+    cyw43_arch_lwip_end();
+
+    int best = -1;
+    int64_t best_delay = INT64_MAX;
+    int64_t best_offset = 0;
+    uint32_t rejected = 0;
+
+    for (uint8_t i = 0; i < s_server_count; i++)
+    {
+        ntp_server_t *s = &s_servers[i];
+
+        if (!s->resolved)
+        {
+            continue;
+        }
+
+        if (!s->replied)
+        {
+            if (++s->misses >= TIME_SYNC_MAX_MISSES)
+            {
+                s->resolved = false;
+            }
+            continue;
+        }
+
+        s->misses = 0;
+
+        if (!s->valid)
+        {
+            /* Kiss-o'-death ou servidor sem sincronismo: outro endereço na próxima rodada. */
+            if (s->stratum == 0U)
+            {
+                s->resolved = false;
+            }
+            continue;
+        }
+
+        /* T1 e T4 na escala do relógio de software (a base não muda durante a rodada). */
+        const int64_t t1 = clock_eval(&s_clk, s->t1_us, NULL);
+        const int64_t t4 = clock_eval(&s_clk, s->t4_us, NULL);
+        int64_t delay = (t4 - t1) - (s->t3_unix_us - s->t2_unix_us);
+
+        if (delay < 0)
+        {
+            delay = 0; /* Resolução dos relógios: T3 - T2 pode superar a ida e volta local. */
+        }
+
+        if (delay > (int64_t)TIME_SYNC_MAX_DELAY_MS * 1000LL)
+        {
+            rejected++;
+            continue;
+        }
+
+        if (delay < best_delay)
+        {
+            best_delay = delay;
+            best_offset = ((s->t2_unix_us - t1) + (s->t3_unix_us - t4)) / 2;
+            best = i;
+        }
+    }
+
+    taskENTER_CRITICAL();
+    s_stats.rounds++;
+    s_stats.replies += s_got;
+    s_stats.rejected += rejected + s_rejected;
+    s_rejected = 0;
+    taskEXIT_CRITICAL();
+
+    if (best < 0)
+    {
+        LOGW(TAG, "Rodada sem respostas (%u consultas).", (unsigned)s_sent);
+        return false;
+    }
+
+    const ntp_server_t *s = &s_servers[best];
+
+    clock_discipline(best_offset, s->t4_us);
+
+    taskENTER_CRITICAL();
+    s_stats.last_delay_us = (uint32_t)best_delay;
+    s_stats.last_server = (uint8_t)best;
+    s_stats.last_stratum = s->stratum;
+    taskEXIT_CRITICAL();
+
+    LOG(TAG, "%s (stratum %u): offset %+ld us, atraso %lu us, freq %+ld ppb (%u/%u respostas).", s->host,
+        (unsigned)s->stratum, (long)clamp_i32(best_offset), (unsigned long)best_delay,
+        (long)s_stats.freq_ppb, (unsigned)s_got, (unsigned)s_sent);
+    return true;
+}
+
+/**
+ * @brief Link Wi‑Fi subiu: nova rodada já.
+ */
+static void wifi_link_cb(bool up, void *ctx)
+{
+    (void)ctx;
+
+    if (up && s_task)
+    {
+        xTaskNotifyGive(s_task);
+    }
+}
+
+/**
+ * @brief Task do serviço de tempo: rodadas periódicas enquanto houver Wi‑Fi.
+ * @param params Não utilizado.
+ */
+void time_sync_task(void *params)
+{
+    (void)params;
+
+    s_task = xTaskGetCurrentTaskHandle();
+    s_done = xSemaphoreCreateBinary();
+
+    for (size_t i = 0; i < count_of(k_hosts) && s_server_count < TIME_SYNC_MAX_SERVERS; i++)
+    {
+        s_servers[s_server_count++].host = k_hosts[i];
+    }
+
+    cyw43_arch_lwip_begin();
+    s_pcb = udp_new_ip_type(IPADDR_TYPE_ANY);
+    if (s_pcb)
+    {
+        udp_recv(s_pcb, ntp_recv_cb, NULL);
+    }
+    cyw43_arch_lwip_end();
+
+    if (!s_pcb || !s_done)
+    {
+        LOGE(TAG, "Serviço de tempo indisponível (pcb/semáforo).");
+        vTaskDelete(NULL);
+        return;
+    }
+
+    (void)wifi_manager_subscribe(wifi_link_cb, NULL);
+    s_tx_client = wifi_manager_tx_register("ntp");
+
+    uint32_t poll_s = TIME_SYNC_POLL_MIN_S;
+
+    for (;;)
+    {
+        if (!wifi_manager_is_connected())
+        {
+            (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        wifi_manager_tx_schedule(s_tx_client, WIFI_TX_NOW);
+
+        if (poll_round())
+        {
+            poll_s = (poll_s < TIME_SYNC_POLL_MAX_S) ? poll_s * 2U : TIME_SYNC_POLL_MAX_S;
+        }
+        else
+        {
+            poll_s = s_stats.synced ? TIME_SYNC_POLL_MIN_S : TIME_SYNC_RETRY_S;
+        }
+
+        s_stats.poll_s = poll_s;
+        wifi_manager_tx_schedule(s_tx_client, poll_s * 1000U);
+        (void)ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(poll_s * 1000U));
+    }
+}
@@ -0,0 +1,49 @@
+/**
+ * @file time_sync.h
+ * @brief Relógio de software disciplinado por NTP (vários servidores, deriva e slew).
+ */
+
+#ifndef TIME_SYNC_H
+#define TIME_SYNC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef TIME_SYNC_SERVERS
+/** @brief Servidores consultados em paralelo a cada rodada (separados por vírgula). */
+#define TIME_SYNC_SERVERS       "0.pool.ntp.org", "1.pool.ntp.org", "a.st1.ntp.br", "time.google.com"
+#endif
+
+#define TIME_SYNC_MAX_SERVERS   4U          /**< Servidores usados da lista. */
+#define TIME_SYNC_POLL_MIN_S    64U         /**< Intervalo inicial entre rodadas (s). */
+#define TIME_SYNC_POLL_MAX_S    1024U       /**< Intervalo máximo entre rodadas (s). */
+#define TIME_SYNC_STEP_MS       1000U       /**< Acima deste offset o relógio salta em vez de deslizar. */
+#define TIME_SYNC_SLEW_PPM      500U        /**< Taxa máxima de correção por slew. */
+#define TIME_SYNC_MAX_FREQ_PPB  500000      /**< Limite da correção de frequência (±500 ppm). */
+
+/** @brief Estado da disciplina do relógio. */
+typedef struct
+{
+    bool synced;                /**< Houve ao menos uma amostra aceita. */
+    uint32_t rounds;            /**< Rodadas de consulta feitas. */
+    uint32_t samples;           /**< Amostras aceitas (melhor servidor da rodada). */
+    uint32_t replies;           /**< Respostas recebidas (todos os servidores). */
+    uint32_t rejected;          /**< Respostas descartadas (modo, stratum, alarme ou atraso). */
+    uint32_t steps;             /**< Saltos do relógio (primeira sincronização ou offset grande). */
+    int32_t last_offset_us;     /**< Offset medido na última amostra. */
+    uint32_t last_delay_us;     /**< Atraso de rede da última amostra (sem o processamento no servidor). */
+    int32_t freq_ppb;           /**< Correção de frequência estimada do cristal. */
+    int32_t slew_pending_us;    /**< Correção ainda a aplicar por slew. */
+    uint8_t last_server;        /**< Índice do servidor escolhido na última rodada. */
+    uint8_t last_stratum;       /**< Stratum desse servidor. */
+    uint32_t poll_s;            /**< Intervalo corrente entre rodadas. */
+} time_sync_stats_t;
+
+int64_t time_sync_now_us(void);
+int64_t time_sync_to_unix_us(uint64_t mono_us);
+bool time_sync_is_synced(void);
+void time_sync_get_stats(time_sync_stats_t *out);
+const char *time_sync_server_name(uint8_t idx);
+void time_sync_task(void *params);
+
+#endif /* TIME_SYNC_H */
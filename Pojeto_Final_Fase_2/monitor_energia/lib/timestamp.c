@@ -0,0 +1,219 @@
+/**
+ * @file timestamp.c
+ * @brief Tempo Unix (µs) para data/hora local em O(1) e timestamps com prefixo em cache.
+ * @details
+ *  `timestamp_days_from_civil`/`timestamp_civil_from_days` usam o calendário
+ *  gregoriano proléptico em eras de 400 anos (146097 dias), com o ano
+ *  começando em março para que o dia bissexto caia no fim: só divisões
+ *  inteiras, sem laço. Compila também no host.
+ */
+
+#include "lib/timestamp.h"
+#include <string.h>
+
+#define SECONDS_PER_DAY     86400LL     /**< Segundos por dia. */
+#define DAYS_PER_ERA        146097LL    /**< Dias em 400 anos gregorianos. */
+#define DAYS_0000_TO_1970   719468LL    /**< Dias de 0000-03-01 a 1970-01-01. */
+
+/** @brief Divisão inteira arredondando para baixo (tempos antes de 1970). */
+static int64_t floor_div(int64_t a, int64_t b)
+{
+    const int64_t q = a / b;
+    return (a % b != 0 && ((a < 0) != (b < 0))) ? q - 1 : q;
+}
+
+/**
+ * @brief Dias desde 1970-01-01 para a data civil dada.
+ * @param y Ano.
+ * @param m Mês [1..12].
+ * @param d Dia [1..31].
+ */
+int64_t timestamp_days_from_civil(int32_t y, uint32_t m, uint32_t d)
+{
+    const int64_t yy = (int64_t)y - (m <= 2U ? 1 : 0);
+    const int64_t era = floor_div(yy, 400);
+    const int64_t yoe = yy - era * 400;                                     /* [0, 399] */
+    const int64_t mp = (m > 2U) ? (int64_t)m - 3 : (int64_t)m + 9;          /* mar = 0 */
+    const int64_t doy = (153 * mp + 2) / 5 + (int64_t)d - 1;                /* [0, 365] */
+    const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;              /* [0, 146096] */
+    return era * DAYS_PER_ERA + doe - DAYS_0000_TO_1970;
+}
+
+/**
+ * @brief Data civil do dia `days` (desde 1970-01-01).
+ */
+void timestamp_civil_from_days(int64_t days, int32_t *y, uint32_t *m, uint32_t *d)
+{
+    const int64_t z = days + DAYS_0000_TO_1970;
+    const int64_t era = floor_div(z, DAYS_PER_ERA);
+    const int64_t doe = z - era * DAYS_PER_ERA;                                 /* [0, 146096] */
+    const int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365; /* [0, 399] */
+    const int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);                /* [0, 365] */
+    const int64_t mp = (5 * doy + 2) / 153;                                     /* [0, 11] */
+    const uint32_t mm = (uint32_t)(mp < 10 ? mp + 3 : mp - 9);
+
+    *d = (uint32_t)(doy - (153 * mp + 2) / 5 + 1);
+    *m = mm;
+    *y = (int32_t)(yoe + era * 400 + (mm <= 2U ? 1 : 0));
+}
+
+/**
+ * @brief Separa um tempo Unix em data/hora local (`TIMESTAMP_TZ_OFFSET_S`).
+ * @param unix_us Microssegundos desde 1970-01-01 UTC.
+ * @param[out] out Campos locais.
+ */
+void timestamp_to_local(int64_t unix_us, fmt_time_t *out)
+{
+    const int64_t local_ms = floor_div(unix_us, 1000) + (int64_t)TIMESTAMP_TZ_OFFSET_S * 1000;
+    const int64_t sec = floor_div(local_ms, 1000);
+    const int64_t days = floor_div(sec, SECONDS_PER_DAY);
+    const uint32_t sod = (uint32_t)(sec - days * SECONDS_PER_DAY);
+
+    int32_t y;
+    uint32_t m, d;
+    timestamp_civil_from_days(days, &y, &m, &d);
+
+    out->year = (uint16_t)((y < 0) ? 0 : (y > 9999) ? 9999 : y);
+    out->month = (uint8_t)m;
+    out->day = (uint8_t)d;
+    out->hour = (uint8_t)(sod / 3600U);
+    out->min = (uint8_t)((sod / 60U) % 60U);
+    out->sec = (uint8_t)(sod % 60U);
+    out->msec = (uint16_t)(local_ms - sec * 1000);
+}
+
+/** @brief Escreve `v` (0..99) com dois dígitos. */
+static void put2(char *p, uint32_t v)
+{
+    p[0] = (char)('0' + v / 10U);
+    p[1] = (char)('0' + v % 10U);
+}
+
+/**
+ * @brief Formata data/hora local reaproveitando o texto do cache.
+ * @param c Cache do chamador (um por contexto; não é reentrante).
+ * @param buf Destino.
+ * @param size Capacidade de `buf`.
+ * @param unix_us Microssegundos desde 1970-01-01 UTC.
+ * @return Caracteres escritos (0 se não couber, como em `fmt`).
+ * @details
+ *  Mesmo segundo: só copia o texto. Segundo novo no mesmo dia: reescreve
+ *  HH:MM:SS. Dia novo: recalcula a data (O(1)).
+ */
+size_t timestamp_format(timestamp_cache_t *c, char *buf, size_t size, int64_t unix_us)
+{
+    const int64_t local_ms = floor_div(unix_us, 1000) + (int64_t)TIMESTAMP_TZ_OFFSET_S * 1000;
+    const int64_t sec = floor_div(local_ms, 1000);
+
+    if (sec != c->sec)
+    {
+        const int64_t days = floor_div(sec, SECONDS_PER_DAY);
+        const uint32_t sod = (uint32_t)(sec - days * SECONDS_PER_DAY);
+
+        if (days != c->day)
+        {
+            fmt_time_t t;
+            timestamp_to_local(unix_us, &t);
+            (void)fmt_timestamp(c->text, sizeof(c->text), &t, c->date_sep, c->time_sep, false);
+            c->day = days;
+        }
+        else
+        {
+            put2(&c->text[11], sod / 3600U);
+            put2(&c->text[14], (sod / 60U) % 60U);
+            put2(&c->text[17], sod % 60U);
+        }
+
+        c->sec = sec;
+    }
+
+    const size_t len = c->with_msec ? 23U : 19U;
+
+    if (!buf || size < len + 1U)
+    {
+        if (buf && size)
+        {
+            buf[0] = '\0';
+        }
+        return 0;
+    }
+
+    memcpy(buf, c->text, 19U);
+
+    if (c->with_msec)
+    {
+        const uint32_t ms = (uint32_t)(local_ms - sec * 1000);
+        buf[19] = '.';
+        buf[20] = (char)('0' + ms / 100U);
+        put2(&buf[21], ms % 100U);
+    }
+
+    buf[len] = '\0';
+    return len;
+}
+
+/** @brief Lê `n` dígitos decimais de `*p`, avançando; false se faltar dígito. */
+static bool parse_digits(const char **p, const char *end, uint32_t n, uint32_t *out)
+{
+    uint32_t v = 0;
+
+    for (uint32_t i = 0; i < n; i++, (*p)++)
+    {
+        if (*p >= end || **p < '0' || **p > '9')
+        {
+            return false;
+        }
+        v = v * 10U + (uint32_t)(**p - '0');
+    }
+    *out = v;
+    return true;
+}
+
+/**
+ * @brief Converte "AAAA-MM-DDTHH:MM:SS" (hora local, `TIMESTAMP_TZ_OFFSET_S`) ou segundos Unix para Unix µs.
+ * @details Sem `sscanf`: usado no firmware (consultas por HTTP e serial) e
+ *          nas ferramentas do host. Aceita também só a data ("AAAA-MM-DD",
+ *          meia-noite local).
+ * @param len Caracteres de `s` a considerar (a string não precisa terminar em '\0').
+ * @return false se o texto não está em nenhum dos formatos.
+ */
+bool timestamp_parse(const char *s, size_t len, int64_t *unix_us)
+{
+    const char *p = s;
+    const char *end = s + len;
+    uint32_t y = 0, mo = 0, d = 0, h = 0, mi = 0, se = 0;
+
+    if (len >= 10U && s[4] == '-' && s[7] == '-')
+    {
+        const bool date_ok = parse_digits(&p, end, 4, &y) && p++ && parse_digits(&p, end, 2, &mo) && p++ &&
+                             parse_digits(&p, end, 2, &d);
+        const bool time_ok = (p == end) || (*p++ == 'T' && parse_digits(&p, end, 2, &h) && p < end && *p++ == ':' &&
+                                            parse_digits(&p, end, 2, &mi) && p < end && *p++ == ':' &&
+                                            parse_digits(&p, end, 2, &se) && p == end);
+        if (!date_ok || !time_ok || mo < 1U || mo > 12U || d < 1U || d > 31U || h > 23U || mi > 59U || se > 60U)
+        {
+            return false;
+        }
+
+        const int64_t local = timestamp_days_from_civil((int32_t)y, mo, d) * SECONDS_PER_DAY + (int64_t)h * 3600 +
+                              (int64_t)mi * 60 + (int64_t)se;
+        *unix_us = (local - TIMESTAMP_TZ_OFFSET_S) * 1000000;
+        return true;
+    }
+
+    int64_t v = 0;
+    if (len == 0U || len > 12U)
+    {
+        return false;
+    }
+    for (; p < end; p++)
+    {
+        if (*p < '0' || *p > '9')
+        {
+            return false;
+        }
+        v = v * 10 + (*p - '0');
+    }
+    *unix_us = v * 1000000;
+    return true;
+}
@@ -0,0 +1,46 @@
+/**
+ * @file timestamp.h
+ * @brief Tempo Unix (µs) para data/hora local em O(1) e timestamps com prefixo em cache.
+ * @details
+ *  A fonte de tempo é `time_sync_now_us()` (Unix µs, 64 bits). Aqui ficam só
+ *  as conversões, sem dependência do SDK: dias <-> data civil por fórmula
+ *  fechada (sem laço por ano/mês) e um formatador que reaproveita o texto
+ *  de data/hora enquanto o segundo (ou o dia) não muda.
+ */
+
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "lib/fmt.h"
+
+#ifndef TIMESTAMP_TZ_OFFSET_S
+#define TIMESTAMP_TZ_OFFSET_S   (-3 * 3600)     /**< Fuso da hora local (s; ex.: -3h). */
+#endif
+
+#define TIMESTAMP_MAX_LEN       24U             /**< "YYYY-MM-DDTHH:MM:SS.mmm" + '\0'. */
+
+/** @brief Texto de data/hora do último segundo formatado. */
+typedef struct
+{
+    int64_t day;            /**< Dia local (desde 1970-01-01) da data em `text`. */
+    int64_t sec;            /**< Segundo local do texto em `text`. */
+    char date_sep;          /**< Separador da data. */
+    char time_sep;          /**< Separador entre data e hora. */
+    bool with_msec;         /**< Acrescenta ".mmm". */
+    char text[TIMESTAMP_MAX_LEN]; /**< "YYYY?MM?DD?HH:MM:SS" (19 caracteres). */
+} timestamp_cache_t;
+
+/** @brief Inicializador de `timestamp_cache_t` (cache vazio). */
+#define TIMESTAMP_CACHE_INIT(ds, ts, ms) \
+    {.day = INT64_MIN, .sec = INT64_MIN, .date_sep = (ds), .time_sep = (ts), .with_msec = (ms)}
+
+int64_t timestamp_days_from_civil(int32_t y, uint32_t m, uint32_t d);
+void timestamp_civil_from_days(int64_t days, int32_t *y, uint32_t *m, uint32_t *d);
+void timestamp_to_local(int64_t unix_us, fmt_time_t *out);
+size_t timestamp_format(timestamp_cache_t *c, char *buf, size_t size, int64_t unix_us);
+bool timestamp_parse(const char *s, size_t len, int64_t *unix_us);
+
+#endif /* TIMESTAMP_H */
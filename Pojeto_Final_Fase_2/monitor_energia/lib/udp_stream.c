@@ -0,0 +1,442 @@
+/**
+ * @file udp_stream.c
+ * @brief Envio das amostras instantâneas de tensão/corrente em datagramas UDP.
+ * @details
+ *  `energy_monitor_task` chama `udp_stream_push()` a cada par de amostras e
+ *  `udp_stream_flush()` ao fim da janela. As amostras são gravadas direto no
+ *  formato de `udp_stream_proto.h` em um de `UDP_STREAM_BATCHES` buffers;
+ *  cada buffer cheio vai por fila para `udp_stream_task`, que o envia e o
+ *  devolve à fila de livres. A amostragem nunca espera pela rede: sem buffer
+ *  livre a amostra é descartada, e o salto de sequência aparece no coletor.
+ *
+ *  O mesmo socket atende `udp_stream_record_sink`, que agrupa os registros
+ *  de 1 Hz da telemetria no formato de `telemetry_codec.h` (magic "ER").
+ *
+ *  O fluxo só sai para um coletor explícito (`UDP_STREAM_HOST`); endereço
+ *  broadcast é recusado para não inundar a rede local a 200 amostras/s.
+ *  Desligado, nem amostras nem registros são enviados.
+ */
+
+#include "lib/udp_stream.h"
+#include <stdio.h>
+#include <string.h>
+#include "pico/cyw43_arch.h"
+#include "lwip/udp.h"
+#include "lwip/pbuf.h"
+#include "lwip/netif.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "utils.h"
+#include "lib/udp_stream_proto.h"
+#include "lib/telemetry_codec.h"
+#include "lib/wifi_manager.h"
+#include "lib/time_sync.h"
+#include "lib/logger.h"
+#include "lib/rtos_stats.h"
+#include "lib/serial_cmd.h"
+
+#define TAG "udp_stream"
+
+#define UDP_STREAM_RATE_HZ          200U    /**< Taxa nominal informada no cabeçalho. */
+#define UDP_STREAM_RESOLVE_RETRY_MS 5000U   /**< Espera entre tentativas de resolver o coletor. */
+#define UDP_STREAM_DGRAM_SIZE       (UDP_STREAM_HDR_SIZE + UDP_STREAM_BATCH_SAMPLES * UDP_STREAM_SAMPLE_SIZE)
+
+/** @brief Datagrama em preparo. */
+typedef struct
+{
+    uint8_t data[UDP_STREAM_DGRAM_SIZE];
+    uint16_t count;     /**< Amostras gravadas. */
+    uint32_t seq;       /**< Sequência da primeira amostra. */
+    uint64_t t0_us;     /**< Instante da primeira amostra (`time_us_64`). */
+} udp_batch_t;
+
+static udp_batch_t s_batches[UDP_STREAM_BATCHES];
+static QueueHandle_t s_free = NULL;     /**< Índices de buffers livres. */
+static QueueHandle_t s_ready = NULL;    /**< Índices de buffers prontos para envio. */
+
+/* Estado do produtor (somente energy_monitor_task). */
+static udp_batch_t *s_fill = NULL;
+static uint8_t s_fill_idx = 0;
+static uint32_t s_seq = 0;
+
+static volatile bool s_enabled = false;
+static int8_t s_tx_client = -1;         /**< Cliente de envio no gerenciador Wi‑Fi (segura o rádio ligado). */
+static udp_stream_stats_t s_stats;
+
+/* Socket e destino, válidos após `s_net_ready`. */
+static struct udp_pcb *s_pcb = NULL;
+static ip_addr_t s_dest;
+static volatile bool s_net_ready = false;
+
+/* Payload de registros em montagem (somente a task do sink). */
+static uint8_t s_rec_payload[TELEMETRY_CODEC_HDR_SIZE + UDP_STREAM_RECORD_BATCH * TELEMETRY_CODEC_REC_SIZE];
+static telemetry_codec_writer_t s_rec_writer;
+static bool s_rec_open = false;
+
+static void udp_cmd(int argc, char **argv);
+
+static const serial_cmd_t s_udp_cmd = {
+    .name = "udp",
+    .args = "[on|off]",
+    .help = "Mostra ou liga/desliga o fluxo UDP de amostras (requer UDP_STREAM_HOST).",
+    .fn = udp_cmd,
+};
+
+/**
+ * @brief Informa se há coletor configurado em `credentials.h`.
+ */
+static inline bool host_configured(void)
+{
+    return UDP_STREAM_HOST[0] != '\0';
+}
+
+/**
+ * @brief Cria as filas, entrega todos os buffers à fila de livres e registra o comando `udp`.
+ */
+void udp_stream_init(void)
+{
+    (void)serial_cmd_register(&s_udp_cmd);
+    s_tx_client = wifi_manager_tx_register("udp");
+    (void)udp_stream_set_enabled(UDP_STREAM_ENABLED != 0);
+
+    s_free = xQueueCreate(UDP_STREAM_BATCHES, sizeof(uint8_t));
+    s_ready = xQueueCreate(UDP_STREAM_BATCHES, sizeof(uint8_t));
+
+    if (!s_free || !s_ready)
+    {
+        LOGE(TAG, "Falha ao criar filas do fluxo UDP.");
+        return;
+    }
+
+    rtos_stats_watch_queue(s_free, "udp_free");
+    rtos_stats_watch_queue(s_ready, "udp_ready");
+
+    for (uint8_t i = 0; i < UDP_STREAM_BATCHES; i++)
+    {
+        (void)xQueueSend(s_free, &i, 0);
+    }
+}
+
+/**
+ * @brief Fecha o datagrama em preparo e o entrega à task de envio.
+ */
+static void submit_fill(void)
+{
+    udp_stream_hdr_t h = {
+        .version = UDP_STREAM_VERSION,
+        .type = UDP_STREAM_TYPE_SAMPLES,
+        .count = s_fill->count,
+        .rate_hz = UDP_STREAM_RATE_HZ,
+        .seq = s_fill->seq,
+        .t0_ms = (uint32_t)(s_fill->t0_us / 1000U),
+        .t0_unix_us = time_sync_is_synced() ? time_sync_to_unix_us(s_fill->t0_us) : 0,
+    };
+
+    udp_stream_put_header(s_fill->data, &h);
+    (void)xQueueSend(s_ready, &s_fill_idx, 0);
+    s_fill = NULL;
+}
+
+/**
+ * @brief Acrescenta uma amostra ao datagrama em preparo (não bloqueia).
+ * @param t_us Instante da amostra (`time_us_64`).
+ * @param v Tensão instantânea [V].
+ * @param i Corrente instantânea [A].
+ * @note Chamada apenas por `energy_monitor_task`.
+ */
+void udp_stream_push(uint64_t t_us, float v, float i)
+{
+    const uint32_t seq = s_seq++;
+
+    if (!s_free || !s_enabled || !wifi_manager_is_connected())
+    {
+        s_stats.dropped++;
+        return;
+    }
+
+    /* dt é u16 em unidades de UDP_STREAM_DT_UNIT_US: uma pausa longa fecha o datagrama corrente. */
+    if (s_fill && (t_us - s_fill->t0_us) / UDP_STREAM_DT_UNIT_US > UINT16_MAX)
+    {
+        submit_fill();
+    }
+
+    if (!s_fill)
+    {
+        if (xQueueReceive(s_free, &s_fill_idx, 0) != pdTRUE)
+        {
+            s_stats.dropped++;
+            return;
+        }
+
+        s_fill = &s_batches[s_fill_idx];
+        s_fill->count = 0;
+        s_fill->seq = seq;
+        s_fill->t0_us = t_us;
+    }
+
+    const udp_stream_sample_t rec = {
+        .dt = (uint16_t)((t_us - s_fill->t0_us) / UDP_STREAM_DT_UNIT_US),
+        .v_cv = udp_stream_to_centi(v),
+        .i_ca = udp_stream_to_centi(i),
+    };
+
+    udp_stream_put_sample(&s_fill->data[UDP_STREAM_HDR_SIZE + s_fill->count * UDP_STREAM_SAMPLE_SIZE], &rec);
+    s_fill->count++;
+
+    if (s_fill->count == UDP_STREAM_BATCH_SAMPLES)
+    {
+        submit_fill();
+    }
+}
+
+/**
+ * @brief Envia o datagrama parcial (fim da janela de amostragem).
+ * @note Chamada apenas por `energy_monitor_task`.
+ */
+void udp_stream_flush(void)
+{
+    if (s_fill && s_fill->count > 0)
+    {
+        submit_fill();
+    }
+}
+
+/**
+ * @brief Liga/desliga o fluxo (amostras desligadas contam como descartadas).
+ * @details Ligado, o fluxo envia a cada ~160 ms: o rádio fica acordado enquanto durar.
+ * @return false se pedido para ligar sem coletor configurado (permanece desligado).
+ */
+bool udp_stream_set_enabled(bool enabled)
+{
+    const bool ok = !enabled || host_configured();
+
+    if (!ok)
+    {
+        LOGW(TAG, "Defina UDP_STREAM_HOST em credentials.h para ligar o fluxo.");
+    }
+
+    s_enabled = enabled && ok;
+    wifi_manager_tx_hold(s_tx_client, s_enabled);
+    return ok;
+}
+
+/**
+ * @brief Informa se o fluxo está habilitado.
+ */
+bool udp_stream_is_enabled(void)
+{
+    return s_enabled;
+}
+
+/**
+ * @brief Copia os contadores do fluxo.
+ * @param[out] out Destino.
+ */
+void udp_stream_get_stats(udp_stream_stats_t *out)
+{
+    if (out)
+    {
+        *out = s_stats;
+    }
+}
+
+/**
+ * @brief Resolve o coletor com Wi‑Fi ativo: IP literal direto, hostname via DNS.
+ * @return false se o endereço for broadcast (global ou da sub-rede), que é recusado.
+ */
+static bool resolve_collector(ip_addr_t *dest)
+{
+    const bool literal = ipaddr_aton(UDP_STREAM_HOST, dest);
+
+    while (!wifi_manager_is_connected() || (!literal && !utils_resolve_dns(UDP_STREAM_HOST, dest, 5000)))
+    {
+        vTaskDelay(pdMS_TO_TICKS(UDP_STREAM_RESOLVE_RETRY_MS));
+    }
+
+    cyw43_arch_lwip_begin();
+    const bool bcast = ip_addr_isbroadcast(dest, netif_default);
+    cyw43_arch_lwip_end();
+
+    return !bcast;
+}
+
+/**
+ * @brief Comando serial `udp [on|off]`.
+ */
+static void udp_cmd(int argc, char **argv)
+{
+    if (argc >= 2)
+    {
+        if (strcmp(argv[1], "on") == 0)
+        {
+            if (!udp_stream_set_enabled(true))
+            {
+                printf("Sem coletor: defina UDP_STREAM_HOST em credentials.h.\n");
+                return;
+            }
+        }
+        else if (strcmp(argv[1], "off") == 0)
+        {
+            (void)udp_stream_set_enabled(false);
+        }
+        else
+        {
+            printf("Uso: udp [on|off]\n");
+            return;
+        }
+    }
+
+    printf("Fluxo UDP %s (coletor: %s:%u, %s).\n", s_enabled ? "ligado" : "desligado",
+           host_configured() ? UDP_STREAM_HOST : "-", (unsigned)UDP_STREAM_PORT,
+           s_net_ready ? "pronto" : "sem socket");
+}
+
+/**
+ * @brief Envia um datagrama ao coletor.
+ * @return true se entregue ao lwIP.
+ */
+static bool send_payload(const uint8_t *data, u16_t len)
+{
+    err_t err = ERR_MEM;
+
+    cyw43_arch_lwip_begin();
+    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, len, PBUF_RAM);
+
+    if (p)
+    {
+        (void)pbuf_take(p, data, len);
+        err = udp_sendto(s_pcb, p, &s_dest, UDP_STREAM_PORT);
+        pbuf_free(p);
+    }
+    cyw43_arch_lwip_end();
+
+    return err == ERR_OK;
+}
+
+/**
+ * @brief Task de envio: consome datagramas prontos e os devolve aos livres.
+ * @param params Não utilizado.
+ */
+void udp_stream_task(void *params)
+{
+    (void)params;
+
+    if (!host_configured())
+    {
+        LOG(TAG, "Fluxo UDP sem coletor (UDP_STREAM_HOST vazio); task encerrada.");
+        vTaskDelete(NULL);
+        return;
+    }
+
+    cyw43_arch_lwip_begin();
+    s_pcb = udp_new_ip_type(IPADDR_TYPE_ANY);
+    cyw43_arch_lwip_end();
+
+    if (!s_pcb || !s_ready)
+    {
+        LOGE(TAG, "Fluxo UDP indisponível (pcb/filas).");
+        vTaskDelete(NULL);
+        return;
+    }
+
+    if (!resolve_collector(&s_dest))
+    {
+        LOGE(TAG, "Coletor %s é broadcast; informe um host explícito.", UDP_STREAM_HOST);
+        (void)udp_stream_set_enabled(false);
+        vTaskDelete(NULL);
+        return;
+    }
+
+    s_net_ready = true;
+    LOG(TAG, "Fluxo de amostras para %s:%u (%u amostras/datagrama).",
+        UDP_STREAM_HOST, (unsigned)UDP_STREAM_PORT, (unsigned)UDP_STREAM_BATCH_SAMPLES);
+
+    for (;;)
+    {
+        uint8_t idx;
+
+        if (xQueueReceive(s_ready, &idx, portMAX_DELAY) != pdTRUE)
+        {
+            continue;
+        }
+
+        const udp_batch_t *b = &s_batches[idx];
+
+        const u16_t len = (u16_t)(UDP_STREAM_HDR_SIZE + b->count * UDP_STREAM_SAMPLE_SIZE);
+
+        if (send_payload(b->data, len))
+        {
+            s_stats.datagrams++;
+            s_stats.samples += b->count;
+        }
+        else
+        {
+            s_stats.send_errors++;
+            s_stats.dropped += b->count;
+        }
+
+        (void)xQueueSend(s_free, &idx, 0);
+    }
+}
+
+/**
+ * @brief O sink de registros espera o socket e o Wi‑Fi (desligado, consome e descarta).
+ */
+static bool record_sink_healthy(void *ctx)
+{
+    (void)ctx;
+    return !s_enabled || (s_net_ready && wifi_manager_is_connected());
+}
+
+/**
+ * @brief Acrescenta um registro ao payload e envia a cada `UDP_STREAM_RECORD_BATCH`.
+ */
+static bool record_sink_publish(void *ctx, const telemetry_record_t *rec)
+{
+    (void)ctx;
+
+    if (!s_enabled || !s_net_ready)
+    {
+        s_rec_open = false;
+        return true;
+    }
+
+    if (!s_rec_open)
+    {
+        s_rec_open = telemetry_codec_begin(&s_rec_writer, s_rec_payload, sizeof(s_rec_payload));
+    }
+
+    (void)telemetry_codec_add(&s_rec_writer, rec);
+
+    if (s_rec_writer.count < UDP_STREAM_RECORD_BATCH)
+    {
+        return true;
+    }
+
+    const size_t len = telemetry_codec_finish(&s_rec_writer);
+    s_rec_open = false;
+
+    if (!send_payload(s_rec_payload, (u16_t)len))
+    {
+        s_stats.send_errors++;
+        return false;
+    }
+
+    s_stats.record_datagrams++;
+    return true;
+}
+
+const telemetry_sink_t udp_stream_record_sink = {
+    .name = "UdpRecordSink",
+    .begin = NULL,
+    .publish = record_sink_publish,
+    .flush = NULL,
+    .healthy = record_sink_healthy,
+    .ctx = NULL,
+    .accept = TELEMETRY_ACCEPT_ALL,
+    .queue_len = UDP_STREAM_RECORD_BATCH,
+    .stack_words = 512,
+    .priority = tskIDLE_PRIORITY + 1,
+    .idle_flush_ms = 0,
+};
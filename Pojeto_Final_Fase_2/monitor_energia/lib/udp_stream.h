@@ -0,0 +1,52 @@
+/**
+ * @file udp_stream.h
+ * @brief Fluxo UDP binário das amostras instantâneas e dos registros de 1 Hz.
+ * @details
+ *  Desligado por padrão: o coletor precisa ser informado em `credentials.h`
+ *  (`UDP_STREAM_HOST`), e o fluxo é ligado por `UDP_STREAM_ENABLED 1` no
+ *  mesmo arquivo ou pelo comando serial `udp on`. Não há destino broadcast.
+ */
+
+#ifndef UDP_STREAM_H
+#define UDP_STREAM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "credentials.h"
+#include "lib/telemetry.h"
+
+#ifndef UDP_STREAM_HOST
+#define UDP_STREAM_HOST             ""                  /**< Coletor (IP/hostname); vazio deixa o fluxo indisponível. */
+#endif
+#ifndef UDP_STREAM_ENABLED
+#define UDP_STREAM_ENABLED          0                   /**< Liga o fluxo no boot (senão, comando `udp on`). */
+#endif
+#ifndef UDP_STREAM_PORT
+#define UDP_STREAM_PORT             5005U               /**< Porta UDP do coletor. */
+#endif
+
+#define UDP_STREAM_BATCH_SAMPLES    32U     /**< Amostras por datagrama. */
+#define UDP_STREAM_BATCHES          4U      /**< Datagramas em preparo/aguardando envio. */
+#define UDP_STREAM_RECORD_BATCH     10U     /**< Registros de telemetria por datagrama. */
+
+/** @brief Contadores do fluxo. */
+typedef struct
+{
+    uint32_t datagrams;     /**< Datagramas enviados. */
+    uint32_t samples;       /**< Amostras enviadas. */
+    uint32_t dropped;       /**< Amostras descartadas (offline, desabilitado ou sem buffer). */
+    uint32_t record_datagrams;  /**< Datagramas de registros (telemetry_codec) enviados. */
+    uint32_t send_errors;   /**< Falhas de pbuf_alloc/udp_sendto. */
+} udp_stream_stats_t;
+
+void udp_stream_init(void);
+void udp_stream_push(uint64_t t_us, float v, float i);
+void udp_stream_flush(void);
+bool udp_stream_set_enabled(bool enabled);
+bool udp_stream_is_enabled(void);
+void udp_stream_get_stats(udp_stream_stats_t *out);
+void udp_stream_task(void *params);
+
+extern const telemetry_sink_t udp_stream_record_sink;   /**< Sink de registros em lote (binário). */
+
+#endif /* UDP_STREAM_H */
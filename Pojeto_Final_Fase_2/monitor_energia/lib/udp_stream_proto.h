@@ -0,0 +1,207 @@
+/**
+ * @file udp_stream_proto.h
+ * @brief Formato binário dos datagramas do fluxo UDP de amostras (firmware e host).
+ * @details
+ *  Todos os campos são little-endian e escritos byte a byte (sem structs
+ *  empacotadas), de modo que o mesmo cabeçalho compila no Pico e no PC.
+ *
+ *  Datagrama = cabeçalho (24 bytes) + `count` registros de amostra (6 bytes):
+ *
+ *  | off | tam | campo                                              |
+ *  |-----|-----|----------------------------------------------------|
+ *  |  0  |  2  | magic "EM"                                         |
+ *  |  2  |  1  | versão (`UDP_STREAM_VERSION`)                      |
+ *  |  3  |  1  | tipo (`UDP_STREAM_TYPE_SAMPLES`)                   |
+ *  |  4  |  2  | count: registros no datagrama                      |
+ *  |  6  |  2  | taxa nominal de amostragem (Hz)                    |
+ *  |  8  |  4  | seq da primeira amostra (contínuo desde o boot)    |
+ *  | 12  |  4  | t0_ms: instante da primeira amostra (ms desde boot)|
+ *  | 16  |  8  | t0_unix_us: mesmo instante em tempo Unix (µs, i64) |
+ *
+ *  Registro de amostra: dt (u16, relativo à primeira amostra, em unidades
+ *  de `UDP_STREAM_DT_UNIT_US`), tensão instantânea em cV (i16) e corrente
+ *  instantânea em cA (i16).
+ *
+ *  `t0_unix_us` vem do relógio disciplinado por NTP (`time_sync`) e vale 0
+ *  enquanto o relógio não foi sincronizado; com ele, amostras de medidores
+ *  diferentes podem ser alinhadas na mesma escala de tempo. A versão 1
+ *  (cabeçalho de 16 bytes, dt em ms) ainda é aceita na leitura.
+ */
+
+#ifndef UDP_STREAM_PROTO_H
+#define UDP_STREAM_PROTO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define UDP_STREAM_MAGIC0           'E'     /**< Primeiro byte do magic. */
+#define UDP_STREAM_MAGIC1           'M'     /**< Segundo byte do magic. */
+#define UDP_STREAM_VERSION          2U      /**< Versão do formato. */
+#define UDP_STREAM_VERSION_V1       1U      /**< Versão anterior (sem t0_unix_us, dt em ms). */
+#define UDP_STREAM_TYPE_SAMPLES     1U      /**< Datagrama de amostras instantâneas. */
+
+#define UDP_STREAM_HDR_SIZE         24U     /**< Bytes do cabeçalho. */
+#define UDP_STREAM_HDR_SIZE_V1      16U     /**< Bytes do cabeçalho na versão 1. */
+#define UDP_STREAM_SAMPLE_SIZE      6U      /**< Bytes por registro de amostra. */
+#define UDP_STREAM_SCALE            100.0f  /**< Unidades por V/A nos registros (cV, cA). */
+#define UDP_STREAM_DT_UNIT_US       10U     /**< Resolução de `dt` (µs); cobre até ~655 ms por datagrama. */
+#define UDP_STREAM_DT_UNIT_US_V1    1000U   /**< Resolução de `dt` na versão 1. */
+
+/** @brief Cabeçalho decodificado. */
+typedef struct
+{
+    uint8_t version;    /**< Versão do formato. */
+    uint8_t type;       /**< `UDP_STREAM_TYPE_*`. */
+    uint16_t count;     /**< Registros no datagrama. */
+    uint16_t rate_hz;   /**< Taxa nominal de amostragem. */
+    uint32_t seq;       /**< Sequência da primeira amostra. */
+    uint32_t t0_ms;     /**< Instante da primeira amostra (ms desde o boot). */
+    int64_t t0_unix_us; /**< Instante da primeira amostra em tempo Unix (0: relógio sem NTP). */
+    uint16_t hdr_size;  /**< Bytes do cabeçalho lido (início dos registros). */
+    uint16_t dt_unit_us; /**< Resolução de `dt` neste datagrama. */
+} udp_stream_hdr_t;
+
+/** @brief Amostra decodificada. */
+typedef struct
+{
+    uint16_t dt;        /**< Deslocamento em relação à primeira amostra (`dt_unit_us`). */
+    int16_t v_cv;       /**< Tensão instantânea [cV]. */
+    int16_t i_ca;       /**< Corrente instantânea [cA]. */
+} udp_stream_sample_t;
+
+static inline void udp_stream_put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void udp_stream_put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static inline void udp_stream_put_u64(uint8_t *p, uint64_t v)
+{
+    udp_stream_put_u32(&p[0], (uint32_t)v);
+    udp_stream_put_u32(&p[4], (uint32_t)(v >> 32));
+}
+
+static inline uint16_t udp_stream_get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | ((uint16_t)p[1] << 8));
+}
+
+static inline uint32_t udp_stream_get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint64_t udp_stream_get_u64(const uint8_t *p)
+{
+    return (uint64_t)udp_stream_get_u32(&p[0]) | ((uint64_t)udp_stream_get_u32(&p[4]) << 32);
+}
+
+/**
+ * @brief Converte V/A para cV/cA com saturação em int16.
+ */
+static inline int16_t udp_stream_to_centi(float x)
+{
+    const float s = x * UDP_STREAM_SCALE;
+
+    if (!(s == s))
+    {
+        return 0;
+    }
+    if (s >= 32767.0f)
+    {
+        return INT16_MAX;
+    }
+    if (s <= -32768.0f)
+    {
+        return INT16_MIN;
+    }
+    return (int16_t)(s < 0.0f ? s - 0.5f : s + 0.5f);
+}
+
+/**
+ * @brief Escreve o cabeçalho em `p` (`UDP_STREAM_HDR_SIZE` bytes).
+ */
+static inline void udp_stream_put_header(uint8_t *p, const udp_stream_hdr_t *h)
+{
+    p[0] = (uint8_t)UDP_STREAM_MAGIC0;
+    p[1] = (uint8_t)UDP_STREAM_MAGIC1;
+    p[2] = h->version;
+    p[3] = h->type;
+    udp_stream_put_u16(&p[4], h->count);
+    udp_stream_put_u16(&p[6], h->rate_hz);
+    udp_stream_put_u32(&p[8], h->seq);
+    udp_stream_put_u32(&p[12], h->t0_ms);
+    udp_stream_put_u64(&p[16], (uint64_t)h->t0_unix_us);
+}
+
+/**
+ * @brief Lê e valida o cabeçalho de um datagrama (versões 1 e 2).
+ * @return true se magic/versão conferem e `len` comporta `count` registros.
+ * @note Os registros começam em `h->hdr_size`; na versão 1 `t0_unix_us` é 0.
+ */
+static inline bool udp_stream_get_header(const uint8_t *p, size_t len, udp_stream_hdr_t *h)
+{
+    if (len < UDP_STREAM_HDR_SIZE_V1 || p[0] != (uint8_t)UDP_STREAM_MAGIC0 ||
+        p[1] != (uint8_t)UDP_STREAM_MAGIC1)
+    {
+        return false;
+    }
+
+    if (p[2] == UDP_STREAM_VERSION && len >= UDP_STREAM_HDR_SIZE)
+    {
+        h->hdr_size = UDP_STREAM_HDR_SIZE;
+        h->dt_unit_us = UDP_STREAM_DT_UNIT_US;
+        h->t0_unix_us = (int64_t)udp_stream_get_u64(&p[16]);
+    }
+    else if (p[2] == UDP_STREAM_VERSION_V1)
+    {
+        h->hdr_size = UDP_STREAM_HDR_SIZE_V1;
+        h->dt_unit_us = UDP_STREAM_DT_UNIT_US_V1;
+        h->t0_unix_us = 0;
+    }
+    else
+    {
+        return false;
+    }
+
+    h->version = p[2];
+    h->type = p[3];
+    h->count = udp_stream_get_u16(&p[4]);
+    h->rate_hz = udp_stream_get_u16(&p[6]);
+    h->seq = udp_stream_get_u32(&p[8]);
+    h->t0_ms = udp_stream_get_u32(&p[12]);
+
+    return h->type != UDP_STREAM_TYPE_SAMPLES ||
+           len >= h->hdr_size + (size_t)h->count * UDP_STREAM_SAMPLE_SIZE;
+}
+
+/**
+ * @brief Escreve um registro de amostra em `p` (`UDP_STREAM_SAMPLE_SIZE` bytes).
+ */
+static inline void udp_stream_put_sample(uint8_t *p, const udp_stream_sample_t *s)
+{
+    udp_stream_put_u16(&p[0], s->dt);
+    udp_stream_put_u16(&p[2], (uint16_t)s->v_cv);
+    udp_stream_put_u16(&p[4], (uint16_t)s->i_ca);
+}
+
+/**
+ * @brief Lê um registro de amostra de `p`.
+ */
+static inline void udp_stream_get_sample(const uint8_t *p, udp_stream_sample_t *s)
+{
+    s->dt = udp_stream_get_u16(&p[0]);
+    s->v_cv = (int16_t)udp_stream_get_u16(&p[2]);
+    s->i_ca = (int16_t)udp_stream_get_u16(&p[4]);
+}
+
+#endif /* UDP_STREAM_PROTO_H */
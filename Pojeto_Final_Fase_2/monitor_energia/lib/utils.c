@@ -1,9 +1,20 @@
 /**
  * @file utils.c
  * @brief Utilitários diversos (DNS com lwIP).
+ * @details
+ *  Cada resolução usa um slot estático (semáforo criado uma vez e nunca
+ *  apagado) marcado com uma geração. O callback do lwIP só escreve no slot
+ *  se a geração ainda for a da consulta que o pediu: uma resposta que chega
+ *  depois do timeout (as retransmissões do lwIP podem passar dele) é
+ *  ignorada, em vez de escrever na pilha de quem já desistiu. As chamadas
+ *  ao lwIP e as trocas de geração ficam sob `cyw43_arch_lwip_begin/end`.
+ *
+ *  O servidor DNS é definido pelo `wifi_manager` ao subir o link.
  */
 
 #include "utils.h"
+#include <stdint.h>
+#include "pico/cyw43_arch.h"
 #include "lwip/dns.h"
 #include "lwip/ip4_addr.h"
 #include "FreeRTOS.h"
@@ -12,34 +23,86 @@
 
 #define TAG "utils"
 
+/** @brief Slot de uma resolução em andamento. */
+typedef struct
+{
+    SemaphoreHandle_t sem;      /**< Sinal da resposta (criado uma vez). */
+    volatile uint32_t gen;      /**< Geração da consulta corrente; callbacks de outras são ignorados. */
+    bool busy;                  /**< Slot em uso por uma task. */
+    ip_addr_t ip;               /**< Endereço resolvido. */
+    err_t result;               /**< ERR_INPROGRESS até o callback. */
+} dns_slot_t;
+
+static dns_slot_t s_slots[UTILS_DNS_SLOTS];
+
 /**
- * @brief Callback interno de resolução DNS (lwIP).
+ * @brief Callback interno de resolução DNS (contexto do lwIP).
  * @param name Host solicitado.
  * @param ipaddr Resultado (se sucesso).
- * @param arg Contexto com semáforo e destino de IP.
+ * @param arg Slot e geração da consulta (`geração * UTILS_DNS_SLOTS + slot`).
  */
 static void dns_cb(const char *name, const ip_addr_t *ipaddr, void *arg)
 {
     (void)name;
 
-    struct
+    const uintptr_t tag = (uintptr_t)arg;
+    const uint32_t idx = (uint32_t)(tag % UTILS_DNS_SLOTS);
+    dns_slot_t *s = &s_slots[idx];
+
+    if ((uintptr_t)(s->gen * UTILS_DNS_SLOTS + idx) != tag)
     {
-        SemaphoreHandle_t sem;
-        ip_addr_t *out;
-        err_t result;
-    } *ctx = (typeof(ctx))arg;
+        return; /* A consulta já desistiu */
+    }
 
+    s->gen++;
     if (ipaddr)
     {
-        *(ctx->out) = *ipaddr;
-        ctx->result = ERR_OK;
+        s->ip = *ipaddr;
+    }
+    s->result = ipaddr ? ERR_OK : ERR_VAL;
+
+    if (portCHECK_IF_IN_ISR())
+    {
+        BaseType_t hp = pdFALSE;
+        xSemaphoreGiveFromISR(s->sem, &hp);
+        portYIELD_FROM_ISR(hp);
     }
     else
     {
-        ctx->result = ERR_VAL;
+        xSemaphoreGive(s->sem);
+    }
+}
+
+/**
+ * @brief Reserva um slot livre (cria o semáforo no primeiro uso).
+ * @return Índice do slot ou -1.
+ */
+static int8_t slot_acquire(void)
+{
+    int8_t idx = -1;
+
+    taskENTER_CRITICAL();
+    for (uint8_t i = 0; i < UTILS_DNS_SLOTS; i++)
+    {
+        if (!s_slots[i].busy)
+        {
+            s_slots[i].busy = true;
+            idx = (int8_t)i;
+            break;
+        }
     }
+    taskEXIT_CRITICAL();
 
-    xSemaphoreGive(ctx->sem);
+    if (idx >= 0 && !s_slots[idx].sem)
+    {
+        s_slots[idx].sem = xSemaphoreCreateBinary();
+        if (!s_slots[idx].sem)
+        {
+            s_slots[idx].busy = false;
+            return -1;
+        }
+    }
+    return idx;
 }
 
 /**
@@ -48,7 +111,7 @@ static void dns_cb(const char *name, const ip_addr_t *ipaddr, void *arg)
  * @param[out] out_ip Endereço IPv4 de saída.
  * @param timeout_ms Tempo máximo de espera (ms).
  * @return true em sucesso; false em timeout/erro.
- * @note Define o DNS primário como 8.8.8.8 antes de resolver.
+ * @note Até `UTILS_DNS_SLOTS` tasks resolvem ao mesmo tempo; além disso falha na hora.
  */
 bool utils_resolve_dns(const char *hostname, ip_addr_t *out_ip, uint32_t timeout_ms)
 {
@@ -57,53 +120,56 @@ bool utils_resolve_dns(const char *hostname, ip_addr_t *out_ip, uint32_t timeout
         return false;
     }
 
-    ip_addr_t dns_server;
-    IP4_ADDR(&dns_server, 8, 8, 8, 8);
-    dns_setserver(0, &dns_server);
-    LOG(TAG, "Servidor DNS primário: 8.8.8.8");
-    LOG(TAG, "Resolvendo hostname: %s", hostname);
-
-    struct
+    const int8_t idx = slot_acquire();
+    if (idx < 0)
     {
-        SemaphoreHandle_t sem;
-        ip_addr_t *out;
-        err_t result;
-    } ctx = {0};
+        LOGW(TAG, "Sem slot DNS livre para %s.", hostname);
+        return false;
+    }
+
+    dns_slot_t *s = &s_slots[idx];
+    ip_addr_t ip;
+
+    LOGD(TAG, "Resolvendo hostname: %s", hostname);
 
-    ctx.out = out_ip;
-    ctx.result = ERR_INPROGRESS;
-    ctx.sem = xSemaphoreCreateBinary();
+    /* Resposta atrasada de uma consulta anterior que já tinha desistido */
+    (void)xSemaphoreTake(s->sem, 0);
 
-    if (!ctx.sem)
+    cyw43_arch_lwip_begin();
+    s->gen++;
+    s->result = ERR_INPROGRESS;
+    err_t err = dns_gethostbyname(hostname, &ip, dns_cb,
+                                  (void *)(uintptr_t)(s->gen * UTILS_DNS_SLOTS + (uint32_t)idx));
+    cyw43_arch_lwip_end();
+
+    if (err == ERR_INPROGRESS)
     {
-        LOG(TAG, "Falha ao criar semáforo DNS.");
-        return false;
+        (void)xSemaphoreTake(s->sem, pdMS_TO_TICKS(timeout_ms));
+
+        /* Invalida a consulta: um callback depois daqui é ignorado */
+        cyw43_arch_lwip_begin();
+        s->gen++;
+        err = s->result;
+        ip = s->ip;
+        cyw43_arch_lwip_end();
     }
 
-    err_t err = dns_gethostbyname(hostname, out_ip, dns_cb, &ctx);
+    s->busy = false;
 
     if (err == ERR_OK)
     {
-        LOG(TAG, "Hostname resolvido imediatamente: %s", ip4addr_ntoa(out_ip));
-        vSemaphoreDelete(ctx.sem);
+        *out_ip = ip;
+        LOGD(TAG, "Hostname resolvido: %s", ip4addr_ntoa(out_ip));
         return true;
     }
 
-    if (err != ERR_INPROGRESS)
+    if (err == ERR_INPROGRESS)
     {
-        LOG(TAG, "dns_gethostbyname falhou (err=%d)", (int)err);
-        vSemaphoreDelete(ctx.sem);
-        return false;
+        LOGW(TAG, "Timeout resolvendo %s", hostname);
     }
-
-    if (xSemaphoreTake(ctx.sem, pdMS_TO_TICKS(timeout_ms)) == pdTRUE && ctx.result == ERR_OK)
+    else
     {
-        LOG(TAG, "Hostname resolvido: %s", ip4addr_ntoa(out_ip));
-        vSemaphoreDelete(ctx.sem);
-        return true;
+        LOGW(TAG, "Erro resolvendo %s (err=%d)", hostname, (int)err);
     }
-
-    LOG(TAG, "Timeout/erro resolvendo %s", hostname);
-    vSemaphoreDelete(ctx.sem);
     return false;
 }
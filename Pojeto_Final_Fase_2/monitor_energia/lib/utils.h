@@ -10,6 +10,8 @@
 #include <stdint.h>
 #include "lwip/ip_addr.h"
 
+#define UTILS_DNS_SLOTS     4U      /**< Resoluções simultâneas (NTP, MQTT, UDP, ThingSpeak). */
+
 bool utils_resolve_dns(const char *hostname, ip_addr_t *out_ip, uint32_t timeout_ms);
 
 #endif /* UTILS_H */
@@ -2,8 +2,36 @@
  * @file wifi_manager.c
  * @brief Gerenciador de conexão Wi‑Fi usando cyw43 (threadsafe background).
  * @details
- *  Mantém tentativa de conexão com backoff exponencial, publica estado e,
- *  quando a conexão sobe, sincroniza o RTC via NTP uma vez.
+ *  Mantém tentativa de conexão com backoff exponencial e publica o estado
+ *  (a hora é mantida por `time_sync`, que assina as transições).
+ *
+ *  Transições de link e de IP chegam pelos callbacks de netif do lwIP como
+ *  eventos em uma fila; a task bloqueia nela até um evento ou o fim do
+ *  backoff (não há varredura periódica). Outras tasks recebem UP/DOWN
+ *  registrando-se com `wifi_manager_subscribe()`.
+ *
+ *  A cada conexão bem-sucedida guarda BSSID e canal do AP. Após uma queda a
+ *  primeira tentativa é uma reassociação direcionada (sem varredura) a esse
+ *  AP, logo em seguida; só se ela falhar usa-se o caminho completo. O lease
+ *  DHCP é mantido pelo lwIP, que ao religar o link faz INIT‑REBOOT (um único
+ *  REQUEST do mesmo IP); com `WIFI_STATIC_IP` definido em credentials.h o
+ *  DHCP é desligado. O tempo entre a queda e o IP de volta é medido.
+ *
+ *  Nenhuma chamada bloqueia a task: a associação é só disparada
+ *  (`cyw43_wifi_join` / `cyw43_arch_wifi_connect_async`) e uma máquina de
+ *  estados (JOINING -> WAIT_IP -> conectado) avança com os eventos da netif e
+ *  com os prazos de cada etapa. Assim `wifi_manager_force_reconnect()` e
+ *  `wifi_manager_cancel_connect()` valem imediatamente, mesmo no meio de uma
+ *  tentativa.
+ *
+ *  Com `WIFI_POWER_SAVE` o rádio fica em `CYW43_AGGRESSIVE_PM` enquanto
+ *  conectado e ocioso. Quem transmite em horários conhecidos registra-se com
+ *  `wifi_manager_tx_register()` e declara o próximo envio com
+ *  `wifi_manager_tx_schedule()`; o gerenciador passa a `CYW43_PERFORMANCE_PM`
+ *  pouco antes do prazo e volta à economia depois. Quem transmite sem
+ *  horário (fluxo UDP ligado, conexão HTTP aberta) segura o rádio acordado
+ *  com `wifi_manager_tx_hold()`. O tempo em cada modo é contado em
+ *  `wifi_manager_get_pm_stats()`.
  */
 
 #include "lib/wifi_manager.h"
@@ -11,20 +39,69 @@
 #include "pico/cyw43_arch.h"
 #include "FreeRTOS.h"
 #include "task.h"
-#include "lib/rtc_ntp.h"
+#include "queue.h"
+#include "lwip/netif.h"
+#include "lwip/dhcp.h"
+#include "lwip/dns.h"
+#include "credentials.h"
 #include "lib/logger.h"
+#include "lib/rtos_stats.h"
 
 #define TAG "wifi_manager"
 
-#define WIFI_NTP_HOST           "pool.ntp.org"  /**< Host NTP para sincronizar RTC. */
-#define WIFI_NTP_TIMEOUT_MS     5000U           /**< Timeout da sincronização NTP. */
 #define WIFI_BACKOFF_MIN_MS     3000U           /**< Backoff mínimo entre tentativas. */
 #define WIFI_BACKOFF_MAX_MS     300000U         /**< Backoff máximo entre tentativas. */
 #define WIFI_CONNECT_GUARD_MS   12000U          /**< Janela de guarda após transições. */
-#define WIFI_CONNECT_TIMEOUT_MS 20000U          /**< Timeout de `connect_timeout_ms`. */
-#define WIFI_TICK_PERIOD_MS     100U            /**< Período de varredura da task. */
+#define WIFI_CONNECT_TIMEOUT_MS 20000U          /**< Limite da associação pelo caminho completo. */
+#define WIFI_SAFETY_POLL_MS     10000U          /**< Releitura do link sem eventos (rede de segurança). */
+#define WIFI_EVENT_QUEUE_LEN    8U              /**< Profundidade da fila de eventos. */
+#define WIFI_FAST_JOIN_TIMEOUT_MS 4000U         /**< Limite da reassociação direcionada. */
+#define WIFI_DHCP_TIMEOUT_MS    12000U          /**< Associado -> IP antes de desistir da tentativa. */
+#define WIFI_PM_WAKE_LEAD_MS    2000U           /**< Antecedência com que o rádio acorda antes de um envio. */
+#define WIFI_PM_HOLD_MS         10000U          /**< Rádio acordado após o prazo se o cliente não reagendar. */
 
-static bool s_ntp_synced_once = false;
+/** @brief AP da última conexão bem-sucedida. */
+typedef struct
+{
+    bool valid;             /**< Há dados do AP. */
+    uint8_t bssid[6];       /**< BSSID do AP. */
+    uint32_t channel;       /**< Canal (ou `CYW43_CHANNEL_NONE`). */
+    uint32_t ip;            /**< Último IP (ordem de rede). */
+} wifi_ap_cache_t;
+
+/** @brief Eventos entregues à task do gerenciador. */
+typedef enum
+{
+    WIFI_EVT_NETIF_LINK = 0,    /**< Callback de link da netif (cyw43 associou/perdeu AP). */
+    WIFI_EVT_NETIF_STATUS,      /**< Callback de status da netif (IP atribuído/removido). */
+    WIFI_EVT_FORCE_RECONNECT,   /**< `wifi_manager_force_reconnect()`. */
+    WIFI_EVT_CANCEL,            /**< `wifi_manager_cancel_connect()`. */
+    WIFI_EVT_TX_SCHEDULE,       /**< Um cliente declarou o próximo envio. */
+} wifi_event_t;
+
+/** @brief Etapa da tentativa de conexão em curso. */
+typedef enum
+{
+    WIFI_CONN_IDLE = 0,         /**< Sem tentativa (conectado ou aguardando a próxima). */
+    WIFI_CONN_JOINING,          /**< Associação pedida, aguardando o AP. */
+    WIFI_CONN_WAIT_IP,          /**< Associado, aguardando DHCP. */
+} wifi_conn_state_t;
+
+/** @brief Cliente que declara o próximo envio. */
+typedef struct
+{
+    const char *name;       /**< Nome (log). */
+    bool pending;           /**< Há envio previsto. */
+    volatile bool hold;     /**< Rádio acordado enquanto verdadeiro (`tx_hold`). */
+    uint32_t due_ms;        /**< Instante previsto do envio (ms desde o boot). */
+} wifi_tx_client_t;
+
+/** @brief Assinante de transições UP/DOWN. */
+typedef struct
+{
+    wifi_link_cb_t cb;
+    void *ctx;
+} wifi_subscriber_t;
 
 static char g_ssid[64];
 static char g_pass[64];
@@ -38,6 +115,31 @@ static uint32_t g_backoff_ms = 0;
 static int g_prev_link = -999;
 static uint32_t g_attempt = 0;
 
+static QueueHandle_t s_events = NULL;
+static netif_status_callback_fn s_prev_status_cb = NULL;
+static netif_status_callback_fn s_prev_link_cb = NULL;
+static wifi_subscriber_t s_subs[WIFI_MAX_SUBSCRIBERS];
+static uint8_t s_sub_count = 0;
+static uint32_t s_event_count = 0;
+
+static wifi_ap_cache_t s_ap;
+static bool s_try_fast = false;
+static uint32_t s_loss_at_ms = 0;       /**< Instante da queda (0 = sem queda pendente). */
+static uint32_t s_attempt_at_ms = 0;    /**< Início da tentativa corrente. */
+static uint32_t s_assoc_at_ms = 0;      /**< Associação observada na tentativa corrente. */
+static wifi_manager_stats_t s_stats;
+
+static wifi_conn_state_t s_conn = WIFI_CONN_IDLE;
+static uint32_t s_deadline_ms = 0;      /**< Limite da etapa corrente de `s_conn`. */
+static bool s_paused = false;           /**< Reconexão automática suspensa por cancelamento. */
+
+static wifi_tx_client_t s_tx[WIFI_MAX_TX_CLIENTS];
+static uint8_t s_tx_count = 0;
+static wifi_pm_stats_t s_pm;            /**< Modo corrente começa em `WIFI_PM_DEFAULT` (padrão do driver). */
+static uint32_t s_pm_since_ms = 0;      /**< Início do modo corrente (contabilidade). */
+static bool s_pm_recheck = false;       /**< Há reavaliação de modo agendada. */
+static uint32_t s_pm_recheck_ms = 0;    /**< Instante da reavaliação. */
+
 /**
  * @brief Timestamp corrente em milissegundos desde o boot.
  */
@@ -85,18 +187,170 @@ static void log_current_ip(void)
  */
 static void log_rssi_if_available(void)
 {
-    int rssi = cyw43_wifi_get_rssi(&cyw43_state, CYW43_ITF_STA);
+    int32_t rssi;
+
+    if (wifi_manager_get_rssi(&rssi))
+    {
+        LOGD(TAG, "RSSI: %d dBm", (int)rssi);
+    }
+}
+
+/**
+ * @brief Enfileira um evento para a task (seguro em callback do lwIP/IRQ).
+ * @note Fila cheia descarta o evento: a task relê o estado real de qualquer forma.
+ */
+static void post_event(wifi_event_t evt)
+{
+    if (!s_events)
+    {
+        return;
+    }
+
+    const uint8_t e = (uint8_t)evt;
+
+    if (portCHECK_IF_IN_ISR())
+    {
+        BaseType_t hp = pdFALSE;
+        (void)xQueueSendFromISR(s_events, &e, &hp);
+        portYIELD_FROM_ISR(hp);
+    }
+    else
+    {
+        (void)xQueueSend(s_events, &e, 0);
+    }
+}
+
+/**
+ * @brief Callback de status da netif STA (IP atribuído/removido, netif up/down).
+ */
+static void netif_status_cb(struct netif *netif)
+{
+    if (s_prev_status_cb)
+    {
+        s_prev_status_cb(netif);
+    }
+
+    post_event(WIFI_EVT_NETIF_STATUS);
+}
+
+/**
+ * @brief Callback de link da netif STA (associação com o AP).
+ */
+static void netif_link_cb(struct netif *netif)
+{
+    if (s_prev_link_cb)
+    {
+        s_prev_link_cb(netif);
+    }
+
+    post_event(WIFI_EVT_NETIF_LINK);
+}
+
+/**
+ * @brief Avisa os assinantes de uma transição UP/DOWN (contexto da task).
+ */
+static void notify_subscribers(bool up)
+{
+    for (uint8_t i = 0; i < s_sub_count; i++)
+    {
+        s_subs[i].cb(up, s_subs[i].ctx);
+    }
+}
+
+/**
+ * @brief Guarda BSSID, canal e IP do AP atual para a reassociação rápida.
+ */
+static void cache_current_ap(void)
+{
+    wifi_ap_cache_t ap = {0};
+    ap.channel = CYW43_CHANNEL_NONE;
+
+    cyw43_arch_lwip_begin();
+    const int rc = cyw43_wifi_get_bssid(&cyw43_state, ap.bssid);
+#ifdef CYW43_IOCTL_GET_CHANNEL
+    uint32_t chinfo[3] = {0}; /* channel_info_t: hw, target, scan */
+    if (cyw43_ioctl(&cyw43_state, CYW43_IOCTL_GET_CHANNEL, sizeof(chinfo), (uint8_t *)chinfo,
+                    CYW43_ITF_STA) == 0 &&
+        chinfo[0] >= 1U && chinfo[0] <= 14U)
+    {
+        ap.channel = chinfo[0];
+    }
+#endif
+    ap.ip = ip4_addr_get_u32(netif_ip4_addr(&cyw43_state.netif[CYW43_ITF_STA]));
+    cyw43_arch_lwip_end();
+
+    if (rc != 0)
+    {
+        return;
+    }
+
+    ap.valid = true;
+    s_ap = ap;
+    LOG(TAG, "AP: %02x:%02x:%02x:%02x:%02x:%02x canal %d", ap.bssid[0], ap.bssid[1], ap.bssid[2],
+        ap.bssid[3], ap.bssid[4], ap.bssid[5],
+        ap.channel == CYW43_CHANNEL_NONE ? -1 : (int)ap.channel);
+}
+
+/**
+ * @brief Define o DNS primário (8.8.8.8) uma vez a cada subida do link.
+ * @note Uma renovação do DHCP pode trocá-lo pelo servidor da rede, que também serve.
+ */
+static void set_dns_server(void)
+{
+    ip_addr_t dns;
+    IP4_ADDR(&dns, 8, 8, 8, 8);
+
+    cyw43_arch_lwip_begin();
+    dns_setserver(0, &dns);
+    cyw43_arch_lwip_end();
+}
+
+/**
+ * @brief Registra os tempos da conexão que acabou de subir.
+ */
+static void record_connect_timing(void)
+{
+    const uint32_t now = now_ms();
+
+    if (s_attempt_at_ms)
+    {
+        const uint32_t assoc = s_assoc_at_ms ? s_assoc_at_ms : now;
+        s_stats.last_join_ms = assoc - s_attempt_at_ms;
+        s_stats.last_ip_ms = now - assoc;
+        s_stats.last_attempt_ms = now - s_attempt_at_ms;
+        s_stats.last_fail = WIFI_FAIL_NONE;
+    }
 
-    if (rssi <= -10 && rssi >= -120)
+    int32_t rssi;
+    if (wifi_manager_get_rssi(&rssi))
     {
-        LOG(TAG, "RSSI: %d dBm", rssi);
+        s_stats.join_rssi_dbm = rssi;
     }
+
+    if (s_loss_at_ms)
+    {
+        const uint32_t outage = now - s_loss_at_ms;
+        s_stats.last_outage_ms = outage;
+        if (outage > s_stats.max_outage_ms)
+        {
+            s_stats.max_outage_ms = outage;
+        }
+        s_stats.outages++;
+        LOG(TAG, "Religado %u ms após a queda (%s; assoc. %u ms, IP %u ms).", (unsigned)outage,
+            s_stats.last_fast ? "reassociação rápida" : "caminho completo",
+            (unsigned)s_stats.last_join_ms, (unsigned)s_stats.last_ip_ms);
+    }
+
+    s_loss_at_ms = 0;
+    s_attempt_at_ms = 0;
+    s_assoc_at_ms = 0;
 }
 
 /**
  * @brief Atualiza o estado do link e executa ações associadas a transições.
+ * @return Status corrente de `cyw43_tcpip_link_status`.
  */
-static void update_link_state(void)
+static int update_link_state(void)
 {
     int st = cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA);
     bool up = (st == CYW43_LINK_UP);
@@ -104,29 +358,42 @@ static void update_link_state(void)
 
     if (st != g_prev_link)
     {
-        LOG(TAG, "Link status: %s -> %s", link_status_str(g_prev_link), link_status_str(st));
+        LOGD(TAG, "Link status: %s -> %s", link_status_str(g_prev_link), link_status_str(st));
+
+        if ((st == CYW43_LINK_JOIN || st == CYW43_LINK_NOIP) && s_attempt_at_ms && !s_assoc_at_ms)
+        {
+            s_assoc_at_ms = now_ms();
+        }
 
         if (up && g_prev_link != CYW43_LINK_UP)
         {
             log_current_ip();
             log_rssi_if_available();
+            record_connect_timing();
+            cache_current_ap();
+            set_dns_server();
+            s_conn = WIFI_CONN_IDLE;
 
-            if (!s_ntp_synced_once)
+            g_backoff_ms = WIFI_BACKOFF_MIN_MS;
+            notify_subscribers(true);
+        }
+        else if (!up && g_prev_link == CYW43_LINK_UP)
+        {
+            s_loss_at_ms = now_ms();
+
+            if (s_ap.valid)
+            {
+                /* Reassociação direcionada já, sem esperar a janela de guarda. */
+                s_try_fast = true;
+                g_next_try_ms = s_loss_at_ms;
+            }
+            else
             {
-                LOG(TAG, "Sincronizando RTC via NTP (%s)...", WIFI_NTP_HOST);
-                if (rtc_ntp_sync(WIFI_NTP_HOST, WIFI_NTP_TIMEOUT_MS))
-                {
-                    LOG(TAG, "RTC sincronizado via NTP.");
-                    s_ntp_synced_once = true;
-                }
-                else
-                {
-                    LOG(TAG, "Falha na sincronização NTP (mantendo RTC atual).");
-                }
+                /* Janela de guarda: o cyw43 pode reassociar sozinho. */
+                g_next_try_ms = s_loss_at_ms + WIFI_CONNECT_GUARD_MS;
             }
 
-            g_backoff_ms = WIFI_BACKOFF_MIN_MS;
-            g_next_try_ms = now_ms() + WIFI_CONNECT_GUARD_MS;
+            notify_subscribers(false);
         }
 
         g_prev_link = st;
@@ -136,33 +403,188 @@ static void update_link_state(void)
             g_backoff_ms = WIFI_BACKOFF_MIN_MS;
         }
     }
+
+    return st;
+}
+
+/**
+ * @brief Traduz um status negativo do cyw43 para o motivo de falha.
+ */
+static wifi_fail_reason_t fail_from_status(int st)
+{
+    switch (st)
+    {
+    case CYW43_LINK_NONET:
+        return WIFI_FAIL_NONET;
+    case CYW43_LINK_BADAUTH:
+        return WIFI_FAIL_BADAUTH;
+    default:
+        return WIFI_FAIL_JOIN;
+    }
+}
+
+/**
+ * @brief Encerra a tentativa em curso como falha e agenda a próxima.
+ * @param why Motivo registrado nas estatísticas.
+ * @details
+ *  Desfaz a associação pendente no cyw43. Se a tentativa que falhou era a
+ *  reassociação rápida, o caminho completo é tentado em seguida; cancelamentos
+ *  não agendam nada (quem cancelou decide); os demais casos seguem o backoff.
+ */
+static void attempt_failed(wifi_fail_reason_t why)
+{
+    const uint32_t now = now_ms();
+    const bool was_fast = s_stats.last_fast;
+
+    cyw43_arch_lwip_begin();
+    (void)cyw43_wifi_leave(&cyw43_state, CYW43_ITF_STA);
+    cyw43_arch_lwip_end();
+
+    s_stats.failures++;
+    s_stats.last_fail = why;
+    s_stats.last_attempt_ms = s_attempt_at_ms ? now - s_attempt_at_ms : 0;
+    s_conn = WIFI_CONN_IDLE;
+    s_attempt_at_ms = 0;
+    s_assoc_at_ms = 0;
+
+    LOGW(TAG, "Tentativa #%u falhou após %u ms (%s).", (unsigned)g_attempt,
+         (unsigned)s_stats.last_attempt_ms, wifi_manager_fail_str(why));
+
+    if (why == WIFI_FAIL_CANCELLED)
+    {
+        return;
+    }
+
+    if (was_fast)
+    {
+        g_next_try_ms = now;
+        return;
+    }
+
+    const uint32_t base = g_backoff_ms;
+    g_backoff_ms = (g_backoff_ms < WIFI_BACKOFF_MAX_MS)
+                       ? (g_backoff_ms * 2U)
+                       : WIFI_BACKOFF_MAX_MS;
+    const uint32_t jitter = g_backoff_ms / 10U;
+    const uint32_t j = jitter ? (rand() % jitter) : 0;
+    g_next_try_ms = now + g_backoff_ms + j;
+
+    LOGD(TAG, "Backoff: base=%u ms, next=%u ms (+jitter=%u)",
+         (unsigned)base, (unsigned)g_backoff_ms, (unsigned)j);
 }
 
 /**
- * @brief Tenta conectar uma vez com timeout definido.
+ * @brief Dispara uma tentativa sem bloquear: reassociação rápida se houver AP conhecido, senão completa.
+ * @details O resultado chega pelos callbacks da netif e é tratado em `advance_connect()`.
  */
-static void try_connect_once(void)
+static void start_attempt(void)
 {
     if (!g_arch_ok || g_ssid[0] == '\0')
     {
-        LOG(TAG, "try_connect_once(): arch_ok=%d, ssid='%s'", (int)g_arch_ok, g_ssid);
+        LOGD(TAG, "start_attempt(): arch_ok=%d, ssid='%s'", (int)g_arch_ok, g_ssid);
+        g_next_try_ms = now_ms() + WIFI_BACKOFF_MAX_MS;
         return;
     }
 
     ++g_attempt;
-    LOG(TAG, "Conectando (tentativa #%u) em \"%s\" ...", (unsigned)g_attempt, g_ssid);
+    s_attempt_at_ms = now_ms();
+    s_assoc_at_ms = 0;
 
-    int rc = cyw43_arch_wifi_connect_timeout_ms(
-        g_ssid, g_pass, CYW43_AUTH_WPA2_AES_PSK, WIFI_CONNECT_TIMEOUT_MS);
+    int rc;
+    uint32_t limit;
 
-    if (rc == 0)
+    if (s_try_fast && s_ap.valid)
     {
-        LOG(TAG, "Assoc. confirmada (aguardando DHCP/IP)");
-        update_link_state();
+        s_try_fast = false;
+        s_stats.last_fast = true;
+        s_stats.fast_attempts++;
+        limit = WIFI_FAST_JOIN_TIMEOUT_MS;
+        LOG(TAG, "Reassociação rápida (canal %d)...",
+            s_ap.channel == CYW43_CHANNEL_NONE ? -1 : (int)s_ap.channel);
+
+        cyw43_arch_lwip_begin();
+        rc = cyw43_wifi_join(&cyw43_state, strlen(g_ssid), (const uint8_t *)g_ssid,
+                             strlen(g_pass), (const uint8_t *)g_pass, CYW43_AUTH_WPA2_AES_PSK,
+                             s_ap.bssid, s_ap.channel);
+        cyw43_arch_lwip_end();
     }
     else
     {
-        LOG(TAG, "Sem confirmação dentro do timeout (rc=%d). Aguardando transições...", rc);
+        s_stats.last_fast = false;
+        s_stats.full_attempts++;
+        limit = WIFI_CONNECT_TIMEOUT_MS;
+        LOG(TAG, "Conectando (tentativa #%u) em \"%s\" ...", (unsigned)g_attempt, g_ssid);
+
+        rc = cyw43_arch_wifi_connect_async(g_ssid, g_pass, CYW43_AUTH_WPA2_AES_PSK);
+    }
+
+    if (rc != 0)
+    {
+        LOGW(TAG, "Início da associação recusado (rc=%d).", rc);
+        attempt_failed(WIFI_FAIL_START);
+        return;
+    }
+
+    s_conn = WIFI_CONN_JOINING;
+    s_deadline_ms = s_attempt_at_ms + limit;
+}
+
+/**
+ * @brief Avança a máquina de estados da conexão com o status corrente do link.
+ * @param st Status lido por `update_link_state()`.
+ */
+static void advance_connect(int st)
+{
+    const uint32_t now = now_ms();
+    const bool expired = (int32_t)(now - s_deadline_ms) >= 0;
+
+    if (g_connected)
+    {
+        s_conn = WIFI_CONN_IDLE;
+        return;
+    }
+
+    switch (s_conn)
+    {
+    case WIFI_CONN_JOINING:
+        if (st == CYW43_LINK_JOIN || st == CYW43_LINK_NOIP)
+        {
+            if (s_stats.last_fast)
+            {
+                s_stats.fast_ok++;
+            }
+            LOGD(TAG, "Assoc. confirmada (aguardando DHCP/IP)");
+            s_conn = WIFI_CONN_WAIT_IP;
+            s_deadline_ms = now + WIFI_DHCP_TIMEOUT_MS;
+        }
+        else if (st < 0)
+        {
+            attempt_failed(fail_from_status(st));
+        }
+        else if (expired)
+        {
+            attempt_failed(WIFI_FAIL_TIMEOUT);
+        }
+        break;
+
+    case WIFI_CONN_WAIT_IP:
+        if (st < 0 || st == CYW43_LINK_DOWN)
+        {
+            attempt_failed(fail_from_status(st));
+        }
+        else if (expired)
+        {
+            attempt_failed(WIFI_FAIL_DHCP);
+        }
+        break;
+
+    case WIFI_CONN_IDLE:
+    default:
+        if (!s_paused && (int32_t)(now - g_next_try_ms) >= 0)
+        {
+            start_attempt();
+        }
+        break;
     }
 }
 
@@ -184,23 +606,102 @@ void wifi_manager_init(const char *ssid, const char *pass)
     g_backoff_ms = 0;
     g_prev_link = -999;
     g_attempt = 0;
-
-    s_ntp_synced_once = false;
+    s_conn = WIFI_CONN_IDLE;
+    s_paused = false;
 
     LOG(TAG, "Inicializando CYW43...");
 
     if (cyw43_arch_init() != 0)
     {
-        LOG(TAG, "Falha em cyw43_arch_init()");
+        LOGE(TAG, "Falha em cyw43_arch_init()");
         g_arch_ok = false;
         return;
     }
 
     g_arch_ok = true;
     cyw43_arch_enable_sta_mode();
+
+    if (!s_events)
+    {
+        s_events = xQueueCreate(WIFI_EVENT_QUEUE_LEN, sizeof(uint8_t));
+        rtos_stats_watch_queue(s_events, "wifi_events");
+    }
+
+    /* A netif STA existe após enable_sta_mode; callbacks anteriores são encadeados. */
+    struct netif *n = &cyw43_state.netif[CYW43_ITF_STA];
+    cyw43_arch_lwip_begin();
+    if (n->status_callback != netif_status_cb)
+    {
+        s_prev_status_cb = n->status_callback;
+        netif_set_status_callback(n, netif_status_cb);
+    }
+    if (n->link_callback != netif_link_cb)
+    {
+        s_prev_link_cb = n->link_callback;
+        netif_set_link_callback(n, netif_link_cb);
+    }
+
+#ifdef WIFI_STATIC_IP
+    /* IP fixo: sem DHCP, o link fica UP assim que associa. */
+    ip4_addr_t ip, mask, gw;
+    if (ip4addr_aton(WIFI_STATIC_IP, &ip) && ip4addr_aton(WIFI_STATIC_NETMASK, &mask) &&
+        ip4addr_aton(WIFI_STATIC_GW, &gw))
+    {
+        dhcp_stop(n);
+        netif_set_addr(n, &ip, &mask, &gw);
+        LOG(TAG, "IP fixo %s (DHCP desligado).", WIFI_STATIC_IP);
+    }
+#endif
+    cyw43_arch_lwip_end();
+
     LOG(TAG, "Init OK (STA). SSID=\"%s\" (threadsafe_background)", g_ssid);
 }
 
+/**
+ * @brief Registra um callback para transições UP/DOWN do Wi‑Fi.
+ * @param cb Chamado na task do gerenciador; deve ser curto e não bloquear.
+ * @param ctx Contexto repassado ao callback.
+ * @return false se não houver vaga.
+ */
+bool wifi_manager_subscribe(wifi_link_cb_t cb, void *ctx)
+{
+    bool ok = false;
+
+    taskENTER_CRITICAL();
+    if (cb && s_sub_count < WIFI_MAX_SUBSCRIBERS)
+    {
+        s_subs[s_sub_count].cb = cb;
+        s_subs[s_sub_count].ctx = ctx;
+        s_sub_count++;
+        ok = true;
+    }
+    taskEXIT_CRITICAL();
+
+    return ok;
+}
+
+/**
+ * @brief Copia as estatísticas de conexão.
+ * @param[out] out Destino.
+ */
+void wifi_manager_get_stats(wifi_manager_stats_t *out)
+{
+    if (out)
+    {
+        *out = s_stats;
+        out->attempts = g_attempt;
+        out->connecting = (s_conn != WIFI_CONN_IDLE);
+    }
+}
+
+/**
+ * @brief Quantidade de eventos de netif/reconexão recebidos pela task.
+ */
+uint32_t wifi_manager_event_count(void)
+{
+    return s_event_count;
+}
+
 /**
  * @brief Informa se está conectado (link UP com IP).
  * @return true se conectado; false caso contrário.
@@ -224,7 +725,7 @@ bool wifi_manager_wait_connected(uint32_t timeout_ms)
     {
         if (absolute_time_diff_us(get_absolute_time(), deadline) < 0)
         {
-            LOG(TAG, "Timeout aguardando conexão.");
+            LOGW(TAG, "Timeout aguardando conexão.");
             return false;
         }
         vTaskDelay(pdMS_TO_TICKS(50));
@@ -235,14 +736,298 @@ bool wifi_manager_wait_connected(uint32_t timeout_ms)
 }
 
 /**
- * @brief Força reabertura imediata da janela de reconexão (zera backoff).
+ * @brief Aborta a tentativa em curso (se houver) e tenta de novo já, com backoff zerado.
+ * @note Também retoma a reconexão automática suspensa por `wifi_manager_cancel_connect()`.
  */
 void wifi_manager_force_reconnect(void)
 {
     LOG(TAG, "force_reconnect(): zerando backoff e reabrindo janela");
-    g_began = false;
-    g_backoff_ms = 0;
-    g_next_try_ms = 0;
+    post_event(WIFI_EVT_FORCE_RECONNECT);
+}
+
+/**
+ * @brief Aborta a tentativa em curso e suspende a reconexão automática.
+ * @note Não derruba uma conexão já estabelecida; `wifi_manager_force_reconnect()` retoma.
+ */
+void wifi_manager_cancel_connect(void)
+{
+    LOG(TAG, "cancel_connect(): abortando tentativa e suspendendo reconexão");
+    post_event(WIFI_EVT_CANCEL);
+}
+
+/**
+ * @brief Descrição curta de um motivo de falha de conexão.
+ */
+const char *wifi_manager_fail_str(wifi_fail_reason_t why)
+{
+    switch (why)
+    {
+    case WIFI_FAIL_NONE:
+        return "ok";
+    case WIFI_FAIL_TIMEOUT:
+        return "timeout";
+    case WIFI_FAIL_JOIN:
+        return "join";
+    case WIFI_FAIL_NONET:
+        return "nonet";
+    case WIFI_FAIL_BADAUTH:
+        return "badauth";
+    case WIFI_FAIL_DHCP:
+        return "dhcp";
+    case WIFI_FAIL_CANCELLED:
+        return "cancelled";
+    case WIFI_FAIL_START:
+        return "start";
+    default:
+        return "unknown";
+    }
+}
+
+/**
+ * @brief Registra um cliente que declara o próximo envio (sinks, publicadores).
+ * @param name Nome para log (duração estática).
+ * @return Identificador do cliente ou -1 se não houver vaga.
+ */
+int8_t wifi_manager_tx_register(const char *name)
+{
+    int8_t id = -1;
+
+    taskENTER_CRITICAL();
+    if (s_tx_count < WIFI_MAX_TX_CLIENTS)
+    {
+        id = (int8_t)s_tx_count;
+        s_tx[s_tx_count].name = name;
+        s_tx[s_tx_count].pending = false;
+        s_tx[s_tx_count].hold = false;
+        s_tx_count++;
+    }
+    taskEXIT_CRITICAL();
+
+    return id;
+}
+
+/**
+ * @brief Declara quando o cliente vai transmitir de novo.
+ * @param client Identificador de `wifi_manager_tx_register`.
+ * @param in_ms Milissegundos até o envio, `WIFI_TX_NOW` ou `WIFI_TX_IDLE`.
+ * @note O rádio sai da economia `WIFI_PM_WAKE_LEAD_MS` antes do prazo e volta
+ *       a ela quando o cliente reagenda ou `WIFI_PM_HOLD_MS` após o prazo.
+ */
+void wifi_manager_tx_schedule(int8_t client, uint32_t in_ms)
+{
+    if (client < 0 || (uint8_t)client >= s_tx_count)
+    {
+        return;
+    }
+
+    taskENTER_CRITICAL();
+    s_tx[client].pending = (in_ms != WIFI_TX_IDLE);
+    s_tx[client].due_ms = now_ms() + ((in_ms != WIFI_TX_IDLE) ? in_ms : 0U);
+    taskEXIT_CRITICAL();
+
+    post_event(WIFI_EVT_TX_SCHEDULE);
+}
+
+/**
+ * @brief Segura (ou solta) o rádio acordado enquanto o cliente transmite sem horário.
+ * @param client Identificador de `wifi_manager_tx_register`.
+ * @param hold true: `CYW43_PERFORMANCE_PM` até soltar; false: volta a valer só o agendamento.
+ * @note Pode ser chamada dos callbacks do lwIP (IRQ).
+ */
+void wifi_manager_tx_hold(int8_t client, bool hold)
+{
+    if (client < 0 || (uint8_t)client >= s_tx_count || s_tx[client].hold == hold)
+    {
+        return;
+    }
+
+    s_tx[client].hold = hold;
+    post_event(WIFI_EVT_TX_SCHEDULE);
+}
+
+/**
+ * @brief Nome curto de um modo de energia.
+ */
+const char *wifi_manager_pm_str(wifi_pm_mode_t mode)
+{
+    switch (mode)
+    {
+    case WIFI_PM_DEFAULT:
+        return "default";
+    case WIFI_PM_AWAKE:
+        return "awake";
+    case WIFI_PM_SAVE:
+        return "save";
+    default:
+        return "unknown";
+    }
+}
+
+/**
+ * @brief Soma o tempo desde a última troca ao contador do modo corrente.
+ * @note Chamar dentro de seção crítica.
+ */
+static void pm_account(uint32_t now)
+{
+    const uint32_t dt = now - s_pm_since_ms;
+
+    if (s_pm.mode == WIFI_PM_SAVE)
+    {
+        s_pm.save_ms += dt;
+    }
+    else
+    {
+        s_pm.active_ms += dt;
+    }
+
+    s_pm_since_ms = now;
+}
+
+/**
+ * @brief Copia o tempo em cada modo de energia (contado até agora).
+ * @param[out] out Destino.
+ */
+void wifi_manager_get_pm_stats(wifi_pm_stats_t *out)
+{
+    if (!out)
+    {
+        return;
+    }
+
+    taskENTER_CRITICAL();
+    pm_account(now_ms());
+    *out = s_pm;
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Modo desejado agora e quando reavaliar.
+ * @param now Instante corrente.
+ * @param[out] recheck_ms Espera até a escolha poder mudar (`UINT32_MAX` = só com eventos).
+ */
+static wifi_pm_mode_t pm_wanted(uint32_t now, uint32_t *recheck_ms)
+{
+    *recheck_ms = UINT32_MAX;
+
+    if (!WIFI_POWER_SAVE || !g_connected)
+    {
+        return WIFI_PM_DEFAULT;
+    }
+
+    wifi_pm_mode_t mode = WIFI_PM_SAVE;
+
+    taskENTER_CRITICAL();
+    for (uint8_t i = 0; i < s_tx_count; i++)
+    {
+        if (s_tx[i].hold)
+        {
+            /* Soltar posta um evento: não precisa de reavaliação por prazo. */
+            mode = WIFI_PM_AWAKE;
+            continue;
+        }
+
+        if (!s_tx[i].pending)
+        {
+            continue;
+        }
+
+        const int32_t to_due = (int32_t)(s_tx[i].due_ms - now);
+        uint32_t next;
+
+        if (to_due > (int32_t)WIFI_PM_WAKE_LEAD_MS)
+        {
+            next = (uint32_t)to_due - WIFI_PM_WAKE_LEAD_MS;
+        }
+        else if (to_due > -(int32_t)WIFI_PM_HOLD_MS)
+        {
+            mode = WIFI_PM_AWAKE;
+            next = (uint32_t)(to_due + (int32_t)WIFI_PM_HOLD_MS);
+        }
+        else
+        {
+            /* Prazo vencido há muito sem reagendar: não segura o rádio. */
+            continue;
+        }
+
+        if (next < *recheck_ms)
+        {
+            *recheck_ms = next;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    return mode;
+}
+
+/**
+ * @brief Aplica no cyw43 o modo de energia adequado ao estado e aos envios declarados.
+ */
+static void pm_update(void)
+{
+    const uint32_t now = now_ms();
+    uint32_t recheck;
+    const wifi_pm_mode_t mode = pm_wanted(now, &recheck);
+
+    s_pm_recheck = (recheck != UINT32_MAX);
+    s_pm_recheck_ms = now + (s_pm_recheck ? recheck : 0U);
+
+    if (mode == s_pm.mode)
+    {
+        return;
+    }
+
+    static const uint32_t cyw43_mode[] = {
+        [WIFI_PM_DEFAULT] = CYW43_DEFAULT_PM,
+        [WIFI_PM_AWAKE] = CYW43_PERFORMANCE_PM,
+        [WIFI_PM_SAVE] = CYW43_AGGRESSIVE_PM,
+    };
+
+    cyw43_arch_lwip_begin();
+    const int rc = cyw43_wifi_pm(&cyw43_state, cyw43_mode[mode]);
+    cyw43_arch_lwip_end();
+
+    taskENTER_CRITICAL();
+    if (rc == 0)
+    {
+        pm_account(now);
+        s_pm.mode = mode;
+        s_pm.switches++;
+    }
+    else
+    {
+        s_pm.errors++;
+    }
+    taskEXIT_CRITICAL();
+
+    if (rc != 0)
+    {
+        LOGW(TAG, "cyw43_wifi_pm(%s) rc=%d", wifi_manager_pm_str(mode), rc);
+    }
+}
+
+/**
+ * @brief Trata um evento de controle (forçar/cancelar) no contexto da task.
+ */
+static void handle_control(wifi_event_t evt)
+{
+    if (evt == WIFI_EVT_CANCEL)
+    {
+        s_paused = true;
+        if (s_conn != WIFI_CONN_IDLE)
+        {
+            attempt_failed(WIFI_FAIL_CANCELLED);
+        }
+    }
+    else if (evt == WIFI_EVT_FORCE_RECONNECT)
+    {
+        s_paused = false;
+        if (s_conn != WIFI_CONN_IDLE)
+        {
+            attempt_failed(WIFI_FAIL_CANCELLED);
+        }
+        g_backoff_ms = WIFI_BACKOFF_MIN_MS;
+        g_next_try_ms = now_ms();
+    }
 }
 
 /**
@@ -255,56 +1040,47 @@ void wifi_manager_task(void *params)
 
     if (!g_arch_ok)
     {
-        LOG(TAG, "wifi_manager_task(): begin() não chamado? Iniciando com credenciais atuais.");
+        LOGW(TAG, "wifi_manager_task(): begin() não chamado? Iniciando com credenciais atuais.");
         wifi_manager_init(g_ssid, g_pass);
     }
 
-    const TickType_t period = pdMS_TO_TICKS(WIFI_TICK_PERIOD_MS);
-    TickType_t last = xTaskGetTickCount();
-
     for (;;)
     {
-        update_link_state();
-        uint32_t now = now_ms();
+        /* Espera um evento ou o próximo prazo: fim da etapa em curso ou da espera entre tentativas. */
+        TickType_t wait = pdMS_TO_TICKS(WIFI_SAFETY_POLL_MS);
 
-        if (wifi_manager_is_connected())
+        if (!wifi_manager_is_connected() && (s_conn != WIFI_CONN_IDLE || !s_paused))
         {
-            if (g_backoff_ms == 0)
-            {
-                g_backoff_ms = WIFI_BACKOFF_MIN_MS;
-            }
-
-            if (g_next_try_ms < now + WIFI_CONNECT_GUARD_MS)
-            {
-                g_next_try_ms = now + WIFI_CONNECT_GUARD_MS;
-            }
+            const uint32_t due = (s_conn != WIFI_CONN_IDLE) ? s_deadline_ms : g_next_try_ms;
+            const int32_t left = (int32_t)(due - now_ms());
+            const TickType_t until = (left > 0) ? pdMS_TO_TICKS((uint32_t)left) : 0;
+            wait = (until < wait) ? until : wait;
         }
-        else
+
+        if (s_pm_recheck)
         {
-            if (g_backoff_ms == 0)
-            {
-                g_backoff_ms = WIFI_BACKOFF_MIN_MS;
-            }
+            const int32_t left = (int32_t)(s_pm_recheck_ms - now_ms());
+            const TickType_t until = (left > 0) ? pdMS_TO_TICKS((uint32_t)left) : 0;
+            wait = (until < wait) ? until : wait;
+        }
+
+        uint8_t evt;
 
-            if ((int32_t)(now - g_next_try_ms) >= 0)
+        if (!s_events)
+        {
+            vTaskDelay(wait ? wait : 1);
+        }
+        else if (xQueueReceive(s_events, &evt, wait) == pdTRUE)
+        {
+            do
             {
-                try_connect_once();
-
-                uint32_t base = g_backoff_ms;
-                g_backoff_ms = (g_backoff_ms < WIFI_BACKOFF_MAX_MS)
-                                   ? (g_backoff_ms * 2U)
-                                   : WIFI_BACKOFF_MAX_MS;
-                uint32_t jitter = g_backoff_ms / 10U;
-                uint32_t j = jitter ? (rand() % jitter) : 0;
-                g_next_try_ms = now + WIFI_CONNECT_GUARD_MS + g_backoff_ms + j;
-
-                LOG(TAG, "Backoff: base=%u ms, next=%u ms (+guard=%u, +jitter=%u)",
-                    (unsigned)base, (unsigned)g_backoff_ms,
-                    (unsigned)WIFI_CONNECT_GUARD_MS, (unsigned)j);
-            }
+                s_event_count++;
+                handle_control((wifi_event_t)evt);
+            } while (xQueueReceive(s_events, &evt, 0) == pdTRUE);
         }
 
-        vTaskDelayUntil(&last, period);
+        advance_connect(update_link_state());
+        pm_update();
     }
 }
 
@@ -319,3 +1095,29 @@ const char *wifi_manager_ip_str(void)
     snprintf(ipbuf, sizeof(ipbuf), "%u.%u.%u.%u", b[0], b[1], b[2], b[3]);
     return ipbuf;
 }
+
+/**
+ * @brief Lê o RSSI atual da associação STA.
+ * @param[out] out_dbm RSSI em dBm.
+ * @return true se conectado e o valor é plausível; false caso contrário.
+ */
+bool wifi_manager_get_rssi(int32_t *out_dbm)
+{
+    if (!out_dbm || !g_arch_ok || !g_connected)
+    {
+        return false;
+    }
+
+    int32_t rssi = 0;
+    cyw43_arch_lwip_begin();
+    int rc = cyw43_wifi_get_rssi(&cyw43_state, &rssi);
+    cyw43_arch_lwip_end();
+
+    if (rc != 0 || rssi > -10 || rssi < -120)
+    {
+        return false;
+    }
+
+    *out_dbm = rssi;
+    return true;
+}
@@ -8,12 +8,100 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include "credentials.h"
+
+#define WIFI_MAX_SUBSCRIBERS    4U      /**< Assinantes de transições UP/DOWN. */
+#define WIFI_MAX_TX_CLIENTS     6U      /**< Clientes que declaram o próximo envio. */
+
+#ifndef WIFI_POWER_SAVE
+#define WIFI_POWER_SAVE         1       /**< 1: economia agressiva entre envios; 0: modo padrão sempre. */
+#endif
+
+#define WIFI_TX_NOW             0U              /**< `tx_schedule`: enviando já (rádio acordado até reagendar). */
+#define WIFI_TX_IDLE            UINT32_MAX      /**< `tx_schedule`: nenhum envio previsto. */
+
+/**
+ * @brief Callback de transição do Wi‑Fi.
+ * @param up true ao subir (link com IP), false ao cair.
+ * @param ctx Contexto informado em `wifi_manager_subscribe`.
+ */
+typedef void (*wifi_link_cb_t)(bool up, void *ctx);
+
+/* IP fixo opcional (credentials.h): WIFI_STATIC_IP, WIFI_STATIC_GW e, se preciso, WIFI_STATIC_NETMASK. */
+#if defined(WIFI_STATIC_IP) && !defined(WIFI_STATIC_NETMASK)
+#define WIFI_STATIC_NETMASK     "255.255.255.0"     /**< Máscara do IP fixo. */
+#endif
+#if defined(WIFI_STATIC_IP) && !defined(WIFI_STATIC_GW)
+#error "WIFI_STATIC_IP requer WIFI_STATIC_GW"
+#endif
+
+/** @brief Motivo do fim sem sucesso de uma tentativa de conexão. */
+typedef enum
+{
+    WIFI_FAIL_NONE = 0,         /**< Sem falha (última tentativa conectou). */
+    WIFI_FAIL_TIMEOUT,          /**< Não associou dentro do prazo. */
+    WIFI_FAIL_JOIN,             /**< Associação recusada ou perdida. */
+    WIFI_FAIL_NONET,            /**< SSID não encontrado. */
+    WIFI_FAIL_BADAUTH,          /**< Senha/autenticação rejeitada. */
+    WIFI_FAIL_DHCP,             /**< Associou, mas não recebeu IP no prazo. */
+    WIFI_FAIL_CANCELLED,        /**< Abortada por cancelamento ou `force_reconnect`. */
+    WIFI_FAIL_START,            /**< O driver recusou iniciar a associação. */
+} wifi_fail_reason_t;
+
+/** @brief Estatísticas de conexão e de reconexão. */
+typedef struct
+{
+    uint32_t attempts;          /**< Tentativas de conexão (rápidas e completas). */
+    uint32_t fast_attempts;     /**< Reassociações direcionadas tentadas. */
+    uint32_t fast_ok;           /**< Reassociações direcionadas que associaram. */
+    uint32_t full_attempts;     /**< Tentativas pelo caminho completo (varredura). */
+    uint32_t outages;           /**< Quedas recuperadas. */
+    uint32_t last_outage_ms;    /**< Queda -> IP de volta (primeiro pacote possível). */
+    uint32_t max_outage_ms;     /**< Maior `last_outage_ms` observado. */
+    uint32_t last_join_ms;      /**< Início da tentativa -> associado. */
+    uint32_t last_ip_ms;        /**< Associado -> IP. */
+    uint32_t failures;          /**< Tentativas encerradas sem conexão. */
+    uint32_t last_attempt_ms;   /**< Duração da última tentativa concluída (sucesso ou falha). */
+    wifi_fail_reason_t last_fail; /**< Motivo da última tentativa (`WIFI_FAIL_NONE` se conectou). */
+    int32_t join_rssi_dbm;      /**< RSSI lido na última conexão [dBm]. */
+    bool last_fast;             /**< Última tentativa foi a reassociação rápida. */
+    bool connecting;            /**< Há tentativa em curso. */
+} wifi_manager_stats_t;
+
+/** @brief Modo de energia do rádio escolhido pelo gerenciador. */
+typedef enum
+{
+    WIFI_PM_DEFAULT = 0,        /**< `CYW43_DEFAULT_PM` (sem conexão, associando). */
+    WIFI_PM_AWAKE,              /**< `CYW43_PERFORMANCE_PM` (envio próximo ou em curso). */
+    WIFI_PM_SAVE,               /**< `CYW43_AGGRESSIVE_PM` (entre envios). */
+} wifi_pm_mode_t;
+
+/** @brief Tempo em cada modo de energia e trocas de modo. */
+typedef struct
+{
+    wifi_pm_mode_t mode;        /**< Modo corrente. */
+    uint32_t switches;          /**< Trocas de modo aplicadas. */
+    uint32_t errors;            /**< `cyw43_wifi_pm` com erro. */
+    uint64_t active_ms;         /**< Tempo em DEFAULT/AWAKE (rádio ativo). */
+    uint64_t save_ms;           /**< Tempo em SAVE. */
+} wifi_pm_stats_t;
 
 void wifi_manager_init(const char *ssid, const char *pass);
 bool wifi_manager_is_connected(void);
 bool wifi_manager_wait_connected(uint32_t timeout_ms);
 void wifi_manager_force_reconnect(void);
+void wifi_manager_cancel_connect(void);
+const char *wifi_manager_fail_str(wifi_fail_reason_t why);
 void wifi_manager_task(void *params);
 const char *wifi_manager_ip_str(void);
+bool wifi_manager_get_rssi(int32_t *out_dbm);
+bool wifi_manager_subscribe(wifi_link_cb_t cb, void *ctx);
+uint32_t wifi_manager_event_count(void);
+void wifi_manager_get_stats(wifi_manager_stats_t *out);
+int8_t wifi_manager_tx_register(const char *name);
+void wifi_manager_tx_schedule(int8_t client, uint32_t in_ms);
+void wifi_manager_tx_hold(int8_t client, bool hold);
+void wifi_manager_get_pm_stats(wifi_pm_stats_t *out);
+const char *wifi_manager_pm_str(wifi_pm_mode_t mode);
 
 #endif /* WIFI_MANAGER_H */
@@ -1,11 +1,29 @@
 /**
  * @file main.c
- * @brief Ponto de entrada: cria tasks (Wi‑Fi, EnergyMonitor, ThingSpeak) e inicia o scheduler.
+ * @brief Ponto de entrada: cria tasks (Wi‑Fi, EnergyMonitor, telemetria) e inicia o scheduler.
  * @details
- *  Inicializa subsistemas (stdio/logger/RTC/ADS1115/Wi‑Fi) e agenda as tasks:
- *   - WiFiManagerTask: gerencia conexão e NTP
+ *  Inicializa subsistemas (stdio/logger/ADS1115/Wi‑Fi) e agenda as tasks:
+ *   - WiFiManagerTask: gerencia a conexão
+ *   - TimeSyncTask: disciplina o relógio de software por NTP (vários servidores)
  *   - EnergyMonitorTask: amostra e calcula RMS/PU/Pinst
- *   - ThingSpeakTask: acumula energia e envia telemetria
+ *   - TelemetryTask: produz um registro por segundo e o entrega aos sinks
+ *     (ThingSpeak, MQTT, SD, UDP), cada um com fila e task próprias
+ *   - MqttPublisherTask: publica as janelas de telemetria via MQTT
+ *   - HttpServerTask: expõe métricas Prometheus em GET /metrics
+ *   - SdQueryTask: atende consultas ao histórico do SD (GET /query e comando
+ *     `query`), um trecho do cartão por vez (prioridade mínima)
+ *   - LoggerTask: escoa o anel de mensagens de log para o stdio (prioridade mínima)
+ *   - SerialCmdTask: console de comandos pela serial USB (ex.: `log wifi_manager debug`)
+ *   - UdpStreamTask: envia as amostras instantâneas em datagramas UDP binários
+ *     (os registros de 1 Hz seguem em lote pelo sink UDP da telemetria)
+ *   - RtosStatsTask: instantâneos de CPU/stack/heap/filas (log e comando `rtos`)
+ *
+ *  Comando `trace` (só com `-DRTOS_TRACE_ENABLE=1` no CMake): grava trocas
+ *  de contexto e eventos de filas num anel em RAM e o despeja na serial ou
+ *  no SD (`lib/rtos_trace.h`).
+ *
+ *  As tasks são criadas por `rtos_stats_create_task`, que guarda o stack
+ *  alocado de cada uma para a recomendação de `rtos stack`.
  */
 
 #include <stdio.h>
@@ -13,13 +31,31 @@
 #include "FreeRTOS.h"
 #include "task.h"
 #include "lib/logger.h"
-#include "lib/rtc_ntp.h"
+#include "lib/serial_cmd.h"
+#include "lib/time_sync.h"
 #include "lib/ads1115_adc.h"
 #include "lib/energy_monitor.h"
 #include "credentials.h"
 #include "lib/wifi_manager.h"
 #include "lib/thingspeak.h"
+#include "lib/mqtt_publisher.h"
+#include "lib/http_server.h"
 #include "lib/sd_card_log_task.h"
+#include "lib/sd_query.h"
+#include "lib/telemetry.h"
+#include "lib/udp_stream.h"
+#include "lib/rtos_stats.h"
+#include "lib/rtos_trace_cmd.h"
+
+/**
+ * @brief Estouro de stack detectado pelo kernel na troca de contexto (`configCHECK_FOR_STACK_OVERFLOW` 2).
+ * @details Com o stack corrompido não há como seguir: avisa a task pela serial e para.
+ */
+void vApplicationStackOverflowHook(TaskHandle_t task, char *name)
+{
+    (void)task;
+    panic("Estouro de stack na task %s", name);
+}
 
 /**
  * @brief Função principal do firmware.
@@ -30,12 +66,24 @@ int main(void)
     /* Inicialização periféricos */
     stdio_init_all();
     logger_init();
-    rtc_ntp_init();
+    rtos_stats_init();
+    rtos_trace_cmd_init();
     ads1115_init();
     wifi_manager_init(SSID, PASSWORD);
+    mqtt_publisher_init();
+    udp_stream_init();
+    sd_card_log_init();
+    sd_query_init();
+
+    /* Destinos de telemetria */
+    telemetry_register_sink(&thingspeak_sink);
+    telemetry_register_sink(&mqtt_publisher_sink);
+    telemetry_register_sink(&sd_card_log_sink);
+    telemetry_register_sink(&udp_stream_record_sink);
+    telemetry_start();
 
     /* Criação das tarefas */
-    xTaskCreate(
+    rtos_stats_create_task(
         wifi_manager_task,
         "WiFiManagerTask",
         2048,
@@ -43,7 +91,15 @@ int main(void)
         tskIDLE_PRIORITY + 2,
         NULL);
 
-    xTaskCreate(
+    rtos_stats_create_task(
+        time_sync_task,
+        "TimeSyncTask",
+        1024,
+        NULL,
+        tskIDLE_PRIORITY + 1,
+        NULL);
+
+    rtos_stats_create_task(
         energy_monitor_task,
         "EnergyMonitorTask",
         2048,
@@ -51,22 +107,70 @@ int main(void)
         tskIDLE_PRIORITY + 1,
         NULL);
 
-    xTaskCreate(
-        thingspeak_task,
-        "ThingSpeakTask",
-        3072,
+    rtos_stats_create_task(
+        telemetry_task,
+        "TelemetryTask",
+        1024,
+        NULL,
+        tskIDLE_PRIORITY + 1,
+        NULL);
+
+    rtos_stats_create_task(
+        mqtt_publisher_task,
+        "MqttPublisherTask",
+        2048,
         NULL,
         tskIDLE_PRIORITY + 1,
         NULL);
 
-    xTaskCreate(
-        sd_card_log_task,
-        "SDCardLogTask",
-        4096, // Aumente o tamanho da stack para a nova tarefa
+    rtos_stats_create_task(
+        logger_task,
+        "LoggerTask",
+        1024,
+        NULL,
+        tskIDLE_PRIORITY,
+        NULL);
+
+    rtos_stats_create_task(
+        serial_cmd_task,
+        "SerialCmdTask",
+        1024,
+        NULL,
+        tskIDLE_PRIORITY,
+        NULL);
+
+    rtos_stats_create_task(
+        http_server_task,
+        "HttpServerTask",
+        1024,
+        NULL,
+        tskIDLE_PRIORITY,
+        NULL);
+
+    rtos_stats_create_task(
+        sd_query_task,
+        "SdQueryTask",
+        1024,
+        NULL,
+        tskIDLE_PRIORITY,
+        NULL);
+
+    rtos_stats_create_task(
+        udp_stream_task,
+        "UdpStreamTask",
+        1024,
         NULL,
         tskIDLE_PRIORITY + 1,
         NULL);
 
+    rtos_stats_create_task(
+        rtos_stats_task,
+        "RtosStatsTask",
+        1024,
+        NULL,
+        tskIDLE_PRIORITY,
+        NULL);
+
     /* Inicialização do escalonador */
     vTaskStartScheduler();
 
@@ -0,0 +1,338 @@
+/**
+ * @file binlog_export.c
+ * @brief Exportador (host) do log binário do SD (`lib/sd_binlog.h`) para CSV ou colunas.
+ * @details
+ *  Valida o cabeçalho, posiciona a leitura com a busca binária sobre os
+ *  índices (`sd_binlog_seek`) quando há intervalo de tempo, e percorre as
+ *  unidades a partir daí. Unidades com CRC inválido (enchimento, gravação
+ *  interrompida) são contadas e puladas. Em arquivos v2 (pré-alocados) a
+ *  leitura para no fim lógico (`sd_binlog_find_end`), não no tamanho.
+ *
+ *  Em arquivos v3 (diário) as unidades de sessão vão para o stderr com a
+ *  janela sem dados (do último registro gravado antes da queda ou do erro
+ *  até o primeiro da sessão) e os registros perdidos numa reabertura; o
+ *  enchimento dos commits é contado e pulado, e saltos de `seq` entre
+ *  registros consecutivos, inclusive de um arquivo para o seguinte, são
+ *  contados como perda.
+ *
+ *  Aceita vários arquivos, exportados na ordem dada: os diários
+ *  `log/AAAAMMDD.bin` ordenados pelo shell formam uma série contínua.
+ *
+ *  Saídas:
+ *   - CSV no stdout, com as colunas do antigo `dados.csv` na frente:
+ *     timestamp,vrms,irms,v_pu,p_instant,seq,t_unix_us,flags;
+ *   - `-c dir`: um arquivo binário little-endian por coluna (t_unix_us.i64,
+ *     seq.u32, vrms.f32, irms.f32, v_pu.f32, p_w.f32, flags.u8) e
+ *     `schema.txt`; cada coluna é contígua e abre direto em numpy/pandas
+ *     (`numpy.fromfile(dir + "/vrms.f32", "<f4")`).
+ *
+ *  Instantes em `-f`/`-t`: "AAAA-MM-DDTHH:MM:SS" na hora local
+ *  (`TIMESTAMP_TZ_OFFSET_S`) ou segundos Unix.
+ *
+ *  Compilação e uso (a partir de `monitor_energia/`):
+ *      gcc -O2 -I. tools/binlog_export.c lib/sd_binlog.c lib/timestamp.c lib/fmt.c -o binlog_export
+ *      ./binlog_export dados.bin > dados.csv
+ *      ./binlog_export -f 2026-10-19T08:00:00 -t 2026-10-19T09:00:00 dados.bin
+ *      ./binlog_export -c colunas/ dados.bin
+ *      ./binlog_export -f 2026-10-18T22:00:00 log/2026101[89].bin > virada.csv
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "lib/sd_binlog.h"
+#include "lib/timestamp.h"
+
+/** @brief Colunas da saída `-c`. */
+typedef struct
+{
+    const char *file;   /**< Nome do arquivo da coluna. */
+    const char *type;   /**< Tipo no schema. */
+    FILE *f;            /**< Arquivo aberto. */
+} column_t;
+
+static column_t s_cols[] = {
+    {"t_unix_us.i64", "int64", NULL}, {"seq.u32", "uint32", NULL}, {"vrms.f32", "float32", NULL},
+    {"irms.f32", "float32", NULL},    {"v_pu.f32", "float32", NULL}, {"p_w.f32", "float32", NULL},
+    {"flags.u8", "uint8", NULL},
+};
+
+/** @brief `sd_binlog_read_fn` sobre stdio. */
+static bool file_read(void *ctx, uint32_t off, uint8_t *buf, uint32_t len)
+{
+    FILE *f = (FILE *)ctx;
+    return fseek(f, (long)off, SEEK_SET) == 0 && fread(buf, 1, len, f) == len;
+}
+
+/** @brief Abre os arquivos de coluna em `dir`. */
+static bool open_columns(const char *dir)
+{
+    char path[512];
+
+    for (size_t i = 0; i < sizeof(s_cols) / sizeof(s_cols[0]); i++)
+    {
+        snprintf(path, sizeof(path), "%s/%s", dir, s_cols[i].file);
+        s_cols[i].f = fopen(path, "wb");
+        if (!s_cols[i].f)
+        {
+            perror(path);
+            return false;
+        }
+    }
+    return true;
+}
+
+/** @brief Grava um valor little-endian de `n` bytes numa coluna. */
+static void put_col(size_t col, uint64_t v, size_t n)
+{
+    uint8_t b[8];
+    for (size_t i = 0; i < n; i++)
+    {
+        b[i] = (uint8_t)(v >> (8U * i));
+    }
+    fwrite(b, 1, n, s_cols[col].f);
+}
+
+static uint32_t f32_bits(float v)
+{
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return bits;
+}
+
+/** @brief Fecha as colunas e escreve `schema.txt`. */
+static void close_columns(const char *dir, unsigned long rows)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/schema.txt", dir);
+    FILE *f = fopen(path, "w");
+
+    for (size_t i = 0; i < sizeof(s_cols) / sizeof(s_cols[0]); i++)
+    {
+        fclose(s_cols[i].f);
+        if (f)
+        {
+            fprintf(f, "%s %s %lu little-endian\n", s_cols[i].file, s_cols[i].type, rows);
+        }
+    }
+    if (f)
+    {
+        fclose(f);
+    }
+}
+
+/** @brief Totais da exportação. */
+typedef struct
+{
+    unsigned long rows;         /**< Registros exportados. */
+    unsigned long bad;          /**< Unidades inválidas antes do fim lógico. */
+    unsigned long index_units;  /**< Índices lidos. */
+    unsigned long pad_units;    /**< Unidades de enchimento (v3). */
+    unsigned long sessions;     /**< Sessões (v3). */
+    unsigned long gaps;         /**< Saltos de seq entre registros consecutivos (v3). */
+    unsigned long lost;         /**< Registros faltando nesses saltos. */
+    uint32_t seeks;             /**< Leituras da busca binária. */
+    uint32_t last_seq;          /**< Seq do último registro exportado (`SD_BINLOG_SEQ_NONE`: nenhum). */
+} export_totals_t;
+
+/** @brief Mostra uma unidade de sessão e a janela sem dados antes dela. */
+static void print_session(const char *path, const sd_binlog_session_t *ss)
+{
+    static timestamp_cache_t cache = TIMESTAMP_CACHE_INIT('-', 'T', false);
+    char t_start[TIMESTAMP_MAX_LEN];
+    char t_prev[TIMESTAMP_MAX_LEN];
+
+    timestamp_format(&cache, t_start, sizeof(t_start), ss->t_start);
+    if (ss->prev_seq == SD_BINLOG_SEQ_NONE)
+    {
+        fprintf(stderr, "%s: sessão %s em %s, seq %u, sem registro anterior.\n", path,
+                (ss->reason == SD_BINLOG_SESSION_BOOT) ? "boot" : "reaberta", t_start, ss->next_seq);
+        return;
+    }
+
+    timestamp_format(&cache, t_prev, sizeof(t_prev), ss->t_prev);
+    fprintf(stderr, "%s: sessão %s em %s, seq %u; último registro anterior %u em %s (%.1f s sem dados", path,
+            (ss->reason == SD_BINLOG_SESSION_BOOT) ? "boot" : "reaberta", t_start, ss->next_seq, ss->prev_seq,
+            t_prev, (double)(ss->t_start - ss->t_prev) / 1e6);
+    if (ss->next_seq > ss->prev_seq + 1U)
+    {
+        fprintf(stderr, ", %u registros perdidos", ss->next_seq - ss->prev_seq - 1U);
+    }
+    fprintf(stderr, ").\n");
+}
+
+/**
+ * @brief Exporta os registros de um arquivo dentro de [t_from, t_to].
+ * @return false se o arquivo não abre ou o cabeçalho é inválido.
+ */
+static bool export_file(const char *path, int64_t t_from, int64_t t_to, bool columns, export_totals_t *tot)
+{
+    static timestamp_cache_t cache = TIMESTAMP_CACHE_INIT('-', 'T', false);
+    FILE *in = fopen(path, "rb");
+    uint8_t u[SD_BINLOG_UNIT];
+
+    if (!in)
+    {
+        perror(path);
+        return false;
+    }
+
+    fseek(in, 0, SEEK_END);
+    sd_binlog_src_t src = {.read = file_read, .ctx = in, .size = (uint32_t)ftell(in)};
+
+    if (!file_read(in, 0, u, sizeof(u)) || !sd_binlog_get_header(u, &src.hdr))
+    {
+        fprintf(stderr, "%s: cabeçalho ausente ou inválido (versões 1 a %u)\n", path, SD_BINLOG_VERSION);
+        fclose(in);
+        return false;
+    }
+
+    // v1 pode ter enchimento no meio; v2 é um prefixo válido seguido de pré-alocação
+    const uint32_t end = (src.hdr.version >= 2U) ? sd_binlog_find_end(&src, NULL, NULL) : src.size;
+    uint32_t seeks = 0;
+    const uint32_t start = (t_from != INT64_MIN) ? sd_binlog_seek(&src, t_from, &seeks) : 0U;
+    unsigned long rows = 0;
+
+    fseek(in, (long)start, SEEK_SET);
+
+    for (uint32_t off = start; off + SD_BINLOG_UNIT <= end; off += SD_BINLOG_UNIT)
+    {
+        if (fread(u, 1, sizeof(u), in) != sizeof(u))
+        {
+            break;
+        }
+
+        const int type = sd_binlog_check(u, &src.hdr);
+        if (type == SD_BINLOG_TYPE_INDEX)
+        {
+            tot->index_units++;
+            continue;
+        }
+        if (type == SD_BINLOG_TYPE_PAD)
+        {
+            tot->pad_units++;
+            continue;
+        }
+        if (type == SD_BINLOG_TYPE_SESSION)
+        {
+            sd_binlog_session_t ss;
+            sd_binlog_get_session(u, &ss);
+            print_session(path, &ss);
+            tot->sessions++;
+            continue;
+        }
+        if (type != SD_BINLOG_TYPE_RECORD)
+        {
+            tot->bad += (type == 0) ? 1U : 0U;
+            continue;
+        }
+
+        sd_binlog_rec_t r;
+        sd_binlog_get_record(u, &r);
+
+        if (r.t_unix_us < t_from)
+        {
+            continue;
+        }
+        if (r.t_unix_us > t_to)
+        {
+            break;
+        }
+
+        if (src.hdr.version >= 3U && tot->last_seq != SD_BINLOG_SEQ_NONE && r.seq != tot->last_seq + 1U)
+        {
+            tot->gaps++;
+            tot->lost += (r.seq > tot->last_seq) ? r.seq - tot->last_seq - 1U : 0U;
+        }
+        tot->last_seq = (src.hdr.version >= 3U) ? r.seq : SD_BINLOG_SEQ_NONE;
+
+        if (columns)
+        {
+            put_col(0, (uint64_t)r.t_unix_us, 8);
+            put_col(1, r.seq, 4);
+            put_col(2, f32_bits(r.vrms), 4);
+            put_col(3, f32_bits(r.irms), 4);
+            put_col(4, f32_bits(r.v_pu), 4);
+            put_col(5, f32_bits(r.p_w), 4);
+            put_col(6, r.flags, 1);
+        }
+        else
+        {
+            char ts[TIMESTAMP_MAX_LEN];
+            timestamp_format(&cache, ts, sizeof(ts), r.t_unix_us);
+            printf("%s,%.2f,%.2f,%.2f,%.1f,%u,%lld,%u\n", ts, r.vrms, r.irms, r.v_pu, r.p_w, r.seq,
+                   (long long)r.t_unix_us, r.flags);
+        }
+        rows++;
+    }
+
+    fprintf(stderr, "%s: v%u, %lu registros a partir do byte %u (%u leituras de índice); fim lógico %u de %u bytes.\n",
+            path, src.hdr.version, rows, start, seeks, end, src.size);
+    tot->rows += rows;
+    tot->seeks += seeks;
+    fclose(in);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    int64_t t_from = INT64_MIN;
+    int64_t t_to = INT64_MAX;
+    const char *col_dir = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "f:t:c:")) != -1)
+    {
+        if ((opt == 'f' && timestamp_parse(optarg, strlen(optarg), &t_from)) ||
+            (opt == 't' && timestamp_parse(optarg, strlen(optarg), &t_to)))
+        {
+            continue;
+        }
+        if (opt == 'c')
+        {
+            col_dir = optarg;
+            continue;
+        }
+        fprintf(stderr, "uso: %s [-f inicio] [-t fim] [-c dir] arquivo.bin...\n", argv[0]);
+        return 1;
+    }
+
+    if (optind >= argc)
+    {
+        fprintf(stderr, "uso: %s [-f inicio] [-t fim] [-c dir] arquivo.bin...\n", argv[0]);
+        return 1;
+    }
+
+    if (col_dir && !open_columns(col_dir))
+    {
+        return 1;
+    }
+
+    if (!col_dir)
+    {
+        printf("timestamp,vrms,irms,v_pu,p_instant,seq,t_unix_us,flags\n");
+    }
+
+    export_totals_t tot = {.last_seq = SD_BINLOG_SEQ_NONE};
+    int rc = 0;
+
+    for (int i = optind; i < argc; i++)
+    {
+        rc |= export_file(argv[i], t_from, t_to, col_dir != NULL, &tot) ? 0 : 1;
+    }
+
+    if (col_dir)
+    {
+        close_columns(col_dir, tot.rows);
+    }
+
+    fprintf(stderr, "%lu registros exportados de %d arquivo(s); %lu índices, %lu unidades inválidas.\n", tot.rows,
+            argc - optind, tot.index_units, tot.bad);
+    if (tot.sessions || tot.pad_units)
+    {
+        fprintf(stderr, "Diário: %lu sessões, %lu unidades de enchimento, %lu saltos de seq (%lu registros).\n",
+                tot.sessions, tot.pad_units, tot.gaps, tot.lost);
+    }
+    return rc;
+}
@@ -0,0 +1,230 @@
+/**
+ * @file codec_bench.c
+ * @brief Benchmark (host) da codificação binária `lib/telemetry_codec.c` contra texto.
+ * @details
+ *  Compara, por registro de medição, o tempo de codificação e os bytes gerados:
+ *   - texto ThingSpeak com `snprintf` ("&fieldN=%.6f", 8 campos);
+ *   - o mesmo texto com `lib/fmt` (caminho atual do firmware);
+ *   - binário com um registro por payload;
+ *   - binário em lotes de 10 e de 60 registros (cabeçalho amortizado).
+ *
+ *  Antes de medir, confere o ida-e-volta binário (bit a bit) de todos os
+ *  registros de teste; qualquer divergência aborta o benchmark.
+ *
+ *  Compilação e execução (a partir de `monitor_energia/`):
+ *      gcc -O2 -I. tools/codec_bench.c lib/telemetry_codec.c lib/fmt.c -o codec_bench -lm && ./codec_bench
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "lib/fmt.h"
+#include "lib/telemetry_codec.h"
+
+#define BENCH_RECORDS   600U        /**< Registros sintéticos (10 min a 1 Hz). */
+#define BENCH_ROUNDS    2000U       /**< Passadas sobre o conjunto por cenário. */
+
+static telemetry_record_t s_recs[BENCH_RECORDS];
+
+/** @brief Relógio monotônico em nanossegundos. */
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/** @brief Gera registros com valores realistas e variados. */
+static void make_records(void)
+{
+    double e = 0.0;
+
+    for (uint32_t n = 0; n < BENCH_RECORDS; n++)
+    {
+        telemetry_record_t *r = &s_recs[n];
+        r->seq = n;
+        r->uptime_s = 3600U + n;
+        r->t_ms = (3600U + n) * 1000U + (n * 7U) % 1000U;
+        r->t_unix_us = 1767225600000000LL + (int64_t)r->t_ms * 1000 + (int64_t)(n % 1000U);
+        r->vrms = 127.0f + (float)((int)(n % 37U) - 18) * 0.11f;
+        r->irms = 4.2f + (float)(n % 23U) * 0.013f;
+        r->v_pu = r->vrms / 127.0f;
+        r->p_w = r->vrms * r->irms;
+        e += r->p_w / 3600.0;
+        r->e_total_wh = e;
+        r->flags = (n % 60U == 0U) ? 1U : 0U;
+        r->valid = true;
+    }
+}
+
+/** @brief Confere codificação/decodificação em lotes de tamanhos variados. */
+static unsigned verify_roundtrip(void)
+{
+    unsigned failures = 0;
+    uint8_t buf[TELEMETRY_CODEC_HDR_SIZE + 64U * TELEMETRY_CODEC_REC_SIZE];
+
+    for (uint32_t batch = 1; batch <= 64U; batch *= 2U)
+    {
+        for (uint32_t base = 0; base < BENCH_RECORDS; base += batch)
+        {
+            telemetry_codec_writer_t w;
+            telemetry_codec_begin(&w, buf, sizeof(buf));
+
+            for (uint32_t k = base; k < base + batch && k < BENCH_RECORDS; k++)
+            {
+                telemetry_codec_add(&w, &s_recs[k]);
+            }
+
+            const size_t len = telemetry_codec_finish(&w);
+            telemetry_codec_reader_t r;
+
+            if (!telemetry_codec_open(&r, buf, len) || r.count != w.count ||
+                telemetry_codec_open(&r, buf, len - 1U))
+            {
+                failures++;
+                continue;
+            }
+
+            for (uint16_t k = 0; k < r.count; k++)
+            {
+                telemetry_record_t got;
+                const telemetry_record_t *want = &s_recs[base + k];
+                telemetry_codec_get(&r, k, &got);
+
+                if (got.seq != want->seq || got.uptime_s != want->uptime_s || got.t_ms != want->t_ms ||
+                    got.t_unix_us != want->t_unix_us ||
+                    memcmp(&got.vrms, &want->vrms, sizeof(float)) != 0 ||
+                    memcmp(&got.irms, &want->irms, sizeof(float)) != 0 ||
+                    memcmp(&got.v_pu, &want->v_pu, sizeof(float)) != 0 ||
+                    memcmp(&got.p_w, &want->p_w, sizeof(float)) != 0 ||
+                    memcmp(&got.e_total_wh, &want->e_total_wh, sizeof(double)) != 0 ||
+                    got.flags != want->flags || got.valid != want->valid)
+                {
+                    if (failures++ < 10U)
+                    {
+                        fprintf(stderr, "DIVERGENCIA lote=%u registro=%u\n", (unsigned)batch,
+                                (unsigned)want->seq);
+                    }
+                }
+            }
+        }
+    }
+
+    return failures;
+}
+
+/** @brief Texto ThingSpeak com snprintf (8 campos "%.6f"). */
+static size_t encode_text_snprintf(char *out, size_t size, const telemetry_record_t *r)
+{
+    return (size_t)snprintf(out, size,
+                            "field1=%.6f&field2=%.6f&field3=%.6f&field4=%.6f"
+                            "&field5=%.6f&field6=%.6f&field7=%.6f&field8=%.6f",
+                            (double)r->vrms, (double)r->irms, (double)r->v_pu, (double)r->p_w,
+                            r->e_total_wh, (double)r->uptime_s, (double)r->t_ms, (double)r->seq);
+}
+
+/** @brief O mesmo texto montado com lib/fmt. */
+static size_t encode_text_fmt(char *out, size_t size, const telemetry_record_t *r)
+{
+    const double v[8] = {r->vrms, r->irms, r->v_pu, r->p_w, r->e_total_wh,
+                         (double)r->uptime_s, (double)r->t_ms, (double)r->seq};
+    fmt_buf_t b;
+    fmt_buf_init(&b, out, size);
+
+    for (uint32_t k = 0; k < 8U; k++)
+    {
+        fmt_buf_str(&b, k ? "&field" : "field");
+        fmt_buf_u32(&b, k + 1U);
+        fmt_buf_char(&b, '=');
+        fmt_buf_double(&b, v[k], 6);
+    }
+
+    return b.overflow ? 0U : b.len;
+}
+
+/** @brief Imprime uma linha de resultado. */
+static void report(const char *name, double ns, size_t bytes, double base_ns)
+{
+    const double points = (double)BENCH_RECORDS * BENCH_ROUNDS;
+    printf("%-22s: %8.1f ns/ponto | %6.1f bytes/ponto | %5.1fx\n",
+           name, ns / points, (double)bytes / points, base_ns / ns);
+}
+
+/** @brief Mede um cenário de texto. */
+static double bench_text(size_t (*enc)(char *, size_t, const telemetry_record_t *), size_t *bytes)
+{
+    char out[512];
+    size_t total = 0;
+
+    const double t0 = now_ns();
+    for (uint32_t round = 0; round < BENCH_ROUNDS; round++)
+    {
+        for (uint32_t n = 0; n < BENCH_RECORDS; n++)
+        {
+            total += enc(out, sizeof(out), &s_recs[n]);
+        }
+    }
+    const double t1 = now_ns();
+
+    *bytes = total;
+    return t1 - t0;
+}
+
+/** @brief Mede o binário com `batch` registros por payload. */
+static double bench_binary(uint32_t batch, size_t *bytes)
+{
+    static uint8_t buf[TELEMETRY_CODEC_HDR_SIZE + 64U * TELEMETRY_CODEC_REC_SIZE];
+    size_t total = 0;
+
+    const double t0 = now_ns();
+    for (uint32_t round = 0; round < BENCH_ROUNDS; round++)
+    {
+        for (uint32_t base = 0; base < BENCH_RECORDS; base += batch)
+        {
+            telemetry_codec_writer_t w;
+            telemetry_codec_begin(&w, buf, sizeof(buf));
+
+            for (uint32_t k = base; k < base + batch && k < BENCH_RECORDS; k++)
+            {
+                telemetry_codec_add(&w, &s_recs[k]);
+            }
+
+            total += telemetry_codec_finish(&w);
+        }
+    }
+    const double t1 = now_ns();
+
+    *bytes = total;
+    return t1 - t0;
+}
+
+int main(void)
+{
+    make_records();
+
+    const unsigned failures = verify_roundtrip();
+    if (failures)
+    {
+        fprintf(stderr, "%u divergencias; benchmark abortado.\n", failures);
+        return 1;
+    }
+
+    printf("Ida-e-volta binario OK (%u registros, lotes de 1 a 64).\n", (unsigned)BENCH_RECORDS);
+
+    size_t bytes;
+    const double base = bench_text(encode_text_snprintf, &bytes);
+    report("texto snprintf", base, bytes, base);
+
+    double t = bench_text(encode_text_fmt, &bytes);
+    report("texto lib/fmt", t, bytes, base);
+
+    t = bench_binary(1, &bytes);
+    report("binario, 1/payload", t, bytes, base);
+
+    t = bench_binary(10, &bytes);
+    report("binario, lote de 10", t, bytes, base);
+
+    t = bench_binary(60, &bytes);
+    report("binario, lote de 60", t, bytes, base);
+    return 0;
+}
@@ -0,0 +1,123 @@
+/**
+ * @file fmt_bench.c
+ * @brief Benchmark (host) do formatador `lib/fmt.c` contra `snprintf`.
+ * @details
+ *  Só mede: a saída é conferida contra `snprintf` por `tools/fmt_test.c`,
+ *  que deve passar antes de os números valerem.
+ *
+ *  Compilação e execução (a partir de `monitor_energia/`):
+ *      gcc -O2 -I. tools/fmt_bench.c lib/fmt.c -o fmt_bench -lm && ./fmt_bench
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "lib/fmt.h"
+
+#define BENCH_ITERS     2000000U    /**< Iterações por cenário de benchmark. */
+
+/** @brief Relógio monotônico em nanossegundos. */
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/** @brief Mede o custo de uma linha CSV ("%s,%.2f,%.2f,%.2f,%.1f") nos dois caminhos. */
+static void bench_csv_line(void)
+{
+    char line[128];
+    volatile size_t sink = 0;
+    fmt_time_t ft = {2025, 8, 14, 12, 34, 56, 0};
+    double v = 127.03, i = 4.998, pu = 1.0002, p = 634.9;
+
+    double t0 = now_ns();
+    for (uint32_t n = 0; n < BENCH_ITERS; n++)
+    {
+        ft.sec = (uint8_t)(n % 60U);
+        sink += (size_t)snprintf(line, sizeof(line), "%04d-%02d-%02dT%02d:%02d:%02d,%.2f,%.2f,%.2f,%.1f\n",
+                                 ft.year, ft.month, ft.day, ft.hour, ft.min, ft.sec,
+                                 v + n * 1e-3, i, pu, p);
+    }
+    double t1 = now_ns();
+    for (uint32_t n = 0; n < BENCH_ITERS; n++)
+    {
+        fmt_buf_t b;
+        fmt_buf_init(&b, line, sizeof(line));
+        ft.sec = (uint8_t)(n % 60U);
+        fmt_buf_timestamp(&b, &ft, '-', 'T', false);
+        fmt_buf_char(&b, ',');
+        fmt_buf_double(&b, v + n * 1e-3, 2);
+        fmt_buf_char(&b, ',');
+        fmt_buf_double(&b, i, 2);
+        fmt_buf_char(&b, ',');
+        fmt_buf_double(&b, pu, 2);
+        fmt_buf_char(&b, ',');
+        fmt_buf_double(&b, p, 1);
+        fmt_buf_char(&b, '\n');
+        sink += b.len;
+    }
+    double t2 = now_ns();
+
+    printf("linha CSV     : snprintf %7.1f ns | fmt %7.1f ns | %.1fx\n",
+           (t1 - t0) / BENCH_ITERS, (t2 - t1) / BENCH_ITERS, (t1 - t0) / (t2 - t1));
+    (void)sink;
+}
+
+/** @brief Mede um campo "%.6f" (ThingSpeak) nos dois caminhos. */
+static void bench_field6(void)
+{
+    char out[40];
+    volatile size_t sink = 0;
+
+    double t0 = now_ns();
+    for (uint32_t n = 0; n < BENCH_ITERS; n++)
+    {
+        sink += (size_t)snprintf(out, sizeof(out), "%.6f", 634.9 + n * 1e-4);
+    }
+    double t1 = now_ns();
+    for (uint32_t n = 0; n < BENCH_ITERS; n++)
+    {
+        sink += fmt_double(out, sizeof(out), 634.9 + n * 1e-4, 6);
+    }
+    double t2 = now_ns();
+
+    printf("campo %%.6f    : snprintf %7.1f ns | fmt %7.1f ns | %.1fx\n",
+           (t1 - t0) / BENCH_ITERS, (t2 - t1) / BENCH_ITERS, (t1 - t0) / (t2 - t1));
+    (void)sink;
+}
+
+/** @brief Mede o timestamp do logger nos dois caminhos. */
+static void bench_timestamp(void)
+{
+    char out[32];
+    volatile size_t sink = 0;
+    fmt_time_t ft = {2025, 8, 14, 12, 34, 56, 789};
+
+    double t0 = now_ns();
+    for (uint32_t n = 0; n < BENCH_ITERS; n++)
+    {
+        ft.msec = (uint16_t)(n % 1000U);
+        sink += (size_t)snprintf(out, sizeof(out), "%04d/%02d/%02d %02d:%02d:%02d.%03u",
+                                 ft.year, ft.month, ft.day, ft.hour, ft.min, ft.sec, ft.msec);
+    }
+    double t1 = now_ns();
+    for (uint32_t n = 0; n < BENCH_ITERS; n++)
+    {
+        ft.msec = (uint16_t)(n % 1000U);
+        sink += fmt_timestamp(out, sizeof(out), &ft, '/', ' ', true);
+    }
+    double t2 = now_ns();
+
+    printf("timestamp log : snprintf %7.1f ns | fmt %7.1f ns | %.1fx\n",
+           (t1 - t0) / BENCH_ITERS, (t2 - t1) / BENCH_ITERS, (t1 - t0) / (t2 - t1));
+    (void)sink;
+}
+
+int main(void)
+{
+    bench_field6();
+    bench_timestamp();
+    bench_csv_line();
+    return 0;
+}
@@ -0,0 +1,280 @@
+/**
+ * @file fmt_test.c
+ * @brief Teste (host) do formatador `lib/fmt.c`: saída igual à do `snprintf` e ida-e-volta texto -> número.
+ * @details
+ *  Varreduras completas de inteiros, decimais fixos com 1..6 casas e
+ *  timestamps de um ano inteiro contra `snprintf`; ida-e-volta de valores
+ *  `double`; e o contrato de buffer pequeno (nada escrito além de
+ *  `buf[0] = '\0'`, retorno 0, `overflow` no acumulador). Sai com código 1
+ *  na primeira divergência encontrada (mostra até 10). O desempenho fica
+ *  com `tools/fmt_bench.c`.
+ *
+ *  Compilação e execução (a partir de `monitor_energia/`):
+ *      gcc -O2 -I. tools/fmt_test.c lib/fmt.c -o fmt_test -lm && ./fmt_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include "lib/fmt.h"
+
+static unsigned s_failures = 0;
+
+/** @brief Registra divergência (mostra no máximo as 10 primeiras). */
+static void mismatch(const char *what, const char *got, const char *want)
+{
+    if (s_failures++ < 10U)
+    {
+        fprintf(stderr, "DIVERGENCIA %s: fmt=\"%s\" snprintf=\"%s\"\n", what, got, want);
+    }
+}
+
+/** @brief Compara fmt_u32/fmt_i32/fmt_u64 com snprintf em faixas completas. */
+static void verify_integers(void)
+{
+    char a[32];
+    char b[32];
+
+    for (uint32_t v = 0; v < 2000000U; v++)
+    {
+        fmt_u32(a, sizeof(a), v);
+        snprintf(b, sizeof(b), "%u", v);
+        if (strcmp(a, b) != 0)
+        {
+            mismatch("u32", a, b);
+        }
+
+        fmt_i32(a, sizeof(a), -(int32_t)v);
+        snprintf(b, sizeof(b), "%d", -(int32_t)v);
+        if (strcmp(a, b) != 0)
+        {
+            mismatch("i32", a, b);
+        }
+    }
+
+    /* Bordas e potências de 10 ± 1 em 32 e 64 bits. */
+    const int64_t edges[] = {INT64_MIN, INT64_MAX, INT32_MIN, INT32_MAX, UINT32_MAX, (int64_t)UINT32_MAX + 1};
+    for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++)
+    {
+        fmt_i64(a, sizeof(a), edges[i]);
+        snprintf(b, sizeof(b), "%lld", (long long)edges[i]);
+        if (strcmp(a, b) != 0)
+        {
+            mismatch("i64", a, b);
+        }
+    }
+
+    uint64_t p = 1;
+    for (int d = 0; d < 20; d++, p *= 10ULL)
+    {
+        for (int k = -1; k <= 1; k++)
+        {
+            uint64_t v = p + (uint64_t)k;
+            fmt_u64(a, sizeof(a), v);
+            snprintf(b, sizeof(b), "%llu", (unsigned long long)v);
+            if (strcmp(a, b) != 0)
+            {
+                mismatch("u64", a, b);
+            }
+        }
+    }
+
+    for (uint32_t v = 0; v < 100000U; v++)
+    {
+        fmt_u32_pad(a, sizeof(a), v, 4);
+        snprintf(b, sizeof(b), "%04u", v);
+        if (strcmp(a, b) != 0)
+        {
+            mismatch("u32_pad", a, b);
+        }
+    }
+}
+
+/**
+ * @brief Ida-e-volta exaustiva de `fmt_fixed`: todo inteiro escalado em
+ *        [-2e6, 2e6] para 1..6 casas deve voltar ao mesmo valor.
+ */
+static void verify_fixed(void)
+{
+    char a[40];
+    char b[40];
+
+    for (uint8_t dec = 1; dec <= 6; dec++)
+    {
+        double pw = pow(10.0, dec);
+
+        for (int64_t s = -2000000; s <= 2000000; s++)
+        {
+            fmt_fixed(a, sizeof(a), s, dec);
+
+            /* Texto -> inteiro escalado, sem ponto flutuante. */
+            int64_t back = 0;
+            int neg = 0;
+            for (const char *c = a; *c; c++)
+            {
+                if (*c == '-')
+                {
+                    neg = 1;
+                }
+                else if (*c != '.')
+                {
+                    back = back * 10 + (*c - '0');
+                }
+            }
+            if (neg)
+            {
+                back = -back;
+            }
+
+            if (back != s)
+            {
+                snprintf(b, sizeof(b), "%lld", (long long)s);
+                mismatch("fixed roundtrip", a, b);
+            }
+
+            /* Valores exatamente representáveis também batem com snprintf. */
+            if ((s % 8) == 0 && s != 0)
+            {
+                snprintf(b, sizeof(b), "%.*f", dec, (double)s / pw);
+                if (strcmp(a, b) != 0 && fabs(strtod(a, NULL) - strtod(b, NULL)) > 0.6 / pw)
+                {
+                    mismatch("fixed vs snprintf", a, b);
+                }
+            }
+        }
+    }
+
+    /* double -> texto -> double dentro de meia unidade da última casa. */
+    srand(1234);
+    for (uint32_t i = 0; i < 1000000U; i++)
+    {
+        double v = ((double)rand() / RAND_MAX - 0.5) * 2.0e5;
+        fmt_double(a, sizeof(a), v, 6);
+        if (fabs(strtod(a, NULL) - v) > 0.5e-6 + fabs(v) * 1e-15)
+        {
+            snprintf(b, sizeof(b), "%.6f", v);
+            mismatch("double roundtrip", a, b);
+        }
+    }
+}
+
+/** @brief Compara `fmt_timestamp` com snprintf para cada segundo de um ano. */
+static void verify_timestamps(void)
+{
+    char a[32];
+    char b[32];
+    time_t base = 1735689600; /* 2025-01-01 00:00:00 UTC */
+
+    for (time_t t = base; t < base + 366 * 86400; t += 7)
+    {
+        struct tm tm;
+        gmtime_r(&t, &tm);
+        fmt_time_t ft = {
+            .year = (uint16_t)(tm.tm_year + 1900), .month = (uint8_t)(tm.tm_mon + 1),
+            .day = (uint8_t)tm.tm_mday, .hour = (uint8_t)tm.tm_hour,
+            .min = (uint8_t)tm.tm_min, .sec = (uint8_t)tm.tm_sec, .msec = (uint16_t)(t % 1000)};
+
+        fmt_timestamp(a, sizeof(a), &ft, '/', ' ', true);
+        snprintf(b, sizeof(b), "%04d/%02d/%02d %02d:%02d:%02d.%03u",
+                 ft.year, ft.month, ft.day, ft.hour, ft.min, ft.sec, ft.msec);
+        if (strcmp(a, b) != 0)
+        {
+            mismatch("timestamp", a, b);
+        }
+    }
+}
+
+/**
+ * @brief Buffer pequeno: para cada tamanho abaixo do necessário, retorno 0 e
+ *        `buf[0] == '\0'` sem tocar o resto; no tamanho exato, a saída completa.
+ */
+static void verify_small_buffers(void)
+{
+    const fmt_time_t ft = {2026, 10, 19, 23, 59, 58, 999};
+    char full[40];
+    char a[40];
+
+    for (int kind = 0; kind < 3; kind++)
+    {
+        size_t need;
+        if (kind == 0)
+        {
+            need = fmt_u32(full, sizeof(full), 4294967295U);
+        }
+        else if (kind == 1)
+        {
+            need = fmt_fixed(full, sizeof(full), -123456789, 4);
+        }
+        else
+        {
+            need = fmt_timestamp(full, sizeof(full), &ft, '-', 'T', true);
+        }
+
+        for (size_t size = 0; size <= need + 1U; size++)
+        {
+            size_t n;
+            memset(a, 'x', sizeof(a));
+            if (kind == 0)
+            {
+                n = fmt_u32(a, size, 4294967295U);
+            }
+            else if (kind == 1)
+            {
+                n = fmt_fixed(a, size, -123456789, 4);
+            }
+            else
+            {
+                n = fmt_timestamp(a, size, &ft, '-', 'T', true);
+            }
+
+            const bool fits = size > need;
+            const bool ok = fits ? (n == need && strcmp(a, full) == 0)
+                                 : (n == 0 && (size == 0 ? a[0] == 'x' : a[0] == '\0') &&
+                                    (size < 2 || a[1] == 'x'));
+            if (!ok)
+            {
+                char what[32];
+                snprintf(what, sizeof(what), "buffer de %zu", size);
+                a[sizeof(a) - 1] = '\0';
+                mismatch(what, a, full);
+            }
+        }
+    }
+
+    /* Acumulador: o trecho que não cabe marca overflow e não avança. */
+    char line[8];
+    fmt_buf_t b;
+    fmt_buf_init(&b, line, sizeof(line));
+    fmt_buf_str(&b, "abc");
+    fmt_buf_u32(&b, 1234U);
+    if (b.overflow || b.len != 7U || strcmp(line, "abc1234") != 0)
+    {
+        mismatch("fmt_buf cheio", line, "abc1234");
+    }
+    fmt_buf_init(&b, line, sizeof(line));
+    fmt_buf_str(&b, "abc");
+    fmt_buf_u32(&b, 12345U);
+    if (!b.overflow || b.len != 3U)
+    {
+        mismatch("fmt_buf overflow", line, "abc");
+    }
+}
+
+int main(void)
+{
+    verify_integers();
+    verify_fixed();
+    verify_timestamps();
+    verify_small_buffers();
+
+    if (s_failures)
+    {
+        fprintf(stderr, "%u divergencias.\n", s_failures);
+        return 1;
+    }
+
+    printf("fmt: OK\n");
+    return 0;
+}
@@ -0,0 +1,50 @@
+/**
+ * @file FreeRTOS.h
+ * @brief FreeRTOS do host: tipos e macros para compilar módulos do firmware no PC.
+ * @details
+ *  Dois usos:
+ *   - só os cabeçalhos: as ferramentas chamam as funções do sink (`begin`,
+ *     `publish`, `flush`) em sequência, sem scheduler; seções críticas viram
+ *     nada e os mutexes (`semphr.h`) sempre são obtidos na hora;
+ *   - com `tools/host/rtos_host.c`: tasks, filas, notificações e atrasos de
+ *     `task.h`/`queue.h` rodam num scheduler cooperativo de relógio virtual
+ *     (uma task por vez, troca só nas chamadas de API), para os testes de
+ *     módulos com tasks (`tools/<módulo>_test.c`).
+ */
+
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE                 0
+#define pdTRUE                  1
+#define pdPASS                  pdTRUE
+#define pdFAIL                  pdFALSE
+#define portMAX_DELAY           UINT32_MAX
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(ms))
+#define tskIDLE_PRIORITY        0U
+#define configTICK_RATE_HZ      1000U
+#define configMAX_TASK_NAME_LEN 16
+#define taskENTER_CRITICAL()    ((void)0)
+#define taskEXIT_CRITICAL()     ((void)0)
+
+/* IRQ simulada (`rtos_host.c`): o teste chama entre `host_isr_enter` e
+   `host_isr_exit` os callbacks que no firmware rodam na IRQ do lwIP/CYW43; a
+   troca pedida com `portYIELD_FROM_ISR` acontece em `host_isr_exit` */
+extern volatile bool host_in_isr;
+#define portCHECK_IF_IN_ISR()   (host_in_isr)
+#define portYIELD_FROM_ISR(x)   ((void)(x))
+void host_isr_enter(void);
+void host_isr_exit(void);
+
+size_t xPortGetFreeHeapSize(void);
+size_t xPortGetMinimumEverFreeHeapSize(void);
+
+#endif /* HOST_FREERTOS_H */
@@ -0,0 +1,10 @@
+/**
+ * @file credentials.h
+ * @brief `credentials.h` do host: vazio (o real, fora do git, não é necessário nos testes).
+ * @details Broker, tópicos e IP fixo ficam nos padrões dos cabeçalhos de `lib/`.
+ */
+
+#ifndef HOST_CREDENTIALS_H
+#define HOST_CREDENTIALS_H
+
+#endif /* HOST_CREDENTIALS_H */
@@ -0,0 +1,55 @@
+/**
+ * @file cyw43.h
+ * @brief `cyw43.h` do host: tipos, constantes (mesmos valores do driver) e a API usada por `lib/wifi_manager.c`.
+ * @details As funções são o rádio de mentira do teste (`tools/wifi_manager_test.c`).
+ */
+
+#ifndef HOST_CYW43_H
+#define HOST_CYW43_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "lwip/netif.h"
+
+#define CYW43_ITF_STA               0
+#define CYW43_ITF_AP                1
+
+#define CYW43_LINK_DOWN             0
+#define CYW43_LINK_JOIN             1
+#define CYW43_LINK_NOIP             2
+#define CYW43_LINK_UP               3
+#define CYW43_LINK_FAIL             (-1)
+#define CYW43_LINK_NONET            (-2)
+#define CYW43_LINK_BADAUTH          (-3)
+
+#define CYW43_CHANNEL_NONE          0xFFFFFFFFU
+#define CYW43_AUTH_WPA2_AES_PSK     0x00400004U
+
+#define CYW43_NO_POWERSAVE_MODE     0
+#define CYW43_PM1_POWERSAVE_MODE    1
+#define CYW43_PM2_POWERSAVE_MODE    2
+
+#define cyw43_pm_value(pm_mode, pm2_sleep_ret_ms, li_beacon_period, li_dtim_period, li_assoc)                  \
+    ((uint32_t)(li_assoc) << 20 | (uint32_t)(li_dtim_period) << 16 | (uint32_t)(li_beacon_period) << 12 |     \
+     (uint32_t)((pm2_sleep_ret_ms) / 10) << 4 | (uint32_t)(pm_mode))
+
+#define CYW43_DEFAULT_PM            cyw43_pm_value(CYW43_PM2_POWERSAVE_MODE, 200, 1, 1, 10)
+#define CYW43_AGGRESSIVE_PM         cyw43_pm_value(CYW43_PM2_POWERSAVE_MODE, 2000, 1, 1, 10)
+#define CYW43_PERFORMANCE_PM        cyw43_pm_value(CYW43_PM2_POWERSAVE_MODE, 20, 1, 1, 1)
+
+typedef struct _cyw43_t
+{
+    struct netif netif[2];      /**< STA e AP. */
+} cyw43_t;
+
+extern cyw43_t cyw43_state;
+
+int cyw43_wifi_pm(cyw43_t *self, uint32_t pm);
+int cyw43_wifi_join(cyw43_t *self, size_t ssid_len, const uint8_t *ssid, size_t key_len, const uint8_t *key,
+                    uint32_t auth_type, const uint8_t *bssid, uint32_t channel);
+int cyw43_wifi_leave(cyw43_t *self, int itf);
+int cyw43_wifi_get_bssid(cyw43_t *self, uint8_t bssid[6]);
+int cyw43_wifi_get_rssi(cyw43_t *self, int32_t *rssi);
+int cyw43_tcpip_link_status(cyw43_t *self, int itf);
+
+#endif /* HOST_CYW43_H */
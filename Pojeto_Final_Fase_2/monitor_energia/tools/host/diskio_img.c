@@ -0,0 +1,266 @@
+/**
+ * @file diskio_img.c
+ * @brief `disk_*` do FatFs sobre um arquivo de imagem (host), com o custo e as falhas simulados de `diskio_img.h`.
+ */
+
+#include "diskio_img.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "ff.h"
+#include "diskio.h"
+#include "hw_config.h"
+#include "hardware/spi.h"
+
+#define SECTOR  512U
+
+uint64_t host_time_us = 0;
+
+static FILE *s_img = NULL;
+static LBA_t s_sectors = 0;
+static LBA_t s_next_write = 0;  /**< Setor seguinte à última escrita. */
+static diskio_img_stats_t s_stats;
+static bool s_cut_armed = false;
+static bool s_off = false;          /**< Sem energia: todo acesso falha. */
+static uint64_t s_cut_left = 0;     /**< Setores ainda gravados antes do corte. */
+static uint32_t s_tear_bytes = 0;   /**< Bytes novos no setor rasgado. */
+static diskio_img_model_t s_model = DISKIO_IMG_MODEL_DEFAULT;
+static uint32_t s_spi_hz = DISKIO_IMG_SPI_HZ;
+static uint32_t s_rand = 1U;        /**< Estado do xorshift das falhas. */
+
+static spi_t s_spi = {.baud_rate = DISKIO_IMG_SPI_HZ};
+static sd_card_t s_card = {.pcName = "0:", .spi = &s_spi};
+
+/** @brief Troca o modelo de custo e de falhas (reinicia a sequência aleatória). */
+void diskio_img_set_model(const diskio_img_model_t *m)
+{
+    s_model = *m;
+    s_rand = m->seed ? m->seed : 1U;
+}
+
+uint32_t diskio_img_spi_hz(void)
+{
+    return s_spi_hz;
+}
+
+/**
+ * @brief `spi_set_baudrate` do host: o mesmo divisor par do RP2040 sobre `clk_peri`.
+ * @return Relógio obtido (ex.: 25 MHz pedidos dão 20,8 MHz).
+ */
+uint32_t spi_set_baudrate(spi_inst_t *spi, uint32_t baudrate)
+{
+    (void)spi;
+    uint32_t div = (DISKIO_IMG_CLK_PERI_HZ + baudrate - 1U) / baudrate;
+    div += div & 1U;
+    s_spi_hz = DISKIO_IMG_CLK_PERI_HZ / (div ? div : 2U);
+    return s_spi_hz;
+}
+
+/** @brief Cartão do drive 0 sobre a imagem (`hw_config.h` do host). */
+sd_card_t *sd_get_by_num(size_t num)
+{
+    return (num == 0U) ? &s_card : NULL;
+}
+
+/** @brief Sorteia um evento com probabilidade `ppm` por milhão (xorshift32). */
+static bool chance(uint32_t ppm)
+{
+    if (ppm == 0U)
+    {
+        return false;
+    }
+    s_rand ^= s_rand << 13;
+    s_rand ^= s_rand >> 17;
+    s_rand ^= s_rand << 5;
+    return (s_rand % 1000000U) < ppm;
+}
+
+/** @brief Adianta o relógio virtual por comando e transferência de `count` setores no SPI atual. */
+static void charge(UINT count, uint32_t per_sector_us)
+{
+    const uint64_t xfer_us = ((uint64_t)SECTOR * 8U * 1000000U + s_spi_hz - 1U) / s_spi_hz;
+    const uint64_t dt = s_model.cmd_us + (xfer_us + per_sector_us) * count;
+    host_time_us += dt;
+    s_stats.busy_us += dt;
+}
+
+/** @brief Falha da transferência: relógio acima da fiação ou erro transitório sorteado. */
+static bool fault(uint32_t ppm)
+{
+    if ((s_model.spi_max_hz && s_spi_hz > s_model.spi_max_hz) || chance(ppm))
+    {
+        s_stats.faults++;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Abre (ou cria, esparso) a imagem com `bytes` de capacidade.
+ */
+bool diskio_img_open(const char *path, uint64_t bytes)
+{
+    s_img = fopen(path, "r+b");
+    if (!s_img)
+    {
+        s_img = fopen(path, "w+b");
+    }
+    if (!s_img || ftruncate(fileno(s_img), (off_t)bytes) != 0)
+    {
+        return false;
+    }
+
+    s_sectors = (LBA_t)(bytes / SECTOR);
+    memset(&s_stats, 0, sizeof(s_stats));
+    diskio_img_power_on();
+    return true;
+}
+
+void diskio_img_close(void)
+{
+    if (s_img)
+    {
+        fclose(s_img);
+        s_img = NULL;
+    }
+}
+
+void diskio_img_get_stats(diskio_img_stats_t *out)
+{
+    *out = s_stats;
+}
+
+/**
+ * @brief Arma uma queda de energia depois de `after_sectors` setores gravados.
+ * @param tear_bytes Bytes novos no setor seguinte (0: setor intacto; até 511).
+ */
+void diskio_img_cut(uint64_t after_sectors, uint32_t tear_bytes)
+{
+    s_cut_armed = true;
+    s_cut_left = after_sectors;
+    s_tear_bytes = (tear_bytes < SECTOR) ? tear_bytes : SECTOR - 1U;
+}
+
+/** @brief Religa o disco e desarma o corte. */
+void diskio_img_power_on(void)
+{
+    s_cut_armed = false;
+    s_off = false;
+}
+
+bool diskio_img_powered(void)
+{
+    return !s_off;
+}
+
+DSTATUS disk_status(BYTE pdrv)
+{
+    return (pdrv == 0U && s_img && !s_off) ? 0U : STA_NOINIT;
+}
+
+DSTATUS disk_initialize(BYTE pdrv)
+{
+    return disk_status(pdrv);
+}
+
+DRESULT disk_read(BYTE pdrv, BYTE *buff, LBA_t sector, UINT count)
+{
+    if (disk_status(pdrv) || sector + count > s_sectors)
+    {
+        return s_off ? RES_NOTRDY : RES_PARERR;
+    }
+
+    s_stats.reads++;
+    s_stats.read_sectors += count;
+    charge(count, 0U);
+    if (fault(s_model.read_err_ppm))
+    {
+        return RES_ERROR;
+    }
+
+    fseeko(s_img, (off_t)sector * SECTOR, SEEK_SET);
+    return (fread(buff, SECTOR, count, s_img) == count) ? RES_OK : RES_ERROR;
+}
+
+DRESULT disk_write(BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count)
+{
+    if (disk_status(pdrv) || sector + count > s_sectors)
+    {
+        return s_off ? RES_NOTRDY : RES_PARERR;
+    }
+
+    s_stats.writes++;
+    s_stats.write_sectors += count;
+    charge(count, s_model.prog_us);
+    if (sector != s_next_write)
+    {
+        s_stats.write_jumps++;
+        host_time_us += s_model.jump_us;
+        s_stats.busy_us += s_model.jump_us;
+    }
+    if (chance(s_model.stall_ppm))
+    {
+        s_stats.stalls++;
+        host_time_us += s_model.stall_us;
+        s_stats.busy_us += s_model.stall_us;
+    }
+    if (fault(s_model.write_err_ppm))
+    {
+        return RES_ERROR; /* Nada gravado; o chamador repete o comando inteiro */
+    }
+    s_next_write = sector + count;
+
+    fseeko(s_img, (off_t)sector * SECTOR, SEEK_SET);
+    if (!s_cut_armed || s_cut_left >= count)
+    {
+        s_cut_left -= s_cut_armed ? count : 0U;
+        return (fwrite(buff, SECTOR, count, s_img) == count) ? RES_OK : RES_ERROR;
+    }
+
+    /* Corte: os setores anteriores entram, o seguinte fica rasgado */
+    const UINT whole = (UINT)s_cut_left;
+    if (fwrite(buff, SECTOR, whole, s_img) != whole ||
+        (s_tear_bytes && fwrite(buff + (size_t)whole * SECTOR, 1, s_tear_bytes, s_img) != s_tear_bytes))
+    {
+        return RES_ERROR;
+    }
+    fflush(s_img);
+    s_cut_armed = false;
+    s_off = true;
+    s_stats.cuts++;
+    return RES_NOTRDY;
+}
+
+DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff)
+{
+    if (disk_status(pdrv))
+    {
+        return RES_NOTRDY;
+    }
+
+    switch (cmd)
+    {
+    case CTRL_SYNC:
+        fflush(s_img);
+        return RES_OK;
+    case GET_SECTOR_COUNT:
+        *(LBA_t *)buff = s_sectors;
+        return RES_OK;
+    case GET_SECTOR_SIZE:
+        *(WORD *)buff = SECTOR;
+        return RES_OK;
+    case GET_BLOCK_SIZE:
+        *(DWORD *)buff = 8192U; /* Bloco de apagamento em setores (4 MB), alinha a FAT como num cartão */
+        return RES_OK;
+    default:
+        return RES_PARERR;
+    }
+}
+
+/**
+ * @brief Data fixa nos arquivos criados (o relógio virtual não é uma data).
+ */
+DWORD get_fattime(void)
+{
+    return ((DWORD)(2026 - 1980) << 25) | ((DWORD)1 << 21) | ((DWORD)1 << 16);
+}
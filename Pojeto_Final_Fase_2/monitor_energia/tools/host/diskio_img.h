@@ -0,0 +1,87 @@
+/**
+ * @file diskio_img.h
+ * @brief Disco do FatFs (drive 0) sobre um arquivo de imagem, com custo de cartão SD simulado (host).
+ * @details
+ *  Implementa `disk_*` e `get_fattime` para compilar o FatFs do submódulo
+ *  no PC. Cada acesso adianta o relógio virtual (`host_time_us`) segundo um
+ *  modelo simples de cartão em SPI: comando, transferência por setor e, na
+ *  escrita, programação; escrita fora de sequência (FAT, diretório,
+ *  cluster recém-alocado longe do anterior) paga também uma troca de
+ *  bloco de apagamento no cartão. Os números são da ordem dos medidos com
+ *  `sd` no firmware, não uma caracterização de cartão. O modelo é
+ *  configurável (`diskio_img_set_model`); a transferência segue o relógio
+ *  do SPI, que o `spi_set_baudrate` do host (`tools/host/hardware/spi.h`)
+ *  ajusta, então a negociação de `lib/sd_card.c` muda o custo como no
+ *  firmware.
+ *
+ *  Falhas: acima de `spi_max_hz` (limite da fiação) toda transferência
+ *  falha com `RES_ERROR`; abaixo, leituras e escritas falham ao acaso com
+ *  as taxas do modelo (semente fixa, reprodutível), e escritas podem
+ *  travar por `stall_us` (coleta de lixo interna do cartão).
+ *
+ *  Queda de energia: `diskio_img_cut` arma um corte depois de um número de
+ *  setores gravados; o setor seguinte fica rasgado (só os primeiros
+ *  `tear_bytes` bytes novos, o resto com o conteúdo anterior) e todo acesso
+ *  seguinte falha com `RES_NOTRDY` até `diskio_img_power_on`, como um
+ *  cartão sem alimentação no meio de um `CMD25`.
+ *
+ *  `sd_get_by_num` dá o cartão do drive 0 (`hw_config.h` do host), para
+ *  compilar `lib/sd_card.c` e `lib/sd_card_log_task.c` sem alteração
+ *  (`tools/sd_bench.c`).
+ */
+
+#ifndef DISKIO_IMG_H
+#define DISKIO_IMG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define DISKIO_IMG_CMD_US       100U    /**< Comando + resposta. */
+#define DISKIO_IMG_SPI_HZ       (12500U * 1000U) /**< Relógio inicial do SPI (512 B em ~330 µs). */
+#define DISKIO_IMG_PROG_US      250U    /**< Programação de um setor. */
+#define DISKIO_IMG_JUMP_US      1800U   /**< Escrita fora de sequência (troca de bloco). */
+#define DISKIO_IMG_CLK_PERI_HZ  (125U * 1000U * 1000U) /**< `clk_peri` do RP2040 (divisores do SPI). */
+
+/** @brief Modelo de custo e de falhas do cartão. */
+typedef struct
+{
+    uint32_t cmd_us;            /**< Comando + resposta, por chamada. */
+    uint32_t prog_us;           /**< Programação, por setor gravado. */
+    uint32_t jump_us;           /**< Escrita fora de sequência. */
+    uint32_t spi_max_hz;        /**< Maior relógio que a fiação aguenta (0: sem limite). */
+    uint32_t read_err_ppm;      /**< Leituras com erro transitório [por milhão]. */
+    uint32_t write_err_ppm;     /**< Escritas com erro transitório [por milhão]. */
+    uint32_t stall_ppm;         /**< Escritas com trava interna [por milhão]. */
+    uint32_t stall_us;          /**< Duração de uma trava. */
+    uint32_t seed;              /**< Semente das falhas. */
+} diskio_img_model_t;
+
+/** @brief Modelo padrão: sem falhas, fiação de até 25 MHz. */
+#define DISKIO_IMG_MODEL_DEFAULT                                                                                   \
+    {.cmd_us = DISKIO_IMG_CMD_US, .prog_us = DISKIO_IMG_PROG_US, .jump_us = DISKIO_IMG_JUMP_US,                    \
+     .spi_max_hz = 25000U * 1000U, .seed = 1U}
+
+/** @brief Contadores do disco simulado. */
+typedef struct
+{
+    uint32_t reads;             /**< Chamadas de disk_read. */
+    uint32_t read_sectors;      /**< Setores lidos. */
+    uint32_t writes;            /**< Chamadas de disk_write. */
+    uint32_t write_sectors;     /**< Setores gravados. */
+    uint32_t write_jumps;       /**< Escritas fora de sequência. */
+    uint32_t cuts;              /**< Quedas de energia simuladas. */
+    uint32_t faults;            /**< Erros injetados (taxa ou relógio acima da fiação). */
+    uint32_t stalls;            /**< Travas de escrita injetadas. */
+    uint64_t busy_us;           /**< Tempo total de disco (relógio virtual). */
+} diskio_img_stats_t;
+
+bool diskio_img_open(const char *path, uint64_t bytes);
+void diskio_img_close(void);
+void diskio_img_get_stats(diskio_img_stats_t *out);
+void diskio_img_set_model(const diskio_img_model_t *m);
+uint32_t diskio_img_spi_hz(void);
+void diskio_img_cut(uint64_t after_sectors, uint32_t tear_bytes);
+void diskio_img_power_on(void);
+bool diskio_img_powered(void);
+
+#endif /* DISKIO_IMG_H */
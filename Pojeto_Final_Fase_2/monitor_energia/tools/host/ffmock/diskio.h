@@ -0,0 +1,38 @@
+/**
+ * @file diskio.h
+ * @brief `diskio.h` de mentira (ver `ff.h`): as funções de disco de `tools/host/diskio_img.c`.
+ */
+
+#ifndef HOST_FFMOCK_DISKIO_H
+#define HOST_FFMOCK_DISKIO_H
+
+#include "ff.h"
+
+typedef BYTE DSTATUS;
+
+/** @brief Resultados de disco (mesmos valores do FatFs). */
+typedef enum
+{
+    RES_OK = 0,
+    RES_ERROR,
+    RES_WRPRT,
+    RES_NOTRDY,
+    RES_PARERR
+} DRESULT;
+
+#define STA_NOINIT          0x01
+#define STA_NODISK          0x02
+
+#define CTRL_SYNC           0
+#define GET_SECTOR_COUNT    1
+#define GET_SECTOR_SIZE     2
+#define GET_BLOCK_SIZE      3
+
+DSTATUS disk_status(BYTE pdrv);
+DSTATUS disk_initialize(BYTE pdrv);
+DRESULT disk_read(BYTE pdrv, BYTE *buff, LBA_t sector, UINT count);
+DRESULT disk_write(BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count);
+DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff);
+DWORD get_fattime(void);
+
+#endif /* HOST_FFMOCK_DISKIO_H */
@@ -0,0 +1,129 @@
+/**
+ * @file ff.h
+ * @brief `ff.h` de mentira: o subconjunto da API do FatFs usado pelo log do SD, sobre arquivos do PC.
+ * @details
+ *  Para rodar `tools/sd_bench.c` sem o submódulo do FatFs (vazio nesta
+ *  árvore). Os tipos e constantes seguem os do FatFs R0.15; as estruturas
+ *  só têm os campos que o firmware lê (`f_size`, `fatbase`, `fname`). A
+ *  implementação está em `ff_mock.c`.
+ */
+
+#ifndef HOST_FFMOCK_FF_H
+#define HOST_FFMOCK_FF_H
+
+#include <stdint.h>
+
+typedef unsigned int UINT;
+typedef uint8_t BYTE;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+typedef uint64_t QWORD;
+typedef DWORD LBA_t;
+typedef DWORD FSIZE_t;
+typedef char TCHAR;
+
+#define FF_USE_EXPAND   1       /**< `f_expand` disponível. */
+#define FF_MIN_SS       512     /**< Setor mínimo. */
+#define FF_MAX_SS       512     /**< Setor máximo. */
+#define FF_LFN_BUF      255     /**< Nome longo em `FILINFO`. */
+
+/** @brief Resultados do FatFs (mesmos valores do R0.15). */
+typedef enum
+{
+    FR_OK = 0,
+    FR_DISK_ERR,
+    FR_INT_ERR,
+    FR_NOT_READY,
+    FR_NO_FILE,
+    FR_NO_PATH,
+    FR_INVALID_NAME,
+    FR_DENIED,
+    FR_EXIST,
+    FR_INVALID_OBJECT,
+    FR_WRITE_PROTECTED,
+    FR_INVALID_DRIVE,
+    FR_NOT_ENABLED,
+    FR_NO_FILESYSTEM,
+    FR_MKFS_ABORTED,
+    FR_TIMEOUT,
+    FR_LOCKED,
+    FR_NOT_ENOUGH_CORE,
+    FR_TOO_MANY_OPEN_FILES,
+    FR_INVALID_PARAMETER
+} FRESULT;
+
+/** @brief Volume: só o início da FAT, relido pela negociação do SPI. */
+typedef struct
+{
+    LBA_t fatbase;      /**< Primeiro setor da FAT (0 no mock). */
+} FATFS;
+
+/** @brief Arquivo aberto. */
+typedef struct
+{
+    FSIZE_t fptr;       /**< Posição de leitura/escrita. */
+    FSIZE_t objsize;    /**< Tamanho. */
+    void *fp;           /**< `FILE *` do PC (NULL: fechado). */
+    LBA_t base;         /**< Setor simulado do início do arquivo. */
+} FIL;
+
+/** @brief Diretório aberto. */
+typedef struct
+{
+    void *dp;           /**< `DIR *` do PC. */
+    char path[64];      /**< Caminho, para o `stat` das entradas. */
+} DIR;
+
+/** @brief Entrada de diretório. */
+typedef struct
+{
+    FSIZE_t fsize;              /**< Tamanho. */
+    WORD fdate;                 /**< Data (não preenchida). */
+    WORD ftime;                 /**< Hora (não preenchida). */
+    BYTE fattrib;               /**< `AM_*`. */
+    TCHAR fname[FF_LFN_BUF + 1]; /**< Nome ("" no fim do diretório). */
+} FILINFO;
+
+/** @brief Parâmetros de `f_mkfs` (ignorados). */
+typedef struct
+{
+    BYTE fmt;
+    BYTE n_fat;
+    UINT align;
+    UINT n_root;
+    DWORD au_size;
+} MKFS_PARM;
+
+#define FA_READ             0x01
+#define FA_WRITE            0x02
+#define FA_OPEN_EXISTING    0x00
+#define FA_CREATE_NEW       0x04
+#define FA_CREATE_ALWAYS    0x08
+#define FA_OPEN_ALWAYS      0x10
+#define FA_OPEN_APPEND      0x30
+
+#define AM_DIR              0x10
+#define FM_FAT32            0x02
+
+#define f_size(fp)  ((fp)->objsize)
+#define f_tell(fp)  ((fp)->fptr)
+#define f_eof(fp)   ((int)((fp)->fptr == (fp)->objsize))
+
+FRESULT f_mount(FATFS *fs, const TCHAR *path, BYTE opt);
+FRESULT f_mkfs(const TCHAR *path, const MKFS_PARM *opt, void *work, UINT len);
+FRESULT f_open(FIL *fp, const TCHAR *path, BYTE mode);
+FRESULT f_close(FIL *fp);
+FRESULT f_read(FIL *fp, void *buff, UINT btr, UINT *br);
+FRESULT f_write(FIL *fp, const void *buff, UINT btw, UINT *bw);
+FRESULT f_lseek(FIL *fp, FSIZE_t ofs);
+FRESULT f_truncate(FIL *fp);
+FRESULT f_sync(FIL *fp);
+FRESULT f_expand(FIL *fp, FSIZE_t fsz, BYTE opt);
+FRESULT f_mkdir(const TCHAR *path);
+FRESULT f_stat(const TCHAR *path, FILINFO *fno);
+FRESULT f_unlink(const TCHAR *path);
+FRESULT f_opendir(DIR *dp, const TCHAR *path);
+FRESULT f_readdir(DIR *dp, FILINFO *fno);
+FRESULT f_closedir(DIR *dp);
+
+#endif /* HOST_FFMOCK_FF_H */
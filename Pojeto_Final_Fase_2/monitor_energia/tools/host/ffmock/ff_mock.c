@@ -0,0 +1,356 @@
+/**
+ * @file ff_mock.c
+ * @brief FatFs de mentira (host): os arquivos do volume são arquivos do diretório corrente, e cada acesso cobra o disco simulado.
+ * @details
+ *  Substitui o FatFs do submódulo em `tools/sd_bench.c` quando ele não
+ *  está disponível. Os dados ficam em arquivos comuns (o diretório `log/`
+ *  do log diário nasce no diretório corrente); o custo de cartão vem de
+ *  chamadas a `disk_read`/`disk_write`, que passam pelo wrapper de
+ *  `lib/sd_card.c` (contadores, degraus do SPI) e pelo modelo de
+ *  `tools/host/diskio_img.c` (tempo, erros, travas):
+ *   - `f_read`/`f_write` cobram os setores do trecho do arquivo, em
+ *     comandos de até `FFMOCK_MAX_SECTORS`, numa faixa de setores própria de
+ *     cada arquivo aberto (gravação sequencial continua sequencial);
+ *   - `f_sync` cobra um setor de diretório fora de sequência;
+ *   - `f_expand` não cobra nada (no FatFs real, só a FAT muda) e preenche o
+ *     arquivo com o conteúdo de arquivos apagados antes, como o lixo que
+ *     a pré-alocação deixa no cartão (exercita a recuperação do diário).
+ *
+ *  Não há FAT nem diretório no disco simulado: tempos de FAT, de busca de
+ *  cluster e de atualização de entrada ficam de fora. Os números do
+ *  benchmark com o mock valem para comparar modos e frequências, não como
+ *  os de um FatFs real; a integridade após quedas fica com `tools/sd_soak.c`
+ *  e `tools/sd_powercut.c`, que exigem o FatFs de verdade.
+ *
+ *  Compilação: ver `tools/sd_bench.c`.
+ */
+
+#include <dirent.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* O DIR do FatFs tem o mesmo nome do DIR do <dirent.h> */
+#define DIR FF_DIR
+#include "ff.h"
+#include "diskio.h"
+#undef DIR
+
+#define FFMOCK_MAX_SECTORS  64U         /**< Setores por comando de leitura/escrita. */
+#define FFMOCK_FILE_BASE    100000U     /**< Setor do primeiro arquivo. */
+#define FFMOCK_FILE_SPAN    1000000U    /**< Setores reservados por arquivo aberto (~500 MB). */
+#define FFMOCK_FILE_SLOTS   7U          /**< Faixas de arquivo (cabem na imagem de 4 GB). */
+#define FFMOCK_DIR_SECTOR   10U         /**< Setor "de diretório" cobrado por `f_sync`. */
+#define FFMOCK_SECTOR       512U        /**< Bytes por setor. */
+
+static uint8_t s_zero[FFMOCK_MAX_SECTORS * FFMOCK_SECTOR];  /**< Dados das cobranças (descartados). */
+static uint8_t *s_stale = NULL;         /**< Conteúdo do último arquivo apagado. */
+static size_t s_stale_len = 0;
+static unsigned s_next_slot = 0;        /**< Próxima faixa de setores. */
+
+/** @brief Tira o prefixo de drive ("0:") do caminho. */
+static const char *host_path(const TCHAR *path)
+{
+    return (path[0] >= '0' && path[0] <= '9' && path[1] == ':') ? path + 2 : path;
+}
+
+/** @brief Cobra do disco simulado os setores do trecho [off, off + n) do arquivo. */
+static FRESULT charge(const FIL *fp, FSIZE_t off, UINT n, bool write)
+{
+    if (n == 0U)
+    {
+        return FR_OK;
+    }
+
+    LBA_t s = fp->base + off / FFMOCK_SECTOR;
+    const LBA_t end = fp->base + (off + n + FFMOCK_SECTOR - 1U) / FFMOCK_SECTOR;
+
+    while (s < end)
+    {
+        const UINT c = (end - s > FFMOCK_MAX_SECTORS) ? FFMOCK_MAX_SECTORS : (UINT)(end - s);
+        const DRESULT r = write ? disk_write(0, s_zero, s, c) : disk_read(0, s_zero, s, c);
+        if (r != RES_OK)
+        {
+            return (r == RES_NOTRDY) ? FR_NOT_READY : FR_DISK_ERR;
+        }
+        s += c;
+    }
+    return FR_OK;
+}
+
+FRESULT f_mount(FATFS *fs, const TCHAR *path, BYTE opt)
+{
+    (void)path;
+    (void)opt;
+    fs->fatbase = 0;
+    return (disk_initialize(0) & STA_NOINIT) ? FR_NOT_READY : FR_OK;
+}
+
+FRESULT f_mkfs(const TCHAR *path, const MKFS_PARM *opt, void *work, UINT len)
+{
+    (void)path;
+    (void)opt;
+    (void)work;
+    (void)len;
+    return FR_OK;
+}
+
+FRESULT f_open(FIL *fp, const TCHAR *path, BYTE mode)
+{
+    const char *p = host_path(path);
+    FILE *f = fopen(p, "r+b");
+
+    memset(fp, 0, sizeof(*fp));
+    if (f && (mode & FA_CREATE_NEW) && !(mode & FA_OPEN_ALWAYS))
+    {
+        fclose(f);
+        return FR_EXIST;
+    }
+    if (f && (mode & FA_CREATE_ALWAYS))
+    {
+        fclose(f);
+        f = NULL;
+    }
+    if (!f)
+    {
+        if (!(mode & (FA_CREATE_NEW | FA_CREATE_ALWAYS | FA_OPEN_ALWAYS)))
+        {
+            return FR_NO_FILE;
+        }
+        f = fopen(p, "w+b");
+        if (!f)
+        {
+            return FR_NO_PATH;
+        }
+    }
+
+    fseek(f, 0, SEEK_END);
+    fp->fp = f;
+    fp->objsize = (FSIZE_t)ftell(f);
+    fp->fptr = ((mode & FA_OPEN_APPEND) == FA_OPEN_APPEND) ? fp->objsize : 0U;
+    fp->base = FFMOCK_FILE_BASE + (LBA_t)(s_next_slot++ % FFMOCK_FILE_SLOTS) * FFMOCK_FILE_SPAN;
+    return FR_OK;
+}
+
+FRESULT f_close(FIL *fp)
+{
+    if (!fp->fp)
+    {
+        return FR_INVALID_OBJECT;
+    }
+    fclose((FILE *)fp->fp);
+    fp->fp = NULL;
+    return FR_OK;
+}
+
+FRESULT f_read(FIL *fp, void *buff, UINT btr, UINT *br)
+{
+    *br = 0;
+    if (!fp->fp)
+    {
+        return FR_INVALID_OBJECT;
+    }
+    if (fp->fptr >= fp->objsize)
+    {
+        return FR_OK;
+    }
+    if (btr > fp->objsize - fp->fptr)
+    {
+        btr = fp->objsize - fp->fptr;
+    }
+
+    const FRESULT fr = charge(fp, fp->fptr, btr, false);
+    if (fr != FR_OK)
+    {
+        return fr;
+    }
+    fseek((FILE *)fp->fp, (long)fp->fptr, SEEK_SET);
+    *br = (UINT)fread(buff, 1, btr, (FILE *)fp->fp);
+    fp->fptr += *br;
+    return FR_OK;
+}
+
+FRESULT f_write(FIL *fp, const void *buff, UINT btw, UINT *bw)
+{
+    *bw = 0;
+    if (!fp->fp)
+    {
+        return FR_INVALID_OBJECT;
+    }
+
+    const FRESULT fr = charge(fp, fp->fptr, btw, true);
+    if (fr != FR_OK)
+    {
+        return fr;
+    }
+    fseek((FILE *)fp->fp, (long)fp->fptr, SEEK_SET);
+    *bw = (UINT)fwrite(buff, 1, btw, (FILE *)fp->fp);
+    fp->fptr += *bw;
+    fp->objsize = (fp->fptr > fp->objsize) ? fp->fptr : fp->objsize;
+    return (*bw == btw) ? FR_OK : FR_DISK_ERR;
+}
+
+FRESULT f_lseek(FIL *fp, FSIZE_t ofs)
+{
+    if (!fp->fp)
+    {
+        return FR_INVALID_OBJECT;
+    }
+    fp->fptr = ofs;
+    return FR_OK;
+}
+
+FRESULT f_truncate(FIL *fp)
+{
+    if (!fp->fp)
+    {
+        return FR_INVALID_OBJECT;
+    }
+    fflush((FILE *)fp->fp);
+    if (ftruncate(fileno((FILE *)fp->fp), (off_t)fp->fptr) != 0)
+    {
+        return FR_DISK_ERR;
+    }
+    fp->objsize = fp->fptr;
+    return FR_OK;
+}
+
+FRESULT f_sync(FIL *fp)
+{
+    if (!fp->fp)
+    {
+        return FR_INVALID_OBJECT;
+    }
+
+    const DRESULT r = disk_write(0, s_zero, FFMOCK_DIR_SECTOR, 1);
+    if (r != RES_OK)
+    {
+        return (r == RES_NOTRDY) ? FR_NOT_READY : FR_DISK_ERR;
+    }
+    fflush((FILE *)fp->fp);
+    return FR_OK;
+}
+
+FRESULT f_expand(FIL *fp, FSIZE_t fsz, BYTE opt)
+{
+    (void)opt;
+    if (!fp->fp)
+    {
+        return FR_INVALID_OBJECT;
+    }
+
+    uint8_t *b = malloc(fsz ? fsz : 1U);
+    if (!b)
+    {
+        return FR_NOT_ENOUGH_CORE;
+    }
+    for (FSIZE_t i = 0; i < fsz; i++)
+    {
+        b[i] = s_stale_len ? s_stale[i % s_stale_len] : (uint8_t)rand();
+    }
+    fseek((FILE *)fp->fp, 0, SEEK_SET);
+    const size_t n = fwrite(b, 1, fsz, (FILE *)fp->fp);
+    free(b);
+    fp->objsize = fsz;
+    return (n == fsz) ? FR_OK : FR_DISK_ERR;
+}
+
+FRESULT f_mkdir(const TCHAR *path)
+{
+    if (mkdir(host_path(path), 0777) == 0)
+    {
+        return FR_OK;
+    }
+    return (errno == EEXIST) ? FR_EXIST : FR_NO_PATH;
+}
+
+FRESULT f_stat(const TCHAR *path, FILINFO *fno)
+{
+    struct stat st;
+    const char *p = host_path(path);
+
+    if (stat(p, &st) != 0)
+    {
+        return FR_NO_FILE;
+    }
+    if (fno)
+    {
+        const char *slash = strrchr(p, '/');
+        fno->fsize = (FSIZE_t)st.st_size;
+        fno->fattrib = S_ISDIR(st.st_mode) ? AM_DIR : 0U;
+        snprintf(fno->fname, sizeof(fno->fname), "%s", slash ? slash + 1 : p);
+    }
+    return FR_OK;
+}
+
+FRESULT f_unlink(const TCHAR *path)
+{
+    const char *p = host_path(path);
+    FILE *f = fopen(p, "rb");
+
+    /* O conteúdo apagado volta como lixo na próxima pré-alocação */
+    if (f)
+    {
+        fseek(f, 0, SEEK_END);
+        const long n = ftell(f);
+        rewind(f);
+        uint8_t *b = (n > 0) ? malloc((size_t)n) : NULL;
+        if (b)
+        {
+            free(s_stale);
+            s_stale = b;
+            s_stale_len = fread(b, 1, (size_t)n, f);
+        }
+        fclose(f);
+    }
+    return (remove(p) == 0) ? FR_OK : FR_NO_FILE;
+}
+
+FRESULT f_opendir(FF_DIR *dp, const TCHAR *path)
+{
+    const char *p = host_path(path);
+    DIR *d = opendir(p);
+
+    if (!d)
+    {
+        return FR_NO_PATH;
+    }
+    dp->dp = d;
+    snprintf(dp->path, sizeof(dp->path), "%s", p);
+    return FR_OK;
+}
+
+FRESULT f_readdir(FF_DIR *dp, FILINFO *fno)
+{
+    struct dirent *e;
+
+    do
+    {
+        e = readdir((DIR *)dp->dp);
+    } while (e && e->d_name[0] == '.');
+
+    if (!e)
+    {
+        fno->fname[0] = '\0';
+        return FR_OK;
+    }
+
+    char full[sizeof(dp->path) + sizeof(fno->fname) + 1U];
+    struct stat st;
+    snprintf(full, sizeof(full), "%s/%s", dp->path, e->d_name);
+    snprintf(fno->fname, sizeof(fno->fname), "%s", e->d_name);
+    fno->fsize = (stat(full, &st) == 0) ? (FSIZE_t)st.st_size : 0U;
+    fno->fattrib = (stat(full, &st) == 0 && S_ISDIR(st.st_mode)) ? AM_DIR : 0U;
+    return FR_OK;
+}
+
+FRESULT f_closedir(FF_DIR *dp)
+{
+    closedir((DIR *)dp->dp);
+    dp->dp = NULL;
+    return FR_OK;
+}
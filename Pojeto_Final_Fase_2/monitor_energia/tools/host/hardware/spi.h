@@ -0,0 +1,15 @@
+/**
+ * @file spi.h
+ * @brief `hardware/spi.h` do host: o relógio do SPI vai para o modelo de `tools/host/diskio_img.c`.
+ */
+
+#ifndef HOST_HARDWARE_SPI_H
+#define HOST_HARDWARE_SPI_H
+
+#include <stdint.h>
+
+typedef struct spi_inst spi_inst_t;     /**< Opaco, como no SDK. */
+
+uint32_t spi_set_baudrate(spi_inst_t *spi, uint32_t baudrate);
+
+#endif /* HOST_HARDWARE_SPI_H */
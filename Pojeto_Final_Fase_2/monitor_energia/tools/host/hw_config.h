@@ -0,0 +1,32 @@
+/**
+ * @file hw_config.h
+ * @brief `hw_config.h` do host: só os campos de `spi_t` e `sd_card_t` usados por `lib/sd_card.c`.
+ * @details O cartão do drive 0 vem de `sd_get_by_num`, em `tools/host/diskio_img.c`.
+ */
+
+#ifndef HOST_HW_CONFIG_H
+#define HOST_HW_CONFIG_H
+
+#include <stddef.h>
+#include "ff.h"
+#include "pico/types.h"
+#include "hardware/spi.h"
+
+/** @brief SPI do cartão. */
+typedef struct
+{
+    spi_inst_t *hw_inst;        /**< Periférico (não usado no host). */
+    uint baud_rate;             /**< Relógio pedido. */
+} spi_t;
+
+/** @brief Cartão SD de um drive do FatFs. */
+typedef struct
+{
+    const char *pcName;         /**< Drive ("0:"). */
+    spi_t *spi;                 /**< SPI do cartão. */
+    FATFS fatfs;                /**< Volume montado. */
+} sd_card_t;
+
+sd_card_t *sd_get_by_num(size_t num);
+
+#endif /* HOST_HW_CONFIG_H */
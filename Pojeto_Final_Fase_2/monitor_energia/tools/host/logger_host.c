@@ -0,0 +1,32 @@
+/**
+ * @file logger_host.c
+ * @brief `lib/logger` do host: os `LOG*` dos módulos testados saem direto no stderr, de avisos para cima.
+ * @details Com `HOST_LOG_LEVEL=4` no ambiente, sai tudo (depuração de um teste).
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "pico/time.h"
+#include "lib/logger.h"
+
+volatile uint8_t logger_tag_levels[LOGGER_MAX_TAGS + 1U];
+
+int8_t logger_tag_slot(const char *tag)
+{
+    (void)tag;
+    const char *env = getenv("HOST_LOG_LEVEL");
+    logger_tag_levels[0] = env ? (uint8_t)atoi(env) : LOG_LEVEL_WARN;
+    return 0;
+}
+
+void logger_log(const char *tag, const char *fmt, ...)
+{
+    va_list ap;
+
+    fprintf(stderr, "[%10.3f] [%s] ", (double)host_time_us / 1e6, tag);
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fputc('\n', stderr);
+}
@@ -0,0 +1,51 @@
+/**
+ * @file mqtt.h
+ * @brief `lwip/apps/mqtt.h` do host: a API do cliente MQTT usada por `lib/mqtt_publisher.c`.
+ * @details As funções são o broker de mentira do teste (`tools/mqtt_publisher_test.c`), que
+ *          responde pela API, sem protocolo MQTT no fio.
+ */
+
+#ifndef HOST_LWIP_APPS_MQTT_H
+#define HOST_LWIP_APPS_MQTT_H
+
+#include "lwip/arch.h"
+#include "lwip/err.h"
+#include "lwip/ip_addr.h"
+
+typedef struct mqtt_client_s mqtt_client_t;
+
+/** @brief Resultado da conexão (mesmos valores do lwIP). */
+typedef enum
+{
+    MQTT_CONNECT_ACCEPTED = 0,
+    MQTT_CONNECT_REFUSED_PROTOCOL_VERSION = 1,
+    MQTT_CONNECT_REFUSED_IDENTIFIER = 2,
+    MQTT_CONNECT_REFUSED_SERVER = 3,
+    MQTT_CONNECT_REFUSED_USERNAME_PASS = 4,
+    MQTT_CONNECT_REFUSED_NOT_AUTHORIZED_ = 5,
+    MQTT_CONNECT_DISCONNECTED = 256,
+    MQTT_CONNECT_TIMEOUT = 257,
+} mqtt_connection_status_t;
+
+typedef void (*mqtt_connection_cb_t)(mqtt_client_t *client, void *arg, mqtt_connection_status_t status);
+typedef void (*mqtt_request_cb_t)(void *arg, err_t err);
+
+struct mqtt_connect_client_info_t
+{
+    const char *client_id;
+    const char *client_user;
+    const char *client_pass;
+    u16_t keep_alive;
+    const char *will_topic;
+    const char *will_msg;
+    u8_t will_qos;
+    u8_t will_retain;
+};
+
+mqtt_client_t *mqtt_client_new(void);
+err_t mqtt_client_connect(mqtt_client_t *client, const ip_addr_t *ipaddr, u16_t port, mqtt_connection_cb_t cb,
+                          void *arg, const struct mqtt_connect_client_info_t *client_info);
+err_t mqtt_publish(mqtt_client_t *client, const char *topic, const void *payload, u16_t payload_length,
+                   u8_t qos, u8_t retain, mqtt_request_cb_t cb, void *arg);
+
+#endif /* HOST_LWIP_APPS_MQTT_H */
@@ -0,0 +1,20 @@
+/**
+ * @file arch.h
+ * @brief `lwip/arch.h` do host: tipos inteiros do lwIP.
+ * @details Os cabeçalhos de `tools/host/lwip/` trazem só o que os módulos do
+ *          firmware usam do lwIP (IPv4, como em `include/lwipopts.h`); as
+ *          funções são de mentira, definidas por cada teste.
+ */
+
+#ifndef HOST_LWIP_ARCH_H
+#define HOST_LWIP_ARCH_H
+
+#include <stdint.h>
+
+typedef uint8_t u8_t;
+typedef int8_t s8_t;
+typedef uint16_t u16_t;
+typedef int16_t s16_t;
+typedef uint32_t u32_t;
+
+#endif /* HOST_LWIP_ARCH_H */
@@ -0,0 +1,13 @@
+/**
+ * @file dhcp.h
+ * @brief `lwip/dhcp.h` do host: só o necessário para compilar o caminho de IP fixo.
+ */
+
+#ifndef HOST_LWIP_DHCP_H
+#define HOST_LWIP_DHCP_H
+
+#include "lwip/netif.h"
+
+void dhcp_stop(struct netif *netif);
+
+#endif /* HOST_LWIP_DHCP_H */
@@ -0,0 +1,19 @@
+/**
+ * @file dns.h
+ * @brief `lwip/dns.h` do host: a API do resolvedor usada por `lib/utils.c` e `lib/wifi_manager.c`.
+ * @details As funções são do teste que as usa (`tools/wifi_manager_test.c`).
+ */
+
+#ifndef HOST_LWIP_DNS_H
+#define HOST_LWIP_DNS_H
+
+#include "lwip/arch.h"
+#include "lwip/err.h"
+#include "lwip/ip_addr.h"
+
+typedef void (*dns_found_callback)(const char *name, const ip_addr_t *ipaddr, void *callback_arg);
+
+void dns_setserver(u8_t numdns, const ip_addr_t *dnsserver);
+err_t dns_gethostbyname(const char *hostname, ip_addr_t *addr, dns_found_callback found, void *callback_arg);
+
+#endif /* HOST_LWIP_DNS_H */
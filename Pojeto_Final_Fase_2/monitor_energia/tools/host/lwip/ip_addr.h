@@ -0,0 +1,24 @@
+/**
+ * @file ip_addr.h
+ * @brief `lwip/ip_addr.h` do host: endereço IPv4 (`LWIP_IPV4` só, como no firmware).
+ */
+
+#ifndef HOST_LWIP_IP_ADDR_H
+#define HOST_LWIP_IP_ADDR_H
+
+#include "lwip/arch.h"
+
+typedef struct ip4_addr
+{
+    u32_t addr;
+} ip4_addr_t;
+
+typedef ip4_addr_t ip_addr_t;
+
+#define ip4_addr_get_u32(a)     ((a)->addr)
+#define ip4_addr_set_u32(a, v)  ((a)->addr = (v))
+#define IP4_ADDR(a, b0, b1, b2, b3)                                                                             \
+    ((a)->addr = (u32_t)((b3) & 0xFFU) << 24 | (u32_t)((b2) & 0xFFU) << 16 | (u32_t)((b1) & 0xFFU) << 8 |    \
+                 (u32_t)((b0) & 0xFFU))
+
+#endif /* HOST_LWIP_IP_ADDR_H */
@@ -0,0 +1,36 @@
+/**
+ * @file netif.h
+ * @brief `lwip/netif.h` do host: a interface de rede com o IP e os callbacks de status e de link.
+ */
+
+#ifndef HOST_LWIP_NETIF_H
+#define HOST_LWIP_NETIF_H
+
+#include "lwip/arch.h"
+#include "lwip/err.h"
+#include "lwip/ip_addr.h"
+
+struct netif;
+
+typedef void (*netif_status_callback_fn)(struct netif *netif);
+
+struct netif
+{
+    ip4_addr_t ip_addr;
+    netif_status_callback_fn status_callback;
+    netif_status_callback_fn link_callback;
+};
+
+#define netif_ip4_addr(n)   ((const ip4_addr_t *)&((n)->ip_addr))
+
+static inline void netif_set_status_callback(struct netif *netif, netif_status_callback_fn cb)
+{
+    netif->status_callback = cb;
+}
+
+static inline void netif_set_link_callback(struct netif *netif, netif_status_callback_fn cb)
+{
+    netif->link_callback = cb;
+}
+
+#endif /* HOST_LWIP_NETIF_H */
@@ -0,0 +1,23 @@
+/**
+ * @file pbuf.h
+ * @brief `lwip/pbuf.h` do host: `struct pbuf` (cadeia de buffers) e as funções usadas pelos callbacks de recepção.
+ * @details As funções são do teste que as usa (`tools/http_server_test.c`).
+ */
+
+#ifndef HOST_LWIP_PBUF_H
+#define HOST_LWIP_PBUF_H
+
+#include "lwip/arch.h"
+
+struct pbuf
+{
+    struct pbuf *next;
+    void *payload;
+    u16_t tot_len;      /**< Bytes desta pbuf e das seguintes. */
+    u16_t len;          /**< Bytes desta pbuf. */
+};
+
+u16_t pbuf_copy_partial(const struct pbuf *p, void *dataptr, u16_t len, u16_t offset);
+u8_t pbuf_free(struct pbuf *p);
+
+#endif /* HOST_LWIP_PBUF_H */
@@ -0,0 +1,52 @@
+/**
+ * @file tcp.h
+ * @brief `lwip/tcp.h` do host: a API TCP bruta usada por `lib/http_server.c`.
+ * @details
+ *  `struct tcp_pcb` fica opaca e as funções são a pilha de mentira do teste
+ *  (`tools/http_server_test.c`). `tcp_sndbuf` é uma função aqui (no lwIP é
+ *  macro sobre o PCB). Como o `lwip/opt.h` do lwIP, inclui `include/lwipopts.h`
+ *  (`MEMP_NUM_TCP_PCB` dimensiona o pool da pilha de mentira).
+ */
+
+#ifndef HOST_LWIP_TCP_H
+#define HOST_LWIP_TCP_H
+
+#include "lwip/arch.h"
+#include "lwip/err.h"
+#include "lwip/ip_addr.h"
+#include "lwip/pbuf.h"
+#include "include/lwipopts.h"
+
+struct tcp_pcb;
+
+#define TCP_WRITE_FLAG_COPY     0x01U
+#define TCP_WRITE_FLAG_MORE     0x02U
+#define TCP_PRIO_MIN            1U
+#define TCP_PRIO_NORMAL         64U
+#define IPADDR_TYPE_ANY         46U
+#define IP_ANY_TYPE             ((const ip_addr_t *)0)
+
+typedef err_t (*tcp_accept_fn)(void *arg, struct tcp_pcb *newpcb, err_t err);
+typedef err_t (*tcp_recv_fn)(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err);
+typedef err_t (*tcp_sent_fn)(void *arg, struct tcp_pcb *tpcb, u16_t len);
+typedef err_t (*tcp_poll_fn)(void *arg, struct tcp_pcb *tpcb);
+typedef void (*tcp_err_fn)(void *arg, err_t err);
+
+struct tcp_pcb *tcp_new_ip_type(u8_t type);
+err_t tcp_bind(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port);
+struct tcp_pcb *tcp_listen_with_backlog(struct tcp_pcb *pcb, u8_t backlog);
+void tcp_accept(struct tcp_pcb *pcb, tcp_accept_fn accept);
+void tcp_arg(struct tcp_pcb *pcb, void *arg);
+void tcp_recv(struct tcp_pcb *pcb, tcp_recv_fn recv);
+void tcp_sent(struct tcp_pcb *pcb, tcp_sent_fn sent);
+void tcp_err(struct tcp_pcb *pcb, tcp_err_fn err);
+void tcp_poll(struct tcp_pcb *pcb, tcp_poll_fn poll, u8_t interval);
+void tcp_setprio(struct tcp_pcb *pcb, u8_t prio);
+void tcp_recved(struct tcp_pcb *pcb, u16_t len);
+u16_t tcp_sndbuf(const struct tcp_pcb *pcb);
+err_t tcp_write(struct tcp_pcb *pcb, const void *dataptr, u16_t len, u8_t apiflags);
+err_t tcp_output(struct tcp_pcb *pcb);
+err_t tcp_close(struct tcp_pcb *pcb);
+void tcp_abort(struct tcp_pcb *pcb);
+
+#endif /* HOST_LWIP_TCP_H */
@@ -0,0 +1,25 @@
+/**
+ * @file cyw43_arch.h
+ * @brief `pico/cyw43_arch.h` do host: o lock do lwIP (sem efeito no scheduler cooperativo de `rtos_host.c`) e a inicialização do rádio.
+ * @details `cyw43_arch_init` e companhia são do teste que as usa (`tools/wifi_manager_test.c`).
+ */
+
+#ifndef HOST_PICO_CYW43_ARCH_H
+#define HOST_PICO_CYW43_ARCH_H
+
+#include "pico/stdlib.h" /* Como o do SDK */
+#include "cyw43.h"
+
+static inline void cyw43_arch_lwip_begin(void)
+{
+}
+
+static inline void cyw43_arch_lwip_end(void)
+{
+}
+
+int cyw43_arch_init(void);
+void cyw43_arch_enable_sta_mode(void);
+int cyw43_arch_wifi_connect_async(const char *ssid, const char *pw, uint32_t auth);
+
+#endif /* HOST_PICO_CYW43_ARCH_H */
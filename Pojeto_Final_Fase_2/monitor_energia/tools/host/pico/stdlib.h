@@ -0,0 +1,14 @@
+/**
+ * @file stdlib.h
+ * @brief `pico/stdlib.h` do host: tipos e relógio virtual (`pico/time.h`).
+ */
+
+#ifndef HOST_PICO_STDLIB_H
+#define HOST_PICO_STDLIB_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "pico/types.h"
+#include "pico/time.h"
+
+#endif /* HOST_PICO_STDLIB_H */
@@ -0,0 +1,45 @@
+/**
+ * @file time.h
+ * @brief `pico/time.h` do host: relógio virtual para ferramentas que compilam módulos do firmware.
+ * @details
+ *  `time_us_64()` devolve `host_time_us`, adiantado pela ferramenta (1 s
+ *  por registro) e pelo disco simulado (`tools/host/diskio_img.c`, um custo
+ *  por setor). As latências medidas com ele são as do modelo de disco, não
+ *  as do PC.
+ */
+
+#ifndef HOST_PICO_TIME_H
+#define HOST_PICO_TIME_H
+
+#include <stdint.h>
+
+extern uint64_t host_time_us;   /**< Relógio virtual [µs]. */
+
+typedef uint64_t absolute_time_t;
+
+static inline uint64_t time_us_64(void)
+{
+    return host_time_us;
+}
+
+static inline absolute_time_t get_absolute_time(void)
+{
+    return host_time_us;
+}
+
+static inline uint32_t to_ms_since_boot(absolute_time_t t)
+{
+    return (uint32_t)(t / 1000U);
+}
+
+static inline absolute_time_t make_timeout_time_ms(uint32_t ms)
+{
+    return host_time_us + (uint64_t)ms * 1000U;
+}
+
+static inline int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to)
+{
+    return (int64_t)(to - from);
+}
+
+#endif /* HOST_PICO_TIME_H */
@@ -0,0 +1,14 @@
+/**
+ * @file types.h
+ * @brief `pico/types.h` do host: só os tipos usados pelos módulos do firmware compilados no PC.
+ */
+
+#ifndef HOST_PICO_TYPES_H
+#define HOST_PICO_TYPES_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+
+#endif /* HOST_PICO_TYPES_H */
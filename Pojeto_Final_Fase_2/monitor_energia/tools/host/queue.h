@@ -0,0 +1,20 @@
+/**
+ * @file queue.h
+ * @brief `queue.h` do host: filas por cópia, com bloqueio no relógio virtual (`tools/host/rtos_host.c`).
+ */
+
+#ifndef HOST_QUEUE_H
+#define HOST_QUEUE_H
+
+#include "FreeRTOS.h"
+
+typedef struct host_queue *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+void vQueueDelete(QueueHandle_t q);
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks);
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *item, BaseType_t *woken);
+BaseType_t xQueueReceive(QueueHandle_t q, void *out, TickType_t ticks);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q);
+
+#endif /* HOST_QUEUE_H */
@@ -0,0 +1,520 @@
+/**
+ * @file rtos_host.c
+ * @brief Scheduler cooperativo de relógio virtual para testar no PC módulos do firmware com tasks e filas.
+ * @details
+ *  Cada task é uma thread, mas só a escolhida (`s_running`) executa: as
+ *  outras esperam no mesmo mutex. A troca acontece só dentro das chamadas
+ *  de API — bloquear (fila vazia/cheia, atraso, notificação), acordar uma
+ *  task de prioridade maior, `taskYIELD` —, então o código do firmware roda
+ *  entre elas sem preempção, e seções críticas podem continuar vazias.
+ *
+ *  Escolha: a task pronta de maior prioridade; entre iguais, a seguinte na
+ *  ordem de criação (round-robin). Sem nenhuma pronta, o relógio virtual
+ *  (`host_time_us`, de `pico/time.h`) salta para o prazo mais próximo; se
+ *  nenhuma task tem prazo, é impasse e o processo sai com status 2. Um
+ *  tick é 1 ms.
+ *
+ *  IRQ simulada: o teste chama entre `host_isr_enter`/`host_isr_exit` um
+ *  callback que no firmware roda na IRQ do lwIP; dentro dela nada troca de
+ *  task, e a task mais prioritária acordada roda na saída (o PendSV do port).
+ *
+ *  Define `host_time_us` (não ligar junto com `tools/host/diskio_img.c`).
+ *  Compilação: junto do teste, com `-lpthread` (ver os `tools/<módulo>_test.c`).
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "pico/time.h"
+
+#define HOST_MAX_TASKS      32U     /**< Tasks simultâneas. */
+
+/** @brief Motivo do bloqueio de uma task. */
+typedef enum
+{
+    WAIT_NONE = 0,      /**< Pronta. */
+    WAIT_DELAY,         /**< Só o prazo. */
+    WAIT_RECV,          /**< Item em `queue`. */
+    WAIT_SEND,          /**< Espaço em `queue`. */
+    WAIT_NOTIFY,        /**< Notificação. */
+    WAIT_DEAD,          /**< Apagada ou retornou. */
+} wait_t;
+
+/** @brief Uma task simulada. */
+typedef struct host_task
+{
+    pthread_t thread;
+    TaskFunction_t fn;
+    void *params;
+    char name[configMAX_TASK_NAME_LEN];
+    UBaseType_t priority;
+    wait_t wait;            /**< Motivo do bloqueio. */
+    struct host_queue *queue;
+    uint64_t wake_us;       /**< Prazo (UINT64_MAX: sem prazo). */
+    bool timed_out;         /**< Acordou pelo prazo. */
+    uint32_t notify;        /**< Valor de notificação. */
+} host_task_t;
+
+/** @brief Fila por cópia (anel). */
+struct host_queue
+{
+    uint8_t *buf;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+};
+
+uint64_t host_time_us = 0;
+volatile bool host_in_isr = false;
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_cv = PTHREAD_COND_INITIALIZER;
+static host_task_t s_tasks[HOST_MAX_TASKS];
+static size_t s_ntasks = 0;
+static host_task_t *s_running = NULL;
+static bool s_yield_pending = false;    /**< Task mais prioritária acordada numa IRQ. */
+
+/* ---------------------------------------------------------------------- */
+/* Escalonamento (com s_lock)                                             */
+/* ---------------------------------------------------------------------- */
+
+/** @brief Próxima task pronta: maior prioridade, round-robin depois de `after`. */
+static host_task_t *pick_ready(const host_task_t *after)
+{
+    host_task_t *best = NULL;
+    const size_t start = after ? (size_t)(after - s_tasks) + 1U : 0U;
+
+    for (size_t k = 0; k < s_ntasks; k++)
+    {
+        host_task_t *t = &s_tasks[(start + k) % s_ntasks];
+        if (t->wait == WAIT_NONE && (!best || t->priority > best->priority))
+        {
+            best = t;
+        }
+    }
+    return best;
+}
+
+/** @brief Deixa `self` esperando até voltar a ser a task corrente. */
+static void wait_turn(host_task_t *self)
+{
+    while (s_running != self)
+    {
+        pthread_cond_wait(&s_cv, &s_lock);
+    }
+}
+
+/**
+ * @brief Passa a vez: escolhe a próxima task (avançando o relógio se preciso) e espera a de `self`.
+ * @details `self` já marcou seu bloqueio (ou continua pronta, num yield).
+ */
+static void reschedule(host_task_t *self)
+{
+    host_task_t *next = pick_ready(self);
+
+    while (!next)
+    {
+        uint64_t t = UINT64_MAX;
+        for (size_t i = 0; i < s_ntasks; i++)
+        {
+            if (s_tasks[i].wait != WAIT_NONE && s_tasks[i].wait != WAIT_DEAD && s_tasks[i].wake_us < t)
+            {
+                t = s_tasks[i].wake_us;
+            }
+        }
+        if (t == UINT64_MAX)
+        {
+            fprintf(stderr, "rtos_host: impasse (todas as tasks bloqueadas sem prazo)\n");
+            exit(2);
+        }
+
+        host_time_us = (t > host_time_us) ? t : host_time_us;
+        for (size_t i = 0; i < s_ntasks; i++)
+        {
+            host_task_t *w = &s_tasks[i];
+            if (w->wait != WAIT_NONE && w->wait != WAIT_DEAD && w->wake_us <= host_time_us)
+            {
+                w->wait = WAIT_NONE;
+                w->timed_out = true;
+            }
+        }
+        next = pick_ready(self);
+    }
+
+    if (next != self)
+    {
+        s_running = next;
+        pthread_cond_broadcast(&s_cv);
+        if (self->wait != WAIT_DEAD)
+        {
+            wait_turn(self);
+        }
+    }
+}
+
+/** @brief Bloqueia a task corrente por `why` até `ticks` (portMAX_DELAY: sem prazo). @return false no prazo. */
+static bool block(wait_t why, struct host_queue *q, TickType_t ticks)
+{
+    host_task_t *self = s_running;
+
+    self->wait = why;
+    self->queue = q;
+    self->timed_out = false;
+    self->wake_us = (ticks == portMAX_DELAY) ? UINT64_MAX : host_time_us + (uint64_t)ticks * 1000U;
+    reschedule(self);
+    self->queue = NULL;
+    return !self->timed_out;
+}
+
+/** @brief Acorda `t`; troca já se ela for mais prioritária (fora de IRQ). @return true se for. */
+static bool wake(host_task_t *t)
+{
+    t->wait = WAIT_NONE;
+    t->wake_us = UINT64_MAX;
+
+    if (t->priority <= s_running->priority)
+    {
+        return false;
+    }
+    if (host_in_isr)
+    {
+        s_yield_pending = true;
+    }
+    else
+    {
+        reschedule(s_running);
+    }
+    return true;
+}
+
+/** @brief Task bloqueada em `why` na fila `q`, a mais prioritária (ou NULL). */
+static host_task_t *waiter_on(wait_t why, const struct host_queue *q)
+{
+    host_task_t *best = NULL;
+
+    for (size_t i = 0; i < s_ntasks; i++)
+    {
+        host_task_t *t = &s_tasks[i];
+        if (t->wait == why && t->queue == q && (!best || t->priority > best->priority))
+        {
+            best = t;
+        }
+    }
+    return best;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Tasks                                                                  */
+/* ---------------------------------------------------------------------- */
+
+static void *task_entry(void *arg)
+{
+    host_task_t *self = (host_task_t *)arg;
+
+    pthread_mutex_lock(&s_lock);
+    wait_turn(self);
+    pthread_mutex_unlock(&s_lock);
+
+    self->fn(self->params);
+
+    /* Task do FreeRTOS não retorna; aqui ela só sai do escalonamento */
+    pthread_mutex_lock(&s_lock);
+    self->wait = WAIT_DEAD;
+    reschedule(self);
+    pthread_mutex_unlock(&s_lock);
+    return NULL;
+}
+
+static host_task_t *new_task(const char *name, UBaseType_t priority)
+{
+    if (s_ntasks >= HOST_MAX_TASKS)
+    {
+        return NULL;
+    }
+
+    host_task_t *t = &s_tasks[s_ntasks++];
+    memset(t, 0, sizeof(*t));
+    snprintf(t->name, sizeof(t->name), "%s", name ? name : "");
+    t->priority = priority;
+    t->wake_us = UINT64_MAX;
+    return t;
+}
+
+void host_rtos_init(UBaseType_t priority)
+{
+    pthread_mutex_lock(&s_lock);
+    s_running = new_task("main", priority);
+    pthread_mutex_unlock(&s_lock);
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_words, void *params,
+                       UBaseType_t priority, TaskHandle_t *handle)
+{
+    (void)stack_words;
+    pthread_mutex_lock(&s_lock);
+
+    host_task_t *t = new_task(name, priority);
+    if (!t)
+    {
+        pthread_mutex_unlock(&s_lock);
+        return pdFAIL;
+    }
+    t->fn = fn;
+    t->params = params;
+    if (handle)
+    {
+        *handle = t;
+    }
+    pthread_create(&t->thread, NULL, task_entry, t);
+    pthread_detach(t->thread);
+
+    if (priority > s_running->priority)
+    {
+        reschedule(s_running);
+    }
+    pthread_mutex_unlock(&s_lock);
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    pthread_mutex_lock(&s_lock);
+    host_task_t *t = task ? (host_task_t *)task : s_running;
+    t->wait = WAIT_DEAD;
+
+    if (t == s_running)
+    {
+        reschedule(t);
+        pthread_mutex_unlock(&s_lock);
+        pthread_exit(NULL);
+    }
+    pthread_mutex_unlock(&s_lock);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    pthread_mutex_lock(&s_lock);
+    (void)block(WAIT_DELAY, NULL, ticks);
+    pthread_mutex_unlock(&s_lock);
+}
+
+void vTaskDelayUntil(TickType_t *prev_wake, TickType_t increment)
+{
+    pthread_mutex_lock(&s_lock);
+    *prev_wake += increment;
+    const TickType_t now = (TickType_t)(host_time_us / 1000U);
+    const TickType_t left = (TickType_t)(*prev_wake - now);
+    if (left != 0U && left <= increment)
+    {
+        (void)block(WAIT_DELAY, NULL, left);
+    }
+    pthread_mutex_unlock(&s_lock);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(host_time_us / 1000U);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return s_running;
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void)
+{
+    UBaseType_t n = 0;
+
+    for (size_t i = 0; i < s_ntasks; i++)
+    {
+        n += (s_tasks[i].wait != WAIT_DEAD) ? 1U : 0U;
+    }
+    return n;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks)
+{
+    pthread_mutex_lock(&s_lock);
+    host_task_t *self = s_running;
+
+    if (self->notify == 0U && ticks != 0U)
+    {
+        (void)block(WAIT_NOTIFY, NULL, ticks);
+    }
+    const uint32_t v = self->notify;
+    self->notify = clear_on_exit ? 0U : (v ? v - 1U : 0U);
+    pthread_mutex_unlock(&s_lock);
+    return v;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    pthread_mutex_lock(&s_lock);
+    host_task_t *t = (host_task_t *)task;
+    t->notify++;
+    if (t->wait == WAIT_NOTIFY)
+    {
+        (void)wake(t);
+    }
+    pthread_mutex_unlock(&s_lock);
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken)
+{
+    pthread_mutex_lock(&s_lock);
+    host_task_t *t = (host_task_t *)task;
+    t->notify++;
+    if (t->wait == WAIT_NOTIFY)
+    {
+        const bool higher = wake(t);
+        if (woken && higher)
+        {
+            *woken = pdTRUE;
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+}
+
+void taskYIELD(void)
+{
+    pthread_mutex_lock(&s_lock);
+    reschedule(s_running);
+    pthread_mutex_unlock(&s_lock);
+}
+
+void host_isr_enter(void)
+{
+    host_in_isr = true;
+}
+
+void host_isr_exit(void)
+{
+    pthread_mutex_lock(&s_lock);
+    host_in_isr = false;
+    if (s_yield_pending)
+    {
+        s_yield_pending = false;
+        reschedule(s_running);
+    }
+    pthread_mutex_unlock(&s_lock);
+}
+
+/* ---------------------------------------------------------------------- */
+/* Filas                                                                  */
+/* ---------------------------------------------------------------------- */
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    struct host_queue *q = calloc(1, sizeof(*q));
+
+    if (!q)
+    {
+        return NULL;
+    }
+    q->buf = calloc(length, item_size);
+    if (!q->buf)
+    {
+        free(q);
+        return NULL;
+    }
+    q->length = length;
+    q->item_size = item_size;
+    return q;
+}
+
+void vQueueDelete(QueueHandle_t q)
+{
+    free(q->buf);
+    free(q);
+}
+
+/** @brief Põe um item (com s_lock e espaço garantido) e acorda quem espera item. @return true se acordou task mais prioritária. */
+static bool queue_put(struct host_queue *q, const void *item)
+{
+    memcpy(q->buf + ((q->head + q->count) % q->length) * q->item_size, item, q->item_size);
+    q->count++;
+
+    host_task_t *t = waiter_on(WAIT_RECV, q);
+    return t ? wake(t) : false;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks)
+{
+    pthread_mutex_lock(&s_lock);
+    while (q->count >= q->length)
+    {
+        if (ticks == 0U || !block(WAIT_SEND, q, ticks))
+        {
+            pthread_mutex_unlock(&s_lock);
+            return pdFALSE;
+        }
+    }
+    (void)queue_put(q, item);
+    pthread_mutex_unlock(&s_lock);
+    return pdTRUE;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *item, BaseType_t *woken)
+{
+    pthread_mutex_lock(&s_lock);
+    if (q->count >= q->length)
+    {
+        pthread_mutex_unlock(&s_lock);
+        return pdFALSE;
+    }
+    if (queue_put(q, item) && woken)
+    {
+        *woken = pdTRUE;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *out, TickType_t ticks)
+{
+    pthread_mutex_lock(&s_lock);
+    while (q->count == 0U)
+    {
+        if (ticks == 0U || !block(WAIT_RECV, q, ticks))
+        {
+            pthread_mutex_unlock(&s_lock);
+            return pdFALSE;
+        }
+    }
+    memcpy(out, q->buf + q->head * q->item_size, q->item_size);
+    q->head = (q->head + 1U) % q->length;
+    q->count--;
+
+    host_task_t *t = waiter_on(WAIT_SEND, q);
+    if (t)
+    {
+        (void)wake(t);
+    }
+    pthread_mutex_unlock(&s_lock);
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q)
+{
+    return q->count;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Heap (sem medição no host)                                             */
+/* ---------------------------------------------------------------------- */
+
+size_t xPortGetFreeHeapSize(void)
+{
+    return 0;
+}
+
+size_t xPortGetMinimumEverFreeHeapSize(void)
+{
+    return 0;
+}
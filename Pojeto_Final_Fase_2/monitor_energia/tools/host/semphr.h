@@ -0,0 +1,32 @@
+/**
+ * @file semphr.h
+ * @brief `semphr.h` do host: numa só thread, todo mutex está livre.
+ */
+
+#ifndef HOST_SEMPHR_H
+#define HOST_SEMPHR_H
+
+#include "FreeRTOS.h"
+
+typedef void *SemaphoreHandle_t;
+
+static inline SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    static uint8_t dummy;
+    return &dummy;
+}
+
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    (void)sem;
+    (void)ticks;
+    return pdTRUE;
+}
+
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    (void)sem;
+    return pdTRUE;
+}
+
+#endif /* HOST_SEMPHR_H */
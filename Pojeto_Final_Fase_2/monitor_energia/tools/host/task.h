@@ -0,0 +1,34 @@
+/**
+ * @file task.h
+ * @brief `task.h` do host (ver `tools/host/FreeRTOS.h`); as funções estão em `tools/host/rtos_host.c`.
+ */
+
+#ifndef HOST_TASK_H
+#define HOST_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef void *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *params);
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_words, void *params,
+                       UBaseType_t priority, TaskHandle_t *handle);
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t *prev_wake, TickType_t increment);
+TickType_t xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+UBaseType_t uxTaskGetNumberOfTasks(void);
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken);
+void taskYIELD(void);
+
+/**
+ * @brief Transforma a thread chamadora (o `main` do teste) numa task de prioridade `priority`.
+ * @details Chamar uma vez, antes de criar tasks. O teste avança o relógio
+ *          virtual com `vTaskDelay`, enquanto as outras tasks rodam.
+ */
+void host_rtos_init(UBaseType_t priority);
+
+#endif /* HOST_TASK_H */
@@ -0,0 +1,745 @@
+/**
+ * @file http_server_test.c
+ * @brief Teste (host) do servidor HTTP (`lib/http_server.c`): scrapes simultâneos, páginas fixadas e limite de conexões.
+ * @details
+ *  Compila `lib/http_server.c` sem alteração sobre o scheduler de relógio
+ *  virtual de `tools/host/rtos_host.c`, com uma pilha TCP de mentira no
+ *  lugar de `lwip/tcp.h`: o teste faz o papel dos clientes (conecta, manda
+ *  a requisição, confirma bytes) chamando os callbacks do servidor numa IRQ
+ *  simulada, como o lwIP no firmware. A pilha guarda o endereço de cada
+ *  `tcp_write` sem cópia e, a cada confirmação, compara a memória da página
+ *  com os bytes enviados: uma página reescrita enquanto fixada aparece como
+ *  divergência. O pool de PCBs tem `MEMP_NUM_TCP_PCB` (`include/lwipopts.h`)
+ *  e, cheio, faz como `tcp_alloc`: recupera um TIME_WAIT ou aborta o PCB de
+ *  menor prioridade abaixo da pedida (`tcp_kill_prio`).
+ *  Roteiro:
+ *   - dois clientes lentos fixam as duas páginas mais antigas; a terceira
+ *     fica corrente e as renderizações seguintes são adiadas (`render_skips`);
+ *   - mais dois clientes ocupam os `HTTP_SERVER_MAX_CONNS` slots e o quinto
+ *     é recusado (`rejected`, `tcp_abort`);
+ *   - os clientes recebem as respostas aos poucos, com renderizações entre
+ *     as confirmações; cada um recebe a página da sua conexão, íntegra e do
+ *     tamanho de `Content-Length`;
+ *   - liberada uma página, a renderização volta e um slot livre aceita um
+ *     novo cliente, que recebe a página mais nova;
+ *   - erro na conexão (`http_err_cb`) também solta a página fixada;
+ *   - o rádio fica segurado (`wifi_manager_tx_hold`) da primeira conexão
+ *     aberta até a última fechar, inclusive com a recusa e o RST no meio;
+ *   - caminho desconhecido: 404;
+ *   - pool cheio: MQTT e ThingSpeak conectados, todos os slots ocupados e
+ *     conexões em TIME_WAIT; a reconexão do ThingSpeak e um scrape além do
+ *     limite não derrubam nenhum scrape em andamento.
+ *  Sai com código 1 na primeira divergência encontrada (mostra até 10).
+ *
+ *  Compilação e execução (a partir de `monitor_energia/`):
+ *      gcc -O2 -I. -Itools/host -Itools/host/ffmock tools/http_server_test.c lib/http_server.c lib/fmt.c \
+ *          lib/timestamp.c tools/host/rtos_host.c tools/host/logger_host.c -o http_server_test -lpthread -lm \
+ *          && ./http_server_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "pico/time.h"
+#include "lwip/tcp.h"
+#include "lib/http_server.h"
+#include "lib/energy_monitor.h"
+#include "lib/wifi_manager.h"
+#include "lib/time_sync.h"
+#include "lib/mqtt_publisher.h"
+#include "lib/telemetry.h"
+#include "lib/udp_stream.h"
+#include "lib/sd_card_log_task.h"
+#include "lib/sd_query.h"
+#include "lib/logger.h"
+#include "lib/rtos_stats.h"
+
+#define TEST_PCBS           (MEMP_NUM_TCP_PCB + 1U)         /**< PCBs da pilha de mentira (pool + escuta). */
+#define TEST_SND_BUF        2920U                           /**< Buffer de envio por PCB (2 MSS). */
+#define TEST_MSS            1460U                           /**< Bytes por confirmação do cliente. */
+#define TEST_SEGS           64U                             /**< `tcp_write` guardados por PCB. */
+#define TEST_RX_MAX         (HTTP_METRICS_PAGE_SIZE + 256U) /**< Resposta recebida por um cliente. */
+
+/** @brief Um `tcp_write` ainda não confirmado. */
+typedef struct
+{
+    const char *ptr;    /**< Memória do servidor (NULL se copiado). */
+    uint16_t len;
+    uint32_t rx_off;    /**< Onde os bytes estão em `rx`. */
+} seg_t;
+
+/** @brief PCB da pilha de mentira: um cliente. */
+struct tcp_pcb
+{
+    bool used;
+    bool listening;             /**< Escuta (no lwIP vem de outro pool). */
+    bool time_wait;             /**< Fechada, ainda ocupando o pool. */
+    bool closed;
+    bool aborted;
+    bool evicted;               /**< Abortada pelo pool cheio. */
+    u8_t prio;
+    uint32_t born;              /**< Ordem de alocação (o mais antigo sai primeiro). */
+    void *arg;
+    tcp_recv_fn recv;
+    tcp_sent_fn sent;
+    tcp_err_fn err;
+    tcp_poll_fn poll;
+    uint16_t sndbuf;            /**< Espaço livre no envio. */
+    seg_t segs[TEST_SEGS];
+    uint8_t nsegs;
+    uint32_t acked;             /**< Bytes confirmados pelo cliente. */
+    char rx[TEST_RX_MAX];       /**< Bytes escritos pelo servidor, na ordem. */
+    uint32_t rx_len;
+};
+
+static unsigned s_failures = 0;
+
+static struct tcp_pcb s_pcbs[TEST_PCBS];
+static uint32_t s_pcb_serial = 0;
+static unsigned s_evictions = 0;        /**< PCBs ativos abortados por falta de PCB. */
+static bool s_radio_hold = false;       /**< Último `wifi_manager_tx_hold` do servidor. */
+static unsigned s_hold_calls = 0;
+static tcp_accept_fn s_accept = NULL;
+static void *s_listen_arg = NULL;
+
+#define CHECK(cond, ...)                                                                          \
+    do                                                                                            \
+    {                                                                                             \
+        if (!(cond) && s_failures++ < 10U)                                                        \
+        {                                                                                         \
+            fprintf(stderr, "FALHA [%.3f s] ", (double)host_time_us / 1e6);                       \
+            fprintf(stderr, __VA_ARGS__);                                                         \
+            fputc('\n', stderr);                                                                  \
+        }                                                                                         \
+    } while (0)
+
+/* ---------------------------------------------------------------------- */
+/* Pilha TCP de mentira (lwip/tcp.h)                                      */
+/* ---------------------------------------------------------------------- */
+
+/** @brief PCBs ocupando o pool de `MEMP_NUM_TCP_PCB` (ativos e em TIME_WAIT). */
+static unsigned pool_in_use(void)
+{
+    unsigned n = 0;
+    for (unsigned i = 0; i < TEST_PCBS; i++)
+    {
+        n += (s_pcbs[i].used && !s_pcbs[i].listening) ? 1U : 0U;
+    }
+    return n;
+}
+
+/**
+ * @brief Libera um PCB como o `tcp_alloc` do lwIP com o pool cheio: primeiro o
+ *        TIME_WAIT mais antigo; senão aborta o ativo mais antigo de menor
+ *        prioridade, abaixo de `prio` (`err` com ERR_ABRT).
+ */
+static void pool_reclaim(u8_t prio)
+{
+    struct tcp_pcb *victim = NULL;
+
+    for (unsigned i = 0; i < TEST_PCBS; i++)
+    {
+        struct tcp_pcb *p = &s_pcbs[i];
+        if (p->used && p->time_wait && (!victim || p->born < victim->born))
+        {
+            victim = p;
+        }
+    }
+    if (victim)
+    {
+        victim->used = false;
+        return;
+    }
+
+    for (unsigned i = 0; i < TEST_PCBS; i++)
+    {
+        struct tcp_pcb *p = &s_pcbs[i];
+        if (p->used && !p->listening && p->prio < prio &&
+            (!victim || p->prio < victim->prio || (p->prio == victim->prio && p->born < victim->born)))
+        {
+            victim = p;
+        }
+    }
+    if (victim)
+    {
+        s_evictions++;
+        victim->evicted = true;
+        victim->aborted = true;
+        if (victim->err)
+        {
+            host_isr_enter();
+            victim->err(victim->arg, ERR_ABRT);
+            host_isr_exit();
+        }
+        victim->used = false;
+    }
+}
+
+/** @brief Aloca um PCB do pool com prioridade `prio`; NULL se nada pôde ser liberado. */
+static struct tcp_pcb *pcb_alloc(u8_t prio)
+{
+    if (pool_in_use() >= MEMP_NUM_TCP_PCB)
+    {
+        pool_reclaim(prio);
+    }
+    if (pool_in_use() >= MEMP_NUM_TCP_PCB)
+    {
+        return NULL;
+    }
+
+    for (unsigned i = 0; i < TEST_PCBS; i++)
+    {
+        if (!s_pcbs[i].used)
+        {
+            memset(&s_pcbs[i], 0, sizeof(s_pcbs[i]));
+            s_pcbs[i].used = true;
+            s_pcbs[i].prio = prio;
+            s_pcbs[i].born = s_pcb_serial++;
+            s_pcbs[i].sndbuf = TEST_SND_BUF;
+            return &s_pcbs[i];
+        }
+    }
+    return NULL;
+}
+
+struct tcp_pcb *tcp_new_ip_type(u8_t type)
+{
+    (void)type;
+    return pcb_alloc(TCP_PRIO_NORMAL);
+}
+
+err_t tcp_bind(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port)
+{
+    (void)pcb;
+    (void)ipaddr;
+    CHECK(port == HTTP_SERVER_PORT, "tcp_bind na porta %u", (unsigned)port);
+    return ERR_OK;
+}
+
+struct tcp_pcb *tcp_listen_with_backlog(struct tcp_pcb *pcb, u8_t backlog)
+{
+    (void)backlog;
+    pcb->listening = true;
+    return pcb;
+}
+
+void tcp_accept(struct tcp_pcb *pcb, tcp_accept_fn accept)
+{
+    s_listen_arg = pcb->arg;
+    s_accept = accept;
+}
+
+void tcp_arg(struct tcp_pcb *pcb, void *arg)
+{
+    pcb->arg = arg;
+}
+
+void tcp_recv(struct tcp_pcb *pcb, tcp_recv_fn recv)
+{
+    pcb->recv = recv;
+}
+
+void tcp_sent(struct tcp_pcb *pcb, tcp_sent_fn sent)
+{
+    pcb->sent = sent;
+}
+
+void tcp_err(struct tcp_pcb *pcb, tcp_err_fn err)
+{
+    pcb->err = err;
+}
+
+void tcp_poll(struct tcp_pcb *pcb, tcp_poll_fn poll, u8_t interval)
+{
+    (void)interval;
+    pcb->poll = poll;
+}
+
+void tcp_setprio(struct tcp_pcb *pcb, u8_t prio)
+{
+    pcb->prio = prio;
+}
+
+void tcp_recved(struct tcp_pcb *pcb, u16_t len)
+{
+    (void)pcb;
+    (void)len;
+}
+
+u16_t tcp_sndbuf(const struct tcp_pcb *pcb)
+{
+    return pcb->sndbuf;
+}
+
+err_t tcp_write(struct tcp_pcb *pcb, const void *dataptr, u16_t len, u8_t apiflags)
+{
+    CHECK(!pcb->closed && !pcb->aborted, "tcp_write num PCB fechado");
+    CHECK(len <= pcb->sndbuf, "tcp_write de %u bytes com %u livres", (unsigned)len, (unsigned)pcb->sndbuf);
+    if (pcb->nsegs >= TEST_SEGS || pcb->rx_len + len > TEST_RX_MAX)
+    {
+        return ERR_MEM;
+    }
+
+    seg_t *s = &pcb->segs[pcb->nsegs++];
+    s->ptr = (apiflags & TCP_WRITE_FLAG_COPY) ? NULL : (const char *)dataptr;
+    s->len = len;
+    s->rx_off = pcb->rx_len;
+    memcpy(pcb->rx + pcb->rx_len, dataptr, len);
+    pcb->rx_len += len;
+    pcb->sndbuf = (uint16_t)(pcb->sndbuf - len);
+    return ERR_OK;
+}
+
+err_t tcp_output(struct tcp_pcb *pcb)
+{
+    (void)pcb;
+    return ERR_OK;
+}
+
+err_t tcp_close(struct tcp_pcb *pcb)
+{
+    pcb->closed = true;
+    return ERR_OK;
+}
+
+void tcp_abort(struct tcp_pcb *pcb)
+{
+    pcb->aborted = true;
+}
+
+u16_t pbuf_copy_partial(const struct pbuf *p, void *dataptr, u16_t len, u16_t offset)
+{
+    if (offset >= p->len)
+    {
+        return 0;
+    }
+    const u16_t n = (u16_t)((p->len - offset < len) ? (p->len - offset) : len);
+    memcpy(dataptr, (const char *)p->payload + offset, n);
+    return n;
+}
+
+u8_t pbuf_free(struct pbuf *p)
+{
+    (void)p;
+    return 1;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Clientes                                                               */
+/* ---------------------------------------------------------------------- */
+
+/** @brief Nova conexão (o SYN aloca um PCB com a prioridade da escuta); NULL se o servidor recusou (abortou) o PCB. */
+static struct tcp_pcb *client_connect(void)
+{
+    struct tcp_pcb *pcb = pcb_alloc(TCP_PRIO_NORMAL);
+
+    CHECK(pcb && s_accept, "sem PCB livre ou servidor sem escuta");
+    if (!pcb || !s_accept)
+    {
+        return NULL;
+    }
+    host_isr_enter();
+    const err_t err = s_accept(s_listen_arg, pcb, ERR_OK);
+    host_isr_exit();
+
+    if (err != ERR_OK)
+    {
+        CHECK(pcb->aborted && err == ERR_ABRT, "conexao recusada sem tcp_abort (err %d)", err);
+        CHECK(!pcb->recv && !pcb->sent, "conexao recusada com callbacks instalados");
+        pcb->used = false;
+        return NULL;
+    }
+    return pcb;
+}
+
+/** @brief Envia a requisição `req` ao servidor. */
+static void client_request(struct tcp_pcb *pcb, const char *req)
+{
+    struct pbuf p = {NULL, (void *)req, (u16_t)strlen(req), (u16_t)strlen(req)};
+
+    host_isr_enter();
+    const err_t err = pcb->recv(pcb->arg, pcb, &p, ERR_OK);
+    host_isr_exit();
+    CHECK(err == ERR_OK, "recv devolveu %d", err);
+}
+
+/**
+ * @brief Confirma até `n` bytes; antes compara os segmentos sem cópia com a memória do servidor.
+ * @return true se a conexão terminou (fechada ou abortada).
+ */
+static bool client_ack(struct tcp_pcb *pcb, uint32_t n)
+{
+    const uint32_t pending = pcb->rx_len - pcb->acked;
+    n = (n < pending) ? n : pending;
+
+    for (uint8_t i = 0; i < pcb->nsegs; i++)
+    {
+        const seg_t *s = &pcb->segs[i];
+        if (s->ptr && s->rx_off + s->len > pcb->acked && memcmp(s->ptr, pcb->rx + s->rx_off, s->len) != 0)
+        {
+            CHECK(false, "pagina reescrita com %u bytes sem confirmacao (offset %u)", (unsigned)s->len,
+                  (unsigned)s->rx_off);
+            break;
+        }
+    }
+
+    if (n > 0U)
+    {
+        pcb->acked += n;
+        pcb->sndbuf = (uint16_t)(pcb->sndbuf + n);
+        host_isr_enter();
+        const err_t err = pcb->sent ? pcb->sent(pcb->arg, pcb, (u16_t)n) : ERR_OK;
+        host_isr_exit();
+        CHECK(err == ERR_OK || (err == ERR_ABRT && pcb->aborted), "sent devolveu %d", err);
+    }
+    return pcb->closed || pcb->aborted;
+}
+
+/** @brief Derruba a conexão pelo lado do lwIP (RST): `err` e PCB liberado. */
+static void client_reset(struct tcp_pcb *pcb)
+{
+    host_isr_enter();
+    pcb->err(pcb->arg, ERR_RST);
+    host_isr_exit();
+    pcb->used = false;
+}
+
+/**
+ * @brief Confere a resposta 200 de /metrics recebida e extrai `uptime_seconds`.
+ * @return uptime da página, ou -1 se a resposta está incompleta ou inconsistente.
+ */
+static long client_page_uptime(const struct tcp_pcb *pcb)
+{
+    static char rx[TEST_RX_MAX + 1U];
+
+    memcpy(rx, pcb->rx, pcb->rx_len);
+    rx[pcb->rx_len] = '\0';
+
+    const char *cl = strstr(rx, "Content-Length: ");
+    const char *body = strstr(rx, "\r\n\r\n");
+    if (strncmp(rx, "HTTP/1.1 200 OK\r\n", 17) != 0 || !cl || !body)
+    {
+        return -1;
+    }
+    body += 4;
+    if ((unsigned long)(rx + pcb->rx_len - body) != strtoul(cl + 16, NULL, 10) ||
+        strncmp(body, "# HELP energia_vrms_volts", 25) != 0)
+    {
+        return -1;
+    }
+
+    const char *up = strstr(body, "\nuptime_seconds ");
+    return up ? strtol(up + 16, NULL, 10) : -1;
+}
+
+/** @brief Confirma aos poucos até o fim, deixando o servidor renderizar entre as confirmações. */
+static void client_drain(struct tcp_pcb *pcb)
+{
+    for (unsigned i = 0; i < 64U && !client_ack(pcb, TEST_MSS); i++)
+    {
+        vTaskDelay(pdMS_TO_TICKS(700));
+    }
+    CHECK(pcb->closed && !pcb->aborted, "conexao nao terminou com tcp_close (fechada %d, abortada %d)",
+          pcb->closed, pcb->aborted);
+    /* Quem fecha primeiro (o servidor) passa por TIME_WAIT */
+    pcb->time_wait = pcb->used;
+}
+
+/** @brief Conexão de outro cliente TCP do firmware (MQTT, ThingSpeak), na prioridade padrão. */
+static struct tcp_pcb *other_connect(void)
+{
+    return pcb_alloc(TCP_PRIO_NORMAL);
+}
+
+/* ---------------------------------------------------------------------- */
+/* Estado dos outros módulos (só leitura pelo render)                      */
+/* ---------------------------------------------------------------------- */
+
+bool energy_monitor_get_last(energy_monitor_data_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->vrms = 127.0;
+    out->irms = 1.5;
+    out->v_pu = 1.0;
+    out->p_instant = 190.5;
+    out->e_wh = (double)host_time_us / 3.6e9;
+    out->t_unix_us = 1700000000000000LL + (int64_t)host_time_us;
+    return true;
+}
+
+bool wifi_manager_is_connected(void)
+{
+    return true;
+}
+
+uint32_t wifi_manager_event_count(void)
+{
+    return 1;
+}
+
+void wifi_manager_get_stats(wifi_manager_stats_t *out)
+{
+    memset(out, 0, sizeof(*out));
+}
+
+void wifi_manager_get_pm_stats(wifi_pm_stats_t *out)
+{
+    memset(out, 0, sizeof(*out));
+}
+
+int8_t wifi_manager_tx_register(const char *name)
+{
+    CHECK(strcmp(name, "http") == 0, "cliente de envio \"%s\"", name);
+    return 2;
+}
+
+void wifi_manager_tx_hold(int8_t client, bool hold)
+{
+    CHECK(client == 2, "tx_hold com cliente %d", client);
+    s_radio_hold = hold;
+    s_hold_calls++;
+}
+
+bool wifi_manager_get_rssi(int32_t *out_dbm)
+{
+    *out_dbm = -55;
+    return true;
+}
+
+void time_sync_get_stats(time_sync_stats_t *out)
+{
+    memset(out, 0, sizeof(*out));
+}
+
+int64_t time_sync_now_us(void)
+{
+    return 1700000000000000LL + (int64_t)host_time_us;
+}
+
+void mqtt_publisher_get_stats(mqtt_publisher_stats_t *out)
+{
+    memset(out, 0, sizeof(*out));
+}
+
+void udp_stream_get_stats(udp_stream_stats_t *out)
+{
+    memset(out, 0, sizeof(*out));
+}
+
+void sd_card_log_get_stats(sd_card_log_stats_t *out)
+{
+    memset(out, 0, sizeof(*out));
+}
+
+void logger_get_stats(logger_stats_t *out)
+{
+    memset(out, 0, sizeof(*out));
+}
+
+uint8_t telemetry_sink_count(void)
+{
+    return 2;
+}
+
+const char *telemetry_sink_name(uint8_t idx)
+{
+    return idx ? "MqttSink" : "SdSink";
+}
+
+bool telemetry_get_sink_stats(uint8_t idx, telemetry_sink_stats_t *out)
+{
+    (void)idx;
+    memset(out, 0, sizeof(*out));
+    return true;
+}
+
+bool rtos_stats_get(rtos_stats_snapshot_t *out)
+{
+    (void)out;
+    return false;
+}
+
+bool sd_query_parse_metrics(const char *s, size_t len, uint8_t *mask)
+{
+    (void)s;
+    (void)len;
+    *mask = SD_QUERY_ALL;
+    return true;
+}
+
+sd_query_result_t sd_query_start(const sd_query_req_t *req, sd_query_out_fn out, sd_query_done_fn done, void *ctx)
+{
+    (void)req;
+    (void)out;
+    (void)done;
+    (void)ctx;
+    return SD_QUERY_NO_CARD;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Roteiro                                                                */
+/* ---------------------------------------------------------------------- */
+
+static const char k_get_metrics[] = "GET /metrics HTTP/1.1\r\nHost: pico\r\n\r\n";
+
+static http_server_stats_t stats(void)
+{
+    http_server_stats_t st;
+    http_server_get_stats(&st);
+    return st;
+}
+
+/** @brief Conecta e pede /metrics. */
+static struct tcp_pcb *scrape(void)
+{
+    struct tcp_pcb *pcb = client_connect();
+    if (pcb)
+    {
+        client_request(pcb, k_get_metrics);
+        CHECK(pcb->rx_len > 0U, "/metrics sem resposta imediata");
+    }
+    return pcb;
+}
+
+int main(void)
+{
+    host_rtos_init(tskIDLE_PRIORITY + 5);
+    xTaskCreate(http_server_task, "Http", 1024, NULL, tskIDLE_PRIORITY + 1, NULL);
+
+    /* Renderizações em t = 0, 1, 2... s; o roteiro age entre elas */
+    vTaskDelay(pdMS_TO_TICKS(10));
+    CHECK(s_accept && stats().renders == 1U, "servidor sem escuta ou sem pagina (%u)", (unsigned)stats().renders);
+    CHECK(!s_radio_hold, "radio segurado sem conexoes");
+
+    /* Dois clientes lentos fixam as páginas de t = 0 e t = 1 */
+    struct tcp_pcb *a = scrape();
+    vTaskDelay(pdMS_TO_TICKS(1000));
+    struct tcp_pcb *b = scrape();
+    vTaskDelay(pdMS_TO_TICKS(1000));
+    CHECK(stats().renders == 3U && stats().render_skips == 0U, "renders %u, adiadas %u (esperado 3, 0)",
+          (unsigned)stats().renders, (unsigned)stats().render_skips);
+
+    /* Página de t = 2 corrente, as outras fixadas: nada livre para renderizar */
+    vTaskDelay(pdMS_TO_TICKS(3000));
+    CHECK(stats().renders == 3U && stats().render_skips == 3U, "com 2 paginas fixadas: renders %u, adiadas %u",
+          (unsigned)stats().renders, (unsigned)stats().render_skips);
+
+    /* Mais dois clientes na página corrente ocupam os slots; o quinto é recusado */
+    struct tcp_pcb *c = scrape();
+    struct tcp_pcb *d = scrape();
+    CHECK(a && b && c && d, "conexao recusada com slots livres");
+    CHECK(!client_connect(), "conexao alem de HTTP_SERVER_MAX_CONNS aceita");
+    CHECK(stats().rejected == 1U, "recusadas %u (esperado 1)", (unsigned)stats().rejected);
+    CHECK(s_radio_hold && s_hold_calls == 1U, "com conexoes abertas: radio segurado %d (%u chamadas)", s_radio_hold,
+          s_hold_calls);
+
+    if (!a || !b || !c || !d)
+    {
+        fprintf(stderr, "%u divergencias.\n", s_failures);
+        return 1;
+    }
+
+    /* A recebe a página de t = 0 aos poucos; as renderizações entre as confirmações não a tocam */
+    client_drain(a);
+    CHECK(client_page_uptime(a) == 0, "cliente A: pagina de uptime %ld (esperado 0)", client_page_uptime(a));
+    const uint32_t skips = stats().render_skips;
+    vTaskDelay(pdMS_TO_TICKS(1000));
+    CHECK(stats().render_skips == skips && stats().renders == 4U, "pagina liberada nao reusada: renders %u",
+          (unsigned)stats().renders);
+
+    /* O slot de A aceita um novo cliente, que recebe a página mais nova */
+    const long newest = (long)(host_time_us / 1000000U);
+    struct tcp_pcb *e = scrape();
+    CHECK(e != NULL, "slot liberado nao aceitou conexao");
+
+    client_drain(b);
+    client_drain(c);
+    client_drain(d);
+    CHECK(client_page_uptime(b) == 1, "cliente B: pagina de uptime %ld (esperado 1)", client_page_uptime(b));
+    CHECK(client_page_uptime(c) == 2 && client_page_uptime(d) == 2, "clientes C/D: paginas de uptime %ld/%ld",
+          client_page_uptime(c), client_page_uptime(d));
+    if (e)
+    {
+        client_drain(e);
+        CHECK(client_page_uptime(e) == newest, "cliente E: pagina de uptime %ld (esperado %ld)",
+              client_page_uptime(e), newest);
+    }
+    CHECK(stats().scrapes == 5U && stats().aborted == 0U, "scrapes %u, abortadas %u (esperado 5, 0)",
+          (unsigned)stats().scrapes, (unsigned)stats().aborted);
+    CHECK(!s_radio_hold && s_hold_calls == 2U, "todas fechadas: radio segurado %d (%u chamadas)", s_radio_hold,
+          s_hold_calls);
+
+    /* Erro na conexão (RST) também solta a página fixada */
+    struct tcp_pcb *f = scrape();
+    vTaskDelay(pdMS_TO_TICKS(1000));
+    struct tcp_pcb *g = scrape();
+    vTaskDelay(pdMS_TO_TICKS(2000));
+    const http_server_stats_t pinned = stats();
+    if (f && g)
+    {
+        client_reset(f);
+        vTaskDelay(pdMS_TO_TICKS(1000));
+        CHECK(stats().renders == pinned.renders + 1U && stats().render_skips == pinned.render_skips,
+              "RST nao soltou a pagina: renders %u -> %u", (unsigned)pinned.renders, (unsigned)stats().renders);
+        CHECK(stats().aborted == 1U, "abortadas %u (esperado 1)", (unsigned)stats().aborted);
+        CHECK(s_radio_hold, "RST de uma conexao soltou o radio com outra aberta");
+        client_drain(g);
+    }
+
+    /* Caminho desconhecido */
+    struct tcp_pcb *h = client_connect();
+    if (h)
+    {
+        client_request(h, "GET /favicon.ico HTTP/1.1\r\n\r\n");
+        CHECK(strncmp(h->rx, "HTTP/1.1 404", 12) == 0, "caminho desconhecido sem 404");
+        client_drain(h);
+    }
+    CHECK(stats().not_found == 1U && stats().scrapes == 6U, "404: %u, scrapes %u", (unsigned)stats().not_found,
+          (unsigned)stats().scrapes);
+    CHECK(!s_radio_hold, "radio segurado depois da ultima conexao");
+
+    /* Pool cheio: MQTT e ThingSpeak conectados, todos os slots ocupados e os PCBs fechados acima em TIME_WAIT */
+    struct tcp_pcb *mqtt = other_connect();
+    struct tcp_pcb *ts = other_connect();
+    struct tcp_pcb *full[HTTP_SERVER_MAX_CONNS];
+    for (unsigned i = 0; i < HTTP_SERVER_MAX_CONNS; i++)
+    {
+        full[i] = scrape();
+    }
+    const http_server_stats_t before = stats();
+
+    /* ThingSpeak fecha (TIME_WAIT do lado dele) e reconecta; um scrape além do limite é recusado */
+    if (ts)
+    {
+        ts->time_wait = true;
+    }
+    struct tcp_pcb *ts2 = other_connect();
+    CHECK(!client_connect(), "conexao alem de HTTP_SERVER_MAX_CONNS aceita com o pool cheio");
+    CHECK(mqtt && ts && ts2, "MQTT/ThingSpeak sem PCB (MEMP_NUM_TCP_PCB = %u)", (unsigned)MEMP_NUM_TCP_PCB);
+    CHECK(s_evictions == 0U && stats().aborted == before.aborted,
+          "pool de %u PCBs: %u scrape(s) derrubado(s) por falta de PCB", (unsigned)MEMP_NUM_TCP_PCB, s_evictions);
+    for (unsigned i = 0; i < HTTP_SERVER_MAX_CONNS; i++)
+    {
+        CHECK(full[i] && !full[i]->aborted, "scrape %u derrubado com o pool cheio", i);
+        if (full[i] && !full[i]->aborted)
+        {
+            client_drain(full[i]);
+            CHECK(client_page_uptime(full[i]) >= 0, "scrape %u com resposta incompleta", i);
+        }
+    }
+    CHECK(stats().rejected == before.rejected + 1U, "recusadas %u (esperado %u)", (unsigned)stats().rejected,
+          (unsigned)before.rejected + 1U);
+
+    if (s_failures)
+    {
+        fprintf(stderr, "%u divergencias.\n", s_failures);
+        return 1;
+    }
+    const http_server_stats_t st = stats();
+    printf("http_server: OK (%u scrapes, %u renders, %u adiadas, %u recusadas, pool de %u PCBs)\n",
+           (unsigned)st.scrapes, (unsigned)st.renders, (unsigned)st.render_skips, (unsigned)st.rejected,
+           (unsigned)MEMP_NUM_TCP_PCB);
+    return 0;
+}
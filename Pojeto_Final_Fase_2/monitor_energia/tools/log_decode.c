@@ -0,0 +1,259 @@
+/**
+ * @file log_decode.c
+ * @brief Decodificador (host) dos logs tokenizados (`LOGGER_TOKENIZED`).
+ * @details
+ *  Lê a seção `log_fmt` do ELF do firmware (32 ou 64 bits) e uma captura da
+ *  serial USB (arquivo ou stdin). Quadros entre bytes 0x00 são decodificados
+ *  (COBS, `lib/log_token.h`) e impressos como o logger em texto imprimiria:
+ *  "dd/mm/aaaa hh:mm:ss.mmm tag: mensagem". Trechos que não são quadros
+ *  válidos (saídas do SDK com printf) passam como estão.
+ *
+ *  Compilação e uso (a partir de `monitor_energia/`):
+ *      gcc -O2 -I. tools/log_decode.c lib/log_token.c lib/timestamp.c lib/fmt.c -o log_decode
+ *      ./log_decode build/monitor_energia.elf captura.bin
+ *      cat /dev/ttyACM0 | ./log_decode build/monitor_energia.elf
+ */
+
+#include <elf.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lib/log_token.h"
+#include "lib/timestamp.h"
+
+#define DEC_MAX_CHUNK   4096U       /**< Maior trecho entre delimitadores. */
+
+static char *s_fmt = NULL;          /**< Conteúdo da seção `log_fmt`. */
+static size_t s_fmt_len = 0;
+
+/** @brief Lê o arquivo inteiro em memória. */
+static unsigned char *read_file(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+    {
+        perror(path);
+        return NULL;
+    }
+
+    fseek(f, 0, SEEK_END);
+    const long sz = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    unsigned char *buf = (sz > 0) ? malloc((size_t)sz) : NULL;
+    if (!buf || fread(buf, 1, (size_t)sz, f) != (size_t)sz)
+    {
+        fprintf(stderr, "%s: leitura falhou\n", path);
+        free(buf);
+        fclose(f);
+        return NULL;
+    }
+
+    fclose(f);
+    *len = (size_t)sz;
+    return buf;
+}
+
+/**
+ * @brief Copia a seção `LOG_TOKEN_SECTION` do ELF para `s_fmt`.
+ * @return 0 em sucesso.
+ */
+static int load_formats(const char *elf_path)
+{
+    size_t len;
+    unsigned char *img = read_file(elf_path, &len);
+
+    if (!img)
+    {
+        return -1;
+    }
+
+    if (len < EI_NIDENT || memcmp(img, ELFMAG, SELFMAG) != 0)
+    {
+        fprintf(stderr, "%s: não é ELF\n", elf_path);
+        free(img);
+        return -1;
+    }
+
+    size_t shoff, shentsize, shnum, shstrndx;
+    const int is64 = img[EI_CLASS] == ELFCLASS64;
+
+    if (is64)
+    {
+        const Elf64_Ehdr *eh = (const Elf64_Ehdr *)img;
+        shoff = eh->e_shoff, shentsize = eh->e_shentsize, shnum = eh->e_shnum, shstrndx = eh->e_shstrndx;
+    }
+    else
+    {
+        const Elf32_Ehdr *eh = (const Elf32_Ehdr *)img;
+        shoff = eh->e_shoff, shentsize = eh->e_shentsize, shnum = eh->e_shnum, shstrndx = eh->e_shstrndx;
+    }
+
+    if (shoff + shnum * shentsize > len || shstrndx >= shnum)
+    {
+        fprintf(stderr, "%s: tabela de seções inválida\n", elf_path);
+        free(img);
+        return -1;
+    }
+
+#define SH_FIELD(i, f) (is64 ? (size_t)((const Elf64_Shdr *)(img + shoff + (i) * shentsize))->f \
+                             : (size_t)((const Elf32_Shdr *)(img + shoff + (i) * shentsize))->f)
+
+    const size_t strtab = SH_FIELD(shstrndx, sh_offset);
+
+    for (size_t i = 0; i < shnum; i++)
+    {
+        const size_t name = strtab + SH_FIELD(i, sh_name);
+        const size_t off = SH_FIELD(i, sh_offset);
+        const size_t size = SH_FIELD(i, sh_size);
+
+        if (name < len && strncmp((const char *)img + name, LOG_TOKEN_SECTION, len - name) == 0 &&
+            off + size <= len)
+        {
+            s_fmt = malloc(size + 1U);
+            memcpy(s_fmt, img + off, size);
+            s_fmt[size] = '\0';
+            s_fmt_len = size;
+            free(img);
+            return 0;
+        }
+    }
+#undef SH_FIELD
+
+    fprintf(stderr, "%s: seção %s ausente (firmware sem LOGGER_TOKENIZED?)\n", elf_path, LOG_TOKEN_SECTION);
+    free(img);
+    return -1;
+}
+
+/** @brief Imprime o prefixo de data/hora como o logger em texto. */
+static void print_time(int64_t t_unix_us)
+{
+    static timestamp_cache_t cache = TIMESTAMP_CACHE_INIT('/', ' ', true);
+    char ts[TIMESTAMP_MAX_LEN];
+
+    const size_t n = timestamp_format(&cache, ts, sizeof(ts), t_unix_us);
+    fwrite(ts, 1, n, stdout);
+}
+
+/**
+ * @brief Decodifica e imprime um quadro.
+ * @return 0 se o trecho era um quadro válido.
+ */
+static int print_frame(const unsigned char *chunk, size_t len)
+{
+    uint8_t raw[DEC_MAX_CHUNK];
+    const size_t n = log_token_cobs_decode(chunk, len, raw, sizeof(raw));
+
+    if (n < LOG_TOKEN_FRAME_HDR || (raw[0] != LOG_TOKEN_FRAME_MSG && raw[0] != LOG_TOKEN_FRAME_DROPPED))
+    {
+        return -1;
+    }
+
+    uint64_t t = 0;
+    for (unsigned i = 0; i < 8U; i++)
+    {
+        t |= (uint64_t)raw[1U + i] << (8U * i);
+    }
+
+    const uint8_t *body = &raw[LOG_TOKEN_FRAME_HDR];
+    const size_t body_len = n - LOG_TOKEN_FRAME_HDR;
+    uint64_t v;
+    const size_t vn = log_token_get_varint(body, body_len, &v);
+
+    if (!vn)
+    {
+        return -1;
+    }
+
+    if (raw[0] == LOG_TOKEN_FRAME_DROPPED)
+    {
+        print_time((int64_t)t);
+        printf(" logger: %llu mensagens descartadas (anel cheio).\n", (unsigned long long)v);
+        return 0;
+    }
+
+    if (v >= s_fmt_len)
+    {
+        return -1;
+    }
+
+    /* Cadeia na seção: TAG, separador, formato. */
+    const char *tag = &s_fmt[v];
+    const char *sep = memchr(tag, LOG_TOKEN_TAG_SEP, strlen(tag));
+    char text[1024];
+
+    if (!sep)
+    {
+        return -1;
+    }
+
+    log_token_render(text, sizeof(text), sep + 1, body + vn, body_len - vn);
+    print_time((int64_t)t);
+    printf(" %.*s: %s\n", (int)(sep - tag), tag, text);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2 || argc > 3)
+    {
+        fprintf(stderr, "uso: %s firmware.elf [captura.bin]\n", argv[0]);
+        return 1;
+    }
+
+    if (load_formats(argv[1]) != 0)
+    {
+        return 1;
+    }
+
+    FILE *in = (argc == 3) ? fopen(argv[2], "rb") : stdin;
+    if (!in)
+    {
+        perror(argv[2]);
+        return 1;
+    }
+
+    static unsigned char chunk[DEC_MAX_CHUNK];
+    size_t len = 0;
+    unsigned long frames = 0;
+    unsigned long bad = 0;
+    int c;
+
+    while ((c = fgetc(in)) != EOF)
+    {
+        if (c != 0)
+        {
+            if (len < sizeof(chunk))
+            {
+                chunk[len++] = (unsigned char)c;
+            }
+            continue;
+        }
+
+        if (len)
+        {
+            if (print_frame(chunk, len) == 0)
+            {
+                frames++;
+            }
+            else
+            {
+                /* Texto comum (ou quadro corrompido): repassa como está. */
+                fwrite(chunk, 1, len, stdout);
+                bad++;
+            }
+            fflush(stdout);
+        }
+        len = 0;
+    }
+
+    fwrite(chunk, 1, len, stdout);
+    fprintf(stderr, "%lu quadros decodificados, %lu trechos repassados como texto.\n", frames, bad);
+
+    if (in != stdin)
+    {
+        fclose(in);
+    }
+    free(s_fmt);
+    return 0;
+}
@@ -0,0 +1,339 @@
+/**
+ * @file logger_bench.c
+ * @brief Benchmark (host) da latência de uma chamada de log: anel (`lib/log_ring.c`) contra escrita direta.
+ * @details
+ *  Reproduz os dois caminhos de `logger_log`:
+ *   - direto: formata e escreve com `fwrite` + `fflush` num pipe de 4 kB
+ *     cujo leitor simula o host USB (lê rápido, mas some por
+ *     `SLOW_PAUSE_US` a cada `SLOW_BURST` bytes);
+ *   - anel: formata na pilha, reserva sob mutex (no firmware, seção
+ *     crítica), copia e publica; uma thread consumidora escoa para o mesmo
+ *     pipe lento.
+ *
+ *  Antes de medir, confere o anel com `BENCH_PRODUCERS` threads produtoras e
+ *  um consumidor: cada mensagem aceita deve chegar uma vez, inteira e na
+ *  ordem do seu produtor; mensagens descartadas só podem faltar. Qualquer
+ *  divergência aborta o benchmark.
+ *
+ *  Compilação e execução (a partir de `monitor_energia/`):
+ *      gcc -O2 -I. tools/logger_bench.c lib/log_ring.c -o logger_bench -lpthread && ./logger_bench
+ */
+
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "lib/log_ring.h"
+
+#define BENCH_RING_SIZE     4096U       /**< Igual a LOGGER_RING_SIZE. */
+#define BENCH_MSG_MAX       160U        /**< Igual a LOGGER_MSG_MAX. */
+#define BENCH_PRODUCERS     4U          /**< Threads no teste de consistência. */
+#define BENCH_CHECK_MSGS    50000U      /**< Mensagens por produtor no teste de consistência. */
+#define BENCH_CALLS         20000U      /**< Chamadas medidas por cenário. */
+#define BENCH_CALL_GAP_US   200U        /**< Intervalo entre chamadas medidas. */
+#define SLOW_PIPE_SIZE      4096        /**< Buffer do pipe (o TX do CDC também é pequeno). */
+#define SLOW_BURST          65536U      /**< Bytes lidos pelo "host USB" entre pausas. */
+#define SLOW_PAUSE_US       20000U      /**< Pausa do host (ex.: terminal ocupado). */
+
+static uint8_t s_buf[BENCH_RING_SIZE] __attribute__((aligned(LOG_RING_ALIGN)));
+static log_ring_t s_ring;
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static volatile int s_stop = 0;
+static unsigned long s_dropped = 0;
+
+/** @brief Relógio monotônico em nanossegundos. */
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    const double x = *(const double *)a;
+    const double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/** @brief Caminho do anel (mesma sequência de `logger_log`). */
+static int ring_log(uint64_t t, const char *tag, const char *fmt, ...)
+{
+    char text[BENCH_MSG_MAX];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(text, sizeof(text), fmt, ap);
+    va_end(ap);
+    n = (n < 0) ? 0 : (n >= (int)sizeof(text)) ? (int)sizeof(text) - 1 : n;
+
+    pthread_mutex_lock(&s_lock);
+    log_ring_entry_t *e = log_ring_reserve(&s_ring, (uint16_t)n);
+    if (!e)
+    {
+        s_dropped++;
+    }
+    pthread_mutex_unlock(&s_lock);
+
+    if (!e)
+    {
+        return 0;
+    }
+
+    e->t_us = t;
+    e->tag = tag;
+    memcpy(log_ring_text(e), text, (size_t)n);
+    log_ring_commit(e);
+    return 1;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Consistência                                                              */
+
+static unsigned s_failures = 0;
+static unsigned long s_next[BENCH_PRODUCERS];
+static unsigned long s_received = 0;
+static unsigned long s_accepted = 0;
+
+static void *check_producer(void *arg)
+{
+    const unsigned id = (unsigned)(uintptr_t)arg;
+    unsigned long ok = 0;
+
+    for (unsigned long k = 0; k < BENCH_CHECK_MSGS; k++)
+    {
+        /* Comprimentos variados exercitam o enchimento no fim do buffer. */
+        const int accepted = ring_log(((uint64_t)id << 32) | k, "chk", "p%u m%lu %.*s", id, k, (int)(k % 97U),
+                                      "................................................"
+                                      "..................................................");
+        ok += (unsigned long)accepted;
+
+        if (!accepted)
+        {
+            sched_yield(); /* Anel cheio: deixa o consumidor andar. */
+        }
+    }
+
+    pthread_mutex_lock(&s_lock);
+    s_accepted += ok;
+    pthread_mutex_unlock(&s_lock);
+    return NULL;
+}
+
+static void check_entry(log_ring_entry_t *e)
+{
+    const unsigned id = (unsigned)(e->t_us >> 32);
+    const unsigned long k = (unsigned long)(uint32_t)e->t_us;
+    char want[BENCH_MSG_MAX];
+    const int n = snprintf(want, sizeof(want), "p%u m%lu %.*s", id, k, (int)(k % 97U),
+                           "................................................"
+                           "..................................................");
+
+    if (id >= BENCH_PRODUCERS || k < s_next[id] || e->len != (uint16_t)n ||
+        memcmp(log_ring_text(e), want, (size_t)n) != 0 || strcmp(e->tag, "chk") != 0)
+    {
+        if (s_failures++ < 10U)
+        {
+            fprintf(stderr, "DIVERGENCIA produtor=%u msg=%lu esperado>=%lu\n", id, k,
+                    id < BENCH_PRODUCERS ? s_next[id] : 0UL);
+        }
+        return;
+    }
+
+    s_next[id] = k + 1U;
+    s_received++;
+}
+
+static void *check_consumer(void *arg)
+{
+    (void)arg;
+
+    for (;;)
+    {
+        const int stop = s_stop;
+        log_ring_entry_t *e;
+
+        while ((e = log_ring_peek(&s_ring)) != NULL)
+        {
+            check_entry(e);
+            log_ring_release(&s_ring, e);
+        }
+
+        if (stop)
+        {
+            return NULL;
+        }
+    }
+}
+
+static void run_check(void)
+{
+    pthread_t prod[BENCH_PRODUCERS];
+    pthread_t cons;
+
+    (void)log_ring_init(&s_ring, s_buf, BENCH_RING_SIZE);
+    s_stop = 0;
+    s_dropped = 0;
+    pthread_create(&cons, NULL, check_consumer, NULL);
+
+    for (unsigned i = 0; i < BENCH_PRODUCERS; i++)
+    {
+        pthread_create(&prod[i], NULL, check_producer, (void *)(uintptr_t)i);
+    }
+    for (unsigned i = 0; i < BENCH_PRODUCERS; i++)
+    {
+        pthread_join(prod[i], NULL);
+    }
+
+    s_stop = 1;
+    pthread_join(cons, NULL);
+
+    if (s_received != s_accepted)
+    {
+        s_failures++;
+        fprintf(stderr, "Recebidas %lu de %lu aceitas.\n", s_received, s_accepted);
+    }
+
+    printf("Consistencia: %u produtores x %u mensagens, %lu entregues, %lu descartadas, pico %u/%u bytes.\n",
+           BENCH_PRODUCERS, BENCH_CHECK_MSGS, s_received, s_dropped, (unsigned)s_ring.high_water,
+           BENCH_RING_SIZE);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Latência com um consumidor lento                                          */
+
+static int s_pipe[2];
+
+/** @brief "Host USB": lê o pipe e some por alguns ms a cada rajada. */
+static void *slow_reader(void *arg)
+{
+    (void)arg;
+    char buf[1024];
+    size_t burst = 0;
+    ssize_t n;
+
+    while ((n = read(s_pipe[0], buf, sizeof(buf))) > 0)
+    {
+        burst += (size_t)n;
+        if (burst >= SLOW_BURST)
+        {
+            burst = 0;
+            usleep(SLOW_PAUSE_US);
+        }
+    }
+    return NULL;
+}
+
+/** @brief Task de escoamento: monta as linhas e escreve no pipe lento. */
+static void *drain(void *arg)
+{
+    FILE *out = (FILE *)arg;
+
+    for (;;)
+    {
+        const int stop = s_stop;
+        log_ring_entry_t *e;
+
+        while ((e = log_ring_peek(&s_ring)) != NULL)
+        {
+            char line[64 + BENCH_MSG_MAX + 1];
+            int n = snprintf(line, 64, "%llu %s: ", (unsigned long long)e->t_us, e->tag);
+            memcpy(&line[n], log_ring_text(e), e->len);
+            n += e->len;
+            line[n++] = '\n';
+            log_ring_release(&s_ring, e);
+            fwrite(line, 1, (size_t)n, out);
+            fflush(out);
+        }
+
+        if (stop)
+        {
+            return NULL;
+        }
+        usleep(100);
+    }
+}
+
+static void report(const char *name, double *lat, unsigned n, unsigned long dropped)
+{
+    qsort(lat, n, sizeof(double), cmp_double);
+    printf("%-10s: p50 %7.2f us | p99 %8.2f us | max %9.2f us | descartes %lu\n", name, lat[n / 2U] / 1e3,
+           lat[n * 99U / 100U] / 1e3, lat[n - 1U] / 1e3, dropped);
+}
+
+static void pace(double t_next)
+{
+    while (now_ns() < t_next)
+    {
+    }
+}
+
+int main(void)
+{
+    run_check();
+    if (s_failures)
+    {
+        fprintf(stderr, "%u divergencias; benchmark abortado.\n", s_failures);
+        return 1;
+    }
+
+    static double lat[BENCH_CALLS];
+    pthread_t reader;
+
+    if (pipe(s_pipe) != 0)
+    {
+        perror("pipe");
+        return 1;
+    }
+    (void)fcntl(s_pipe[1], F_SETPIPE_SZ, SLOW_PIPE_SIZE);
+    pthread_create(&reader, NULL, slow_reader, NULL);
+    FILE *out = fdopen(s_pipe[1], "w");
+
+    /* Direto: o chamador espera o pipe (USB) aceitar a linha. */
+    double t_next = now_ns();
+    for (unsigned k = 0; k < BENCH_CALLS; k++)
+    {
+        t_next += BENCH_CALL_GAP_US * 1e3;
+        pace(t_next);
+        const double t0 = now_ns();
+        char text[BENCH_MSG_MAX];
+        const int n = snprintf(text, sizeof(text), "Janela %u: Vrms=%.2f V Irms=%.3f A P=%.1f W", k,
+                               127.0 + k % 7U, 4.2 + k % 3U, 556.9);
+        fprintf(out, "%llu energy_monitor: ", (unsigned long long)k);
+        fwrite(text, 1, (size_t)n, out);
+        fputc('\n', out);
+        fflush(out);
+        lat[k] = now_ns() - t0;
+    }
+    report("direto", lat, BENCH_CALLS, 0);
+
+    /* Anel: o chamador só copia; a thread de escoamento espera o pipe. */
+    pthread_t drainer;
+    (void)log_ring_init(&s_ring, s_buf, BENCH_RING_SIZE);
+    s_stop = 0;
+    s_dropped = 0;
+    pthread_create(&drainer, NULL, drain, out);
+
+    t_next = now_ns();
+    for (unsigned k = 0; k < BENCH_CALLS; k++)
+    {
+        t_next += BENCH_CALL_GAP_US * 1e3;
+        pace(t_next);
+        const double t0 = now_ns();
+        (void)ring_log(k, "energy_monitor", "Janela %u: Vrms=%.2f V Irms=%.3f A P=%.1f W", k, 127.0 + k % 7U,
+                       4.2 + k % 3U, 556.9);
+        lat[k] = now_ns() - t0;
+    }
+    report("anel", lat, BENCH_CALLS, s_dropped);
+
+    s_stop = 1;
+    pthread_join(drainer, NULL);
+    fclose(out);
+    pthread_join(reader, NULL);
+    return 0;
+}
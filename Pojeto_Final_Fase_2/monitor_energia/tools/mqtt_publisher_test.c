@@ -0,0 +1,532 @@
+/**
+ * @file mqtt_publisher_test.c
+ * @brief Teste (host) da máquina de estados do publicador MQTT (`lib/mqtt_publisher.c`): slots em voo, republicação, backoff e fila de janelas.
+ * @details
+ *  Compila `lib/mqtt_publisher.c` sem alteração sobre o scheduler de relógio
+ *  virtual de `tools/host/rtos_host.c`, com um broker de mentira no lugar de
+ *  `lwip/apps/mqtt` (`mqtt_client_connect`, `mqtt_publish`): o teste
+ *  responde às conexões e confirma, falha ou perde as publicações chamando
+ *  os callbacks do publicador numa IRQ simulada, como o lwIP no firmware.
+ *  Roteiro:
+ *   - conexões recusadas: tentativas espaçadas por 2, 4, 8, 16 e 32 s;
+ *   - janela de 5 tópicos com 4 slots: 4 em voo, o 5º (QoS 0) sai quando
+ *     um PUBACK libera o slot;
+ *   - `mqtt_publish` com ERR_MEM (buffer do lwIP cheio): o slot espera e a
+ *     mesma mensagem sai quando há espaço;
+ *   - PUBACK com erro (`reclaim_slots`): republica o mesmo tópico e payload;
+ *   - queda com mensagens em voo (`requeue_inflight`): a confirmada conta
+ *     como publicada, as outras voltam depois da reconexão (2 s, backoff
+ *     zerado), antes do resto da janela;
+ *   - fila de 4 janelas com o broker fora: descarta as mais antigas;
+ *   - sink da telemetria: delta de energia e rádio acordado até a janela
+ *     toda confirmada (`wifi_manager_tx_schedule`).
+ *  Sai com código 1 na primeira divergência encontrada (mostra até 10).
+ *
+ *  Escopo: só a lógica do publicador acima da API `lwip/apps/mqtt.h`
+ *  (slots, republicação, backoff, fila de janelas e agendamento do rádio).
+ *  O cliente MQTT do lwIP não é compilado: nenhum byte MQTT 3.1.1 é gerado
+ *  nem decodificado, então CONNECT (client id, keepalive, will), o
+ *  enquadramento de PUBLISH/PUBACK e a numeração dos packet ids ficam fora
+ *  deste teste e continuam sendo conferidos contra um broker real.
+ *
+ *  Compilação e execução (a partir de `monitor_energia/`):
+ *      gcc -O2 -I. -Itools/host tools/mqtt_publisher_test.c lib/mqtt_publisher.c lib/fmt.c \
+ *          tools/host/rtos_host.c tools/host/logger_host.c -o mqtt_publisher_test -lpthread -lm \
+ *          && ./mqtt_publisher_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "pico/time.h"
+#include "lwip/apps/mqtt.h"
+#include "lib/mqtt_publisher.h"
+#include "lib/wifi_manager.h"
+#include "lib/telemetry.h"
+#include "lib/rtos_stats.h"
+#include "lib/utils.h"
+
+#define TEST_MAX_PUBS       256U        /**< Publicações guardadas pelo broker. */
+#define TEST_MAX_CONNECTS   32U         /**< Conexões guardadas pelo broker. */
+#define TEST_STEP_MS        50U         /**< Passo do broker entre respostas. */
+#define TEST_NEXT_WINDOW_MS 42000U      /**< `telemetry_next_window_ms` de mentira. */
+#define TEST_TOPICS         5U          /**< Tópicos por janela (vrms, irms, p_w, e_wh, uptime_s). */
+
+/** @brief Uma publicação recebida pelo broker. */
+typedef struct
+{
+    uint8_t topic;              /**< Índice do tópico (ordem de `k_topics`). */
+    char payload[32];
+    uint8_t qos;
+    mqtt_request_cb_t cb;
+    void *arg;
+    bool open;                  /**< Aguardando resposta do broker. */
+} pub_t;
+
+static const char *const k_topic_names[TEST_TOPICS] = {
+    MQTT_TOPIC_PREFIX "vrms", MQTT_TOPIC_PREFIX "irms", MQTT_TOPIC_PREFIX "p_w",
+    MQTT_TOPIC_PREFIX "e_wh", MQTT_TOPIC_PREFIX "uptime_s",
+};
+
+static unsigned s_failures = 0;
+
+static uint8_t s_client_dummy;
+static pub_t s_pubs[TEST_MAX_PUBS];
+static unsigned s_npubs = 0;
+static unsigned s_pub_rejects = 0;          /**< `mqtt_publish` recusados (ERR_MEM). */
+static bool s_outbuf_full = false;          /**< Próximos `mqtt_publish` dão ERR_MEM. */
+static bool s_auto_ack = false;             /**< Broker confirma tudo a cada passo. */
+
+static mqtt_connection_cb_t s_conn_cb = NULL;
+static void *s_conn_arg = NULL;
+static bool s_conn_pending = false;         /**< Conexão aguardando resposta. */
+static unsigned s_refuse_left = 0;          /**< Próximas conexões recusadas. */
+static uint64_t s_connect_us[TEST_MAX_CONNECTS];
+static unsigned s_nconnects = 0;
+
+static uint32_t s_tx_last = 0;              /**< Último `wifi_manager_tx_schedule`. */
+static unsigned s_tx_calls = 0;
+
+#define CHECK(cond, ...)                                                                          \
+    do                                                                                            \
+    {                                                                                             \
+        if (!(cond) && s_failures++ < 10U)                                                        \
+        {                                                                                         \
+            fprintf(stderr, "FALHA [%.3f s] ", (double)host_time_us / 1e6);                       \
+            fprintf(stderr, __VA_ARGS__);                                                         \
+            fputc('\n', stderr);                                                                  \
+        }                                                                                         \
+    } while (0)
+
+/* ---------------------------------------------------------------------- */
+/* Broker de mentira (lwip/apps/mqtt)                                     */
+/* ---------------------------------------------------------------------- */
+
+mqtt_client_t *mqtt_client_new(void)
+{
+    return (mqtt_client_t *)&s_client_dummy;
+}
+
+err_t mqtt_client_connect(mqtt_client_t *client, const ip_addr_t *ipaddr, u16_t port, mqtt_connection_cb_t cb,
+                          void *arg, const struct mqtt_connect_client_info_t *client_info)
+{
+    (void)client;
+    (void)ipaddr;
+    (void)port;
+    CHECK(!s_conn_pending, "mqtt_client_connect com outra conexao pendente");
+    CHECK(client_info && client_info->will_topic, "conexao sem will");
+    s_conn_cb = cb;
+    s_conn_arg = arg;
+    s_conn_pending = true;
+    if (s_nconnects < TEST_MAX_CONNECTS)
+    {
+        s_connect_us[s_nconnects] = host_time_us;
+    }
+    s_nconnects++;
+    return ERR_OK;
+}
+
+err_t mqtt_publish(mqtt_client_t *client, const char *topic, const void *payload, u16_t payload_length,
+                   u8_t qos, u8_t retain, mqtt_request_cb_t cb, void *arg)
+{
+    (void)client;
+    (void)retain;
+
+    if (s_outbuf_full)
+    {
+        s_pub_rejects++;
+        return ERR_MEM;
+    }
+
+    pub_t *p = &s_pubs[s_npubs < TEST_MAX_PUBS ? s_npubs : TEST_MAX_PUBS - 1U];
+    memset(p, 0, sizeof(*p));
+    p->topic = 0xFF;
+    for (uint8_t i = 0; i < TEST_TOPICS; i++)
+    {
+        if (strcmp(topic, k_topic_names[i]) == 0)
+        {
+            p->topic = i;
+        }
+    }
+    CHECK(p->topic != 0xFF, "topico desconhecido %s", topic);
+    snprintf(p->payload, sizeof(p->payload), "%.*s", (int)payload_length, (const char *)payload);
+    p->qos = qos;
+    p->cb = cb;
+    p->arg = arg;
+    p->open = true;
+    s_npubs++;
+    return ERR_OK;
+}
+
+/** @brief Publicações ainda sem resposta. */
+static unsigned open_pubs(void)
+{
+    unsigned n = 0;
+    for (unsigned i = 0; i < s_npubs; i++)
+    {
+        n += s_pubs[i].open ? 1U : 0U;
+    }
+    return n;
+}
+
+/** @brief Responde a publicação `i` (PUBACK com `err`) na IRQ simulada. */
+static void broker_answer(unsigned i, err_t err)
+{
+    CHECK(i < s_npubs && s_pubs[i].open, "resposta para a publicacao %u, que nao esta aberta", i);
+    s_pubs[i].open = false;
+    host_isr_enter();
+    s_pubs[i].cb(s_pubs[i].arg, err);
+    host_isr_exit();
+}
+
+/** @brief Muda o estado da conexão na IRQ simulada. */
+static void broker_conn(mqtt_connection_status_t status)
+{
+    s_conn_pending = false;
+    host_isr_enter();
+    s_conn_cb((mqtt_client_t *)&s_client_dummy, s_conn_arg, status);
+    host_isr_exit();
+}
+
+/** @brief Roda o broker por `ms`: responde conexões pela política e confirma se `s_auto_ack`. */
+static void broker_run(uint32_t ms)
+{
+    const uint64_t until = host_time_us + (uint64_t)ms * 1000U;
+
+    while (host_time_us < until)
+    {
+        if (s_conn_pending)
+        {
+            if (s_refuse_left)
+            {
+                s_refuse_left--;
+                broker_conn(MQTT_CONNECT_REFUSED_SERVER);
+            }
+            else
+            {
+                broker_conn(MQTT_CONNECT_ACCEPTED);
+            }
+        }
+        for (unsigned i = 0; s_auto_ack && i < s_npubs; i++)
+        {
+            if (s_pubs[i].open)
+            {
+                broker_answer(i, ERR_OK);
+            }
+        }
+        vTaskDelay(pdMS_TO_TICKS(TEST_STEP_MS));
+    }
+}
+
+/* ---------------------------------------------------------------------- */
+/* Ambiente do publicador                                                 */
+/* ---------------------------------------------------------------------- */
+
+bool utils_resolve_dns(const char *hostname, ip_addr_t *out_ip, uint32_t timeout_ms)
+{
+    (void)hostname;
+    (void)timeout_ms;
+    out_ip->addr = 0x0100007FU;
+    return true;
+}
+
+bool wifi_manager_is_connected(void)
+{
+    return true;
+}
+
+bool wifi_manager_subscribe(wifi_link_cb_t cb, void *ctx)
+{
+    (void)cb;
+    (void)ctx;
+    return true;
+}
+
+int8_t wifi_manager_tx_register(const char *name)
+{
+    (void)name;
+    return 0;
+}
+
+void wifi_manager_tx_schedule(int8_t client, uint32_t in_ms)
+{
+    CHECK(client == 0, "tx_schedule do cliente %d", client);
+    s_tx_last = in_ms;
+    s_tx_calls++;
+}
+
+uint32_t telemetry_next_window_ms(void)
+{
+    return TEST_NEXT_WINDOW_MS;
+}
+
+BaseType_t rtos_stats_create_task(TaskFunction_t fn, const char *name, uint32_t stack_words, void *params,
+                                  UBaseType_t priority, TaskHandle_t *handle)
+{
+    return xTaskCreate(fn, name, stack_words, params, priority, handle);
+}
+
+void rtos_stats_watch_queue(QueueHandle_t q, const char *name)
+{
+    (void)q;
+    (void)name;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Roteiro                                                                */
+/* ---------------------------------------------------------------------- */
+
+static mqtt_publisher_stats_t stats(void)
+{
+    mqtt_publisher_stats_t st;
+    mqtt_publisher_get_stats(&st);
+    return st;
+}
+
+/** @brief Enfileira a janela `k` (uptime_s = k, valores distintos por janela). */
+static bool window(uint32_t k)
+{
+    return mqtt_publisher_publish_window(100.0 + k, (double)k / 8.0, 10.0 * k, (double)k / 16.0, k);
+}
+
+/** @brief Conexões recusadas com backoff exponencial, depois aceita. */
+static void step_backoff(void)
+{
+    static const uint32_t k_backoff_ms[] = {2000, 4000, 8000, 16000, 32000};
+
+    s_refuse_left = 5;
+    broker_run(70000);
+
+    CHECK(s_nconnects == 6U, "%u tentativas de conexao (esperado 6)", s_nconnects);
+    for (unsigned i = 0; i + 1U < s_nconnects && i < 5U; i++)
+    {
+        const uint64_t gap_ms = (s_connect_us[i + 1U] - s_connect_us[i]) / 1000U;
+        CHECK(gap_ms >= k_backoff_ms[i] && gap_ms <= k_backoff_ms[i] + 1000U,
+              "intervalo %u entre conexoes: %u ms (esperado %u)", i, (unsigned)gap_ms, (unsigned)k_backoff_ms[i]);
+    }
+
+    const mqtt_publisher_stats_t st = stats();
+    CHECK(st.connected && st.reconnects == 1U, "conectado %d, reconexoes %u", st.connected,
+          (unsigned)st.reconnects);
+}
+
+/** @brief 5 tópicos, 4 slots: o 5º espera um PUBACK. */
+static void step_slots(void)
+{
+    const unsigned base = s_npubs;
+
+    CHECK(window(1), "janela 1 recusada");
+    broker_run(200);
+    CHECK(s_npubs - base == 4U && open_pubs() == 4U, "%u publicacoes com 4 slots", s_npubs - base);
+    for (unsigned i = 0; i < 4U && base + i < s_npubs; i++)
+    {
+        CHECK(s_pubs[base + i].topic == i && s_pubs[base + i].qos == 1U, "publicacao %u: topico %u qos %u", i,
+              (unsigned)s_pubs[base + i].topic, (unsigned)s_pubs[base + i].qos);
+    }
+    CHECK(stats().inflight == 4U, "inflight %u (esperado 4)", (unsigned)stats().inflight);
+
+    broker_answer(base, ERR_OK);
+    broker_answer(base + 1U, ERR_OK);
+    broker_run(200);
+    CHECK(stats().published == 2U, "publicadas %u (esperado 2)", (unsigned)stats().published);
+    CHECK(s_npubs - base == 5U && s_pubs[base + 4U].topic == 4U && s_pubs[base + 4U].qos == 0U &&
+              strcmp(s_pubs[base + 4U].payload, "1") == 0,
+          "5o topico nao saiu depois do PUBACK");
+
+    s_auto_ack = true;
+    broker_run(200);
+    s_auto_ack = false;
+    CHECK(stats().published == 5U && stats().inflight == 0U, "janela 1: %u publicadas, %u em voo",
+          (unsigned)stats().published, (unsigned)stats().inflight);
+}
+
+/** @brief ERR_MEM do lwIP: o slot espera e a mesma mensagem sai depois. */
+static void step_outbuf_full(void)
+{
+    const unsigned base = s_npubs;
+
+    s_outbuf_full = true;
+    CHECK(window(2), "janela 2 recusada");
+    broker_run(300);
+    CHECK(s_pub_rejects > 0U && s_npubs == base, "ERR_MEM: %u recusas, %u publicacoes", s_pub_rejects,
+          s_npubs - base);
+    CHECK(stats().inflight == 1U && stats().retried == 0U, "ERR_MEM: inflight %u, retried %u",
+          (unsigned)stats().inflight, (unsigned)stats().retried);
+
+    s_outbuf_full = false;
+    broker_run(1500);   /* A task tenta de novo no próximo ciclo (MQTT_IDLE_WAIT_MS) */
+    CHECK(s_npubs - base == 4U && s_pubs[base].topic == 0U && strcmp(s_pubs[base].payload, "102.00") == 0,
+          "ERR_MEM: depois do espaco %u publicacoes, primeira topico %u \"%s\"", s_npubs - base,
+          (unsigned)s_pubs[base].topic, s_pubs[base].payload);
+
+    s_auto_ack = true;
+    broker_run(200);
+    s_auto_ack = false;
+    CHECK(stats().published == 10U, "janela 2: %u publicadas", (unsigned)stats().published);
+}
+
+/** @brief PUBACK com erro: republica o mesmo tópico e payload. */
+static void step_puback_error(void)
+{
+    const unsigned base = s_npubs;
+
+    CHECK(window(3), "janela 3 recusada");
+    broker_run(200);
+    CHECK(s_npubs - base == 4U, "janela 3: %u publicacoes", s_npubs - base);
+
+    broker_answer(base + 1U, ERR_TIMEOUT);
+    broker_run(200);
+    CHECK(stats().retried == 1U, "retried %u (esperado 1)", (unsigned)stats().retried);
+    CHECK(s_npubs - base == 5U && s_pubs[base + 4U].topic == 1U &&
+              strcmp(s_pubs[base + 4U].payload, s_pubs[base + 1U].payload) == 0,
+          "republicacao: topico %u \"%s\"", (unsigned)s_pubs[s_npubs - 1U].topic, s_pubs[s_npubs - 1U].payload);
+
+    s_auto_ack = true;
+    broker_run(300);
+    s_auto_ack = false;
+    CHECK(stats().published == 15U && stats().inflight == 0U, "janela 3: %u publicadas, %u em voo",
+          (unsigned)stats().published, (unsigned)stats().inflight);
+}
+
+/** @brief Queda com mensagens em voo: republica após a reconexão, antes do resto da janela. */
+static void step_drop_inflight(void)
+{
+    const unsigned base = s_npubs;
+
+    CHECK(window(4), "janela 4 recusada");
+    broker_run(200);
+    CHECK(s_npubs - base == 4U, "janela 4: %u publicacoes", s_npubs - base);
+
+    /* PUBACK do 1º e queda antes de a task rodar: ACKED e INFLIGHT juntos em requeue_inflight */
+    broker_answer(base, ERR_OK);
+    const unsigned connects = s_nconnects;
+    const uint64_t drop_us = host_time_us;
+    for (unsigned i = base + 1U; i < base + 4U; i++)
+    {
+        s_pubs[i].open = false; /* Perdidas com a conexão */
+    }
+    broker_conn(MQTT_CONNECT_DISCONNECTED);
+    broker_run(100);
+
+    mqtt_publisher_stats_t st = stats();
+    CHECK(!st.connected && st.published == 16U && st.retried == 4U,
+          "queda: conectado %d, publicadas %u (esperado 16), retried %u (esperado 4)", st.connected,
+          (unsigned)st.published, (unsigned)st.retried);
+
+    broker_run(4000);
+    CHECK(s_nconnects == connects + 1U, "queda: %u tentativas de reconexao", s_nconnects - connects);
+    if (s_nconnects > connects)
+    {
+        const uint64_t gap_ms = (s_connect_us[connects] - drop_us) / 1000U;
+        CHECK(gap_ms >= 2000U && gap_ms <= 3000U, "reconexao %u ms apos a queda (esperado 2 s)", (unsigned)gap_ms);
+    }
+
+    /* Os três em voo voltam primeiro, iguais; depois o 5º tópico */
+    CHECK(s_npubs - base == 8U, "depois da reconexao: %u publicacoes (esperado 8)", s_npubs - base);
+    for (unsigned i = 0; i < 3U && base + 4U + i < s_npubs; i++)
+    {
+        const pub_t *again = &s_pubs[base + 4U + i];
+        const pub_t *orig = &s_pubs[base + 1U + i];
+        CHECK(again->topic == orig->topic && strcmp(again->payload, orig->payload) == 0,
+              "republicacao %u: topico %u \"%s\" (original %u \"%s\")", i, (unsigned)again->topic, again->payload,
+              (unsigned)orig->topic, orig->payload);
+    }
+    CHECK(s_npubs - base < 8U || s_pubs[base + 7U].topic == 4U, "5o topico fora de ordem");
+
+    s_auto_ack = true;
+    broker_run(300);
+    s_auto_ack = false;
+    st = stats();
+    CHECK(st.published == 20U && st.retried == 4U && st.reconnects == 2U,
+          "janela 4: %u publicadas, retried %u, reconexoes %u", (unsigned)st.published, (unsigned)st.retried,
+          (unsigned)st.reconnects);
+}
+
+/** @brief Broker fora: a fila de 4 janelas descarta as mais antigas. */
+static void step_queue_full(void)
+{
+    broker_conn(MQTT_CONNECT_DISCONNECTED);
+    s_refuse_left = 2;
+    broker_run(100);
+
+    const unsigned base = s_npubs;
+    for (uint32_t k = 5; k <= 10U; k++)
+    {
+        CHECK(window(k) == (k <= 8U), "janela %u: retorno inesperado de publish_window", (unsigned)k);
+    }
+    CHECK(stats().dropped == 2U, "descartadas %u (esperado 2)", (unsigned)stats().dropped);
+
+    s_auto_ack = true;
+    broker_run(20000);
+    s_auto_ack = false;
+
+    CHECK(stats().connected && stats().published == 40U, "fila: conectado %d, %u publicadas (esperado 40)",
+          stats().connected, (unsigned)stats().published);
+    uint32_t expect = 7;
+    for (unsigned i = base; i < s_npubs; i++)
+    {
+        if (s_pubs[i].topic == 4U)
+        {
+            char want[12];
+            snprintf(want, sizeof(want), "%u", (unsigned)expect++);
+            CHECK(strcmp(s_pubs[i].payload, want) == 0, "fila: janela \"%s\" publicada (esperada %s)",
+                  s_pubs[i].payload, want);
+        }
+    }
+    CHECK(expect == 11U, "fila: %u janelas publicadas (esperadas 7..10)", (unsigned)(expect - 7U));
+}
+
+/** @brief Sink da telemetria: delta de energia e rádio acordado até a janela confirmada. */
+static void step_sink(void)
+{
+    telemetry_record_t rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.e_total_wh = 5.0;
+    rec.uptime_s = 60;
+
+    for (unsigned round = 0; round < 2U; round++)
+    {
+        const unsigned base = s_npubs;
+
+        CHECK(mqtt_publisher_sink.publish(mqtt_publisher_sink.ctx, &rec), "sink: publish recusado");
+        CHECK(s_tx_last == WIFI_TX_NOW, "sink: radio nao acordado (%u)", (unsigned)s_tx_last);
+
+        broker_run(200);
+        CHECK(s_tx_last == WIFI_TX_NOW, "sink: radio liberado com a janela em voo");
+        CHECK(s_npubs - base == 4U && strcmp(s_pubs[base + 3U].payload, round ? "2.5000" : "5.0000") == 0,
+              "sink: e_wh \"%s\" na rodada %u", (s_npubs - base >= 4U) ? s_pubs[base + 3U].payload : "?", round);
+
+        s_auto_ack = true;
+        broker_run(300);
+        s_auto_ack = false;
+        CHECK(s_tx_last == TEST_NEXT_WINDOW_MS, "sink: tx_schedule %u depois da janela (esperado %u)",
+              (unsigned)s_tx_last, (unsigned)TEST_NEXT_WINDOW_MS);
+
+        rec.e_total_wh = 7.5;
+        rec.uptime_s = 120;
+    }
+}
+
+int main(void)
+{
+    host_rtos_init(tskIDLE_PRIORITY + 5);
+    xTaskCreate(mqtt_publisher_task, "MqttPub", 1024, NULL, tskIDLE_PRIORITY + 2, NULL);
+
+    step_backoff();
+    step_slots();
+    step_outbuf_full();
+    step_puback_error();
+    step_drop_inflight();
+    step_queue_full();
+    step_sink();
+
+    if (s_failures)
+    {
+        fprintf(stderr, "%u divergencias.\n", s_failures);
+        return 1;
+    }
+    printf("mqtt_publisher: OK (%u publicacoes, %u conexoes)\n", s_npubs, s_nconnects);
+    return 0;
+}
@@ -0,0 +1,576 @@
+/**
+ * @file rtos_trace_json.c
+ * @brief Conversor (host) do despejo do gravador de eventos (`lib/rtos_trace.h`) para JSON do Chrome/Perfetto.
+ * @details
+ *  Lê a imagem binária gravada no SD (`trace sd`) ou uma captura da serial
+ *  com o despejo em hexadecimal (`trace usb`, ou a tecla 'd' do console dos
+ *  exercícios de `atividades/semana_12`); numa captura com vários despejos
+ *  vale o último. O JSON ("Trace Event Format") abre em ui.perfetto.dev ou
+ *  em chrome://tracing:
+ *   - processo "CPU": uma linha por task, com as fatias em que executou
+ *     (de uma troca de contexto até a seguinte) e, nelas, os envios,
+ *     recebimentos, bloqueios e tempos esgotados em filas;
+ *   - processo "ISRs": as ISRs marcadas pela aplicação e as operações de
+ *     fila feitas em ISR (linha "ISR");
+ *   - processo "Trechos": os trechos da aplicação (amostragem, envios);
+ *   - contadores "fila <nome>": ocupação após cada operação.
+ *
+ *  No stderr sai um resumo: tempo de CPU por task, operações por fila,
+ *  duração dos trechos e quanto cada par de trechos se sobrepôs (ex.: envio
+ *  ao ThingSpeak durante a amostragem).
+ *
+ *  Compilação e uso (a partir de `monitor_energia/`):
+ *      gcc -O2 -I. tools/rtos_trace_json.c -o rtos_trace_json
+ *      ./rtos_trace_json captura_serial.txt > trace.json
+ *      ./rtos_trace_json trace/00012345.bin > trace.json
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lib/rtos_trace.h"
+
+#define TJ_MAX_NAMES    (RTOS_TRACE_MAX_TASKS + RTOS_TRACE_MAX_NAMES) /**< Nomes na imagem. */
+#define TJ_MAX_SPANS    4096U       /**< Trechos guardados para o cálculo de sobreposição. */
+#define TJ_PID_CPU      1           /**< Processo das tasks. */
+#define TJ_PID_ISR      2           /**< Processo das ISRs. */
+#define TJ_PID_SPAN     3           /**< Processo dos trechos. */
+#define TJ_TID_ISR      0           /**< Linha das operações de fila em ISR sem marca. */
+
+static const char k_begin[] = "=== RTOS TRACE BEGIN ===";
+static const char k_end[] = "=== RTOS TRACE END";
+
+/** @brief Nome da imagem. */
+typedef struct
+{
+    uint8_t kind;                   /**< `rtos_trace_name_kind_t`. */
+    uint16_t id;                    /**< Id nos eventos. */
+    char name[RTOS_TRACE_NAME_LEN]; /**< Nome terminado em '\0'. */
+} tj_name_t;
+
+/** @brief Um trecho concluído. */
+typedef struct
+{
+    uint16_t id;
+    uint64_t t0;
+    uint64_t t1;
+} tj_span_t;
+
+/** @brief Acumuladores por id (tasks, filas, trechos). */
+typedef struct
+{
+    uint64_t run_us;                /**< Task: tempo executando. */
+    uint32_t slices;                /**< Task: fatias. */
+    uint32_t sends;                 /**< Fila: envios (tasks e ISRs). */
+    uint32_t recvs;                 /**< Fila: recebimentos. */
+    uint32_t blocks;                /**< Fila: bloqueios. */
+    uint32_t fails;                 /**< Fila: tempos esgotados. */
+    uint8_t depth_max;              /**< Fila: maior ocupação vista. */
+    uint64_t open_t;                /**< Trecho/ISR: início em aberto (0: fechado). */
+    uint32_t count;                 /**< Trecho: ocorrências. */
+    uint64_t total_us;              /**< Trecho: soma das durações. */
+    uint64_t max_us;                /**< Trecho: maior duração. */
+} tj_acc_t;
+
+static tj_name_t s_names[TJ_MAX_NAMES];
+static unsigned s_nnames = 0;
+static tj_acc_t s_task[65536];
+static tj_acc_t s_queue[65536];
+static tj_acc_t s_span[65536];
+static uint64_t s_isr_open[65536];
+static uint8_t s_depth[65536];      /**< Ocupação de cada fila após a última operação. */
+static tj_span_t s_spans[TJ_MAX_SPANS];
+static unsigned s_nspans = 0;
+static int s_first = 1;             /**< Próximo evento JSON é o primeiro (sem vírgula). */
+
+/** @brief Lê o arquivo inteiro em memória. */
+static unsigned char *read_file(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+    {
+        perror(path);
+        return NULL;
+    }
+
+    fseek(f, 0, SEEK_END);
+    const long sz = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    unsigned char *buf = (sz > 0) ? malloc((size_t)sz + 1U) : NULL;
+    if (!buf || fread(buf, 1, (size_t)sz, f) != (size_t)sz)
+    {
+        fprintf(stderr, "%s: leitura falhou\n", path);
+        free(buf);
+        fclose(f);
+        return NULL;
+    }
+    fclose(f);
+    buf[sz] = '\0';
+    *len = (size_t)sz;
+    return buf;
+}
+
+/** @brief Valor de um dígito hexadecimal (-1 se não for). */
+static int hex_val(int c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+/**
+ * @brief Extrai o último despejo em hexadecimal de uma captura da serial.
+ * @return Imagem binária (alocada) ou NULL sem despejo completo.
+ */
+static unsigned char *from_capture(const char *text, size_t *len)
+{
+    const char *begin = NULL;
+    for (const char *p = strstr(text, k_begin); p; p = strstr(p + 1, k_begin))
+    {
+        begin = p;
+    }
+    if (!begin)
+    {
+        return NULL;
+    }
+
+    const char *end = strstr(begin, k_end);
+    if (!end)
+    {
+        fprintf(stderr, "despejo sem marcador de fim (captura interrompida?)\n");
+        return NULL;
+    }
+
+    begin += sizeof(k_begin) - 1U;
+    unsigned char *out = malloc((size_t)(end - begin) / 2U + 1U);
+    size_t n = 0;
+    int hi = -1;
+
+    for (const char *p = begin; p < end && out; p++)
+    {
+        const int v = hex_val((unsigned char)*p);
+        if (v < 0)
+        {
+            continue; /* Quebras de linha, '\r' */
+        }
+        if (hi < 0)
+        {
+            hi = v;
+        }
+        else
+        {
+            out[n++] = (unsigned char)((hi << 4) | v);
+            hi = -1;
+        }
+    }
+
+    const unsigned long declared = strtoul(end + sizeof(k_end) - 1U, NULL, 10);
+    if (declared != n)
+    {
+        fprintf(stderr, "despejo com %zu bytes, marcador diz %lu (linhas perdidas na serial?)\n", n, declared);
+        free(out);
+        return NULL;
+    }
+    *len = n;
+    return out;
+}
+
+static uint16_t get_u16(const unsigned char *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const unsigned char *p)
+{
+    return (uint32_t)get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+/** @brief Nome de `kind`/`id`, ou um genérico ("task 7"). */
+static const char *name_of(uint8_t kind, uint16_t id)
+{
+    static const char *const k_generic[] = {"task", "fila", "isr", "trecho"};
+    static char buf[4][32];
+    static unsigned next = 0;
+
+    for (unsigned i = 0; i < s_nnames; i++)
+    {
+        if (s_names[i].kind == kind && s_names[i].id == id)
+        {
+            return s_names[i].name;
+        }
+    }
+
+    char *b = buf[next++ % 4U];
+    snprintf(b, sizeof(buf[0]), "%s %u", k_generic[kind < 4U ? kind : 0U], (unsigned)id);
+    return b;
+}
+
+/** @brief Escreve `s` como string JSON. */
+static void json_str(const char *s)
+{
+    putchar('"');
+    for (; *s; s++)
+    {
+        const unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\')
+        {
+            printf("\\%c", c);
+        }
+        else if (c < 0x20U)
+        {
+            printf("\\u%04x", c);
+        }
+        else
+        {
+            putchar(c);
+        }
+    }
+    putchar('"');
+}
+
+/** @brief Abre um evento JSON (vírgula entre eventos). */
+static void ev_open(const char *ph, int pid, int tid, uint64_t ts)
+{
+    printf("%s\n{\"ph\":\"%s\",\"pid\":%d,\"tid\":%d,\"ts\":%llu", s_first ? "" : ",", ph, pid, tid,
+           (unsigned long long)ts);
+    s_first = 0;
+}
+
+/** @brief Metadado de nome de processo ou de linha. */
+static void meta(const char *what, int pid, int tid, const char *name)
+{
+    ev_open("M", pid, tid, 0);
+    printf(",\"name\":\"%s\",\"args\":{\"name\":", what);
+    json_str(name);
+    printf("}}");
+}
+
+/** @brief Fatia de execução de uma task. */
+static void slice(uint16_t task, uint64_t t0, uint64_t t1)
+{
+    if (t1 <= t0)
+    {
+        return;
+    }
+    ev_open("X", TJ_PID_CPU, task, t0);
+    printf(",\"dur\":%llu,\"name\":", (unsigned long long)(t1 - t0));
+    json_str(name_of(RTOS_TRACE_NAME_TASK, task));
+    printf("}");
+    s_task[task].run_us += t1 - t0;
+    s_task[task].slices++;
+}
+
+/** @brief Evento instantâneo de fila (com ocupação) na linha `pid`/`tid`. */
+static void queue_instant(int pid, int tid, uint64_t ts, const char *what, uint16_t q, unsigned depth)
+{
+    ev_open("i", pid, tid, ts);
+    printf(",\"s\":\"t\",\"name\":");
+    char label[64];
+    snprintf(label, sizeof(label), "%s %s", what, name_of(RTOS_TRACE_NAME_QUEUE, q));
+    json_str(label);
+    printf(",\"args\":{\"itens\":%u}}", depth);
+}
+
+/** @brief Contador de ocupação de uma fila. */
+static void queue_counter(uint64_t ts, uint16_t q, int depth)
+{
+    char label[48];
+    snprintf(label, sizeof(label), "fila %s", name_of(RTOS_TRACE_NAME_QUEUE, q));
+    ev_open("C", TJ_PID_CPU, 0, ts);
+    printf(",\"name\":");
+    json_str(label);
+    printf(",\"args\":{\"itens\":%d}}", depth < 0 ? 0 : depth);
+    if (depth > s_queue[q].depth_max)
+    {
+        s_queue[q].depth_max = (uint8_t)(depth > 255 ? 255 : depth);
+    }
+}
+
+/** @brief Início ou fim de uma fatia aninhada (ISR ou trecho). */
+static void begin_end(const char *ph, int pid, uint16_t id, uint64_t ts, uint8_t kind)
+{
+    ev_open(ph, pid, id, ts);
+    printf(",\"name\":");
+    json_str(name_of(kind, id));
+    printf("}");
+}
+
+/** @brief Sobreposição de [a0,a1) e [b0,b1). */
+static uint64_t overlap(uint64_t a0, uint64_t a1, uint64_t b0, uint64_t b1)
+{
+    const uint64_t lo = (a0 > b0) ? a0 : b0;
+    const uint64_t hi = (a1 < b1) ? a1 : b1;
+    return (hi > lo) ? hi - lo : 0U;
+}
+
+/** @brief Resumo no stderr. */
+static void summary(uint64_t span_us, uint32_t nev, uint32_t overwritten)
+{
+    fprintf(stderr, "%u eventos (%u sobrescritos antes do despejo) em %.3f ms\n", nev, overwritten,
+            (double)span_us / 1000.0);
+
+    fprintf(stderr, "%-16s %10s %7s %7s\n", "task", "CPU ms", "CPU %", "fatias");
+    for (unsigned i = 0; i < 65536U; i++)
+    {
+        if (s_task[i].slices)
+        {
+            fprintf(stderr, "%-16s %10.3f %7.2f %7u\n", name_of(RTOS_TRACE_NAME_TASK, (uint16_t)i),
+                    (double)s_task[i].run_us / 1000.0,
+                    span_us ? 100.0 * (double)s_task[i].run_us / (double)span_us : 0.0, s_task[i].slices);
+        }
+    }
+
+    for (unsigned i = 1; i < 65536U; i++)
+    {
+        const tj_acc_t *q = &s_queue[i];
+        if (q->sends || q->recvs || q->blocks || q->fails)
+        {
+            fprintf(stderr, "fila %-16s %6u envios %6u receb. %5u bloqueios %4u esgotados, max %u itens\n",
+                    name_of(RTOS_TRACE_NAME_QUEUE, (uint16_t)i), q->sends, q->recvs, q->blocks, q->fails,
+                    q->depth_max);
+        }
+    }
+
+    for (unsigned i = 1; i < 65536U; i++)
+    {
+        const tj_acc_t *s = &s_span[i];
+        if (s->count)
+        {
+            fprintf(stderr, "trecho %-14s %5u vezes, media %.3f ms, max %.3f ms\n",
+                    name_of(RTOS_TRACE_NAME_SPAN, (uint16_t)i), s->count,
+                    (double)s->total_us / (double)s->count / 1000.0, (double)s->max_us / 1000.0);
+        }
+    }
+
+    /* Sobreposição entre trechos de ids diferentes (a < b) */
+    for (unsigned a = 1; a < 65536U; a++)
+    {
+        if (!s_span[a].count)
+        {
+            continue;
+        }
+        for (unsigned b = a + 1U; b < 65536U; b++)
+        {
+            if (!s_span[b].count)
+            {
+                continue;
+            }
+            uint64_t ov = 0;
+            for (unsigned i = 0; i < s_nspans; i++)
+            {
+                for (unsigned j = 0; j < s_nspans; j++)
+                {
+                    if (s_spans[i].id == a && s_spans[j].id == b)
+                    {
+                        ov += overlap(s_spans[i].t0, s_spans[i].t1, s_spans[j].t0, s_spans[j].t1);
+                    }
+                }
+            }
+            if (ov)
+            {
+                fprintf(stderr, "sobreposicao %s x %s: %.3f ms\n", name_of(RTOS_TRACE_NAME_SPAN, (uint16_t)a),
+                        name_of(RTOS_TRACE_NAME_SPAN, (uint16_t)b), (double)ov / 1000.0);
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "uso: %s despejo.bin|captura.txt > trace.json\n", argv[0]);
+        return 1;
+    }
+
+    size_t len = 0;
+    unsigned char *raw = read_file(argv[1], &len);
+    if (!raw)
+    {
+        return 1;
+    }
+
+    unsigned char *img = raw;
+    if (len < RTOS_TRACE_HDR_SIZE || get_u32(raw) != RTOS_TRACE_MAGIC)
+    {
+        img = from_capture((const char *)raw, &len);
+        if (!img)
+        {
+            fprintf(stderr, "%s: nem imagem binaria nem captura com despejo\n", argv[1]);
+            return 1;
+        }
+    }
+
+    const uint32_t nev = get_u32(&img[8]);
+    const uint32_t overwritten = get_u32(&img[12]);
+    const unsigned nnames = get_u16(&img[16]);
+    const size_t need = RTOS_TRACE_HDR_SIZE + (size_t)nnames * RTOS_TRACE_NAME_SIZE +
+                        (size_t)nev * sizeof(rtos_trace_event_t);
+
+    if (get_u32(img) != RTOS_TRACE_MAGIC || get_u16(&img[4]) != RTOS_TRACE_VERSION ||
+        get_u16(&img[6]) != sizeof(rtos_trace_event_t) || nnames > TJ_MAX_NAMES || len < need)
+    {
+        fprintf(stderr, "%s: cabecalho invalido ou imagem truncada (%zu de %zu bytes)\n", argv[1], len, need);
+        return 1;
+    }
+
+    const unsigned char *p = img + RTOS_TRACE_HDR_SIZE;
+    for (unsigned i = 0; i < nnames; i++, p += RTOS_TRACE_NAME_SIZE)
+    {
+        s_names[i].kind = p[0];
+        s_names[i].id = get_u16(&p[2]);
+        memcpy(s_names[i].name, &p[4], RTOS_TRACE_NAME_LEN);
+        s_names[i].name[RTOS_TRACE_NAME_LEN - 1U] = '\0';
+    }
+    s_nnames = nnames;
+
+    printf("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    meta("process_name", TJ_PID_CPU, 0, "CPU");
+    meta("process_name", TJ_PID_ISR, 0, "ISRs");
+    meta("process_name", TJ_PID_SPAN, 0, "Trechos");
+    meta("thread_name", TJ_PID_ISR, TJ_TID_ISR, "ISR");
+    for (unsigned i = 0; i < s_nnames; i++)
+    {
+        static const int k_pid[] = {TJ_PID_CPU, 0, TJ_PID_ISR, TJ_PID_SPAN};
+        if (s_names[i].kind < 4U && k_pid[s_names[i].kind])
+        {
+            meta("thread_name", k_pid[s_names[i].kind], s_names[i].id, s_names[i].name);
+        }
+    }
+
+    /* Instantes de 32 bits desenrolados; zero no primeiro evento */
+    uint64_t t = 0;
+    uint32_t prev_raw = nev ? get_u32(p) : 0U;
+    int task = -1;          /* Task em execução (-1: desconhecida) */
+    uint64_t task_t0 = 0;
+    uint16_t isr = 0;       /* ISR marcada em curso (0: nenhuma) */
+
+    for (uint32_t i = 0; i < nev; i++, p += sizeof(rtos_trace_event_t))
+    {
+        const uint32_t raw_t = get_u32(p);
+        const uint8_t type = p[4];
+        const uint8_t aux = p[5];
+        const uint16_t id = get_u16(&p[6]);
+
+        t += (uint32_t)(raw_t - prev_raw);
+        prev_raw = raw_t;
+
+        switch (type)
+        {
+        case RTOS_TRACE_EV_SWITCH_IN:
+            if (task >= 0)
+            {
+                slice((uint16_t)task, task_t0, t);
+            }
+            task = id;
+            task_t0 = t;
+            break;
+
+        case RTOS_TRACE_EV_QUEUE_SEND:
+        case RTOS_TRACE_EV_QUEUE_RECV:
+        case RTOS_TRACE_EV_QUEUE_SEND_ISR:
+        case RTOS_TRACE_EV_QUEUE_RECV_ISR:
+        {
+            const int send = (type == RTOS_TRACE_EV_QUEUE_SEND || type == RTOS_TRACE_EV_QUEUE_SEND_ISR);
+            const int in_isr = (type == RTOS_TRACE_EV_QUEUE_SEND_ISR || type == RTOS_TRACE_EV_QUEUE_RECV_ISR);
+            const int d = (int)aux + (send ? 1 : -1);
+            if (in_isr)
+            {
+                queue_instant(TJ_PID_ISR, isr, t, send ? "envio" : "receb.", id, (unsigned)d);
+            }
+            else
+            {
+                queue_instant(TJ_PID_CPU, task < 0 ? 0 : task, t, send ? "envio" : "receb.", id, (unsigned)d);
+            }
+            queue_counter(t, id, d);
+            s_depth[id] = (uint8_t)(d < 0 ? 0 : d);
+            s_queue[id].sends += send ? 1U : 0U;
+            s_queue[id].recvs += send ? 0U : 1U;
+            break;
+        }
+
+        case RTOS_TRACE_EV_QUEUE_BLOCK_SEND:
+        case RTOS_TRACE_EV_QUEUE_BLOCK_RECV:
+            queue_instant(TJ_PID_CPU, task < 0 ? 0 : task, t,
+                          type == RTOS_TRACE_EV_QUEUE_BLOCK_SEND ? "bloqueia (cheia)" : "bloqueia (vazia)", id, aux);
+            s_queue[id].blocks++;
+            break;
+
+        case RTOS_TRACE_EV_QUEUE_FAIL:
+            queue_instant(TJ_PID_CPU, task < 0 ? 0 : task, t, aux ? "esgotou receb." : "esgotou envio", id,
+                          s_depth[id]);
+            s_queue[id].fails++;
+            break;
+
+        case RTOS_TRACE_EV_ISR_ENTER:
+            begin_end("B", TJ_PID_ISR, id, t, RTOS_TRACE_NAME_ISR);
+            s_isr_open[id] = t + 1U;
+            isr = id;
+            break;
+
+        case RTOS_TRACE_EV_ISR_EXIT:
+            if (s_isr_open[id])
+            {
+                begin_end("E", TJ_PID_ISR, id, t, RTOS_TRACE_NAME_ISR);
+                s_isr_open[id] = 0;
+            }
+            isr = 0;
+            break;
+
+        case RTOS_TRACE_EV_SPAN_BEGIN:
+            begin_end("B", TJ_PID_SPAN, id, t, RTOS_TRACE_NAME_SPAN);
+            s_span[id].open_t = t + 1U; /* +1: 0 é "fechado" */
+            break;
+
+        case RTOS_TRACE_EV_SPAN_END:
+            if (s_span[id].open_t)
+            {
+                const uint64_t t0 = s_span[id].open_t - 1U;
+                begin_end("E", TJ_PID_SPAN, id, t, RTOS_TRACE_NAME_SPAN);
+                s_span[id].count++;
+                s_span[id].total_us += t - t0;
+                s_span[id].max_us = (t - t0 > s_span[id].max_us) ? t - t0 : s_span[id].max_us;
+                s_span[id].open_t = 0;
+                if (s_nspans < TJ_MAX_SPANS)
+                {
+                    s_spans[s_nspans++] = (tj_span_t){id, t0, t};
+                }
+            }
+            break;
+
+        case RTOS_TRACE_EV_TICK:
+            ev_open("i", TJ_PID_ISR, TJ_TID_ISR, t);
+            printf(",\"s\":\"t\",\"name\":\"tick\"}");
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    if (task >= 0)
+    {
+        slice((uint16_t)task, task_t0, t);
+    }
+    printf("\n]}\n");
+
+    summary(t, nev, overwritten);
+
+    if (img != raw)
+    {
+        free(img);
+    }
+    free(raw);
+    return 0;
+}
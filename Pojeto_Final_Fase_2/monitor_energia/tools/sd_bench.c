@@ -0,0 +1,277 @@
+/**
+ * @file sd_bench.c
+ * @brief Benchmark (host) do caminho de gravação do firmware: `lib/sd_card.c` e o sink do SD sobre uma imagem FAT.
+ * @details
+ *  Compila sem alteração `lib/sd_card.c` (montagem, negociação do SPI e
+ *  contadores de `disk_read`/`disk_write`, interceptados com `--wrap` como
+ *  no firmware) e `lib/sd_card_log_task.c` (o sink: `begin`, `publish`,
+ *  `flush`), sobre o disco simulado de `tools/host/diskio_img.c` e os
+ *  substitutos de FreeRTOS e SDK de `tools/host/`. Cada registro adianta
+ *  1 s de relógio virtual, então dias de gravação rodam em segundos.
+ *
+ *  O relatório traz a latência de `publish` (o que a task do sink bloqueia)
+ *  em percentis, a vazão do disco no tempo de disco, as falhas injetadas e,
+ *  no fim, o próprio relatório do comando serial `sd` do firmware. O modo
+ *  de gravação é o de compilação, como no firmware: binário diário
+ *  (padrão), CSV com buffer (`-DSD_CARD_LOG_BINARY=0`) ou CSV por
+ *  `sd_card_append_to_csv` (`-DSD_CARD_LOG_BINARY=0
+ *  -DSD_CARD_LOG_KEEP_OPEN=0`).
+ *
+ *  Modelo do cartão (`diskio_img_model_t`): `-s` limite de relógio da
+ *  fiação [MHz] (a negociação fica abaixo dele), `-p` programação por setor
+ *  [µs], `-e`/`-r` erros transitórios de escrita/leitura [ppm], `-g`/`-G`
+ *  travas de escrita [ppm] e sua duração [µs], `-x` semente. A integridade
+ *  após quedas fica com `tools/sd_soak.c` e `tools/sd_powercut.c`.
+ *
+ *  Requer o FatFs do submódulo com `FF_USE_MKFS` e `FF_USE_EXPAND` em 1.
+ *  Compilação (a partir de `monitor_energia/`):
+ *      FF=no-OS-FatFs-SD-SPI-RPi-Pico/FatFs_SPI/ff15/source
+ *      gcc -O2 -I. -Itools/host -I$FF tools/sd_bench.c tools/host/diskio_img.c lib/sd_card.c \
+ *          lib/sd_card_log_task.c lib/sd_daylog.c lib/sd_writer.c lib/sd_binlog.c lib/timestamp.c lib/fmt.c \
+ *          $FF/ff.c $FF/ffunicode.c $FF/ffsystem.c -Wl,--wrap=disk_read,--wrap=disk_write -o sd_bench
+ *      ./sd_bench -d 7 /tmp/sd.img
+ *      ./sd_bench -d 1 -s 16 -e 100 -g 500 -G 250000 /tmp/sd.img
+ *
+ *  Sem o submódulo, com o FatFs de mentira de `tools/host/ffmock/` (arquivos
+ *  do PC, só o custo de dados e de `f_sync` no disco; rodar num diretório
+ *  vazio, onde nasce o `log/`):
+ *      gcc -O2 -I. -Itools/host -Itools/host/ffmock tools/sd_bench.c tools/host/diskio_img.c lib/sd_card.c \
+ *          lib/sd_card_log_task.c lib/sd_daylog.c lib/sd_writer.c lib/sd_binlog.c lib/timestamp.c lib/fmt.c \
+ *          tools/host/ffmock/ff_mock.c -Wl,--wrap=disk_read,--wrap=disk_write -o sd_bench
+ *      mkdir /tmp/sdb && cd /tmp/sdb && $OLDPWD/sd_bench -d 3 sd.img
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "ff.h"
+#include "pico/time.h"
+#include "diskio_img.h"
+#include "lib/sd_card.h"
+#include "lib/sd_card_log_task.h"
+#include "lib/serial_cmd.h"
+#include "lib/telemetry.h"
+#include "lib/time_sync.h"
+
+#define BENCH_IMG_BYTES     (4ULL * 1024U * 1024U * 1024U) /**< Imagem esparsa de 4 GB. */
+#define BENCH_START_UNIX_S  1792368000LL                    /**< 2026-10-19 00:00 UTC. */
+#define BENCH_BEGIN_TRIES   10U                             /**< Montagens tentadas (o despachante repete). */
+
+static const serial_cmd_t *s_sd_cmd = NULL;
+static telemetry_sink_stats_t s_sink;
+
+/* ---------------------------------------------------------------------- */
+/* Ambiente do sink: relógio sincronizado, console e despachante          */
+/* ---------------------------------------------------------------------- */
+
+int64_t time_sync_now_us(void)
+{
+    return BENCH_START_UNIX_S * 1000000 + (int64_t)host_time_us;
+}
+
+bool time_sync_is_synced(void)
+{
+    return true;
+}
+
+/** @brief Guarda o comando "sd" para imprimir o relatório do firmware no fim. */
+bool serial_cmd_register(const serial_cmd_t *cmd)
+{
+    if (strcmp(cmd->name, "sd") == 0)
+    {
+        s_sd_cmd = cmd;
+    }
+    return true;
+}
+
+uint8_t telemetry_sink_count(void)
+{
+    return 1U;
+}
+
+const char *telemetry_sink_name(uint8_t idx)
+{
+    return (idx == 0U) ? sd_card_log_sink.name : NULL;
+}
+
+bool telemetry_get_sink_stats(uint8_t idx, telemetry_sink_stats_t *out)
+{
+    *out = s_sink;
+    return idx == 0U;
+}
+
+/* ---------------------------------------------------------------------- */
+
+/** @brief Compara latências para `qsort`. */
+static int cmp_u32(const void *a, const void *b)
+{
+    const uint32_t x = *(const uint32_t *)a;
+    const uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/** @brief Percentil `p` (0..1) de um vetor ordenado. */
+static uint32_t pct(const uint32_t *v, size_t n, double p)
+{
+    size_t i = (size_t)(p * (double)n);
+    return v[(i < n) ? i : n - 1U];
+}
+
+/** @brief Registro de telemetria sintético de número `i`, no instante corrente. */
+static void make_record(telemetry_record_t *r, uint32_t i)
+{
+    memset(r, 0, sizeof(*r));
+    r->valid = true;
+    r->seq = i;
+    r->uptime_s = (uint32_t)(host_time_us / 1000000U);
+    r->t_unix_us = time_sync_now_us();
+    r->vrms = 127.0f + (float)(i % 7U) * 0.1f;
+    r->irms = 1.0f + (float)(i % 11U) * 0.05f;
+    r->v_pu = r->vrms / 127.0f;
+    r->p_w = r->vrms * r->irms;
+}
+
+int main(int argc, char **argv)
+{
+    diskio_img_model_t model = DISKIO_IMG_MODEL_DEFAULT;
+    uint32_t days = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:s:p:e:r:g:G:x:")) != -1)
+    {
+        const uint32_t v = (uint32_t)strtoul(optarg, NULL, 10);
+        switch (opt)
+        {
+        case 'd':
+            days = v;
+            break;
+        case 's':
+            model.spi_max_hz = v * 1000U * 1000U;
+            break;
+        case 'p':
+            model.prog_us = v;
+            break;
+        case 'e':
+            model.write_err_ppm = v;
+            break;
+        case 'r':
+            model.read_err_ppm = v;
+            break;
+        case 'g':
+            model.stall_ppm = v;
+            break;
+        case 'G':
+            model.stall_us = v;
+            break;
+        case 'x':
+            model.seed = v;
+            break;
+        default:
+            optind = argc;
+            break;
+        }
+    }
+
+    if (optind != argc - 1 || days == 0U)
+    {
+        fprintf(stderr,
+                "uso: %s [-d dias] [-s MHz max] [-p us/setor] [-e ppm escrita] [-r ppm leitura]\n"
+                "          [-g ppm travas] [-G us por trava] [-x semente] imagem.img\n",
+                argv[0]);
+        return 1;
+    }
+
+    /* Formatação antes do modelo de falhas (não entra nos erros injetados) */
+    static uint8_t work[FF_MAX_SS * 8];
+    const MKFS_PARM fmt = {FM_FAT32, 0, 0, 0, 32768};
+    if (!diskio_img_open(argv[optind], BENCH_IMG_BYTES) || f_mkfs("", &fmt, work, sizeof(work)) != FR_OK)
+    {
+        fprintf(stderr, "%s: falha ao criar/formatar a imagem\n", argv[optind]);
+        return 1;
+    }
+
+    diskio_img_stats_t ds0;
+    sd_disk_stats_t dk0;
+    diskio_img_get_stats(&ds0);
+    sd_card_get_disk_stats(&dk0);
+    diskio_img_set_model(&model);
+
+    const clock_t wall0 = clock();
+    const uint64_t sim0 = host_time_us;
+
+    sd_card_log_init();
+    uint32_t tries = 0;
+    while (!sd_card_log_sink.begin(NULL))
+    {
+        if (++tries >= BENCH_BEGIN_TRIES)
+        {
+            fprintf(stderr, "montagem falhou %u vezes\n", tries);
+            return 2;
+        }
+    }
+
+    const uint32_t n = days * 86400U;
+    uint32_t *lat = malloc(sizeof(uint32_t) * n);
+    if (!lat)
+    {
+        return 1;
+    }
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        telemetry_record_t r;
+        make_record(&r, i);
+
+        const uint64_t t0 = host_time_us;
+        const bool ok = sd_card_log_sink.publish(NULL, &r);
+        lat[i] = (uint32_t)(host_time_us - t0);
+        s_sink.delivered += ok ? 1U : 0U;
+        s_sink.failed += ok ? 0U : 1U;
+
+        host_time_us = t0 + 1000000U; /* Próximo registro 1 s depois do anterior */
+    }
+    (void)sd_card_log_sink.flush(NULL);
+
+    const double wall_s = (double)(clock() - wall0) / CLOCKS_PER_SEC;
+    diskio_img_stats_t ds;
+    sd_disk_stats_t dk;
+    diskio_img_get_stats(&ds);
+    sd_card_get_disk_stats(&dk);
+
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        sum += lat[i];
+    }
+    qsort(lat, n, sizeof(lat[0]), cmp_u32);
+
+    const uint64_t busy_us = ds.busy_us - ds0.busy_us;
+    const uint64_t wr_bytes = (uint64_t)(dk.write_sectors - dk0.write_sectors) * 512U;
+    const uint64_t wr_us = dk.write_total_us - dk0.write_total_us;
+
+    printf("modo %s%s, %u dias (%llu s simulados em %.2f s), %u registros, %u falhas de publish\n",
+           SD_CARD_LOG_BINARY ? "binario diario" : "CSV", SD_CARD_LOG_KEEP_OPEN ? "" : " (abre/grava/fecha)", days,
+           (unsigned long long)((host_time_us - sim0) / 1000000U), wall_s, n, s_sink.failed);
+    printf("latencia de publish [us]: media %llu  p50 %u  p90 %u  p99 %u  p99.9 %u  max %u\n",
+           (unsigned long long)(sum / n), pct(lat, n, 0.50), pct(lat, n, 0.90), pct(lat, n, 0.99),
+           pct(lat, n, 0.999), lat[n - 1U]);
+    printf("disco: %.3f%% do tempo ocupado; gravacao %llu kB a %llu kB/s; SPI a %u kHz (%u descidas)\n",
+           100.0 * (double)busy_us / (double)(host_time_us - sim0), (unsigned long long)(wr_bytes / 1024U),
+           (unsigned long long)(wr_us ? wr_bytes * 1000U / wr_us : 0U), diskio_img_spi_hz() / 1000U,
+           dk.spi_downshifts);
+    printf("falhas injetadas: %u erros, %u travas; erros vistos pelo FatFs: %u\n", ds.faults - ds0.faults,
+           ds.stalls - ds0.stalls, dk.errors - dk0.errors);
+
+    if (s_sd_cmd)
+    {
+        char *sd_argv[] = {"sd"};
+        printf("--- comando \"sd\" do firmware (inclui a formatacao) ---\n");
+        s_sd_cmd->fn(1, sd_argv);
+    }
+
+    free(lat);
+    diskio_img_close();
+    return s_sink.delivered ? 0 : 2;
+}
@@ -0,0 +1,317 @@
+/**
+ * @file sd_powercut.c
+ * @brief Injeção de quedas de energia (host) no diário do SD: cortes em pontos aleatórios da gravação.
+ * @details
+ *  Formata uma imagem FAT32 como `tools/sd_soak.c` e repete ciclos de
+ *  boot: monta, grava registros (um por segundo de relógio virtual) com
+ *  `lib/sd_daylog` como no firmware e corta a energia depois de um número
+ *  aleatório de setores gravados, com o setor seguinte rasgado num ponto
+ *  aleatório (`diskio_img_cut`). A gravação de dados, FAT e diretório é
+ *  cortada igualmente: commits, criação e pré-alocação do arquivo do dia
+ *  seguinte, poda e fechamento na virada.
+ *
+ *  A cada boot a recuperação tem de achar o último registro confirmado no
+ *  ciclo anterior (`committed_seq`, o que já tinha voltado do cartão antes
+ *  do corte); no fim, todos os arquivos são relidos e conferidos:
+ *   - os seqs são estritamente crescentes e contínuos (a recuperação
+ *     retoma do último registro gravado, então não há salto nem repetição);
+ *   - cada registro tem o instante com que foi gravado pela última vez
+ *     naquele seq (nada de resto de um ciclo anterior);
+ *   - todo registro confirmado antes de um corte está lá;
+ *   - os clusters livres mais os dos arquivos fecham com o total do volume
+ *     (senão, clusters perdidos por um corte no meio de uma alocação).
+ *
+ *  Requer o FatFs do submódulo como `tools/sd_soak.c`. Compilação (a
+ *  partir de `monitor_energia/`):
+ *      FF=no-OS-FatFs-SD-SPI-RPi-Pico/FatFs_SPI/ff15/source
+ *      gcc -O2 -I. -Itools/host -I$FF tools/sd_powercut.c tools/host/diskio_img.c lib/sd_daylog.c \
+ *          lib/sd_writer.c lib/sd_binlog.c lib/timestamp.c lib/fmt.c $FF/ff.c $FF/ffunicode.c \
+ *          $FF/ffsystem.c -o sd_powercut
+ *      ./sd_powercut -c 500 -s 1 /tmp/cut.img
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ff.h"
+#include "pico/time.h"
+#include "diskio_img.h"
+#include "lib/sd_binlog.h"
+#include "lib/sd_daylog.h"
+
+#define CUT_IMG_BYTES       (4ULL * 1024U * 1024U * 1024U) /**< Imagem esparsa de 4 GB. */
+#define CUT_START_UNIX_S    1792368000LL                    /**< 2026-10-19 00:00 UTC. */
+#define CUT_MAX_SECTORS     8192U   /**< Maior ciclo em setores gravados (~1,4 dia de registros). */
+#define CUT_OFF_MAX_S       600U    /**< Maior tempo sem energia entre ciclos [s]. */
+#define CUT_MAX_SEQ         (1U << 24) /**< Capacidade da tabela de instantes por seq. */
+
+static FATFS s_fs;
+static sd_daylog_t s_daylog;
+static int64_t *s_t_of_seq;         /**< Instante gravado por último em cada seq. */
+
+/** @brief Registro sintético no instante `t_s`. */
+static void make_record(sd_binlog_rec_t *r, int64_t t_s)
+{
+    memset(r, 0, sizeof(*r));
+    r->t_unix_us = t_s * 1000000;
+    r->vrms = 127.0f + (float)(t_s % 7) * 0.1f;
+    r->irms = 1.0f + (float)(t_s % 11) * 0.05f;
+    r->v_pu = r->vrms / 127.0f;
+    r->p_w = r->vrms * r->irms;
+}
+
+/** @brief Compara dias para `qsort`. */
+static int cmp_i64(const void *a, const void *b)
+{
+    const int64_t x = *(const int64_t *)a;
+    const int64_t y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/** @brief Resultado da releitura. */
+typedef struct
+{
+    uint32_t files;             /**< Arquivos diários. */
+    uint64_t records;           /**< Registros válidos. */
+    uint32_t first_seq;         /**< Menor seq (os anteriores foram podados). */
+    uint32_t last_seq;          /**< Maior seq. */
+    uint64_t order_errors;      /**< Seqs fora de ordem, repetidos ou com salto. */
+    uint64_t stale;             /**< Registros com instante diferente do gravado por último. */
+    uint32_t sessions;          /**< Unidades de sessão. */
+    uint64_t file_clusters;     /**< Clusters ocupados pelos arquivos e diretórios. */
+} verify_t;
+
+/**
+ * @brief Relê um arquivo inteiro, conferindo a ordem e os instantes.
+ * @details Vai até o tamanho, não até o fim lógico: uma unidade válida
+ *          depois do fim (resto de um ciclo cortado) também é conferida.
+ */
+static void verify_file(const char *path, verify_t *v, uint32_t *next_seq)
+{
+    FIL f;
+    uint8_t u[SD_BINLOG_UNIT];
+    sd_binlog_hdr_t hdr;
+    UINT br;
+
+    if (f_open(&f, path, FA_READ) != FR_OK)
+    {
+        printf("%s: nao abre\n", path);
+        v->order_errors++;
+        return;
+    }
+
+    v->file_clusters += (f_size(&f) + s_fs.csize * FF_MAX_SS - 1U) / (s_fs.csize * FF_MAX_SS);
+
+    if (f_read(&f, u, sizeof(u), &br) != FR_OK || br != sizeof(u) || !sd_binlog_get_header(u, &hdr))
+    {
+        (void)f_close(&f);
+        return; // Criação cortada antes do cabeçalho: o arquivo é reescrito no próximo boot
+    }
+
+    while (f_read(&f, u, sizeof(u), &br) == FR_OK && br == sizeof(u))
+    {
+        const int type = sd_binlog_check(u, &hdr);
+        if (type == SD_BINLOG_TYPE_SESSION)
+        {
+            v->sessions++;
+        }
+        if (type != SD_BINLOG_TYPE_RECORD)
+        {
+            continue;
+        }
+
+        sd_binlog_rec_t r;
+        sd_binlog_get_record(u, &r);
+        if (*next_seq == SD_BINLOG_SEQ_NONE)
+        {
+            v->first_seq = r.seq;
+        }
+        else if (r.seq != *next_seq)
+        {
+            printf("%s: seq %u onde se esperava %u\n", path, r.seq, *next_seq);
+            v->order_errors++;
+        }
+        if (r.seq >= CUT_MAX_SEQ || s_t_of_seq[r.seq] != r.t_unix_us)
+        {
+            v->stale++;
+        }
+        *next_seq = r.seq + 1U;
+        v->last_seq = r.seq;
+        v->records++;
+    }
+
+    (void)f_close(&f);
+}
+
+/** @brief Relê todos os arquivos diários em ordem de dia. */
+static void verify_all(verify_t *v)
+{
+    static int64_t days[1024];
+    char path[SD_DAYLOG_PATH_LEN];
+    uint32_t next_seq = SD_BINLOG_SEQ_NONE;
+    DIR dir;
+    FILINFO fno;
+
+    memset(v, 0, sizeof(*v));
+    v->file_clusters = 1U; // Diretório log/ (um cluster de 32 kB basta)
+
+    if (f_opendir(&dir, SD_DAYLOG_DIR) != FR_OK)
+    {
+        return;
+    }
+    while (v->files < 1024U && f_readdir(&dir, &fno) == FR_OK && fno.fname[0])
+    {
+        if (sd_daylog_parse_name(fno.fname, &days[v->files]))
+        {
+            v->files++;
+        }
+    }
+    (void)f_closedir(&dir);
+
+    qsort(days, v->files, sizeof(days[0]), cmp_i64);
+    for (uint32_t i = 0; i < v->files; i++)
+    {
+        sd_daylog_path(path, sizeof(path), days[i]);
+        verify_file(path, v, &next_seq);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t cycles = 200;
+    unsigned seed = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "c:s:")) != -1)
+    {
+        if (opt == 'c')
+        {
+            cycles = (uint32_t)strtoul(optarg, NULL, 10);
+        }
+        else if (opt == 's')
+        {
+            seed = (unsigned)strtoul(optarg, NULL, 10);
+        }
+        else
+        {
+            optind = argc;
+            break;
+        }
+    }
+
+    if (optind != argc - 1 || cycles == 0U)
+    {
+        fprintf(stderr, "uso: %s [-c ciclos] [-s semente] imagem.img\n", argv[0]);
+        return 1;
+    }
+
+    static uint8_t work[FF_MAX_SS * 8];
+    const MKFS_PARM fmt = {FM_FAT32, 0, 0, 0, 32768};
+
+    s_t_of_seq = calloc(CUT_MAX_SEQ, sizeof(s_t_of_seq[0]));
+    if (!s_t_of_seq || !diskio_img_open(argv[optind], CUT_IMG_BYTES) || f_mkfs("", &fmt, work, sizeof(work)) != FR_OK)
+    {
+        fprintf(stderr, "%s: falha ao criar/formatar a imagem\n", argv[optind]);
+        return 1;
+    }
+
+    srand(seed);
+    int64_t t_s = CUT_START_UNIX_S;
+    uint32_t committed = SD_BINLOG_SEQ_NONE;   // Último seq confirmado antes de um corte
+    uint32_t recover_errors = 0;
+    uint32_t mount_errors = 0;
+    uint64_t appended = 0;
+    uint64_t unconfirmed = 0;                   // Registros ainda sem commit em cada corte
+
+    for (uint32_t c = 0; c < cycles; c++)
+    {
+        if (f_mount(&s_fs, "", 1) != FR_OK)
+        {
+            printf("ciclo %u: volume nao monta\n", c);
+            mount_errors++;
+            break;
+        }
+
+        sd_daylog_init(&s_daylog, SD_DAYLOG_COMMIT_MS);
+        diskio_img_cut((uint64_t)(rand() % CUT_MAX_SECTORS) + 1U, (uint32_t)rand() % 512U);
+
+        bool first = true;
+        while (diskio_img_powered())
+        {
+            sd_binlog_rec_t r;
+            make_record(&r, t_s);
+
+            if (sd_daylog_append(&s_daylog, &r, true) == FR_OK)
+            {
+                const uint32_t seq = s_daylog.next_seq - 1U;
+                // O boot retoma do último registro no cartão: nunca antes do confirmado
+                if (first && committed != SD_BINLOG_SEQ_NONE && (seq == 0U || seq - 1U < committed))
+                {
+                    printf("ciclo %u: retomou no seq %u, confirmado ate %u\n", c, seq, committed);
+                    recover_errors++;
+                }
+                if (seq < CUT_MAX_SEQ)
+                {
+                    s_t_of_seq[seq] = r.t_unix_us;
+                }
+                first = false;
+                appended++;
+                (void)sd_daylog_poll(&s_daylog, false);
+            }
+            host_time_us += 1000000U;
+            t_s++;
+        }
+
+        if (s_daylog.stats.committed_seq != SD_BINLOG_SEQ_NONE)
+        {
+            committed = s_daylog.stats.committed_seq;
+        }
+        if (!first)
+        {
+            unconfirmed += s_daylog.next_seq - ((committed != SD_BINLOG_SEQ_NONE) ? committed + 1U : 0U);
+        }
+
+        (void)f_mount(NULL, "", 0); // FIL e janela do FATFS abandonados, como num boot
+        diskio_img_power_on();
+        const uint32_t off_s = (uint32_t)rand() % CUT_OFF_MAX_S;
+        host_time_us += (uint64_t)off_s * 1000000U;
+        t_s += off_s;
+    }
+
+    verify_t v;
+    DWORD free_clst = 0;
+    FATFS *fs;
+    uint32_t total_clst = 0;
+
+    if (f_mount(&s_fs, "", 1) == FR_OK && f_getfree("", &free_clst, &fs) == FR_OK)
+    {
+        total_clst = fs->n_fatent - 2U;
+        verify_all(&v);
+    }
+    else
+    {
+        memset(&v, 0, sizeof(v));
+        mount_errors++;
+    }
+
+    const bool committed_ok = committed == SD_BINLOG_SEQ_NONE || (v.records && v.last_seq >= committed);
+    const int64_t leaked = (int64_t)total_clst - (int64_t)free_clst - (int64_t)v.file_clusters - 1; // -1: raiz
+    diskio_img_stats_t ds;
+    diskio_img_get_stats(&ds);
+
+    printf("%u ciclos (semente %u), %llu registros gravados, %llu sem commit nos cortes, %u cortes\n", cycles, seed,
+           (unsigned long long)appended, (unsigned long long)unconfirmed, ds.cuts);
+    printf("releitura: %u arquivo(s), %llu registros, seq %u..%u, %u sessoes\n", v.files,
+           (unsigned long long)v.records, v.first_seq, v.last_seq, v.sessions);
+    printf("erros: %u de recuperacao, %llu de ordem, %llu registros velhos, %s, %u de montagem\n", recover_errors,
+           (unsigned long long)v.order_errors, (unsigned long long)v.stale,
+           committed_ok ? "confirmados presentes" : "CONFIRMADOS FALTANDO", mount_errors);
+    printf("clusters: %u no volume, %u livres, %llu nos arquivos, %lld perdidos\n", total_clst, (unsigned)free_clst,
+           (unsigned long long)v.file_clusters, (long long)leaked);
+
+    (void)f_mount(NULL, "", 0);
+    diskio_img_close();
+    free(s_t_of_seq);
+    return (recover_errors || mount_errors || v.order_errors || v.stale || !committed_ok) ? 2 : 0;
+}
@@ -0,0 +1,359 @@
+/**
+ * @file sd_soak.c
+ * @brief Soak (host) do log do SD sobre uma imagem FAT: latência por registro e integridade após dias de gravação.
+ * @details
+ *  Formata uma imagem FAT32 (clusters de 32 kB, como um cartão SDHC),
+ *  monta com o FatFs do submódulo e grava um registro por segundo de
+ *  relógio virtual durante `-d` dias, por um de dois caminhos:
+ *   - `daylog` (padrão): `lib/sd_daylog` como no firmware, um arquivo por
+ *     dia pré-alocado com `f_expand`, poda pelo orçamento;
+ *   - `single`: um único `dados.bin` crescendo por anexos (`lib/sd_writer`
+ *     sem pré-alocação), o caminho anterior, para comparação.
+ *
+ *  A latência de cada registro (anexo + prazos de descarga e `f_sync`, o
+ *  que a task do sink bloqueia) é medida no relógio virtual, adiantado pelo
+ *  modelo de disco de `tools/host/diskio_img.c`; o relatório traz p50, p90,
+ *  p99, p99,9 e máximo, e os contadores do disco. Com `-r h` a gravação é
+ *  reiniciada a cada h horas sem fechar o arquivo (queda de energia: o
+ *  buffer em RAM se perde). No fim, todos os arquivos são relidos pelo
+ *  FatFs e a sequência dos registros é conferida; no modo `daylog` o seq
+ *  do diário continua após as quedas, então qualquer salto é falha.
+ *  Cortes no meio de uma gravação ficam com `tools/sd_powercut.c`.
+ *
+ *  Requer o FatFs do submódulo `no-OS-FatFs-SD-SPI-RPi-Pico` com
+ *  `FF_USE_MKFS` e `FF_USE_EXPAND` em 1 no `ffconf.h`. Compilação (a partir
+ *  de `monitor_energia/`, ajustando FF à versão do submódulo):
+ *      FF=no-OS-FatFs-SD-SPI-RPi-Pico/FatFs_SPI/ff15/source
+ *      gcc -O2 -I. -Itools/host -I$FF tools/sd_soak.c tools/host/diskio_img.c lib/sd_daylog.c \
+ *          lib/sd_writer.c lib/sd_binlog.c lib/timestamp.c lib/fmt.c $FF/ff.c $FF/ffunicode.c \
+ *          $FF/ffsystem.c -o sd_soak
+ *      ./sd_soak -d 30 /tmp/sd.img
+ *      ./sd_soak -d 30 -m single /tmp/sd.img
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ff.h"
+#include "pico/time.h"
+#include "diskio_img.h"
+#include "lib/sd_binlog.h"
+#include "lib/sd_daylog.h"
+#include "lib/sd_writer.h"
+
+#define SOAK_IMG_BYTES      (4ULL * 1024U * 1024U * 1024U) /**< Imagem esparsa de 4 GB. */
+#define SOAK_START_UNIX_S   1792368000LL                    /**< 2026-10-19 00:00 UTC. */
+#define SOAK_SINGLE_FILE    "dados.bin"                     /**< Arquivo do modo `single`. */
+
+static FATFS s_fs;
+static sd_daylog_t s_daylog;
+static sd_writer_t s_single;
+static sd_binlog_hdr_t s_single_hdr;
+static uint8_t s_single_header[SD_BINLOG_UNIT];
+
+/** @brief Compara latências para `qsort`. */
+static int cmp_u32(const void *a, const void *b)
+{
+    const uint32_t x = *(const uint32_t *)a;
+    const uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/** @brief Percentil `p` (0..1) de um vetor ordenado. */
+static uint32_t pct(const uint32_t *v, size_t n, double p)
+{
+    size_t i = (size_t)(p * (double)n);
+    return v[(i < n) ? i : n - 1U];
+}
+
+/** @brief Registro sintético de número `i`. */
+static void make_record(sd_binlog_rec_t *r, uint32_t i)
+{
+    r->seq = i;
+    r->flags = 0U;
+    r->t_unix_us = (SOAK_START_UNIX_S + (int64_t)i) * 1000000;
+    r->vrms = 127.0f + (float)(i % 7U) * 0.1f;
+    r->irms = 1.0f + (float)(i % 11U) * 0.05f;
+    r->v_pu = r->vrms / 127.0f;
+    r->p_w = r->vrms * r->irms;
+}
+
+/** @brief (Re)inicia o modo `single`: um arquivo, cabeçalho na criação, sem pré-alocação. */
+static void single_begin(void)
+{
+    s_single_hdr.version = SD_BINLOG_VERSION;
+    s_single_hdr.salt = 0x5EEDU;
+    s_single_hdr.created_unix_us = SOAK_START_UNIX_S * 1000000;
+    sd_binlog_put_header(s_single_header, &s_single_hdr);
+    sd_writer_init(&s_single, SOAK_SINGLE_FILE, s_single_header, sizeof(s_single_header), SD_WRITER_FLUSH_MS,
+                   SD_WRITER_SYNC_MS);
+}
+
+/** @brief Grava um registro no modo `single` (índice a cada segmento, como o daylog). */
+static FRESULT single_append(const sd_binlog_rec_t *r)
+{
+    static sd_binlog_index_t ix;
+    uint8_t u[SD_BINLOG_UNIT];
+    FRESULT fr = sd_writer_open(&s_single);
+
+    if (fr != FR_OK)
+    {
+        return fr;
+    }
+
+    uint32_t off = (uint32_t)sd_writer_size(&s_single);
+    off += (SD_BINLOG_UNIT - off % SD_BINLOG_UNIT) % SD_BINLOG_UNIT;
+    if (off != sd_writer_size(&s_single))
+    {
+        memset(u, 0, sizeof(u));
+        (void)sd_writer_append(&s_single, u, off - (uint32_t)sd_writer_size(&s_single));
+    }
+    if (sd_binlog_is_index_unit(off / SD_BINLOG_UNIT))
+    {
+        sd_binlog_put_index(u, &s_single_hdr, &ix);
+        (void)sd_writer_append(&s_single, u, sizeof(u));
+        sd_binlog_index_next(&ix);
+        off += SD_BINLOG_UNIT;
+    }
+
+    sd_binlog_put_record(u, &s_single_hdr, r);
+    fr = sd_writer_append(&s_single, u, sizeof(u));
+    sd_binlog_index_add(&ix, off, r);
+    return fr;
+}
+
+/**
+ * @brief Relê um arquivo inteiro e confere a sequência contínua.
+ * @details Vai até o tamanho do arquivo, não até o fim lógico: resto de
+ *          pré-alocação ou de arquivos apagados não pode passar no CRC.
+ * @param[in,out] next_seq Sequência esperada (UINT32_MAX: ainda nenhuma).
+ * @param[out] gaps Registros faltando entre consecutivos.
+ */
+static uint32_t verify_file(const char *path, uint32_t *next_seq, uint64_t *gaps)
+{
+    FIL f;
+    uint8_t u[SD_BINLOG_UNIT];
+    sd_binlog_hdr_t hdr;
+    uint32_t n = 0;
+    UINT br;
+
+    if (f_open(&f, path, FA_READ) != FR_OK)
+    {
+        return 0;
+    }
+
+    if (f_read(&f, u, sizeof(u), &br) == FR_OK && br == sizeof(u) && sd_binlog_get_header(u, &hdr))
+    {
+        while (f_read(&f, u, sizeof(u), &br) == FR_OK && br == sizeof(u))
+        {
+            if (sd_binlog_check(u, &hdr) != SD_BINLOG_TYPE_RECORD)
+            {
+                continue;
+            }
+
+            sd_binlog_rec_t r;
+            sd_binlog_get_record(u, &r);
+            if (*next_seq != UINT32_MAX && r.seq > *next_seq)
+            {
+                *gaps += r.seq - *next_seq;
+            }
+            *next_seq = r.seq + 1U;
+            n++;
+        }
+    }
+
+    (void)f_close(&f);
+    return n;
+}
+
+/** @brief Compara dias para `qsort`. */
+static int cmp_i64(const void *a, const void *b)
+{
+    const int64_t x = *(const int64_t *)a;
+    const int64_t y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/** @brief Relê todos os arquivos, os diários em ordem de dia. */
+static uint64_t verify_all(bool daylog, uint64_t *gaps, uint32_t *files)
+{
+    static int64_t days[1024];
+    uint32_t next_seq = UINT32_MAX;
+    char path[SD_DAYLOG_PATH_LEN];
+    uint64_t n = 0;
+    DIR dir;
+    FILINFO fno;
+
+    *gaps = 0;
+    *files = 0;
+
+    if (!daylog)
+    {
+        *files = 1U;
+        return verify_file(SOAK_SINGLE_FILE, &next_seq, gaps);
+    }
+
+    if (f_opendir(&dir, SD_DAYLOG_DIR) != FR_OK)
+    {
+        return 0;
+    }
+    while (*files < 1024U && f_readdir(&dir, &fno) == FR_OK && fno.fname[0])
+    {
+        if (sd_daylog_parse_name(fno.fname, &days[*files]))
+        {
+            (*files)++;
+        }
+    }
+    (void)f_closedir(&dir);
+
+    qsort(days, *files, sizeof(days[0]), cmp_i64);
+    for (uint32_t i = 0; i < *files; i++)
+    {
+        sd_daylog_path(path, sizeof(path), days[i]);
+        n += verify_file(path, &next_seq, gaps);
+    }
+    return n;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t days = 7;
+    uint32_t reboot_h = 0;
+    bool daylog = true;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:m:r:")) != -1)
+    {
+        if (opt == 'd')
+        {
+            days = (uint32_t)strtoul(optarg, NULL, 10);
+        }
+        else if (opt == 'r')
+        {
+            reboot_h = (uint32_t)strtoul(optarg, NULL, 10);
+        }
+        else if (opt == 'm' && (strcmp(optarg, "daylog") == 0 || strcmp(optarg, "single") == 0))
+        {
+            daylog = (strcmp(optarg, "daylog") == 0);
+        }
+        else
+        {
+            optind = argc;
+            break;
+        }
+    }
+
+    if (optind != argc - 1 || days == 0U)
+    {
+        fprintf(stderr, "uso: %s [-d dias] [-m daylog|single] [-r horas entre quedas] imagem.img\n", argv[0]);
+        return 1;
+    }
+
+    static uint8_t work[FF_MAX_SS * 8];
+    const MKFS_PARM fmt = {FM_FAT32, 0, 0, 0, 32768};
+
+    if (!diskio_img_open(argv[optind], SOAK_IMG_BYTES) || f_mkfs("", &fmt, work, sizeof(work)) != FR_OK ||
+        f_mount(&s_fs, "", 1) != FR_OK)
+    {
+        fprintf(stderr, "%s: falha ao criar/formatar/montar a imagem\n", argv[optind]);
+        return 1;
+    }
+
+    const uint32_t n = days * 86400U;
+    uint32_t *lat = malloc(sizeof(uint32_t) * n);
+    uint32_t errors = 0;
+    uint32_t reboots = 0;
+
+    if (!lat)
+    {
+        return 1;
+    }
+
+    if (daylog)
+    {
+        sd_daylog_init(&s_daylog, SD_DAYLOG_COMMIT_MS);
+    }
+    else
+    {
+        single_begin();
+    }
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        if (reboot_h && i && i % (reboot_h * 3600U) == 0U)
+        {
+            /* Queda de energia: FIL abandonado, buffer perdido; a montagem é refeita */
+            (void)f_mount(NULL, "", 0);
+            (void)f_mount(&s_fs, "", 1);
+            if (daylog)
+            {
+                sd_daylog_init(&s_daylog, SD_DAYLOG_COMMIT_MS);
+            }
+            else
+            {
+                single_begin();
+            }
+            reboots++;
+        }
+
+        sd_binlog_rec_t r;
+        make_record(&r, i);
+
+        const uint64_t t0 = host_time_us;
+        FRESULT fr;
+        if (daylog)
+        {
+            fr = sd_daylog_append(&s_daylog, &r, true);
+            fr = (fr == FR_OK) ? sd_daylog_poll(&s_daylog, false) : fr;
+        }
+        else
+        {
+            fr = single_append(&r);
+            fr = (fr == FR_OK) ? sd_writer_poll(&s_single) : fr;
+        }
+        lat[i] = (uint32_t)(host_time_us - t0);
+        errors += (fr != FR_OK) ? 1U : 0U;
+
+        host_time_us = t0 + 1000000U; /* Próximo registro 1 s depois do anterior */
+    }
+
+    (void)(daylog ? sd_daylog_close(&s_daylog) : sd_writer_close(&s_single));
+
+    uint64_t gaps;
+    uint32_t files;
+    const uint64_t found = verify_all(daylog, &gaps, &files);
+    diskio_img_stats_t ds;
+    diskio_img_get_stats(&ds);
+
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        sum += lat[i];
+    }
+    qsort(lat, n, sizeof(lat[0]), cmp_u32);
+
+    printf("modo %s, %u dias, %u registros, %u quedas, %u erros\n", daylog ? "daylog" : "single", days, n, reboots,
+           errors);
+    printf("latencia por registro [us]: media %llu  p50 %u  p90 %u  p99 %u  p99.9 %u  max %u\n",
+           (unsigned long long)(sum / n), pct(lat, n, 0.50), pct(lat, n, 0.90), pct(lat, n, 0.99),
+           pct(lat, n, 0.999), lat[n - 1U]);
+    if (daylog)
+    {
+        printf("rotacao: %u trocas (max %u us), %u criados (max %u us), %u sem pre-alocacao, %u apagados\n",
+               s_daylog.stats.rotations, s_daylog.stats.rotate_max_us, s_daylog.stats.created,
+               s_daylog.stats.create_max_us, s_daylog.stats.prealloc_failed, s_daylog.stats.pruned);
+        printf("diario: %u commits, %u unidades de enchimento, %u sessoes, confirmado ate o seq %u\n",
+               s_daylog.stats.commits, s_daylog.stats.pad_units, s_daylog.stats.sessions,
+               s_daylog.stats.committed_seq);
+    }
+    printf("disco: %u leituras (%u setores), %u gravacoes (%u setores), %u fora de sequencia\n", ds.reads,
+           ds.read_sectors, ds.writes, ds.write_sectors, ds.write_jumps);
+    printf("releitura: %u arquivo(s), %llu registros, %llu faltando entre consecutivos\n", files,
+           (unsigned long long)found, (unsigned long long)gaps);
+
+    free(lat);
+    (void)f_mount(NULL, "", 0);
+    diskio_img_close();
+    return (errors || ((daylog || !reboot_h) && gaps)) ? 2 : 0;
+}
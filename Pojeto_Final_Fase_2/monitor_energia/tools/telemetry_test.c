@@ -0,0 +1,308 @@
+/**
+ * @file telemetry_test.c
+ * @brief Teste (host) do despachante de telemetria (`lib/telemetry.c`): fan-out, descarte do mais antigo e contadores por sink.
+ * @details
+ *  Compila `lib/telemetry.c` sem alteração sobre o scheduler de relógio
+ *  virtual de `tools/host/rtos_host.c`: `telemetry_task` produz um
+ *  registro por segundo (o Wi-Fi sobe em 5 s) e cinco sinks de mentira, cada
+ *  um na sua task `sink_worker`, recebem o fan-out:
+ *   - `rapido`: publica na hora; recebe todos, em ordem, sem descarte;
+ *   - `lento`: leva 2,5 s por registro; a fila de 3 enche, e cada registro
+ *     que ele tira deve estar entre os 3 mais novos (descarta o mais
+ *     antigo, não o novo);
+ *   - `janela`: só `TELEMETRY_ACCEPT_WINDOW`; recebe a subida do link e os
+ *     fechamentos a cada `TELEMETRY_WINDOW_S`;
+ *   - `falho`: `publish` falha nos registros ímpares;
+ *   - `doente`: `healthy` falso até 20 s; a fila segura os 4 mais novos e
+ *     os outros contam como descartados.
+ *  No fim confere `telemetry_get_sink_stats` de cada sink contra o que os
+ *  sinks viram. Sai com código 1 na primeira divergência encontrada
+ *  (mostra até 10).
+ *
+ *  Compilação e execução (a partir de `monitor_energia/`):
+ *      gcc -O2 -I. -Itools/host tools/telemetry_test.c lib/telemetry.c tools/host/rtos_host.c \
+ *          tools/host/logger_host.c -o telemetry_test -lpthread && ./telemetry_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "pico/time.h"
+#include "lib/telemetry.h"
+#include "lib/energy_monitor.h"
+#include "lib/wifi_manager.h"
+#include "lib/rtos_stats.h"
+
+#define TEST_LINK_UP_MS     5000U       /**< Wi-Fi sobe aqui. */
+#define TEST_SICK_UNTIL_MS  20000U      /**< `doente` fica saudável aqui. */
+#define TEST_SICK_CHECK_MS  10500U      /**< Conferência com `doente` ainda parado. */
+#define TEST_END_MS         186500U     /**< Fim: registros em 1..186 s. */
+#define TEST_SLOW_MS        2500U       /**< Duração de um `publish` do `lento`. */
+#define TEST_MAX_RECS       256U        /**< Registros guardados por sink. */
+
+/** @brief O que um sink de mentira recebeu. */
+typedef struct
+{
+    uint32_t seq[TEST_MAX_RECS];
+    uint8_t flags[TEST_MAX_RECS];
+    uint32_t n;
+    uint8_t queue_len;
+} seen_t;
+
+static unsigned s_failures = 0;
+static uint32_t s_produced = 0;     /**< Registros produzidos (seq do último = s_produced - 1). */
+static seen_t s_fast, s_slow, s_window, s_flaky, s_sick;
+
+/** @brief Registra divergência (mostra no máximo as 10 primeiras). */
+#define CHECK(cond, ...)                                                                          \
+    do                                                                                            \
+    {                                                                                             \
+        if (!(cond) && s_failures++ < 10U)                                                        \
+        {                                                                                         \
+            fprintf(stderr, "FALHA [%.3f s] ", (double)host_time_us / 1e6);                       \
+            fprintf(stderr, __VA_ARGS__);                                                         \
+            fputc('\n', stderr);                                                                  \
+        }                                                                                         \
+    } while (0)
+
+/* ---------------------------------------------------------------------- */
+/* Ambiente de `telemetry_task`                                           */
+/* ---------------------------------------------------------------------- */
+
+bool energy_monitor_get_last(energy_monitor_data_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->vrms = 127.0;
+    out->t_boot_us = host_time_us;
+    s_produced++;
+    return true;
+}
+
+bool wifi_manager_is_connected(void)
+{
+    return host_time_us >= (uint64_t)TEST_LINK_UP_MS * 1000U;
+}
+
+BaseType_t rtos_stats_create_task(TaskFunction_t fn, const char *name, uint32_t stack_words, void *params,
+                                  UBaseType_t priority, TaskHandle_t *handle)
+{
+    return xTaskCreate(fn, name, stack_words, params, priority, handle);
+}
+
+void rtos_stats_watch_queue(QueueHandle_t q, const char *name)
+{
+    (void)q;
+    (void)name;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Sinks de mentira                                                       */
+/* ---------------------------------------------------------------------- */
+
+/** @brief Guarda o registro e confere a ordem (seq crescente). */
+static void record(seen_t *s, const telemetry_record_t *rec, const char *name)
+{
+    CHECK(s->n == 0 || rec->seq > s->seq[s->n - 1U], "%s: seq %u depois de %u", name, (unsigned)rec->seq,
+          (unsigned)s->seq[s->n - 1U]);
+    if (s->n < TEST_MAX_RECS)
+    {
+        s->seq[s->n] = rec->seq;
+        s->flags[s->n] = rec->flags;
+        s->n++;
+    }
+}
+
+/** @brief O registro tirado da fila está entre os `queue_len` mais novos. */
+static void check_newest(const seen_t *s, const telemetry_record_t *rec, const char *name)
+{
+    CHECK(rec->seq + s->queue_len >= s_produced, "%s: seq %u tirado com o produtor em %u (fila %u)", name,
+          (unsigned)rec->seq, (unsigned)(s_produced - 1U), (unsigned)s->queue_len);
+}
+
+static bool fast_publish(void *ctx, const telemetry_record_t *rec)
+{
+    (void)ctx;
+    record(&s_fast, rec, "rapido");
+    return true;
+}
+
+static bool slow_publish(void *ctx, const telemetry_record_t *rec)
+{
+    (void)ctx;
+    check_newest(&s_slow, rec, "lento");
+    record(&s_slow, rec, "lento");
+    vTaskDelay(pdMS_TO_TICKS(TEST_SLOW_MS));
+    return true;
+}
+
+static bool window_publish(void *ctx, const telemetry_record_t *rec)
+{
+    (void)ctx;
+    CHECK(rec->flags & TELEMETRY_FLAG_WINDOW, "janela: seq %u sem TELEMETRY_FLAG_WINDOW", (unsigned)rec->seq);
+    record(&s_window, rec, "janela");
+    return true;
+}
+
+static bool flaky_publish(void *ctx, const telemetry_record_t *rec)
+{
+    (void)ctx;
+    record(&s_flaky, rec, "falho");
+    return (rec->seq & 1U) == 0U;
+}
+
+static bool sick_publish(void *ctx, const telemetry_record_t *rec)
+{
+    (void)ctx;
+    CHECK(host_time_us >= (uint64_t)TEST_SICK_UNTIL_MS * 1000U, "doente: publish antes de ficar saudavel");
+    if (s_sick.n == 0U)
+    {
+        check_newest(&s_sick, rec, "doente");
+    }
+    record(&s_sick, rec, "doente");
+    return true;
+}
+
+static bool sick_healthy(void *ctx)
+{
+    (void)ctx;
+    return host_time_us >= (uint64_t)TEST_SICK_UNTIL_MS * 1000U;
+}
+
+#define TEST_SINK(NAME, PUBLISH, HEALTHY, ACCEPT, QLEN)                                           \
+    {                                                                                             \
+        .name = NAME, .begin = NULL, .publish = PUBLISH, .flush = NULL, .healthy = HEALTHY,       \
+        .ctx = NULL, .accept = ACCEPT, .queue_len = QLEN, .stack_words = 512,                     \
+        .priority = tskIDLE_PRIORITY + 1, .idle_flush_ms = 0,                                     \
+    }
+
+static const telemetry_sink_t k_sinks[] = {
+    TEST_SINK("rapido", fast_publish, NULL, TELEMETRY_ACCEPT_ALL, 4),
+    TEST_SINK("lento", slow_publish, NULL, TELEMETRY_ACCEPT_ALL, 3),
+    TEST_SINK("janela", window_publish, NULL, TELEMETRY_ACCEPT_WINDOW, 2),
+    TEST_SINK("falho", flaky_publish, NULL, TELEMETRY_ACCEPT_ALL, 4),
+    TEST_SINK("doente", sick_publish, sick_healthy, TELEMETRY_ACCEPT_ALL, 4),
+};
+
+/* ---------------------------------------------------------------------- */
+/* Conferências                                                           */
+/* ---------------------------------------------------------------------- */
+
+static telemetry_sink_stats_t stats_of(uint8_t idx)
+{
+    telemetry_sink_stats_t st;
+    CHECK(telemetry_get_sink_stats(idx, &st), "telemetry_get_sink_stats(%u) falhou", (unsigned)idx);
+    return st;
+}
+
+/** @brief Com `doente` parado: fila com os 4 mais novos, resto descartado, nada entregue. */
+static void verify_sick_stalled(void)
+{
+    const telemetry_sink_stats_t st = stats_of(4);
+
+    CHECK(!st.healthy, "doente: healthy verdadeiro antes de %u ms", (unsigned)TEST_SICK_UNTIL_MS);
+    CHECK(st.delivered == 0U && st.failed == 0U, "doente: %u entregues, %u falhas parado", (unsigned)st.delivered,
+          (unsigned)st.failed);
+    CHECK(st.queued == 4U, "doente: %u na fila (esperado 4)", (unsigned)st.queued);
+    CHECK(st.dropped + st.queued == s_produced, "doente: %u descartados + %u na fila != %u produzidos",
+          (unsigned)st.dropped, (unsigned)st.queued, (unsigned)s_produced);
+}
+
+static void verify_end(void)
+{
+    const uint32_t n = s_produced;
+    const uint32_t expect_windows[] = {4, 64, 124, 184};   /* Subida do link em 5 s, depois a cada 60 s */
+
+    CHECK(n == TEST_END_MS / 1000U, "%u registros produzidos (esperado %u)", (unsigned)n,
+          (unsigned)(TEST_END_MS / 1000U));
+    CHECK(telemetry_sink_count() == 5U, "%u sinks registrados", (unsigned)telemetry_sink_count());
+    CHECK(strcmp(telemetry_sink_name(1), "lento") == 0, "nome do sink 1: %s", telemetry_sink_name(1));
+    CHECK(telemetry_sink_name(5) == NULL, "nome de sink inexistente");
+
+    /* rapido: todos, em ordem, seq 0..n-1 */
+    telemetry_sink_stats_t st = stats_of(0);
+    CHECK(st.delivered == n && st.dropped == 0U && st.failed == 0U && st.queued == 0U,
+          "rapido: %u entregues, %u descartados, %u falhas, %u na fila (produzidos %u)", (unsigned)st.delivered,
+          (unsigned)st.dropped, (unsigned)st.failed, (unsigned)st.queued, (unsigned)n);
+    CHECK(st.queued_max == 1U && st.healthy, "rapido: queued_max %u, healthy %d", (unsigned)st.queued_max,
+          st.healthy);
+    CHECK(s_fast.n == n && s_fast.seq[0] == 0U && s_fast.seq[n - 1U] == n - 1U, "rapido: viu %u registros",
+          (unsigned)s_fast.n);
+
+    uint32_t windows = 0;
+    for (uint32_t i = 0; i < s_fast.n; i++)
+    {
+        if (s_fast.flags[i] & TELEMETRY_FLAG_WINDOW)
+        {
+            CHECK(windows < 4U && s_fast.seq[i] == expect_windows[windows], "janela inesperada no seq %u",
+                  (unsigned)s_fast.seq[i]);
+            CHECK((windows == 0U) == ((s_fast.flags[i] & TELEMETRY_FLAG_LINK_UP) != 0U),
+                  "TELEMETRY_FLAG_LINK_UP no seq %u", (unsigned)s_fast.seq[i]);
+            windows++;
+        }
+    }
+    CHECK(windows == 4U, "%u janelas (esperado 4)", (unsigned)windows);
+
+    /* lento: descartou os mais antigos; vistos (um pode estar em `publish`) + descartados + na fila = produzidos */
+    st = stats_of(1);
+    CHECK(st.dropped > 0U && s_slow.n - st.delivered <= 1U, "lento: %u descartados, %u entregues (viu %u)",
+          (unsigned)st.dropped, (unsigned)st.delivered, (unsigned)s_slow.n);
+    CHECK(s_slow.n + st.dropped + st.queued == n, "lento: %u + %u + %u != %u produzidos", (unsigned)s_slow.n,
+          (unsigned)st.dropped, (unsigned)st.queued, (unsigned)n);
+    CHECK(st.queued_max == 3U, "lento: queued_max %u (esperado 3)", (unsigned)st.queued_max);
+
+    /* janela: só os fechamentos de janela */
+    st = stats_of(2);
+    CHECK(st.delivered == 4U && st.dropped == 0U && s_window.n == 4U, "janela: %u entregues, %u descartados",
+          (unsigned)st.delivered, (unsigned)st.dropped);
+    for (uint32_t i = 0; i < s_window.n && i < 4U; i++)
+    {
+        CHECK(s_window.seq[i] == expect_windows[i], "janela: recebeu seq %u (esperado %u)",
+              (unsigned)s_window.seq[i], (unsigned)expect_windows[i]);
+    }
+
+    /* falho: falhas nos ímpares, contadas à parte */
+    st = stats_of(3);
+    CHECK(st.delivered == (n + 1U) / 2U && st.failed == n / 2U && st.dropped == 0U,
+          "falho: %u entregues, %u falhas, %u descartados (produzidos %u)", (unsigned)st.delivered,
+          (unsigned)st.failed, (unsigned)st.dropped, (unsigned)n);
+
+    /* doente: recuperou; entregues + descartados = produzidos */
+    st = stats_of(4);
+    CHECK(st.healthy && st.queued == 0U, "doente: healthy %d, %u na fila", st.healthy, (unsigned)st.queued);
+    CHECK(st.delivered + st.dropped == n && st.delivered == s_sick.n, "doente: %u entregues + %u descartados != %u",
+          (unsigned)st.delivered, (unsigned)st.dropped, (unsigned)n);
+    CHECK(st.dropped == TEST_SICK_UNTIL_MS / 1000U - 4U, "doente: %u descartados (esperado %u)",
+          (unsigned)st.dropped, (unsigned)(TEST_SICK_UNTIL_MS / 1000U - 4U));
+}
+
+int main(void)
+{
+    host_rtos_init(tskIDLE_PRIORITY + 5);
+
+    for (size_t i = 0; i < sizeof(k_sinks) / sizeof(k_sinks[0]); i++)
+    {
+        CHECK(telemetry_register_sink(&k_sinks[i]), "registro do sink %s", k_sinks[i].name);
+    }
+    s_slow.queue_len = k_sinks[1].queue_len;
+    s_sick.queue_len = k_sinks[4].queue_len;
+
+    CHECK(telemetry_start(), "telemetry_start");
+    CHECK(!telemetry_register_sink(&k_sinks[0]), "registro aceito depois de telemetry_start");
+    xTaskCreate(telemetry_task, "Telemetry", 1024, NULL, tskIDLE_PRIORITY + 2, NULL);
+
+    vTaskDelay(pdMS_TO_TICKS(TEST_SICK_CHECK_MS));
+    verify_sick_stalled();
+
+    vTaskDelay(pdMS_TO_TICKS(TEST_END_MS - TEST_SICK_CHECK_MS));
+    verify_end();
+
+    if (s_failures)
+    {
+        fprintf(stderr, "%u divergencias.\n", s_failures);
+        return 1;
+    }
+    printf("telemetry: OK (%u registros, 5 sinks)\n", (unsigned)s_produced);
+    return 0;
+}
@@ -0,0 +1,351 @@
+/**
+ * @file udp_stream_rx.c
+ * @brief Receptor (host) do fluxo UDP de amostras: CSV, perdas e vazão.
+ * @details
+ *  Decodifica os datagramas de `lib/udp_stream_proto.h` e escreve uma linha
+ *  CSV por amostra (`seq,t_ms,t_unix_us,v,i`) na saída padrão. A cada segundo imprime
+ *  em stderr datagramas, amostras, perdas (saltos de sequência), amostras
+ *  fora de ordem/duplicadas e a vazão. Datagramas de registros de 1 Hz
+ *  (`lib/telemetry_codec.h`, magic "ER") vão para o CSV indicado com `-r`.
+ *
+ *  Com `-l` um processo filho faz o papel do Pico: gera senoides de 60 Hz
+ *  amostradas a 200 Hz (e um registro de 1 Hz, em lotes de 10), codifica
+ *  com os mesmos formatos do firmware e envia para 127.0.0.1, descartando
+ *  `-d` % dos datagramas de amostras para exercitar a detecção de perdas.
+ *
+ *  Compilação e uso (a partir de `monitor_energia/`):
+ *      gcc -O2 -I. tools/udp_stream_rx.c lib/telemetry_codec.c -o udp_stream_rx -lm
+ *      ./udp_stream_rx [-p porta] [-t segundos] [-r registros.csv] > amostras.csv
+ *      ./udp_stream_rx -l -d 5 -t 10 > /dev/null
+ */
+
+#include <arpa/inet.h>
+#include <math.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include "lib/udp_stream_proto.h"
+#include "lib/telemetry_codec.h"
+
+#define RX_DEFAULT_PORT     5005        /**< Porta padrão (igual a UDP_STREAM_PORT). */
+#define RX_MAX_DGRAM        1500        /**< Maior datagrama aceito. */
+#define LOOP_RATE_HZ        200U        /**< Taxa simulada no modo loopback. */
+#define LOOP_BATCH          32U         /**< Amostras por datagrama no loopback. */
+#define LOOP_RECORD_BATCH   10U         /**< Registros de 1 Hz por datagrama no loopback. */
+
+/** @brief Contadores do receptor. */
+typedef struct
+{
+    unsigned long datagrams;
+    unsigned long bad;          /**< Datagramas com magic/versão/tamanho inválidos. */
+    unsigned long samples;
+    unsigned long lost;         /**< Amostras nunca recebidas (saltos de seq). */
+    unsigned long late;         /**< Amostras fora de ordem ou duplicadas. */
+    unsigned long records;      /**< Registros de 1 Hz decodificados. */
+    unsigned long long bytes;
+} rx_stats_t;
+
+static volatile sig_atomic_t s_stop = 0;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    s_stop = 1;
+}
+
+/** @brief Relógio monotônico em segundos. */
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/** @brief Tempo Unix em segundos (base do t0_unix_us simulado). */
+static double wall_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Emissor simulado (modo loopback): senoides 60 Hz a 200 Hz.
+ */
+static void loopback_sender(unsigned port, double seconds, double drop_pct)
+{
+    const int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in to = {0};
+    to.sin_family = AF_INET;
+    to.sin_port = htons((uint16_t)port);
+    to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    const unsigned total = (unsigned)(seconds * LOOP_RATE_HZ);
+    const double t_start = now_s();
+    const int64_t unix_start_us = (int64_t)(wall_s() * 1e6);
+    uint8_t dgram[UDP_STREAM_HDR_SIZE + LOOP_BATCH * UDP_STREAM_SAMPLE_SIZE];
+    uint8_t rec_dgram[TELEMETRY_CODEC_HDR_SIZE + LOOP_RECORD_BATCH * TELEMETRY_CODEC_REC_SIZE];
+    telemetry_codec_writer_t w;
+    uint32_t seq = 0;
+    uint32_t rec_seq = 0;
+
+    (void)telemetry_codec_begin(&w, rec_dgram, sizeof(rec_dgram));
+
+    srand(12345);
+
+    while (seq < total)
+    {
+        const uint64_t t0_us = (uint64_t)seq * 1000000U / LOOP_RATE_HZ;
+        udp_stream_hdr_t h = {
+            .version = UDP_STREAM_VERSION, .type = UDP_STREAM_TYPE_SAMPLES, .count = 0,
+            .rate_hz = LOOP_RATE_HZ, .seq = seq, .t0_ms = (uint32_t)(t0_us / 1000U),
+            .t0_unix_us = unix_start_us + (int64_t)t0_us,
+        };
+
+        for (unsigned k = 0; k < LOOP_BATCH && seq < total; k++, seq++, h.count++)
+        {
+            const double t = (double)seq / LOOP_RATE_HZ;
+            const udp_stream_sample_t s = {
+                .dt = (uint16_t)(((uint64_t)seq * 1000000U / LOOP_RATE_HZ - t0_us) / UDP_STREAM_DT_UNIT_US),
+                .v_cv = udp_stream_to_centi((float)(179.6 * sin(2.0 * M_PI * 60.0 * t))),
+                .i_ca = udp_stream_to_centi((float)(7.07 * sin(2.0 * M_PI * 60.0 * t - 0.5))),
+            };
+            udp_stream_put_sample(&dgram[UDP_STREAM_HDR_SIZE + k * UDP_STREAM_SAMPLE_SIZE], &s);
+        }
+
+        udp_stream_put_header(dgram, &h);
+
+        /* Um registro de 1 Hz a cada LOOP_RATE_HZ amostras. */
+        while ((rec_seq + 1U) * LOOP_RATE_HZ <= seq)
+        {
+            const telemetry_record_t rec = {
+                .seq = rec_seq, .uptime_s = rec_seq + 1U, .t_ms = (rec_seq + 1U) * 1000U,
+                .t_unix_us = 0,
+                .vrms = 127.0f, .irms = 5.0f, .v_pu = 1.0f, .p_w = 556.9f,
+                .e_total_wh = 556.9 * (rec_seq + 1U) / 3600.0, .flags = 0, .valid = true,
+            };
+            rec_seq++;
+
+            if (!telemetry_codec_add(&w, &rec) || w.count == LOOP_RECORD_BATCH)
+            {
+                const size_t len = telemetry_codec_finish(&w);
+                (void)sendto(fd, rec_dgram, len, 0, (const struct sockaddr *)&to, sizeof(to));
+                (void)telemetry_codec_begin(&w, rec_dgram, sizeof(rec_dgram));
+            }
+        }
+
+        if ((double)rand() / RAND_MAX * 100.0 >= drop_pct)
+        {
+            (void)sendto(fd, dgram, UDP_STREAM_HDR_SIZE + h.count * UDP_STREAM_SAMPLE_SIZE, 0,
+                         (const struct sockaddr *)&to, sizeof(to));
+        }
+
+        /* Cadência real: um datagrama a cada LOOP_BATCH amostras. */
+        const double wait = t_start + (double)seq / LOOP_RATE_HZ - now_s();
+        if (wait > 0.0)
+        {
+            usleep((useconds_t)(wait * 1e6));
+        }
+    }
+
+    close(fd);
+}
+
+/** @brief Linha de progresso/resumo em stderr. */
+static void report(const rx_stats_t *st, const rx_stats_t *prev, double dt, const char *label)
+{
+    const unsigned long expected = st->samples + st->lost;
+    const double loss = expected ? 100.0 * (double)st->lost / (double)expected : 0.0;
+
+    fprintf(stderr, "%s dgrams=%lu bad=%lu amostras=%lu perdidas=%lu (%.2f%%) fora_ordem=%lu "
+                    "registros=%lu | %.1f amostras/s %.2f kB/s\n",
+            label, st->datagrams, st->bad, st->samples, st->lost, loss, st->late, st->records,
+            dt > 0.0 ? (double)(st->samples - prev->samples) / dt : 0.0,
+            dt > 0.0 ? (double)(st->bytes - prev->bytes) / dt / 1000.0 : 0.0);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned port = RX_DEFAULT_PORT;
+    double seconds = 0.0;
+    double drop_pct = 0.0;
+    int loopback = 0;
+    FILE *rec_csv = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "p:t:d:lr:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'p': port = (unsigned)atoi(optarg); break;
+        case 't': seconds = atof(optarg); break;
+        case 'd': drop_pct = atof(optarg); break;
+        case 'l': loopback = 1; break;
+        case 'r':
+            rec_csv = fopen(optarg, "w");
+            if (!rec_csv)
+            {
+                perror(optarg);
+                return 1;
+            }
+            fprintf(rec_csv, "seq,uptime_s,t_ms,t_unix_us,vrms,irms,v_pu,p_w,e_total_wh,flags,valid\n");
+            break;
+        default:
+            fprintf(stderr, "uso: %s [-p porta] [-t segundos] [-r registros.csv] [-l [-d %%descarte]]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    if (loopback && seconds <= 0.0)
+    {
+        seconds = 5.0;
+    }
+
+    const int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    const int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    if (bind(fd, (const struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        perror("bind");
+        return 1;
+    }
+
+    struct timeval tv = {0, 200000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    signal(SIGINT, on_signal);
+
+    pid_t child = -1;
+    if (loopback)
+    {
+        child = fork();
+        if (child == 0)
+        {
+            close(fd);
+            loopback_sender(port, seconds, drop_pct);
+            _exit(0);
+        }
+    }
+
+    printf("seq,t_ms,t_unix_us,v,i\n");
+
+    rx_stats_t st = {0};
+    rx_stats_t prev = {0};
+    int have_seq = 0;
+    uint32_t next_seq = 0;
+    const double t_start = now_s();
+    double t_report = t_start;
+    /* Loopback: encerra pouco depois do emissor (datagramas finais em trânsito). */
+    const double t_end = seconds > 0.0 ? t_start + seconds + (loopback ? 0.5 : 0.0) : 0.0;
+    uint8_t buf[RX_MAX_DGRAM];
+
+    while (!s_stop && (t_end == 0.0 || now_s() < t_end))
+    {
+        const ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        const double t = now_s();
+
+        if (n > 0)
+        {
+            udp_stream_hdr_t h;
+            telemetry_codec_reader_t r;
+            st.bytes += (unsigned long long)n;
+
+            if (telemetry_codec_open(&r, buf, (size_t)n))
+            {
+                for (uint16_t k = 0; k < r.count; k++)
+                {
+                    telemetry_record_t rec;
+                    telemetry_codec_get(&r, k, &rec);
+
+                    if (rec_csv)
+                    {
+                        fprintf(rec_csv, "%u,%u,%u,%lld,%.2f,%.3f,%.4f,%.1f,%.4f,%u,%d\n", (unsigned)rec.seq,
+                                (unsigned)rec.uptime_s, (unsigned)rec.t_ms, (long long)rec.t_unix_us, rec.vrms,
+                                rec.irms, rec.v_pu, rec.p_w, rec.e_total_wh, (unsigned)rec.flags, rec.valid ? 1 : 0);
+                    }
+                }
+
+                st.records += r.count;
+                continue;
+            }
+
+            if (!udp_stream_get_header(buf, (size_t)n, &h) || h.type != UDP_STREAM_TYPE_SAMPLES)
+            {
+                st.bad++;
+                continue;
+            }
+
+            st.datagrams++;
+
+            if (!have_seq)
+            {
+                next_seq = h.seq;
+                have_seq = 1;
+            }
+
+            if ((int32_t)(h.seq - next_seq) < 0)
+            {
+                st.late += h.count;
+            }
+            else
+            {
+                st.lost += h.seq - next_seq;
+                next_seq = h.seq + h.count;
+            }
+
+            for (uint16_t k = 0; k < h.count; k++)
+            {
+                udp_stream_sample_t s;
+                udp_stream_get_sample(&buf[h.hdr_size + k * UDP_STREAM_SAMPLE_SIZE], &s);
+                const uint32_t dt_us = (uint32_t)s.dt * h.dt_unit_us;
+
+                /* t_unix_us vazio enquanto o medidor não tem NTP. */
+                printf("%u,%.2f,", (unsigned)(h.seq + k), h.t0_ms + dt_us / 1000.0);
+                if (h.t0_unix_us)
+                {
+                    printf("%lld", (long long)(h.t0_unix_us + dt_us));
+                }
+                printf(",%.2f,%.2f\n", s.v_cv / UDP_STREAM_SCALE, s.i_ca / UDP_STREAM_SCALE);
+            }
+
+            st.samples += h.count;
+        }
+
+        if (t - t_report >= 1.0)
+        {
+            report(&st, &prev, t - t_report, "[rx]");
+            prev = st;
+            t_report = t;
+        }
+    }
+
+    rx_stats_t zero = {0};
+    report(&st, &zero, now_s() - t_start, "[total]");
+
+    if (child > 0)
+    {
+        waitpid(child, NULL, 0);
+    }
+
+    if (rec_csv)
+    {
+        fclose(rec_csv);
+    }
+
+    close(fd);
+    return 0;
+}
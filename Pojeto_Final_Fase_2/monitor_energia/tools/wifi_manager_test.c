@@ -0,0 +1,405 @@
+/**
+ * @file wifi_manager_test.c
+ * @brief Teste (host) dos modos de energia do rádio em `lib/wifi_manager.c` (`wifi_manager_tx_schedule`/`tx_hold`, `pm_wanted`/`pm_update`).
+ * @details
+ *  Compila `lib/wifi_manager.c` sem alteração sobre o scheduler de relógio
+ *  virtual de `tools/host/rtos_host.c`, com um rádio de mentira no lugar do
+ *  cyw43: `cyw43_wifi_pm` guarda cada troca com o instante, e o teste sobe
+ *  e derruba o link chamando os callbacks da netif numa IRQ simulada.
+ *  Roteiro (o teste declara envios como os clientes do firmware):
+ *   - conectado e sem envios: economia (`CYW43_AGGRESSIVE_PM`);
+ *   - envio declarado: acorda `WIFI_PM_WAKE_LEAD_MS` antes do prazo e volta
+ *     à economia ao reagendar, ou `WIFI_PM_HOLD_MS` após o prazo;
+ *   - `WIFI_TX_NOW`/`WIFI_TX_IDLE`: acorda e volta na hora;
+ *   - dois clientes: acordado enquanto qualquer um precisar;
+ *   - `wifi_manager_tx_hold` (fluxo UDP ligado, conexão HTTP aberta):
+ *     acordado além de `WIFI_PM_HOLD_MS` até o último cliente soltar;
+ *   - queda e reassociação rápida: modo padrão sem link, de volta ao modo
+ *     pedido com o IP;
+ *   - `cyw43_wifi_pm` com erro: conta o erro e mantém o modo;
+ *   - tempo ativo e em economia somam o tempo decorrido.
+ *  Sai com código 1 na primeira divergência encontrada (mostra até 10).
+ *
+ *  Compilação e execução (a partir de `monitor_energia/`):
+ *      gcc -O2 -I. -Itools/host tools/wifi_manager_test.c lib/wifi_manager.c tools/host/rtos_host.c \
+ *          tools/host/logger_host.c -o wifi_manager_test -lpthread && ./wifi_manager_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "pico/cyw43_arch.h"
+#include "lib/wifi_manager.h"
+#include "lib/rtos_stats.h"
+
+#define TEST_PM_LOG         64U         /**< Trocas de modo guardadas. */
+#define TEST_TOL_MS         5U          /**< Folga no instante de uma troca. */
+
+/** @brief Uma troca de modo aplicada no rádio. */
+typedef struct
+{
+    uint32_t ms;
+    wifi_pm_mode_t mode;
+} pm_change_t;
+
+static unsigned s_failures = 0;
+
+cyw43_t cyw43_state;
+
+static int s_link = CYW43_LINK_DOWN;        /**< Status devolvido por `cyw43_tcpip_link_status`. */
+static int s_pm_rc = 0;                     /**< Retorno dos próximos `cyw43_wifi_pm`. */
+static unsigned s_pm_errors = 0;            /**< `cyw43_wifi_pm` devolvidos com erro. */
+static pm_change_t s_pm_log[TEST_PM_LOG];
+static unsigned s_pm_count = 0;
+static unsigned s_pm_checked = 0;           /**< Trocas já conferidas pelo roteiro. */
+static unsigned s_full_joins = 0;
+static unsigned s_fast_joins = 0;
+static unsigned s_dns_sets = 0;             /**< `dns_setserver` chamados (um por subida do link). */
+static const uint8_t k_bssid[6] = {0x02, 0x11, 0x22, 0x33, 0x44, 0x55};
+
+#define CHECK(cond, ...)                                                                          \
+    do                                                                                            \
+    {                                                                                             \
+        if (!(cond) && s_failures++ < 10U)                                                        \
+        {                                                                                         \
+            fprintf(stderr, "FALHA [%.3f s] ", (double)host_time_us / 1e6);                       \
+            fprintf(stderr, __VA_ARGS__);                                                         \
+            fputc('\n', stderr);                                                                  \
+        }                                                                                         \
+    } while (0)
+
+/* ---------------------------------------------------------------------- */
+/* Rádio de mentira (cyw43)                                               */
+/* ---------------------------------------------------------------------- */
+
+int cyw43_arch_init(void)
+{
+    return 0;
+}
+
+void cyw43_arch_enable_sta_mode(void)
+{
+}
+
+int cyw43_arch_wifi_connect_async(const char *ssid, const char *pw, uint32_t auth)
+{
+    (void)pw;
+    (void)auth;
+    CHECK(strcmp(ssid, "rede") == 0, "conexao no SSID \"%s\"", ssid);
+    s_full_joins++;
+    return 0;
+}
+
+int cyw43_wifi_join(cyw43_t *self, size_t ssid_len, const uint8_t *ssid, size_t key_len, const uint8_t *key,
+                    uint32_t auth_type, const uint8_t *bssid, uint32_t channel)
+{
+    (void)self;
+    (void)ssid_len;
+    (void)ssid;
+    (void)key_len;
+    (void)key;
+    (void)auth_type;
+    (void)channel;
+    CHECK(bssid && memcmp(bssid, k_bssid, sizeof(k_bssid)) == 0, "reassociacao sem o BSSID guardado");
+    s_fast_joins++;
+    return 0;
+}
+
+int cyw43_wifi_leave(cyw43_t *self, int itf)
+{
+    (void)self;
+    (void)itf;
+    return 0;
+}
+
+int cyw43_wifi_get_bssid(cyw43_t *self, uint8_t bssid[6])
+{
+    (void)self;
+    memcpy(bssid, k_bssid, sizeof(k_bssid));
+    return 0;
+}
+
+int cyw43_wifi_get_rssi(cyw43_t *self, int32_t *rssi)
+{
+    (void)self;
+    *rssi = -52;
+    return 0;
+}
+
+int cyw43_tcpip_link_status(cyw43_t *self, int itf)
+{
+    (void)self;
+    (void)itf;
+    return s_link;
+}
+
+int cyw43_wifi_pm(cyw43_t *self, uint32_t pm)
+{
+    (void)self;
+
+    if (s_pm_rc != 0)
+    {
+        s_pm_errors++;
+        return s_pm_rc;
+    }
+
+    wifi_pm_mode_t mode;
+    switch (pm)
+    {
+    case CYW43_DEFAULT_PM:
+        mode = WIFI_PM_DEFAULT;
+        break;
+    case CYW43_PERFORMANCE_PM:
+        mode = WIFI_PM_AWAKE;
+        break;
+    case CYW43_AGGRESSIVE_PM:
+        mode = WIFI_PM_SAVE;
+        break;
+    default:
+        CHECK(false, "cyw43_wifi_pm(0x%08x) fora dos modos do gerenciador", (unsigned)pm);
+        return -1;
+    }
+
+    if (s_pm_count < TEST_PM_LOG)
+    {
+        s_pm_log[s_pm_count].ms = (uint32_t)(host_time_us / 1000U);
+        s_pm_log[s_pm_count].mode = mode;
+    }
+    s_pm_count++;
+    return 0;
+}
+
+void dns_setserver(u8_t numdns, const ip_addr_t *dnsserver)
+{
+    CHECK(numdns == 0U && dnsserver->addr == 0x08080808U, "dns_setserver(%u, 0x%08x)", (unsigned)numdns,
+          (unsigned)dnsserver->addr);
+    s_dns_sets++;
+}
+
+void rtos_stats_watch_queue(QueueHandle_t q, const char *name)
+{
+    (void)q;
+    (void)name;
+}
+
+/** @brief Muda o link e avisa pela netif na IRQ simulada, como o cyw43. */
+static void radio_link(int status)
+{
+    struct netif *n = &cyw43_state.netif[CYW43_ITF_STA];
+
+    s_link = status;
+    ip4_addr_set_u32(&n->ip_addr, (status == CYW43_LINK_UP) ? 0x3200A8C0U : 0U); /* 192.168.0.50 */
+    host_isr_enter();
+    n->link_callback(n);
+    n->status_callback(n);
+    host_isr_exit();
+}
+
+/* ---------------------------------------------------------------------- */
+/* Roteiro                                                                */
+/* ---------------------------------------------------------------------- */
+
+static uint32_t now_ms(void)
+{
+    return (uint32_t)(host_time_us / 1000U);
+}
+
+/** @brief Espera até o instante `ms` (desde o boot). */
+static void at(uint32_t ms)
+{
+    if (ms > now_ms())
+    {
+        vTaskDelay(pdMS_TO_TICKS(ms - now_ms()));
+    }
+}
+
+/** @brief Confere a próxima troca aplicada no rádio. */
+static void expect_pm(wifi_pm_mode_t mode, uint32_t ms)
+{
+    if (s_pm_checked >= s_pm_count)
+    {
+        CHECK(false, "faltou a troca para %s em %u ms", wifi_manager_pm_str(mode), (unsigned)ms);
+        return;
+    }
+
+    const pm_change_t *c = &s_pm_log[s_pm_checked++];
+    CHECK(c->mode == mode && c->ms >= ms && c->ms <= ms + TEST_TOL_MS, "troca %u: %s em %u ms (esperado %s em %u ms)",
+          s_pm_checked, wifi_manager_pm_str(c->mode), (unsigned)c->ms, wifi_manager_pm_str(mode), (unsigned)ms);
+}
+
+/** @brief Nenhuma troca além das conferidas. */
+static void expect_no_pm(void)
+{
+    CHECK(s_pm_checked == s_pm_count, "%u troca(s) inesperada(s), a primeira para %s em %u ms",
+          s_pm_count - s_pm_checked, wifi_manager_pm_str(s_pm_log[s_pm_checked].mode),
+          (unsigned)s_pm_log[s_pm_checked].ms);
+    s_pm_checked = s_pm_count;
+}
+
+static wifi_pm_stats_t pm_stats(void)
+{
+    wifi_pm_stats_t pm;
+    wifi_manager_get_pm_stats(&pm);
+    return pm;
+}
+
+int main(void)
+{
+    host_rtos_init(tskIDLE_PRIORITY + 5);
+    wifi_manager_init("rede", "senha");
+    const int8_t mqtt = wifi_manager_tx_register("mqtt");
+    const int8_t sd = wifi_manager_tx_register("sd");
+    const int8_t udp = wifi_manager_tx_register("udp");
+    const int8_t http = wifi_manager_tx_register("http");
+    CHECK(mqtt == 0 && sd == 1 && udp == 2 && http == 3, "clientes %d/%d/%d/%d", mqtt, sd, udp, http);
+    xTaskCreate(wifi_manager_task, "WiFi", 1024, NULL, tskIDLE_PRIORITY + 3, NULL);
+
+    /* Associando: continua no modo padrão do driver */
+    at(10);
+    CHECK(s_full_joins == 1U, "%u conexoes iniciadas (esperado 1)", s_full_joins);
+    expect_no_pm();
+
+    /* Conectado e sem envios previstos: economia */
+    at(100);
+    radio_link(CYW43_LINK_UP);
+    at(110);
+    CHECK(wifi_manager_is_connected() && s_dns_sets == 1U, "link UP: conectado %d, DNS definido %u vez(es)",
+          wifi_manager_is_connected(), s_dns_sets);
+    expect_pm(WIFI_PM_SAVE, 100);
+    expect_no_pm();
+
+    /* Envio em 10 s: acorda 2 s antes; reagendado depois do envio, volta à economia */
+    at(1000);
+    wifi_manager_tx_schedule(mqtt, 10000);
+    at(11500);
+    expect_pm(WIFI_PM_AWAKE, 9000);
+    expect_no_pm();
+    wifi_manager_tx_schedule(mqtt, 60000);
+    at(11510);
+    expect_pm(WIFI_PM_SAVE, 11500);
+
+    /* Sem reagendar: acordado até WIFI_PM_HOLD_MS depois do prazo (71,5 s) */
+    at(82000);
+    expect_pm(WIFI_PM_AWAKE, 69500);
+    expect_pm(WIFI_PM_SAVE, 81500);
+    expect_no_pm();
+
+    /* Envio imediato e fim do envio */
+    at(90000);
+    wifi_manager_tx_schedule(mqtt, WIFI_TX_NOW);
+    at(90500);
+    wifi_manager_tx_schedule(mqtt, WIFI_TX_IDLE);
+    at(90600);
+    expect_pm(WIFI_PM_AWAKE, 90000);
+    expect_pm(WIFI_PM_SAVE, 90500);
+    expect_no_pm();
+
+    /* Dois clientes: o rádio dorme só entre os envios dos dois */
+    at(100000);
+    wifi_manager_tx_schedule(sd, 5000);
+    wifi_manager_tx_schedule(mqtt, 20000);
+    at(105200);
+    wifi_manager_tx_schedule(sd, WIFI_TX_IDLE);
+    at(120100);
+    wifi_manager_tx_schedule(mqtt, WIFI_TX_IDLE);
+    at(120200);
+    expect_pm(WIFI_PM_AWAKE, 103000);
+    expect_pm(WIFI_PM_SAVE, 105200);
+    expect_pm(WIFI_PM_AWAKE, 118000);
+    expect_pm(WIFI_PM_SAVE, 120100);
+    expect_no_pm();
+
+    /* Queda durante um envio: modo padrão sem link; volta acordado com a reassociação rápida */
+    at(130000);
+    wifi_manager_tx_schedule(mqtt, WIFI_TX_NOW);
+    at(131000);
+    radio_link(CYW43_LINK_DOWN);
+    at(131300);
+    CHECK(!wifi_manager_is_connected() && s_fast_joins == 1U, "queda: conectado %d, reassociacoes %u",
+          wifi_manager_is_connected(), s_fast_joins);
+    radio_link(CYW43_LINK_UP);
+    at(140100);
+    CHECK(s_dns_sets == 2U, "DNS definido %u vez(es) depois da reassociacao (esperado 2)", s_dns_sets);
+    expect_pm(WIFI_PM_AWAKE, 130000);
+    expect_pm(WIFI_PM_DEFAULT, 131000);
+    expect_pm(WIFI_PM_AWAKE, 131300);
+    expect_pm(WIFI_PM_SAVE, 140000); /* WIFI_PM_HOLD_MS depois do WIFI_TX_NOW */
+    expect_no_pm();
+
+    /* Erro do driver: conta e mantém o modo; o próximo pedido aplica */
+    at(150000);
+    s_pm_rc = -5;
+    wifi_manager_tx_schedule(mqtt, WIFI_TX_NOW);
+    at(150100);
+    CHECK(s_pm_errors >= 1U && pm_stats().errors == s_pm_errors && pm_stats().mode == WIFI_PM_SAVE,
+          "erro do driver: %u chamadas com erro, %u contados, modo %s", s_pm_errors, (unsigned)pm_stats().errors,
+          wifi_manager_pm_str(pm_stats().mode));
+    expect_no_pm();
+    s_pm_rc = 0;
+    wifi_manager_tx_schedule(mqtt, WIFI_TX_NOW);
+    at(150200);
+    wifi_manager_tx_schedule(mqtt, WIFI_TX_IDLE);
+    at(151000);
+    expect_pm(WIFI_PM_AWAKE, 150100);
+    expect_pm(WIFI_PM_SAVE, 150200);
+    expect_no_pm();
+
+    /* Clientes sem horário: fluxo UDP e depois um scrape HTTP seguram o rádio até o último soltar */
+    at(160000);
+    wifi_manager_tx_hold(udp, true);
+    at(170000);
+    wifi_manager_tx_hold(http, true);
+    wifi_manager_tx_schedule(mqtt, WIFI_TX_NOW);
+    wifi_manager_tx_schedule(mqtt, WIFI_TX_IDLE);
+    at(175000);
+    wifi_manager_tx_hold(udp, false);
+    at(200000);
+    CHECK(pm_stats().mode == WIFI_PM_AWAKE, "segurado por http: modo %s", wifi_manager_pm_str(pm_stats().mode));
+    wifi_manager_tx_hold(http, false);
+    at(200100);
+    expect_pm(WIFI_PM_AWAKE, 160000);
+    expect_pm(WIFI_PM_SAVE, 200000);
+    expect_no_pm();
+
+    /* Segurado durante a queda: volta acordado com o IP, não em economia */
+    wifi_manager_tx_hold(udp, true);
+    at(201000);
+    radio_link(CYW43_LINK_DOWN);
+    at(201300);
+    radio_link(CYW43_LINK_UP);
+    at(230000);
+    wifi_manager_tx_hold(udp, false);
+    at(230100);
+    expect_pm(WIFI_PM_AWAKE, 200100);
+    expect_pm(WIFI_PM_DEFAULT, 201000);
+    expect_pm(WIFI_PM_AWAKE, 201300);
+    expect_pm(WIFI_PM_SAVE, 230000);
+    expect_no_pm();
+
+    /* Contabilidade: os dois contadores cobrem o tempo todo; economia confere com as trocas */
+    const wifi_pm_stats_t pm = pm_stats();
+    uint64_t save_ms = 0;
+    for (unsigned i = 0; i < s_pm_count && i < TEST_PM_LOG; i++)
+    {
+        if (s_pm_log[i].mode == WIFI_PM_SAVE)
+        {
+            save_ms += ((i + 1U < s_pm_count) ? s_pm_log[i + 1U].ms : now_ms()) - s_pm_log[i].ms;
+        }
+    }
+    CHECK(pm.active_ms + pm.save_ms == now_ms() && pm.save_ms == save_ms && pm.switches == s_pm_count,
+          "contabilidade: ativo %u + economia %u ms (decorrido %u, economia pelas trocas %u), trocas %u/%u",
+          (unsigned)pm.active_ms, (unsigned)pm.save_ms, (unsigned)now_ms(), (unsigned)save_ms,
+          (unsigned)pm.switches, s_pm_count);
+
+    if (s_failures)
+    {
+        fprintf(stderr, "%u divergencias.\n", s_failures);
+        return 1;
+    }
+    printf("wifi_manager: OK (%u trocas de modo, %.1f%% do tempo em economia)\n", s_pm_count,
+           100.0 * (double)pm.save_ms / (double)now_ms());
+    return 0;
+}
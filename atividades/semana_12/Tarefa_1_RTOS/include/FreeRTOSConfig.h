@@ -82,5 +82,7 @@ to exclude the API function. */
 #define INCLUDE_xQueueGetMutexHolder 1
 
 /* A header file that defines trace macro can be included here. */
+/* Gravador de eventos do monitor_energia (RTOS_TRACE_ENABLE vem do CMake) */
+#include "lib/rtos_trace.h"
 
 #endif /* FREERTOS_CONFIG_H */
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "FreeRTOS.h"
 #include "task.h"
 #include "tarefas.h" // Inclui as declarações das tarefas e handles
+#include "lib/rtos_trace.h"
 
 // --- Definição dos Handles das Tarefas ---
 // Estas são as variáveis globais que o 'extern' em tasks.h aponta.
@@ -21,6 +22,11 @@ int main() {
     xTaskCreate(buzzer_task, "Buzzer_Task", 256, NULL, 1, &buzzer_task_handle);
     xTaskCreate(button_task, "Button_Task", 256, NULL, 2, NULL);
 
+#if RTOS_TRACE_ENABLE
+    // Console do gravador de eventos: teclas t/o/s/d na serial USB.
+    xTaskCreate(rtos_trace_console_task, "Trace_Task", 512, NULL, 1, NULL);
+#endif
+
     // Inicia o escalonador do FreeRTOS.
     vTaskStartScheduler();
 
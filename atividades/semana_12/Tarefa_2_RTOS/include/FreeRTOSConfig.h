@@ -138,6 +138,8 @@ to exclude the API function. */
 #define INCLUDE_xQueueGetMutexHolder            1
 
 /* A header file that defines trace macro can be included here. */
+/* Gravador de eventos do monitor_energia (RTOS_TRACE_ENABLE vem do CMake) */
+#include "lib/rtos_trace.h"
 
 /* Enable printf via USB */
 #define configUSE_STDIO 1
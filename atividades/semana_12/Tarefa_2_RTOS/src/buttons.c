@@ -10,8 +10,10 @@
 #include "hardware/gpio.h"
 #include "pico/time.h"
 #include "reaction_time.h"
+#include "lib/rtos_trace.h"
 
 static QueueHandle_t button_queue = NULL;
+static uint16_t trace_isr = 0; // Id da ISR no gravador de eventos
 
 /**
  * ISR para tratamento de pressionamento de botões
@@ -20,6 +22,7 @@ static QueueHandle_t button_queue = NULL;
  */
 static void button_isr(uint gpio, uint32_t events)
 {
+    RTOS_TRACE_ISR_ENTER(trace_isr);
     uint32_t current_time = to_ms_since_boot(get_absolute_time());
     static uint32_t last_button_a_time = 0;
     static uint32_t last_button_b_time = 0;
@@ -36,6 +39,7 @@ static void button_isr(uint gpio, uint32_t events)
         button_event_t event = EVENT_BUTTON_B_PRESSED;
         xQueueSendFromISR(button_queue, &event, NULL);
     }
+    RTOS_TRACE_ISR_EXIT(trace_isr);
 }
 
 /**
@@ -45,6 +49,7 @@ static void button_isr(uint gpio, uint32_t events)
 void buttons_init(QueueHandle_t queue)
 {
     button_queue = queue;
+    trace_isr = rtos_trace_isr("botoes");
 
     gpio_init(BUTTON_A_PIN);
     gpio_set_dir(BUTTON_A_PIN, GPIO_IN);
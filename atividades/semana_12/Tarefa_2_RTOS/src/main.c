@@ -8,6 +8,7 @@
 #include "reaction_time.h"
 #include "rgb_led.h"
 #include "oled.h"
+#include "lib/rtos_trace.h"
 
 int main(void)
 {
@@ -31,6 +32,11 @@ int main(void)
 
     xTaskCreate(buttons_task,"Button Task",256,NULL,1,NULL);
 
+#if RTOS_TRACE_ENABLE
+    /* Console do gravador de eventos (teclas t/o/s/d na serial USB) */
+    xTaskCreate(rtos_trace_console_task,"Trace Task",512,NULL,1,NULL);
+#endif
+
     /* Inicia o escalonador*/
     vTaskStartScheduler();
 
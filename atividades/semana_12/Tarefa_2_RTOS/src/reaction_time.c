@@ -13,6 +13,7 @@
 #include "pico/stdlib.h"
 #include "rgb_led.h"
 #include "oled.h"
+#include "lib/rtos_trace.h"
 
 static volatile system_state_t current_state = STATE_IDLE;
 static uint32_t led_on_time = 0;
@@ -25,6 +26,7 @@ static QueueHandle_t button_queue = NULL;
 void reaction_time_init(void)
 {
     button_queue = xQueueCreate(10, sizeof(button_event_t));
+    rtos_trace_name_queue(button_queue, "botoes");
     rgb_led_init();
     printf("Aperte o botao A para iniciar.\n");
     oled_draw_text_centered("A | Iniciar");
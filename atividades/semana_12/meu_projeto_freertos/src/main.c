@@ -2,6 +2,7 @@
 #include "pico/stdlib.h"
 #include "FreeRTOS.h"
 #include "task.h"
+#include "lib/rtos_trace.h"
 
 #define RGB_LED_G 11
 
@@ -22,6 +23,9 @@ int main() {
     stdio_init_all();
 
     xTaskCreate(blink_task, "Blink", 256, NULL, 1, NULL);
+#if RTOS_TRACE_ENABLE
+    xTaskCreate(rtos_trace_console_task, "Trace", 512, NULL, 1, NULL);
+#endif
     
     vTaskStartScheduler();
     